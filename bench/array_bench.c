@@ -0,0 +1,55 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "bench.h"
+#include "array.h"
+
+// Each operation is one emplace into an array that starts empty, so growth
+//    reallocations are amortized into the result.
+static void bench_emplace_back(index_s iterations) {
+  Array array = array_new(int);
+  for (index_s i = 0; i < iterations; ++i) {
+    int* element = array_emplace_back(array);
+    *element = (int)i;
+  }
+  bench_sink = array->size;
+  array_delete(&array);
+}
+
+static void bench_emplace_back_reserved(index_s iterations) {
+  Array array = array_new_reserve(int, iterations);
+  for (index_s i = 0; i < iterations; ++i) {
+    int* element = array_emplace_back(array);
+    *element = (int)i;
+  }
+  bench_sink = array->size;
+  array_delete(&array);
+}
+
+static const Benchmark array_benchmarks[] = {
+  { "emplace_back",           bench_emplace_back,           sizeof(int) },
+  { "emplace_back_reserved",  bench_emplace_back_reserved,  sizeof(int) },
+};
+
+BENCH_SUITE(bench_array, "array", NULL, NULL, array_benchmarks);
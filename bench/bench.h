@@ -0,0 +1,69 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_BENCH_H_
+#define _MCLIB_BENCH_H_
+
+#include "types.h"
+
+// Micro-benchmark suites for McLib_bench.
+//
+// Each benchmark's run function performs the measured operation `iterations`
+// times. The runner picks an iteration count that makes one repetition last
+// at least the minimum sample time, then reports the median over several
+// repetitions. `bytes` is the input size handled by one operation, used for
+// throughput (0 if throughput doesn't apply).
+//
+// Suites are declared per module in the same way as the spec suites, and
+// listed in bench_main.c.
+
+typedef struct {
+  const char* name;
+  void (*run)(index_s iterations);
+  index_s bytes;
+} Benchmark;
+
+typedef struct {
+  const char* name;
+  void (*setup)(void);
+  void (*teardown)(void);
+  const Benchmark* benchmarks;
+  index_s count;
+} BenchSuite;
+
+// Declares a suite over a static array of benchmarks, ex:
+//
+//    static const Benchmark str_benchmarks[] = { ... };
+//    BENCH_SUITE(bench_string, "str", setup, teardown, str_benchmarks);
+#define BENCH_SUITE(NAME, LABEL, SETUP, TEARDOWN, BENCHMARKS)                 \
+  BenchSuite NAME = {                                                         \
+    LABEL, SETUP, TEARDOWN, BENCHMARKS, ARRAY_COUNT(BENCHMARKS)               \
+  }                                                                           //
+
+// Results written here can't be optimized away, so consuming the final value
+//    of each run keeps the measured work alive.
+extern volatile index_s bench_sink;
+extern volatile float bench_sink_f;
+
+#endif
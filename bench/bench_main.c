@@ -0,0 +1,349 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Bench suites
+
+extern BenchSuite bench_array;
+extern BenchSuite bench_matrix;
+extern BenchSuite bench_string;
+
+volatile index_s bench_sink;
+volatile float bench_sink_f;
+
+#define BENCH_MAX_REPS 64
+#define BENCH_NAME_MAX 96
+
+typedef struct {
+  char name[BENCH_NAME_MAX];
+  double ns_per_op;     // median over repetitions
+  double ns_min;
+  double ns_max;
+  double bytes_per_sec; // 0 when not applicable
+  index_s iterations;   // per repetition
+} BenchResult;
+
+typedef struct {
+  const char* filter;
+  const char* json_path;
+  const char* baseline_path;
+  double min_time_ms;
+  double threshold;     // percent slowdown treated as a regression
+  int reps;
+} BenchOptions;
+
+static double bench_now_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double bench_time(const Benchmark* bench, index_s iterations) {
+  double start = bench_now_ns();
+  bench->run(iterations);
+  return bench_now_ns() - start;
+}
+
+static int bench_cmp_double(const void* lhs, const void* rhs) {
+  double a = *(const double*)lhs, b = *(const double*)rhs;
+  return (a > b) - (a < b);
+}
+
+static BenchResult bench_measure(
+  const BenchSuite* suite, const Benchmark* bench, const BenchOptions* opts
+) {
+  BenchResult ret = { 0 };
+  snprintf(ret.name, sizeof(ret.name), "%s/%s", suite->name, bench->name);
+
+  // grow the iteration count until one repetition is long enough to time
+  //    reliably, which also serves as the warmup
+  double min_ns = opts->min_time_ms * 1e6;
+  index_s iterations = 1;
+  double elapsed = bench_time(bench, iterations);
+  while (elapsed < min_ns) {
+    double scale = elapsed > 0 ? min_ns / elapsed * 1.2 : 10;
+    if (scale > 10) scale = 10;
+    if (scale < 2) scale = 2;
+    iterations = (index_s)(iterations * scale);
+    elapsed = bench_time(bench, iterations);
+  }
+
+  double samples[BENCH_MAX_REPS];
+  for (int r = 0; r < opts->reps; ++r) {
+    samples[r] = bench_time(bench, iterations) / (double)iterations;
+  }
+  qsort(samples, opts->reps, sizeof(double), bench_cmp_double);
+
+  int mid = opts->reps / 2;
+  ret.ns_per_op = opts->reps % 2
+    ? samples[mid] : (samples[mid - 1] + samples[mid]) * 0.5;
+  ret.ns_min = samples[0];
+  ret.ns_max = samples[opts->reps - 1];
+  ret.iterations = iterations;
+  if (bench->bytes && ret.ns_per_op > 0) {
+    ret.bytes_per_sec = (double)bench->bytes / ret.ns_per_op * 1e9;
+  }
+
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////////////////
+
+static void bench_print_bytes(double bytes_per_sec) {
+  static const char* units[] = { "B/s", "KiB/s", "MiB/s", "GiB/s" };
+  int unit = 0;
+  while (bytes_per_sec >= 1024 && unit < 3) {
+    bytes_per_sec /= 1024;
+    ++unit;
+  }
+  printf("%9.2f %-5s", bytes_per_sec, units[unit]);
+}
+
+static void bench_print(const BenchResult* result) {
+  double spread = result->ns_per_op > 0
+    ? (result->ns_max - result->ns_min) / result->ns_per_op * 100 : 0;
+  printf("%-36s %12.2f ns/op  +/-%5.1f%%  ", result->name,
+    result->ns_per_op, spread * 0.5
+  );
+  if (result->bytes_per_sec > 0) bench_print_bytes(result->bytes_per_sec);
+  printf("\n");
+}
+
+static bool bench_write_json(
+  const char* path, const BenchResult* results, index_s count
+) {
+  FILE* file = fopen(path, "w");
+  if (!file) return false;
+
+  fprintf(file, "{\n  \"benchmarks\": [\n");
+  for (index_s i = 0; i < count; ++i) {
+    const BenchResult* r = &results[i];
+    fprintf(file,
+      "    {\"name\": \"%s\", \"ns_per_op\": %.4f, \"ns_min\": %.4f, "
+      "\"ns_max\": %.4f, \"bytes_per_sec\": %.1f, \"iterations\": %lld}%s\n",
+      r->name, r->ns_per_op, r->ns_min, r->ns_max, r->bytes_per_sec,
+      (long long)r->iterations, i + 1 < count ? "," : ""
+    );
+  }
+  fprintf(file, "  ]\n}\n");
+
+  fclose(file);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Baseline comparison
+////////////////////////////////////////////////////////////////////////////////
+
+// Reads back the name and ns_per_op of each entry written by bench_write_json.
+//    Not a general JSON parser, it only needs to understand its own output.
+static index_s bench_read_baseline(
+  const char* path, BenchResult* out, index_s capacity
+) {
+  FILE* file = fopen(path, "r");
+  if (!file) return -1;
+
+  index_s count = 0;
+  char line[512];
+
+  while (count < capacity && fgets(line, sizeof(line), file)) {
+    const char* name = strstr(line, "\"name\": \"");
+    const char* ns = strstr(line, "\"ns_per_op\": ");
+    if (!name || !ns) continue;
+
+    name += strlen("\"name\": \"");
+    const char* name_end = strchr(name, '"');
+    if (!name_end || name_end - name >= BENCH_NAME_MAX) continue;
+
+    BenchResult* r = &out[count++];
+    *r = (BenchResult) { 0 };
+    memcpy(r->name, name, name_end - name);
+    r->ns_per_op = strtod(ns + strlen("\"ns_per_op\": "), NULL);
+  }
+
+  fclose(file);
+  return count;
+}
+
+// Prints the change against the baseline for each benchmark in both sets,
+//    returning the number of regressions past the threshold.
+static int bench_compare(
+  const BenchResult* results, index_s count,
+  const BenchResult* baseline, index_s base_count, double threshold
+) {
+  int regressions = 0;
+
+  printf("\n%-36s %12s %12s %9s\n", "comparison", "base ns/op", "ns/op", "change");
+
+  for (index_s i = 0; i < count; ++i) {
+    const BenchResult* base = NULL;
+    for (index_s j = 0; j < base_count; ++j) {
+      if (!strcmp(results[i].name, baseline[j].name)) {
+        base = &baseline[j];
+        break;
+      }
+    }
+
+    if (!base || base->ns_per_op <= 0) {
+      printf("%-36s %12s %12.2f %9s\n", results[i].name, "-",
+        results[i].ns_per_op, "new"
+      );
+      continue;
+    }
+
+    double change = (results[i].ns_per_op / base->ns_per_op - 1) * 100;
+    bool regressed = change > threshold;
+    regressions += regressed;
+
+    printf("%-36s %12.2f %12.2f %+8.1f%%%s\n", results[i].name,
+      base->ns_per_op, results[i].ns_per_op, change,
+      regressed ? "  REGRESSED" : ""
+    );
+  }
+
+  return regressions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Main
+////////////////////////////////////////////////////////////////////////////////
+
+static void bench_usage(const char* exe) {
+  printf(
+    "usage: %s [options]\n"
+    "  --filter <text>      only run benchmarks whose name contains text\n"
+    "  --reps <n>           repetitions per benchmark (default 9)\n"
+    "  --min-time <ms>      minimum time per repetition (default 20)\n"
+    "  --json <file>        write results as JSON\n"
+    "  --baseline <file>    compare against JSON from a previous run\n"
+    "  --threshold <pct>    slowdown reported as a regression (default 5)\n",
+    exe
+  );
+}
+
+int main(int argc, char* argv[]) {
+  BenchSuite* suites[] = {
+    &bench_array,
+    &bench_matrix,
+    &bench_string,
+  };
+
+  BenchOptions opts = {
+    .min_time_ms = 20,
+    .threshold = 5,
+    .reps = 9,
+  };
+
+  for (int i = 1; i < argc; ++i) {
+    const char* arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (!strcmp(arg, "--help") || !strcmp(arg, "-h")) {
+      bench_usage(argv[0]);
+      return 0;
+    }
+
+    if (!value) {
+      printf("missing value for %s\n", arg);
+      return 1;
+    }
+
+    if (!strcmp(arg, "--filter")) opts.filter = value;
+    else if (!strcmp(arg, "--reps")) opts.reps = atoi(value);
+    else if (!strcmp(arg, "--min-time")) opts.min_time_ms = atof(value);
+    else if (!strcmp(arg, "--json")) opts.json_path = value;
+    else if (!strcmp(arg, "--baseline")) opts.baseline_path = value;
+    else if (!strcmp(arg, "--threshold")) opts.threshold = atof(value);
+    else {
+      printf("unknown option: %s\n", arg);
+      bench_usage(argv[0]);
+      return 1;
+    }
+    ++i;
+  }
+
+  opts.reps = MAX(1, MIN(opts.reps, BENCH_MAX_REPS));
+  if (opts.min_time_ms <= 0) opts.min_time_ms = 1;
+
+  index_s total = 0;
+  for (size_t s = 0; s < ARRAY_COUNT(suites); ++s) total += suites[s]->count;
+
+  BenchResult* results = malloc(sizeof(BenchResult) * total);
+  index_s count = 0;
+
+  for (size_t s = 0; s < ARRAY_COUNT(suites); ++s) {
+    const BenchSuite* suite = suites[s];
+    bool ready = false;
+
+    for (index_s b = 0; b < suite->count; ++b) {
+      const Benchmark* bench = &suite->benchmarks[b];
+      char name[BENCH_NAME_MAX];
+      snprintf(name, sizeof(name), "%s/%s", suite->name, bench->name);
+      if (opts.filter && !strstr(name, opts.filter)) continue;
+
+      // only set up suites that have something to run
+      if (!ready && suite->setup) suite->setup();
+      ready = true;
+
+      results[count] = bench_measure(suite, bench, &opts);
+      bench_print(&results[count++]);
+    }
+
+    if (ready && suite->teardown) suite->teardown();
+  }
+
+  int ret = 0;
+
+  if (opts.json_path && !bench_write_json(opts.json_path, results, count)) {
+    printf("failed to write %s\n", opts.json_path);
+    ret = 1;
+  }
+
+  if (opts.baseline_path) {
+    BenchResult* baseline = malloc(sizeof(BenchResult) * 1024);
+    index_s base_count = bench_read_baseline(opts.baseline_path, baseline, 1024);
+
+    if (base_count < 0) {
+      printf("failed to read %s\n", opts.baseline_path);
+      ret = 1;
+    } else {
+      int regressions = bench_compare(
+        results, count, baseline, base_count, opts.threshold);
+      if (regressions) ret = 2;
+    }
+
+    free(baseline);
+  }
+
+  free(results);
+  return ret;
+}
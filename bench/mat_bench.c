@@ -0,0 +1,63 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "bench.h"
+#include "mat.h"
+
+// Each result feeds into the next operation so the calls can't be hoisted or
+//    overlapped, and the rotation keeps the values bounded over long runs.
+
+static void bench_m4mul(index_s iterations) {
+  mat4 rot = m4rotation(v3norm(v3f(1, 2, 3)), 0.01f);
+  mat4 m = m4identity;
+  for (index_s i = 0; i < iterations; ++i) {
+    m = m4mul(m, rot);
+  }
+  bench_sink_f = m.f[0];
+}
+
+static void bench_m4inverse(index_s iterations) {
+  mat4 m = m4rotation(v3norm(v3f(1, 2, 3)), 0.5f);
+  for (index_s i = 0; i < iterations; ++i) {
+    m = m4inverse(m);
+  }
+  bench_sink_f = m.f[0];
+}
+
+static void bench_mv4mul(index_s iterations) {
+  mat4 rot = m4rotation(v3norm(v3f(1, 2, 3)), 0.01f);
+  vec4 v = v4f(1, 0, 0, 1);
+  for (index_s i = 0; i < iterations; ++i) {
+    v = mv4mul(rot, v);
+  }
+  bench_sink_f = v.x;
+}
+
+static const Benchmark mat_benchmarks[] = {
+  { "m4mul",      bench_m4mul,      sizeof(mat4) * 2 },
+  { "m4inverse",  bench_m4inverse,  sizeof(mat4) },
+  { "mv4mul",     bench_mv4mul,     sizeof(mat4) + sizeof(vec4) },
+};
+
+BENCH_SUITE(bench_matrix, "mat", NULL, NULL, mat_benchmarks);
@@ -0,0 +1,113 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "bench.h"
+#include "str.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define STR_BENCH_TEXT_SIZE (64 * 1024)
+#define STR_BENCH_SPLIT_SIZE (4 * 1024)
+
+static char* text;
+static StringRange text_range;
+static StringRange split_range;
+
+// Comma separated words with the search target only at the very end
+static void str_bench_setup(void) {
+  static const char* words[] = {
+    "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel"
+  };
+
+  text = malloc(STR_BENCH_TEXT_SIZE + 1);
+  index_s size = 0;
+  for (index_s i = 0; size < STR_BENCH_TEXT_SIZE - 32; ++i) {
+    const char* word = words[i % ARRAY_COUNT(words)];
+    index_s length = (index_s)strlen(word);
+    memcpy(text + size, word, length);
+    memcpy(text + size + length, ", ", 2);
+    size += length + 2;
+  }
+  memcpy(text + size, "needle", 6);
+  size += 6;
+  text[size] = '\0';
+
+  text_range = str_range_s(text, size);
+  split_range = str_range_s(text, STR_BENCH_SPLIT_SIZE);
+}
+
+static void str_bench_teardown(void) {
+  free(text);
+  text = NULL;
+}
+
+static void bench_index_of(index_s iterations) {
+  index_s found = 0;
+  for (index_s i = 0; i < iterations; ++i) {
+    found += istr_index_of(text_range, R("needle"), 0);
+  }
+  bench_sink = found;
+}
+
+static void bench_split(index_s iterations) {
+  index_s parts = 0;
+  for (index_s i = 0; i < iterations; ++i) {
+    Array_StrR split = istr_split(split_range, R(", "));
+    parts += split->size;
+    arr_str_delete(&split);
+  }
+  bench_sink = parts;
+}
+
+static void bench_format(index_s iterations) {
+  index_s size = 0;
+  for (index_s i = 0; i < iterations; ++i) {
+    String str = str_format("{} + {} = {:.3} ({!x})", (int)i, 42, 3.14159, 255);
+    size += str->size;
+    str_delete(&str);
+  }
+  bench_sink = size;
+}
+
+static void bench_to_double(index_s iterations) {
+  double sum = 0;
+  for (index_s i = 0; i < iterations; ++i) {
+    double d = 0;
+    istr_to_double(R("-12345.678901"), &d);
+    sum += d;
+  }
+  bench_sink_f = (float)sum;
+}
+
+static const Benchmark str_benchmarks[] = {
+  { "index_of",   bench_index_of,   STR_BENCH_TEXT_SIZE },
+  { "split",      bench_split,      STR_BENCH_SPLIT_SIZE },
+  { "format",     bench_format,     0 },
+  { "to_double",  bench_to_double,  13 },
+};
+
+BENCH_SUITE(bench_string, "str",
+  str_bench_setup, str_bench_teardown, str_benchmarks
+);
@@ -4,6 +4,7 @@ build_target="clang"
 unit_test=false
 build_type="Debug"
 skip_cmake=false
+bench=false
 args=""
 
 while [ "$1" != "" ]; do
@@ -19,6 +20,7 @@ while [ "$1" != "" ]; do
       echo ": r release                              : release build (default is debug)"
       echo ": a args    \" \"                          : passes args to built exe (if any)"
       echo ": s skip-cmake                           : skips cmake"
+      echo ": b bench                                : runs benchmarks instead of tests"
       exit
       ;;
     -a | --args)
@@ -31,6 +33,9 @@ while [ "$1" != "" ]; do
     -s | --skip-cmake)
       skip_cmake=true
       ;;
+    -b | --bench)
+      bench=true
+      ;;
     *)
       echo ": Unknown parameter: $1"
       exit
@@ -81,16 +86,58 @@ esac
 sources_test=" \
   ./lib/cspec/cspec.c \
   ./lib/cspec/tst/cspec_spec.c \
+  ./tst/array_spec.c \
+  ./tst/async_spec.c \
+  ./tst/blob_spec.c \
+  ./tst/camera_spec.c \
+  ./tst/color_spec.c \
+  ./tst/file_spec.c \
+  ./tst/geom_spec.c \
+  ./tst/job_spec.c \
+  ./tst/kdtree_spec.c \
+  ./tst/memstats_spec.c \
+  ./tst/noise_spec.c \
+  ./tst/pack_spec.c \
+  ./tst/parallel_spec.c \
+  ./tst/rng_spec.c \
+  ./tst/skin_spec.c \
   ./tst/spec_main.c \
   ./tst/str_spec.c \
+  ./tst/trace_spec.c \
+  ./tst/utility_spec.c \
+  ./tst/vec_inline_probe.c \
+  ./tst/vec_inline_spec.c \
+  ./tst/vec_t_spec.c \
 "
 
 sources=" \
   ./src/array.c \
+  ./src/async.c \
+  ./src/blob.c \
+  ./src/camera.c \
+  ./src/color.c \
+  ./src/file.c \
+  ./src/geom.c \
+  ./src/job.c \
+  ./src/kdtree.c \
+  ./src/mat.c \
+  ./src/memstats.c \
+  ./src/noise.c \
+  ./src/pack.c \
+  ./src/parallel.c \
+  ./src/rng.c \
+  ./src/skin.c \
   ./src/str.c \
+  ./src/trace.c \
   ./src/utility.c \
+  ./src/vec.c \
 "
 
+libs=""
+if [[ "$OSTYPE" != msys* && "$OSTYPE" != cygwin* ]]; then
+  libs="-lpthread -lm"
+fi
+
 includes=" \
   -I ./include -I ./lib/cspec \
 "
@@ -100,8 +147,34 @@ flags_memtest=" \
   -Dcalloc=cspec_calloc -Dfree=cspec_free \
 ";
 
+sources_bench=" \
+  ./bench/bench_main.c \
+  ./bench/array_bench.c \
+  ./bench/mat_bench.c \
+  ./bench/str_bench.c \
+"
+
+# Benchmarks are always optimized and built without the memtest defines
+if [ "$bench" = true ]; then
+
+  case "$build_target" in
+    "clang" | "gcc" )
+      mkdir -p build/$build_target/bench
+      $build_target -o build/$build_target/bench/bench.exe -O2 \
+        -Wall -Wextra -Wno-missing-braces $includes -I ./bench \
+        $sources $sources_bench $libs
+
+      if [ "$?" == "0" ]; then
+        ./build/$build_target/bench/bench.exe $args
+      fi
+      ;;
+    * )
+      echo ": Benchmarks for $build_target are built by cmake as McLib_bench"
+      ;;
+  esac
+
 # WASM not supported here
-if [ "$build_target" = "wasm" ]; then
+elif [ "$build_target" = "wasm" ]; then
 
   echo ": WASM build not supported for McLib tests (requires libc)"
 
@@ -118,7 +191,7 @@ elif [ "$build_target" = "clang" ]; then
   mkdir -p build/$build_target/$build_type
 
   clang $flags_memtest -o build/clang/$build_type/test.exe \
-    $flags_common $flags_debug_opt $includes $sources $sources_test
+    $flags_common $flags_debug_opt $includes $sources $sources_test $libs
 
   if [ "$?" == "0" ]; then
     ./build/clang/$build_type/test.exe $args
@@ -129,7 +202,7 @@ elif [ "$build_target" = "gcc" ]; then
 
   mkdir -p build/gcc/$build_type
 
-  gcc -o build/gcc/$build_type/test.exe $flags_memtest $includes $sources $sources_test
+  gcc -o build/gcc/$build_type/test.exe $flags_memtest $includes $sources $sources_test $libs
 
   if [ "$?" == "0" ]; then
     ./build/gcc/$build_type/test.exe $args
@@ -38,7 +38,9 @@ typedef struct {
 #define array_new(TYPE) _array_new_(sizeof(TYPE))
 #define array_new_reserve(TYPE, capacity) _array_new_reserve_(sizeof(TYPE), capacity)
 Array   _array_new_(index_s elemenet_size);
+#define array_view(TYPE, data, count) _array_view_(sizeof(TYPE), data, count)
 Array   _array_new_reserve_(index_s element_size, index_s capacity);
+Array   _array_view_(index_s element_size, const void* data, index_s count);
 void    array_reserve(Array array, index_s capacity);
 void    array_truncate(Array array, index_s capacity);
 void    array_clear(Array array);
@@ -62,6 +64,7 @@ bool    array_read(const Array array, index_s index, void* out_element);
 bool    array_read_front(const Array array, void* out_element);
 bool    array_read_back(const Array array, void* out_element);
 bool    array_contains(const Array array, const void* to_find);
+void    array_reverse(Array array);
 void    array_sort(Array array, bool (*cmp)(const void* lhs, const void* rhs));
 //void*   array_ref_find(Array array, bool (*predicate)(const void* el));
 //void    array_filter(Array array, bool (*filter)(const void* el));
@@ -119,6 +122,7 @@ void    array_sort(Array array, bool (*cmp)(const void* lhs, const void* rhs));
 //
 // // Algorithm
 // void     arr_t_filter(Array_T, predicate);
+// void     arr_t_reverse(Array_T);
 // void     arr_t_sort(Array_T, compare_fn cmp);
 // T        arr_t_find(Array_T, predicate);
 // T*       arr_t_ref_find(Array_T, predicate);
@@ -501,6 +505,12 @@ static inline bool _prefix(_contains)
   return array_contains((Array)arr, &to_find);
 }
 
+// \brief Reverses the order of the elements in place.
+static inline void _prefix(_reverse)
+(_arr_type arr) {
+  array_reverse((Array)arr);
+}
+
 #ifdef con_cmp
 
 // \brief Sorts the array in place
@@ -0,0 +1,79 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_ASYNC_H_
+#define _MCLIB_ASYNC_H_
+
+#include "types.h"
+#include "str.h"
+#include "job.h"
+
+// \brief AsyncReader reads many files at once through a fixed set of reusable
+//    buffers, handing each filled buffer to a callback so parsing overlaps
+//    with the reads still in flight.
+//
+// \brief On Linux the reads go through io_uring with the buffers registered
+//    with the kernel. Elsewhere, or where io_uring is unavailable (old
+//    kernels, seccomp), each read is a pread on the JobPool instead. Build
+//    with MCLIB_NO_URING to always use the fallback.
+//
+// \brief Files larger than a buffer arrive as several chunks, each with its
+//    offset, and chunks of one file may complete out of order. A chunk's
+//    contents are only valid during the callback; the buffer is reused after.
+//    Callbacks run on the pool's threads or on the thread calling
+//    async_reader_poll or async_reader_wait, so they must be thread safe.
+//
+//    AsyncReader reader = async_reader_new(pool, 16, 1 << 20);
+//    for (index_s i = 0; i < paths->size; ++i) {
+//      async_read_file(reader, paths->arr[i], count_lines, &totals[i]);
+//    }
+//    async_reader_wait(reader);
+//    async_reader_delete(&reader);
+typedef struct {
+  index_s const pending;      // files queued or being read
+  bool const uring;           // reads go through io_uring
+}* AsyncReader;
+
+typedef struct {
+  const char* path;
+  void* data;                 // as given to async_read_file
+  index_s offset;             // of contents within the file
+  index_s file_size;
+  StringRange contents;
+  bool last;                  // the chunk ends at the end of the file
+  bool error;                 // the file couldn't be opened or read
+} AsyncChunk;
+
+typedef void (*AsyncReadFn)(const AsyncChunk* chunk);
+
+AsyncReader async_reader_new(
+              JobPool pool, index_s buffer_count, index_s buffer_size);
+void        async_reader_delete(AsyncReader* reader);
+
+void        async_read_file(
+              AsyncReader reader, const char* path, AsyncReadFn fn, void* data);
+index_s     async_reader_poll(AsyncReader reader);
+void        async_reader_wait(AsyncReader reader);
+
+#endif
@@ -0,0 +1,108 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_BLOB_H_
+#define _MCLIB_BLOB_H_
+
+#include "types.h"
+#include "array.h"
+#include "str.h"
+#include "file.h"
+
+// \brief A blob file is a sequence of binary sections, each holding either an
+//    Array of plain-old-data elements or a table of strings. Every section
+//    starts with a header recording its kind, element size, count, alignment
+//    and a checksum of its payload, and the payload starts at a multiple of
+//    its alignment from the start of the file.
+//
+// \brief Loading maps the file and hands out views straight into the mapping:
+//    no parsing, no copying, and only the pages actually touched get read.
+//    The views are read-only and live until blob_close.
+//
+// \brief Data is stored in the writer's byte order and layout, so element
+//    types should be fixed-size and free of pointers. A file written on a
+//    machine with a different byte order fails to open.
+//
+//    FileWriter out = file_writer_open("world.blob");
+//    blob_write_array(out, entities, 0);
+//    blob_write_strings(out, names);
+//    file_writer_close(&out);
+//
+//    BlobFile blob = blob_open("world.blob");
+//    Array_Entity entities = (Array_Entity)blob_array(blob, 0);
+//    BlobStrings names = blob_strings(blob, 1);
+//    StringRange first = blob_string(names, 0);
+//    ...
+//    blob_close(&blob);
+typedef struct {
+  index_s const section_count;
+  StringRange const range;      // the whole mapped file
+}* BlobFile;
+
+typedef enum {
+  BLOB_NONE,
+  BLOB_ARRAY,
+  BLOB_STRINGS,
+} BlobKind;
+
+// \brief A read-only string table from a blob file. String i occupies
+//    data[offsets[i]] up to offsets[i + 1] - 1, followed by a '\0' so it can
+//    also be used as a C string.
+typedef struct {
+  index_s count;
+  const long long* offsets;     // count + 1 entries
+  const char* data;
+} BlobStrings;
+
+// Payload alignment used when 0 is passed to blob_write_array
+#define BLOB_DEFAULT_ALIGN 16
+
+// Largest supported alignment, since a mapping only guarantees page alignment
+#define BLOB_MAX_ALIGN 4096
+
+bool        blob_write_array(FileWriter writer, Array array, index_s alignment);
+bool        blob_write_array_s(FileWriter writer, const void* data,
+              index_s element_size, index_s count, index_s alignment);
+bool        blob_write_strings(FileWriter writer, Array_StrR strings);
+bool        blob_write_strings_s(
+              FileWriter writer, const StringRange* strings, index_s count);
+
+BlobFile    blob_open(const char* path);
+void        blob_close(BlobFile* blob);
+bool        blob_verify(BlobFile blob);
+BlobKind    blob_kind(BlobFile blob, index_s section);
+Array       blob_array(BlobFile blob, index_s section);
+BlobStrings blob_strings(BlobFile blob, index_s section);
+
+// \brief Gets string i of a table.
+static inline StringRange blob_string(BlobStrings table, index_s i) {
+  assert(i >= 0 && i < table.count);
+  return str_range_s(table.data + table.offsets[i],
+    (index_s)(table.offsets[i + 1] - table.offsets[i] - 1)
+  );
+}
+
+unsigned long long blob_checksum(const void* data, index_s size);
+
+#endif
@@ -0,0 +1,86 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_CAMERA_H_
+#define _MCLIB_CAMERA_H_
+
+#include "types.h"
+#include "vec.h"
+#include "mat.h"
+
+// \brief Camera keeps the view and projection for a viewpoint along with the
+//    matrices derived from them: the combined view-projection, the inverse of
+//    each, and the frustum planes.
+//
+// \brief Derived values are computed on first access after a change and then
+//    cached, so reading a camera that hasn't moved costs a copy. Setters that
+//    are given the current values don't invalidate anything.
+//
+// \brief The view matrix is built directly from the orthonormal look basis
+//    (as is its inverse), and the projection inverses are written out from
+//    the known layout of m4perspective/m4ortho, so no general 4x4 inverse is
+//    needed. Eye and clip space follow the projection builders: the camera
+//    looks down -z with +y up, and clip depth is [0, 1] for perspective and
+//    [-1, 1] for ortho.
+typedef struct {
+  vec3 const pos;
+  vec3 const target;
+  vec3 const up;
+}* Camera;
+
+// Frustum planes as (normal, distance) with normals facing inward, so a point
+//    P is inside a plane when v3dot(plane.xyz, P) + plane.w >= 0
+typedef enum {
+  CAM_PLANE_LEFT,
+  CAM_PLANE_RIGHT,
+  CAM_PLANE_BOTTOM,
+  CAM_PLANE_TOP,
+  CAM_PLANE_NEAR,
+  CAM_PLANE_FAR,
+  CAM_PLANE_COUNT
+} CameraPlane;
+
+Camera  cam_new_perspective(float fov_rads, float aspect, float near, float far);
+Camera  cam_new_ortho(
+  float left, float right, float top, float bottom, float near, float far);
+void    cam_delete(Camera* cam);
+
+void    cam_look(Camera cam, vec3 pos, vec3 target, vec3 up);
+void    cam_set_perspective(
+  Camera cam, float fov_rads, float aspect, float near, float far);
+void    cam_set_ortho(Camera cam,
+  float left, float right, float top, float bottom, float near, float far);
+void    cam_set_aspect(Camera cam, float aspect);
+
+mat4    cam_view(Camera cam);
+mat4    cam_projection(Camera cam);
+mat4    cam_viewproj(Camera cam);
+mat4    cam_view_inverse(Camera cam);
+mat4    cam_projection_inverse(Camera cam);
+mat4    cam_viewproj_inverse(Camera cam);
+vec4    cam_plane(Camera cam, CameraPlane plane);
+
+bool    cam_sphere_visible(Camera cam, vec3 center, float radius);
+
+#endif
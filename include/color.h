@@ -0,0 +1,64 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_COLOR_H_
+#define _MCLIB_COLOR_H_
+
+#include "types.h"
+#include "vec.h"
+
+// Batch color conversions for compositing and image processing.
+//
+// color4b values are 8-bit unorm (0-255 maps to 0.0-1.0). The sRGB transfer
+// functions only apply to the rgb channels; alpha is always linear. All batch
+// functions accept aliasing in-place buffers where the in and out types match.
+
+// Exact sRGB transfer functions (per IEC 61966-2-1)
+float srgb_to_linear(float srgb);
+float linear_to_srgb(float linear);
+
+// Polynomial approximations for batch work where a few steps of error are
+//    fine: max absolute error is ~0.002 (to linear) and ~0.012 (to sRGB)
+float srgb_to_linear_fast(float srgb);
+float linear_to_srgb_fast(float linear);
+
+// byte <-> float without any transfer function
+void c4b_to_c4(color4* out, const color4b* in, index_s count);
+void c4_to_c4b(color4b* out, const color4* in, index_s count);
+
+// Alpha premultiplication (unpremultiply leaves fully transparent pixels as-is)
+void c4_premultiply(color4* colors, index_s count);
+void c4_unpremultiply(color4* colors, index_s count);
+void c4b_premultiply(color4b* colors, index_s count);
+void c4b_unpremultiply(color4b* colors, index_s count);
+
+// sRGB bytes <-> linear floats, table-based and correctly rounded to the byte
+void c4b_srgb_to_linear(color4* out, const color4b* in, index_s count);
+void c4_linear_to_srgb(color4b* out, const color4* in, index_s count);
+
+// sRGB floats <-> linear floats, in place using the polynomial approximations
+void c4_srgb_to_linear_fast(color4* colors, index_s count);
+void c4_linear_to_srgb_fast(color4* colors, index_s count);
+
+#endif
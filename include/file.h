@@ -0,0 +1,169 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_FILE_H_
+#define _MCLIB_FILE_H_
+
+#include "types.h"
+#include "str.h"
+
+////////////////////////////////////////////////////////////////////////////////
+// Mapped files
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief MappedFile is a whole file mapped read-only into memory, viewed as a
+//    StringRange. Pages are loaded by the OS on first access, so nothing is
+//    copied and only the parts that are read take up memory.
+//
+// \brief The range is valid until the file is unmapped with str_unmap_file.
+//    Substrings taken from it (split, token, etc.) share that lifetime.
+//
+//    MappedFile file = str_map_file("data.csv");
+//    if (file) {
+//      Array_StrR lines = str_split(file->range, "\n");
+//      ...
+//      str_unmap_file(&file);
+//    }
+typedef struct {
+  StringRange const range;
+}* MappedFile;
+
+typedef enum {
+  FILE_ACCESS_NORMAL,
+  FILE_ACCESS_SEQUENTIAL,   // read ahead aggressively
+  FILE_ACCESS_RANDOM,       // don't read ahead
+  FILE_ACCESS_WILLNEED,     // start loading the whole range now
+} FileAccess;
+
+// \brief Maps a file for reading, hinted for sequential access.
+//
+// \returns A new MappedFile, or NULL if the file couldn't be opened or mapped.
+MappedFile  str_map_file(const char* path);
+void        str_unmap_file(MappedFile* file);
+void        str_map_advise(MappedFile file, FileAccess access);
+
+////////////////////////////////////////////////////////////////////////////////
+// Line reader
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief LineReader streams the lines of a file through a mapped window that
+//    slides forward as it goes, so files much larger than memory (or than the
+//    address space on 32-bit targets) can be read without copying.
+//
+// \brief Lines are returned without their "\n" or "\r\n", and point directly
+//    into the window, so each one is only valid until the next call to
+//    line_reader_next. A final newline doesn't start another, empty line.
+//    A line longer than the window grows the window to fit it.
+//
+//    LineReader reader = line_reader_new("huge.log");
+//    StringRange line;
+//    while (line_reader_next(reader, &line)) {
+//      if (str_contains(line, "ERROR")) str_write(line);
+//    }
+//    line_reader_delete(&reader);
+typedef struct {
+  index_s const line_number;  // of the last line read, starting from 1
+  index_s const offset;       // of the last line read, in bytes from the start
+  index_s const file_size;
+}* LineReader;
+
+#ifndef LINE_READER_WINDOW
+# define LINE_READER_WINDOW (64 * 1024 * 1024)
+#endif
+
+#define line_reader_new(path) line_reader_new_window(path, LINE_READER_WINDOW)
+
+LineReader  line_reader_new_window(const char* path, index_s window_size);
+void        line_reader_delete(LineReader* reader);
+bool        line_reader_next(LineReader reader, StringRange* out_line);
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffered reader
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief FileReader reads a file (or stdin) through a large aligned buffer
+//    with plain read calls, and hands out StringRanges pointing into that
+//    buffer. Each range is only valid until the next read from the reader.
+//
+// \brief The buffer grows when a single line or read_exact request is larger
+//    than it, so any record that fits in memory can be read in one piece.
+//
+//    FileReader in = file_reader_stdin();
+//    FileWriter out = file_writer_stdout();
+//    StringRange line;
+//    while (file_read_line(in, &line)) {
+//      file_write(out, str_trim(line));
+//      file_write_char(out, '\n');
+//    }
+//    file_writer_close(&out);
+//    file_reader_close(&in);
+typedef struct {
+  index_s const position;     // bytes consumed so far
+}* FileReader;
+
+typedef struct {
+  index_s const written;      // bytes accepted so far, including buffered
+  bool const error;           // a write failed, later writes are dropped
+}* FileWriter;
+
+#ifndef FILE_BUFFER_SIZE
+# define FILE_BUFFER_SIZE (1024 * 1024)
+#endif
+
+// Buffers are aligned for the benefit of O_DIRECT-style and SIMD consumers
+#define FILE_BUFFER_ALIGN 4096
+
+FileReader  file_reader_open(const char* path);
+FileReader  file_reader_stdin(void);
+void        file_reader_close(FileReader* reader);
+
+bool        file_read_line(FileReader reader, StringRange* out_line);
+bool        file_read_until(FileReader reader, char delim, StringRange* out);
+bool        file_read_exact(FileReader reader, index_s count, StringRange* out);
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffered writer
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief `void file_write(writer, str)`
+// \brief Writes a String, StringRange or C string to the buffer.
+#define file_write(writer, str)     file_write_range(writer, _s2r(str))
+
+// \brief `void file_write_format(writer, fmt, ...)`
+// \brief Writes a formatted string, see str_format for the format details.
+#define file_write_format(writer, ...)                                        \
+  _file_write_owned(writer, _str_format(__VA_ARGS__, _str_fmtarg_end))        //
+
+FileWriter  file_writer_open(const char* path);
+FileWriter  file_writer_stdout(void);
+bool        file_writer_close(FileWriter* writer);
+bool        file_writer_flush(FileWriter writer);
+
+void        file_write_range(FileWriter writer, StringRange str);
+void        file_write_char(FileWriter writer, char c);
+void        file_write_int(FileWriter writer, long long value);
+void        file_write_float(FileWriter writer, double value, int precision);
+void        _file_write_owned(FileWriter writer, String str);
+
+#endif
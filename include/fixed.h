@@ -0,0 +1,135 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_FIXED_H_
+#define _MCLIB_FIXED_H_
+
+#include "types.h"
+#include "mat.h"
+
+// Q16.16 fixed point scalars, vectors and matrices for deterministic lockstep
+// simulation. All arithmetic is done with integer operations, so results are
+// bit-identical across compilers and platforms. Products truncate toward
+// negative infinity. Sums, differences and negations are done on unsigned
+// values, so overflow wraps around modulo 2^32 instead of being undefined, and
+// products keep the low 32 bits of the shifted result.
+//
+// See vec_t.h for the full list of generated types and functions, ex: fxvec3,
+// fxv3add, fxv3from(vec3), fxm4mul, fxmv4mul.
+
+typedef int fixed;
+
+#define FX_SHIFT  16
+#define FX_ONE    ((fixed)1 << FX_SHIFT)
+#define FX_HALF   (FX_ONE >> 1)
+#define FX_MAX    ((fixed)0x7FFFFFFF)
+#define FX_MIN    (-FX_MAX - 1)
+
+// \brief Converts an integer to fixed point.
+#define fx(I) ((fixed)((unsigned)(I) << FX_SHIFT))
+
+static inline fixed fx_from_float(float f) {
+  return (fixed)(f * (float)FX_ONE + (f < 0 ? -0.5f : 0.5f));
+}
+
+static inline float fx_to_float(fixed x) {
+  return (float)x * (1.0f / (float)FX_ONE);
+}
+
+static inline fixed fx_from_double(double d) {
+  return (fixed)(d * (double)FX_ONE + (d < 0 ? -0.5 : 0.5));
+}
+
+static inline double fx_to_double(fixed x) {
+  return (double)x * (1.0 / (double)FX_ONE);
+}
+
+static inline fixed fx_add(fixed a, fixed b) {
+  return (fixed)((unsigned)a + (unsigned)b);
+}
+
+static inline fixed fx_sub(fixed a, fixed b) {
+  return (fixed)((unsigned)a - (unsigned)b);
+}
+
+static inline fixed fx_neg(fixed a) {
+  return (fixed)(0u - (unsigned)a);
+}
+
+static inline fixed fx_mul(fixed a, fixed b) {
+  return (fixed)(((long long)a * b) >> FX_SHIFT);
+}
+
+// \brief Divides two fixed point values. Division by zero saturates to the
+//    signed limit rather than trapping.
+static inline fixed fx_div(fixed a, fixed b) {
+  if (b == 0) return a < 0 ? FX_MIN : FX_MAX;
+  return (fixed)(((long long)a * FX_ONE) / b);
+}
+
+// \brief Square root by bitwise integer root of the value scaled by 2^16.
+//    Negative inputs return 0.
+static inline fixed fx_sqrt(fixed a) {
+  if (a <= 0) return 0;
+  unsigned long long n = (unsigned long long)a << FX_SHIFT;
+  unsigned long long root = 0;
+  unsigned long long bit = 1ull << 62;
+  while (bit > n) bit >>= 2;
+  while (bit) {
+    if (n >= root + bit) {
+      n -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (fixed)root;
+}
+
+#define vec_scalar fixed
+#define vec_prefix fx
+#define vec_one FX_ONE
+#define vec_add fx_add
+#define vec_sub fx_sub
+#define vec_neg fx_neg
+#define vec_mul fx_mul
+#define vec_div fx_div
+#define vec_sqrt fx_sqrt
+#define vec_from_float fx_from_float
+#define vec_to_float fx_to_float
+#include "vec_t.h"
+#undef vec_scalar
+#undef vec_prefix
+#undef vec_one
+#undef vec_add
+#undef vec_sub
+#undef vec_neg
+#undef vec_mul
+#undef vec_div
+#undef vec_sqrt
+#undef vec_from_float
+#undef vec_to_float
+
+#endif
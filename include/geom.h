@@ -0,0 +1,91 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_GEOMETRY_H_
+#define _MCLIB_GEOMETRY_H_
+
+#include "types.h"
+#include "array.h"
+#include "vec.h"
+
+// 2D polygon utilities over vec2 point sets.
+//
+// Polygons are simple (non-self-intersecting) closed loops given as a run of
+// vertices, with the last vertex connecting back to the first. Either winding
+// is accepted; results are always counter-clockwise. Orientation predicates
+// are evaluated in double precision.
+//
+// Each function has an Array_vec2 form and a _s form taking a pointer and
+// count, in the style of kd_new_v2.
+
+// A line segment between two points, in either direction
+typedef struct seg2 {
+  union {
+    vec2 p[2];
+    struct { vec2 a, b; };
+  };
+} seg2;
+
+// An intersection between the segments at indices a and b, where a < b
+typedef struct seg2hit {
+  vec2 point;
+  index_s a, b;
+} seg2hit;
+
+#define con_type seg2
+#define con_prefix seg2
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#define con_type seg2hit
+#define con_prefix seg2hit
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#define geom_area(polygon) geom_area_s((polygon)->arr, (polygon)->size)
+#define geom_hull(points, out) geom_hull_s((points)->arr, (points)->size, out)
+#define geom_triangulate(polygon, out)                                        \
+  geom_triangulate_s((polygon)->arr, (polygon)->size, out)                    //
+#define geom_contains(polygon, P)                                             \
+  geom_contains_s((polygon)->arr, (polygon)->size, P)                         //
+#define geom_contains_batch(polygon, points, out)                             \
+  geom_contains_batch_s(                                                      \
+    (polygon)->arr, (polygon)->size, (points)->arr, (points)->size, out)      //
+#define geom_intersect_all(segments, out)                                     \
+  geom_intersect_all_s((segments)->arr, (segments)->size, out)                //
+
+float   geom_area_s(const vec2* polygon, index_s count);
+index_s geom_hull_s(const vec2* points, index_s count, Array_vec2 out);
+index_s geom_triangulate_s(const vec2* polygon, index_s count, Array out);
+bool    geom_contains_s(const vec2* polygon, index_s count, vec2 P);
+void    geom_contains_batch_s(
+  const vec2* polygon, index_s poly_count,
+  const vec2* points, index_s count, bool* out
+);
+index_s geom_intersect_all_s(
+  const seg2* segments, index_s count, Array_seg2hit out);
+
+#endif
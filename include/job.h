@@ -0,0 +1,80 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_JOB_H_
+#define _MCLIB_JOB_H_
+
+#include "types.h"
+
+// \brief JobPool is a work-stealing scheduler over a fixed set of worker
+//    threads. Each worker owns a Chase-Lev deque: it pushes and pops its own
+//    jobs from the bottom while idle workers steal from the top, so related
+//    work stays on one core until someone runs out.
+//
+// \brief Jobs submitted from outside the pool go to a shared queue. Any thread
+//    waiting on a job helps run queued work instead of blocking, so nested
+//    waits inside jobs are fine and the calling thread contributes too.
+//
+// \brief A Job handle keeps the job alive until it's passed to job_wait or
+//    job_release, exactly one of which must be called for every handle.
+//
+//    JobPool pool = job_pool_new(0);
+//    Job load = job_run(pool, load_mesh, &mesh);
+//    Job upload = job_run_after(pool, load, upload_mesh, &mesh);
+//    job_release(&load);
+//    job_wait(pool, &upload);
+//    job_pool_delete(&pool);
+typedef struct {
+  int const worker_count;
+}* JobPool;
+
+typedef struct _Job_Opaque* Job;
+
+typedef void (*JobFn)(void* data);
+typedef void (*JobRangeFn)(void* data, index_s begin, index_s end);
+
+// \brief Capacity of each worker's deque. A worker with a full deque runs new
+//    jobs immediately rather than queueing them.
+#ifndef JOB_DEQUE_SIZE
+# define JOB_DEQUE_SIZE 4096
+#endif
+
+int     job_hardware_threads(void);
+
+JobPool job_pool_new(int worker_count);
+void    job_pool_delete(JobPool* pool);
+int     job_worker_index(JobPool pool);
+
+Job     job_run(JobPool pool, JobFn fn, void* data);
+Job     job_run_child(JobPool pool, Job parent, JobFn fn, void* data);
+Job     job_run_after(JobPool pool, Job dependency, JobFn fn, void* data);
+Job     job_current(void);
+bool    job_done(Job job);
+void    job_wait(JobPool pool, Job* job);
+void    job_release(Job* job);
+
+void    parallel_for(JobPool pool, index_s begin, index_s end, index_s grain,
+          JobRangeFn fn, void* data);
+
+#endif
@@ -0,0 +1,64 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_KDTREE_H_
+#define _MCLIB_KDTREE_H_
+
+#include "types.h"
+#include "array.h"
+#include "vec.h"
+
+// \brief KdTree is a static, balanced k-d tree over a set of 2D or 3D points,
+//    used for nearest-neighbour and radius queries in logarithmic time.
+//
+// \brief The tree is stored implicitly: the points are copied and permuted so
+//    that the median of every sub-range is the splitting node for that range,
+//    meaning no child pointers are stored. Query results are the indices of
+//    the points in the original input array.
+//
+// \brief The tree does not keep a reference to the input points, so the source
+//    array can be modified or deleted after construction.
+typedef struct {
+  index_s const dimensions;
+  index_s const size;
+}* KdTree;
+
+// \brief Builds a tree over the points in the given array.
+#define kd_new_v2(points) kd_new_v2_s((points)->arr, (points)->size)
+#define kd_new_v3(points) kd_new_v3_s((points)->arr, (points)->size)
+
+KdTree  kd_new_v2_s(const vec2* points, index_s count);
+KdTree  kd_new_v3_s(const vec3* points, index_s count);
+void    kd_delete(KdTree* tree);
+
+index_s kd_nearest_v2(KdTree tree, vec2 P, float* dist_sq_out);
+index_s kd_nearest_v3(KdTree tree, vec3 P, float* dist_sq_out);
+index_s kd_knn_v2(
+  KdTree tree, vec2 P, index_s k, index_s* out_indices, float* out_dist_sq);
+index_s kd_knn_v3(
+  KdTree tree, vec3 P, index_s k, index_s* out_indices, float* out_dist_sq);
+index_s kd_radius_v2(KdTree tree, vec2 P, float radius, Array out_indices);
+index_s kd_radius_v3(KdTree tree, vec3 P, float radius, Array out_indices);
+
+#endif
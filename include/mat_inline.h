@@ -0,0 +1,100 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_MATRIX_INLINE_H_
+#define _MCLIB_MATRIX_INLINE_H_
+
+// Definitions for the trivial matrix functions declared in mat.h, following
+// the same MCLIB_INLINE_MATH rules as vec_inline.h.
+
+#include "mat.h"
+
+#ifndef _math_fn
+# ifdef MCLIB_INLINE_MATH
+#  define _math_fn static inline
+# else
+#  define _math_fn
+# endif
+#endif
+
+_math_fn mat4 m4basis(vec3 x, vec3 y, vec3 z, vec3 origin) {
+  return (mat4) {.f={
+    x.x, y.x, z.x, 0,
+    x.y, y.y, z.y, 0,
+    x.z, y.z, z.z, 0,
+    -v3dot(x, origin), -v3dot(y, origin), -v3dot(z, origin), 1
+  }};
+}
+
+_math_fn mat4 m4translation(vec3 vec) {
+  mat4 ret = m4identity;
+  ret.col[3].xyz = vec;
+  return ret;
+}
+
+_math_fn mat4 m4scalar(vec3 scalar) {
+  mat4 ret = m4identity;
+  ret.m[0][0] = scalar.x;
+  ret.m[1][1] = scalar.y;
+  ret.m[2][2] = scalar.z;
+  return ret;
+}
+
+_math_fn mat4 m4uniform(float scalar) {
+  mat4 ret = m4identity;
+  ret.m[0][0] = scalar;
+  ret.m[1][1] = scalar;
+  ret.m[2][2] = scalar;
+  return ret;
+}
+
+_math_fn mat4 m4mul(mat4 a, mat4 b) {
+  mat4 ret = m4zero;
+
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) {
+      for (int i = 0; i < 4; ++i) {
+        ret.m[x][y] += a.m[i][y] * b.m[x][i];
+      }
+    }
+  }
+
+  return ret;
+}
+
+_math_fn vec4 mv4mul(mat4 m, vec4 v) {
+  vec4 ret = v4zero;
+
+  for (int y = 0; y < 4; ++y) {
+    for (int x = 0; x < 4; ++x) {
+      ret.f[y] += m.m[x][y] * v.f[x];
+    }
+  }
+
+  return ret;
+}
+
+#undef _math_fn
+
+#endif
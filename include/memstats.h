@@ -0,0 +1,119 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_MEMSTATS_H_
+#define _MCLIB_MEMSTATS_H_
+
+#include "types.h"
+
+// Opt-in allocation statistics for Array and String.
+//
+// Building with MCLIB_MEMSTATS routes every allocation made by the containers
+// through counting wrappers, which track live and peak bytes, allocation and
+// realloc counts, and the bytes moved when a realloc can't grow in place
+// (such as from array_reserve). Strings made through the str_ producer macros
+// (str_new, str_copy, str_format, str_split, ...) are also attributed to the
+// file and line of the call, so the sites holding the most memory can be
+// listed.
+//
+// Without MCLIB_MEMSTATS the wrappers are plain malloc/realloc/free and the
+// query functions report nothing, so callers don't need to check the define.
+//
+// Buffers taken with array_release belong to the caller and stop being
+// tracked, except where McLib keeps them itself (str_format's result).
+
+typedef struct {
+  index_s live_bytes;
+  index_s peak_bytes;
+  index_s live_count;         // allocations currently held
+  index_s alloc_count;        // total allocations made
+  index_s free_count;
+  index_s realloc_count;
+  index_s realloc_copy_bytes; // bytes moved by reallocs that changed address
+} MemStats;
+
+typedef struct {
+  const char* file;           // NULL for allocations without a call site
+  int line;
+  index_s live_bytes;
+  index_s live_count;
+  index_s total_bytes;
+  index_s alloc_count;
+} MemSite;
+
+typedef enum {
+  MEM_EVENT_ALLOC,
+  MEM_EVENT_REALLOC,
+  MEM_EVENT_FREE,
+} MemEventType;
+
+typedef struct {
+  MemEventType type;
+  const void* ptr;            // NULL for frees
+  uintptr_t old_addr;         // 0 for new allocations. Already released, so
+                              //    it's only an address to match against.
+  index_s size;
+  index_s old_size;
+  const MemSite* site;
+} MemEvent;
+
+// Called after each tracked event. Hooks may be called from any thread that
+//    uses the containers, and must not allocate through McLib themselves.
+typedef void (*MemHook)(const MemEvent* event, void* user_data);
+
+MemStats  memstats_get(void);
+index_s   memstats_sites(MemSite* out, index_s capacity);
+void      memstats_reset_peak(void);
+void      memstats_set_hook(MemHook hook, void* user_data);
+void      memstats_dump(void);
+bool      memstats_dump_every(double seconds);
+
+// Allocation entry points for the library sources
+#ifdef MCLIB_MEMSTATS
+
+void* memstats_malloc(size_t size);
+void* memstats_realloc(void* ptr, size_t size);
+void  memstats_free(void* ptr);
+void  memstats_adopt(void* ptr, size_t size);
+void  memstats_disown(void* ptr);
+void  memstats_site_begin(const char* file, int line);
+void  memstats_site_end(void);
+
+# define mem_malloc(SIZE)         memstats_malloc(SIZE)
+# define mem_realloc(PTR, SIZE)   memstats_realloc(PTR, SIZE)
+# define mem_free(PTR)            memstats_free(PTR)
+# define mem_adopt(PTR, SIZE)     memstats_adopt(PTR, SIZE)
+# define mem_disown(PTR)          memstats_disown(PTR)
+
+#else
+
+# define mem_malloc(SIZE)         malloc(SIZE)
+# define mem_realloc(PTR, SIZE)   realloc(PTR, SIZE)
+# define mem_free(PTR)            free(PTR)
+# define mem_adopt(PTR, SIZE)     ((void)(PTR), (void)(SIZE))
+# define mem_disown(PTR)          ((void)(PTR))
+
+#endif
+
+#endif
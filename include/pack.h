@@ -0,0 +1,85 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_PACK_H_
+#define _MCLIB_PACK_H_
+
+#include "types.h"
+#include "vec.h"
+
+// Compact encodings for vertex and network buffers.
+//
+// Scalar conversions:
+//    - f16:    IEEE 754 half float, round-to-nearest-even
+//    - unorm8: [0, 1] <-> [0, 255]
+//    - snorm8: [-1, 1] <-> [-127, 127]
+//    - unorm16/snorm16: same as above with 16 bits
+//    - oct:    unit vec3 normals as a vec2 in [-1, 1] (octahedral mapping),
+//              with oct16 packing both components as snorm16 into a uint
+//
+// The batch pack_/unpack_ functions operate on a flat run of float components,
+// so a vector array converts by passing its float data and the total number of
+// components. ex: for an Array_vec4 `arr` into a u16 buffer of halves:
+//
+//    pack_f16(out, arr->arr->f, arr->size * v4floats);
+//
+// Batch versions use SSE2 (and F16C for halves) when the compiler targets it,
+// and always produce the same results as their scalar counterparts. For
+// halves that includes NaN, which keeps the top of its payload and is quieted.
+
+u16         ftoh(float f);
+float       htof(u16 h);
+byte        ftoun8(float f);
+float       un8tof(byte b);
+signed char ftosn8(float f);
+float       sn8tof(signed char b);
+u16         ftoun16(float f);
+float       un16tof(u16 s);
+short       ftosn16(float f);
+float       sn16tof(short s);
+
+vec2        oct_encode(vec3 n);
+vec3        oct_decode(vec2 e);
+uint        oct_pack16(vec3 n);
+vec3        oct_unpack16(uint packed);
+
+vec3b       b3from_v3(vec3 v);
+vec3        v3from_b3(vec3b b);
+vec4b       b4from_v4(vec4 v);
+vec4        v4from_b4(vec4b b);
+
+void pack_f16(u16* out, const float* in, index_s count);
+void unpack_f16(float* out, const u16* in, index_s count);
+void pack_unorm8(byte* out, const float* in, index_s count);
+void unpack_unorm8(float* out, const byte* in, index_s count);
+void pack_snorm8(signed char* out, const float* in, index_s count);
+void unpack_snorm8(float* out, const signed char* in, index_s count);
+void pack_unorm16(u16* out, const float* in, index_s count);
+void unpack_unorm16(float* out, const u16* in, index_s count);
+void pack_snorm16(short* out, const float* in, index_s count);
+void unpack_snorm16(float* out, const short* in, index_s count);
+void pack_oct16(uint* out, const vec3* in, index_s count);
+void unpack_oct16(vec3* out, const uint* in, index_s count);
+
+#endif
@@ -0,0 +1,158 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_PARALLEL_H_
+#define _MCLIB_PARALLEL_H_
+
+#include "types.h"
+#include "array.h"
+#include "job.h"
+#include "str.h"
+
+// \brief Data-parallel algorithms over Arrays, run on a JobPool. The macros
+//    take any Array or Array_T; the _s variants take a raw buffer instead.
+//
+// \brief Work is split into a few contiguous chunks per worker, and results
+//    that depend on order (reduce, scan, filter, sort) come out exactly as the
+//    serial loop would produce them, provided the operations are associative.
+//    Small inputs skip the pool and run serially on the calling thread.
+//
+//    float sum = 0;
+//    par_reduce(pool, values, &sum, sizeof(sum), sum_floats, add_floats, NULL);
+//    par_sort(pool, values, float_less);
+
+// \brief Called on [begin, end) of the input, with first pointing at begin.
+typedef void (*ParChunkFn)(void* data, void* first, index_s begin, index_s end);
+
+// \brief Folds count elements from first into acc.
+typedef void (*ParReduceFn)(
+  void* data, void* acc, const void* first, index_s count);
+
+// \brief Folds another chunk's accumulator into acc.
+typedef void (*ParCombineFn)(void* data, void* acc, const void* other);
+
+// \brief Sets acc to acc op rhs, where op is associative.
+typedef void (*ParScanFn)(void* acc, const void* rhs);
+
+typedef bool (*ParPredicateFn)(void* data, const void* element);
+
+// \brief Returns true if lhs sorts strictly before rhs, the same comparator as
+//    con_cmp for typed arrays.
+typedef bool (*ParLessFn)(const void* lhs, const void* rhs);
+
+// Inputs below this many elements aren't split up
+#ifndef PAR_MIN_CHUNK
+# define PAR_MIN_CHUNK 4096
+#endif
+
+// Text below this many bytes isn't split up
+#ifndef PAR_MIN_TEXT_CHUNK
+# define PAR_MIN_TEXT_CHUNK (64 * 1024)
+#endif
+
+typedef enum {
+  PAR_PARSE_INT,
+  PAR_PARSE_LONG,
+  PAR_PARSE_FLOAT,
+  PAR_PARSE_DOUBLE,
+} ParParseType;
+
+#define par_foreach(POOL, ARRAY, GRAIN, FN, DATA)                             \
+  par_foreach_s(POOL, (ARRAY)->arr, (ARRAY)->size, (ARRAY)->element_size,     \
+    GRAIN, FN, DATA)                                                          //
+
+#define par_reduce(POOL, ARRAY, ACC, ACC_SIZE, REDUCE, COMBINE, DATA)         \
+  par_reduce_s(POOL, (ARRAY)->arr, (ARRAY)->size, (ARRAY)->element_size,      \
+    ACC, ACC_SIZE, REDUCE, COMBINE, DATA)                                     //
+
+#define par_scan_inclusive(POOL, IN, OUT, IDENTITY, OP)                       \
+  _par_scan_((POOL), (Array)(IN), (Array)(OUT), (IDENTITY), (OP), true)       //
+
+#define par_scan_exclusive(POOL, IN, OUT, IDENTITY, OP)                       \
+  _par_scan_((POOL), (Array)(IN), (Array)(OUT), (IDENTITY), (OP), false)      //
+
+#define par_filter(POOL, IN, OUT, PREDICATE, DATA)                            \
+  _par_filter_((POOL), (Array)(IN), (Array)(OUT), (PREDICATE), (DATA))        //
+
+#define par_sort(POOL, ARRAY, LESS)                                           \
+  par_sort_s(POOL, (ARRAY)->arr, (ARRAY)->size, (ARRAY)->element_size, LESS)  //
+
+// \brief Splits str exactly like str_split, but in parallel: the text is cut
+//    into chunks that each end just past a delimiter, every chunk is split on
+//    its own, and the pieces are stitched together in order.
+//
+// \brief Delimiters that can overlap themselves (such as "aa") can't be found
+//    reliably from the middle of the text, so those are split serially.
+//
+// \returns An array of StringRanges whose lifetimes are bound to str.
+#define par_str_split(POOL, STR, DEL)                                         \
+  _par_str_split_((POOL), _s2r(STR), _s2r(DEL))                               //
+
+// \brief Parses each field of str between delimiters, in parallel, and
+//    replaces the contents of OUT with the values in order. OUT must be an
+//    Array of int, index_s, float or double respectively. Fields are trimmed
+//    first and empty ones are skipped, so trailing newlines are fine.
+//
+// \returns False if any non-empty field wasn't a valid number. Those fields
+//    are left out of OUT.
+#define par_str_to_int(POOL, STR, DEL, OUT)                                   \
+  _par_str_parse_((POOL), _s2r(STR), _s2r(DEL), (Array)(OUT), PAR_PARSE_INT)  //
+
+#define par_str_to_long(POOL, STR, DEL, OUT)                                  \
+  _par_str_parse_((POOL), _s2r(STR), _s2r(DEL), (Array)(OUT), PAR_PARSE_LONG) //
+
+#define par_str_to_float(POOL, STR, DEL, OUT)                                 \
+  _par_str_parse_((POOL), _s2r(STR), _s2r(DEL), (Array)(OUT),                 \
+    PAR_PARSE_FLOAT)                                                          //
+
+#define par_str_to_double(POOL, STR, DEL, OUT)                                \
+  _par_str_parse_((POOL), _s2r(STR), _s2r(DEL), (Array)(OUT),                 \
+    PAR_PARSE_DOUBLE)                                                         //
+
+void    par_foreach_s(JobPool pool, void* elements, index_s count,
+          index_s element_size, index_s grain, ParChunkFn fn, void* data);
+
+void    par_reduce_s(JobPool pool, const void* elements, index_s count,
+          index_s element_size, void* acc, index_s acc_size,
+          ParReduceFn reduce, ParCombineFn combine, void* data);
+
+void    par_scan_s(JobPool pool, const void* in, void* out, index_s count,
+          index_s element_size, const void* identity, ParScanFn op,
+          bool inclusive);
+
+void    par_sort_s(JobPool pool, void* elements, index_s count,
+          index_s element_size, ParLessFn less);
+
+void    _par_scan_(JobPool pool, const Array in, Array out,
+          const void* identity, ParScanFn op, bool inclusive);
+
+index_s _par_filter_(JobPool pool, const Array in, Array out,
+          ParPredicateFn predicate, void* data);
+
+Array_StrR _par_str_split_(JobPool pool, StringRange str, StringRange del);
+
+bool    _par_str_parse_(JobPool pool, StringRange str, StringRange del,
+          Array out, ParParseType type);
+
+#endif
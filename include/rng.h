@@ -0,0 +1,71 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_RNG_H_
+#define _MCLIB_RNG_H_
+
+#include "types.h"
+#include "vec.h"
+
+// Fast pseudo-random numbers for procedural generation.
+//
+// Rng runs RNG_LANES independent xoshiro128** generators side by side, so the
+// batch fills step every lane at once with SSE2 when the compiler targets it.
+// Single draws hand out the lanes' outputs one at a time, and a fill of n
+// values always gives the same results as n single draws, with or without
+// SIMD.
+//
+// The state is plain data and can be copied freely. For parallel work, give
+// each thread its own copy and call rng_jump on it a different number of
+// times, which advances every lane by 2^64 draws so the streams never overlap.
+//
+// Not suitable for anything security related.
+
+#define RNG_LANES 4
+
+typedef struct Rng {
+  uint state[4][RNG_LANES];
+  uint buffer[RNG_LANES];
+  int  used;
+} Rng;
+
+Rng   rng_new(unsigned long long seed);
+void  rng_jump(Rng* rng);
+
+// Uniform 32-bit value
+uint  rng_uint(Rng* rng);
+
+// Uniform float in [0, 1), with 24 bits of randomness
+float rng_float(Rng* rng);
+
+// Uniform float in [lo, hi)
+float rng_range(Rng* rng, float lo, float hi);
+
+// Fill with uniform values in [lo, hi), per component for the vector types
+void  rng_fill_uint(Rng* rng, uint* out, index_s count);
+void  rng_fill_f(Rng* rng, float* out, index_s count, float lo, float hi);
+void  rng_fill_v2(Rng* rng, vec2* out, index_s count, vec2 lo, vec2 hi);
+void  rng_fill_v3(Rng* rng, vec3* out, index_s count, vec3 lo, vec3 hi);
+
+#endif
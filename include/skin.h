@@ -0,0 +1,94 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_SKIN_H_
+#define _MCLIB_SKIN_H_
+
+#include "types.h"
+#include "vec.h"
+#include "mat.h"
+
+// Batch vertex skinning over structure-of-arrays vertex streams.
+//
+// Each vertex has SKIN_INFLUENCES bone influences, stored as one stream of
+// bone indices and one of weights per influence slot. Weights for a vertex are
+// expected to sum to 1, with unused slots given a weight of 0. The palette is
+// never read through an unused slot, so its bone index can be anything.
+//
+// The kernels work on a [begin, end) range of vertices and only write outputs
+// within that range, so a mesh can be split into chunks and skinned from
+// several threads at once. Output streams may be the same as the inputs.
+//
+// With AVX2 enabled, eight vertices are skinned at a time with the palette
+// entries fetched by gathers. Results match the scalar path within rounding.
+
+#define SKIN_INFLUENCES 4
+
+// An affine transform as three rows of four, where the last column is the
+//    translation. Compared to mat4, the bottom row is implied to be (0 0 0 1).
+typedef struct mat34 {
+  union {
+    float f[12];
+    float m[3][4];
+    vec4  row[3];
+  };
+} mat34;
+
+// A rigid transform as a unit dual quaternion. Quaternions use the Hamilton
+//    convention, rotating v by computing q v q*.
+typedef struct dquat {
+  quat real;
+  quat dual;
+} dquat;
+
+// Three parallel float arrays, one per vec3 component
+typedef struct {
+  float* x;
+  float* y;
+  float* z;
+} SkinStream;
+
+typedef struct {
+  SkinStream positions;
+  SkinStream normals;      // optional, x may be NULL to skip normals
+  SkinStream out_positions;
+  SkinStream out_normals;
+  const u16* bones[SKIN_INFLUENCES];
+  const float* weights[SKIN_INFLUENCES];
+} SkinMesh;
+
+mat34 m34from_m4(mat4 m);
+mat4  m4from_m34(mat34 m);
+vec3  m34transform(mat34 m, vec3 p);
+
+dquat dq_from_rt(quat rotation, vec3 translation);
+dquat dq_from_m34(mat34 m);
+vec3  dq_transform(dquat dq, vec3 p);
+
+void skin_lbs(
+  const SkinMesh* mesh, const mat34* palette, index_s begin, index_s end);
+void skin_dqs(
+  const SkinMesh* mesh, const dquat* palette, index_s begin, index_s end);
+
+#endif
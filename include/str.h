@@ -146,11 +146,20 @@ StringRange str_range_s(const char* c_str, index_s length);
 
 String  str_new(const char* c_str);
 String  str_new_s(const char* c_str, index_s length);
-#define str_copy(str)               istr_copy(_s2r(str))
+#define str_copy(str)               _str_site(istr_copy(_s2r(str)))
 String  str_from_bool(bool b);
 String  str_from_int(int i);
 String  str_from_float(float f);
 
+// UTF-16 or UTF-32 to UTF-8. str_from_ returns NULL for unpaired surrogates
+//    or invalid code points. The _to_utf8 versions write into out, which needs
+//    3 bytes per UTF-16 unit or 4 per code point, and return the byte count
+//    or -1.
+String  str_from_utf16(const u16* in, index_s count);
+String  str_from_utf32(const uint* in, index_s count);
+index_s str_utf16_to_utf8(char* out, const u16* in, index_s count);
+index_s str_utf32_to_utf8(char* out, const uint* in, index_s count);
+
 void    str_delete(String* str);
 
 #define str_eq(lhs, rhs)            istr_eq(_s2r(lhs), _s2r(rhs))
@@ -158,6 +167,16 @@ void    str_delete(String* str);
 #define str_ends_with(str, end)     istr_ends_with(_s2r(str), _s2r(end))
 #define str_contains(str, check)    istr_contains(_s2r(str), _s2r(check))
 
+// \brief Case-insensitive versions of the above. Only ASCII letters are
+//    folded, other bytes (including UTF-8 sequences) must match exactly.
+#define str_eq_nocase(lhs, rhs)     istr_eq_nocase(_s2r(lhs), _s2r(rhs))
+#define str_starts_with_nocase(str, start) \
+                    istr_starts_with_nocase(_s2r(str), _s2r(start))
+#define str_ends_with_nocase(str, end) \
+                    istr_ends_with_nocase(_s2r(str), _s2r(end))
+#define str_contains_nocase(str, check) \
+                    istr_contains_nocase(_s2r(str), _s2r(check))
+
 #define str_to_bool(str, out)       istr_to_bool(_s2r(str), out)
 #define str_to_int(str, out)        istr_to_int(_s2r(str), out)
 #define str_to_long(str, out)       istr_to_long(_s2r(str), out)
@@ -185,6 +204,13 @@ void    str_delete(String* str);
 #define str_index_of_char(str, to_find, from_pos) \
                     istr_index_of_char(_s2r(str), to_find, from_pos)
 
+// \brief Case-insensitive str_index_of, folding ASCII letters only.
+//
+// \returns
+//    The index in str of the match, or str.size if none is present.
+#define str_index_of_nocase(str, to_find, from_pos) \
+                    istr_index_of_nocase(_s2r(str), _s2r(to_find), from_pos)
+
 // \brief Gets a token as a substring of str described by the starting position
 //    pos that ends with (not including) any delimeter character in to_find.
 //
@@ -233,7 +259,7 @@ void    str_delete(String* str);
 //
 // \returns An array of StringRanges whose lifetimes are bound to str.
 //    The Array must be deleted by the user via arr_str_delete(&arr).
-#define str_split(str, del)         istr_split(_s2r(str), _s2r(del))
+#define str_split(str, del)         _str_site(istr_split(_s2r(str), _s2r(del)))
 
 // \brief Joins an array of string ranges into a new string, each separated by a
 //    given delimiter.
@@ -244,12 +270,100 @@ void    str_delete(String* str);
 // \param strings - The array of string ranges to join.
 //
 // \returns a new string, which must be deleted later by the caller.
-#define str_join(del, strings)      istr_join(_s2r(del), strings)
-#define str_concat(left, right)     istr_concat(_s2r(left), _s2r(right))
-#define str_replace(str, tok, w)    istr_replace(_s2r(str), _s2r(tok), _s2r(w))
-#define str_replace_all(s, t, w)    istr_replace_all(_s2r(s), _s2r(t), _s2r(w))
-#define str_prepend(str, length, c) istr_prepend(_s2r(str), length, c)
-#define str_append(str, length, c)  istr_append(_s2r(str), length, c)
+#define str_join(del, strings)      _str_site(istr_join(_s2r(del), strings))
+#define str_concat(left, right) \
+                    _str_site(istr_concat(_s2r(left), _s2r(right)))
+
+// \brief `String str_replace(str, token, with)`
+// \brief Copies str with the first instance of token replaced, or for
+//    str_replace_all every non-overlapping instance. An empty token matches
+//    nothing.
+//
+// \returns a new string, which must be deleted later by the caller.
+#define str_replace(str, tok, w) \
+                    _str_site(istr_replace(_s2r(str), _s2r(tok), _s2r(w)))
+#define str_replace_all(s, t, w) \
+                    _str_site(istr_replace_all(_s2r(s), _s2r(t), _s2r(w)))
+
+// \brief A token and the text str_replace_multi substitutes for it.
+typedef struct {
+  StringRange token;
+  StringRange with;
+} StrReplacement;
+
+// \brief `String str_replace_multi(str, const StrReplacement* table, count)`
+// \brief Applies a table of replacements in one left-to-right scan. Where
+//    several tokens match at the same position the longest wins, and replaced
+//    text isn't scanned again.
+//
+//    StrReplacement escapes[] = {
+//      { R("&"), R("&amp;") }, { R("<"), R("&lt;") }, { R(">"), R("&gt;") },
+//    };
+//    String html = str_replace_multi(text, escapes, 3);
+//
+// \returns a new string, which must be deleted later by the caller.
+#define str_replace_multi(str, table, count) \
+                    _str_site(istr_replace_multi(_s2r(str), table, count))
+
+// \brief Copies the string with ASCII letters converted to lower or upper case.
+//
+// \returns a new string, which must be deleted later by the caller.
+#define str_to_lower(str)           _str_site(istr_to_lower(_s2r(str)))
+#define str_to_upper(str)           _str_site(istr_to_upper(_s2r(str)))
+
+// \brief `index_s str_to_lower_to(char* out, str)`
+// \brief Writes the converted string into out, which needs room for str.size
+//    characters and may be the string's own memory to convert in place. No
+//    terminator is added.
+//
+// \returns The number of characters written, str.size.
+#define str_to_lower_to(out, str)   istr_to_lower_to(out, _s2r(str))
+#define str_to_upper_to(out, str)   istr_to_upper_to(out, _s2r(str))
+
+// \brief UTF-8 support. Strings are still sized and indexed in bytes, these
+//    read and produce code points where needed. Validation, counting and the
+//    ASCII parts of transcoding run 16 bytes at a time with SSE2/SSSE3.
+//
+//    index_s pos = 0;
+//    uint cp;
+//    while (str_utf8_next(str, &pos, &cp)) { ... }
+
+// \brief Checks that str is well-formed UTF-8: no overlong encodings,
+//    surrogates, values past U+10FFFF or truncated sequences.
+#define str_utf8_valid(str)         istr_utf8_valid(_s2r(str))
+
+// \returns The byte offset of the first invalid sequence, or str.size.
+#define str_utf8_validate(str)      istr_utf8_validate(_s2r(str))
+
+// \brief Counts code points, assuming str is valid.
+#define str_utf8_length(str)        istr_utf8_length(_s2r(str))
+
+// \brief `bool str_utf8_next(str, index_s* pos, uint* out_cp)`
+// \brief Decodes the code point at pos and moves pos past it. An invalid
+//    byte decodes as U+FFFD and is skipped on its own.
+//
+// \returns false once pos reaches the end of the string.
+#define str_utf8_next(str, pos, cp) istr_utf8_next(_s2r(str), pos, cp)
+
+// \brief `index_s str_to_utf16(u16* out, str)`
+// \brief Transcodes into out, which needs room for str.size units at most
+//    (str_utf16_length gives the exact count).
+//
+// \returns The number of units written, or -1 if str isn't valid UTF-8.
+#define str_to_utf16(out, str)      istr_to_utf16(out, _s2r(str))
+#define str_to_utf32(out, str)      istr_to_utf32(out, _s2r(str))
+#define str_utf16_length(str)       istr_utf16_length(_s2r(str))
+
+// \brief `index_s str_to_utf16_array(Array out, str)`
+// \brief Appends to an Array of 2-byte (or, for utf32, 4-byte) elements.
+//
+// \returns The number of elements added, or -1 (adding none) if invalid.
+#define str_to_utf16_array(out, str) istr_to_utf16_array(out, _s2r(str))
+#define str_to_utf32_array(out, str) istr_to_utf32_array(out, _s2r(str))
+
+#define str_prepend(str, length, c) \
+                    _str_site(istr_prepend(_s2r(str), length, c))
+#define str_append(str, length, c)  _str_site(istr_append(_s2r(str), length, c))
 
 // \brief `String str_format(fmt, ...)`
 // \brief Builds a new string from a format string and variable arguments.
@@ -283,7 +397,8 @@ void    str_delete(String* str);
 //    - exponent (TODO):    {:.3e}, {:.3E} (should be {!e}?)
 //
 // \returns a new string, which must be deleted later by the caller.
-#define str_format(...)             _str_format(__VA_ARGS__, _str_fmtarg_end)
+#define str_format(...) \
+                    _str_site(_str_format(__VA_ARGS__, _str_fmtarg_end))
 
 // \brief `void str_print(fmt, ...)`
 // \brief Prints a formatted string as a log.
@@ -299,6 +414,18 @@ void    str_delete(String* str);
 //String str_pad_left(StringRange str, index_s length, char c);
 //String str_pad_right(StringRange str, index_s length, char c);
 
+// \brief ASCII case folding tables. Bytes other than letters map to themselves.
+extern const byte str_lower_table[256];
+extern const byte str_upper_table[256];
+
+static inline char str_char_lower(char c) {
+  return (char)str_lower_table[(byte)c];
+}
+
+static inline char str_char_upper(char c) {
+  return (char)str_upper_table[(byte)c];
+}
+
 static inline index_s     _str_size(StringRange s) { return s.size; }
 static inline StringRange _str_range_r(StringRange range) { return range; }
 static inline StringRange _str_range_st(const String str) {
@@ -314,16 +441,33 @@ bool        istr_ends_with(StringRange str, StringRange ends);
 bool        istr_contains(StringRange str, StringRange check);
 bool        istr_contains_char(StringRange str, char check);
 bool        istr_contains_any(StringRange str, StringRange check_chars);
+bool        istr_eq_nocase(StringRange lhs, StringRange rhs);
+bool        istr_starts_with_nocase(StringRange str, StringRange starts);
+bool        istr_ends_with_nocase(StringRange str, StringRange ends);
+bool        istr_contains_nocase(StringRange str, StringRange check);
 bool        istr_to_bool(StringRange str, bool* out_bool);
 bool        istr_to_int(StringRange str, int* out_int);
 bool        istr_to_long(StringRange str, index_s* out_int);
 bool        istr_to_float(StringRange str, float* out_float);
 bool        istr_to_double(StringRange str, double* out_float);
-//String    istr_to_upper(StringRange str);
-//String    istr_to_lower(StringRange str);
+bool        istr_utf8_valid(StringRange str);
+index_s     istr_utf8_validate(StringRange str);
+index_s     istr_utf8_length(StringRange str);
+bool        istr_utf8_next(StringRange str, index_s* pos, uint* out_cp);
+index_s     istr_utf16_length(StringRange str);
+index_s     istr_to_utf16(u16* out, StringRange str);
+index_s     istr_to_utf32(uint* out, StringRange str);
+index_s     istr_to_utf16_array(Array out, StringRange str);
+index_s     istr_to_utf32_array(Array out, StringRange str);
+String      istr_to_upper(StringRange str);
+String      istr_to_lower(StringRange str);
+index_s     istr_to_upper_to(char* out, StringRange str);
+index_s     istr_to_lower_to(char* out, StringRange str);
 //String    istr_to_title(StringRange str);
 index_s     istr_index_of_char(StringRange str, char c, index_s from);
 index_s     istr_index_of(StringRange str, StringRange to_find, index_s from);
+index_s     istr_index_of_nocase(
+              StringRange str, StringRange to_find, index_s from);
 StringRange istr_token(StringRange str, StringRange del_chrs, index_s* pos);
 //index_s   istr_index_of_last(StringRange str, StringRange find, index_s from);
 index_s     istr_find(StringRange str, StringRange to_find);
@@ -338,10 +482,10 @@ Array_StrR  istr_split(StringRange str, StringRange del);
 //Array     istr_parenthetize(StringRange str); // block out segments by parens? ([{}])
 String      istr_join(StringRange deliminter, const Array_StringRange strings);
 String      istr_concat(StringRange left, StringRange right);
-// for replace, start with basic string replace, maybe later look into adding regex support?
-//    differentiate between regular strings and regex with the regular "a" vs "/a/"
-//String    istr_replace(StringRange str, StringRange to_rep, StringRange with);
-//String    istr_replace_all(StringRange str, StringRange r, StringRange w);
+String      istr_replace(StringRange str, StringRange token, StringRange with);
+String      istr_replace_all(StringRange str, StringRange t, StringRange w);
+String      istr_replace_multi(
+              StringRange str, const StrReplacement* table, index_s count);
 String      istr_prepend(StringRange str, index_s length, char c);
 String      istr_append(StringRange str, index_s length, char c);
 String      istr_format(StringRange fmt, ...);
@@ -419,4 +563,36 @@ static inline _Str_FmtArg _sarg_arg(_Str_FmtArg e) {
   _Str_FmtArg:        _sarg_arg         \
 )(arg)                                  //
 
+// Call site attribution for the producer macros under MCLIB_MEMSTATS, so the
+//    memory of each String is listed against the line that made it. The
+//    library's own calls are left unattributed (see memstats.h).
+#if defined(MCLIB_MEMSTATS) && !defined(_MCLIB_STR_NO_SITES)
+
+#include "memstats.h"
+
+static inline String _str_site_end_str(String str) {
+  memstats_site_end();
+  return str;
+}
+
+static inline Array_StrR _str_site_end_arr(Array_StrR arr) {
+  memstats_site_end();
+  return arr;
+}
+
+#define _str_site(EXPR) (memstats_site_begin(__FILE__, __LINE__),             \
+  _Generic((EXPR),                                                            \
+    String:     _str_site_end_str,                                            \
+    Array_StrR: _str_site_end_arr                                             \
+  )(EXPR))                                                                    //
+
+#define str_new(c_str)              _str_site(str_new(c_str))
+#define str_new_s(c_str, length)    _str_site(str_new_s(c_str, length))
+#define str_from_int(i)             _str_site(str_from_int(i))
+#define str_from_float(f)           _str_site(str_from_float(f))
+
+#else
+#define _str_site(EXPR) EXPR
+#endif
+
 #endif
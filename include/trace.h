@@ -0,0 +1,77 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_TRACE_H_
+#define _MCLIB_TRACE_H_
+
+#include "types.h"
+
+// Lightweight timing zones, exported as Chrome trace-event JSON for viewing
+// in Perfetto (ui.perfetto.dev) or chrome://tracing.
+//
+// Zones are only recorded when built with MCLIB_TRACE; otherwise the macros
+// expand to nothing and the library's built-in zones (str_format, str_split,
+// array growth, m4inverse) cost nothing. The functions below stay available
+// either way so tools don't need to check the define.
+//
+// Each thread records into its own ring buffer of TRACE_BUFFER_EVENTS events,
+// so the oldest events are overwritten on long runs. Events are 24 bytes, so
+// that's 1.5 MB per thread at the default. A thread's buffer outlives it so its
+// events can still be exported, and trace_clear passes it on to the next new
+// thread, so memory follows the most threads alive between clears. Zones nest,
+// and their names must be string literals or otherwise outlive the trace.
+//
+//    void update(void) {
+//      TRACE_BEGIN("update");
+//      ...
+//      TRACE_END();
+//    }
+//
+//    TRACE_SCOPE("physics") {
+//      // don't return or break out of a TRACE_SCOPE block
+//    }
+
+#ifndef TRACE_BUFFER_EVENTS
+# define TRACE_BUFFER_EVENTS (1 << 16)
+#endif
+
+void  trace_begin(const char* name);
+void  trace_end(void);
+void  trace_set_thread_name(const char* name);
+void  trace_clear(void);
+bool  trace_export(const char* path);
+
+#ifdef MCLIB_TRACE
+# define TRACE_BEGIN(NAME)  trace_begin(NAME)
+# define TRACE_END()        trace_end()
+# define TRACE_SCOPE(NAME)                                                    \
+  for (int _trace_once = (trace_begin(NAME), 1); _trace_once;                 \
+    _trace_once = (trace_end(), 0))                                           //
+#else
+# define TRACE_BEGIN(NAME)  ((void)0)
+# define TRACE_END()        ((void)0)
+# define TRACE_SCOPE(NAME)
+#endif
+
+#endif
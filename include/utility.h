@@ -25,10 +25,56 @@
 #ifndef _MCLIB_UTILITY_H_
 #define _MCLIB_UTILITY_H_
 
+#include "types.h"
+
+// Buffer sizes that fit any output of the matching _to function, including
+//    the terminating '\0'
+#define ITOS_BUFFER_SIZE 12
+#define LLTOS_BUFFER_SIZE 21
+#define FTOS_BUFFER_SIZE 24
+
 float stof(const char* s);
-const char* ftos(float f);
 int stoi(const char* i);
+
+// itos and ftos return a per-thread buffer, valid until the next call to
+//    either on the same thread. The _to versions write into the caller's
+//    buffer and return the length written, not counting the '\0'.
 const char* itos(int i);
+const char* ftos(float f);
+int itos_to(char* out, int i);
+int lltos_to(char* out, long long i);
+int ftos_to(char* out, float f);
+
+// Reversal and byte swapping use SSSE3 or AVX2 shuffles when the compiler
+//    targets them, otherwise 64-bit byte swaps.
+//
+// memrev reverses bytes, memrev_elements reverses the order of count elements
+//    of any size while keeping the bytes of each element in order.
+//    ex: memrev_elements(arr->arr, arr->element_size, arr->size)
+//
+// The bswap_s functions convert arrays between little and big endian in place.
+
 void memrev(void* p, unsigned size);
+void memrev_elements(void* p, index_s element_size, index_s count);
+
+void bswap16_s(u16* p, index_s count);
+void bswap32_s(uint* p, index_s count);
+void bswap64_s(unsigned long long* p, index_s count);
+void bswapf_s(float* p, index_s count);
+
+#if defined(_MSC_VER) && !defined(__clang__)
+# include <stdlib.h>
+static inline u16 bswap16(u16 x) { return _byteswap_ushort(x); }
+static inline uint bswap32(uint x) { return _byteswap_ulong(x); }
+static inline unsigned long long bswap64(unsigned long long x) {
+  return _byteswap_uint64(x);
+}
+#else
+static inline u16 bswap16(u16 x) { return __builtin_bswap16(x); }
+static inline uint bswap32(uint x) { return __builtin_bswap32(x); }
+static inline unsigned long long bswap64(unsigned long long x) {
+  return __builtin_bswap64(x);
+}
+#endif
 
 #endif
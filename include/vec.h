@@ -230,7 +230,13 @@ typedef vec4 color4;
 #define b4white     ((vec4b){.i={ 255, 255, 255, 255 } })
 #define b4gray      ((vec4b){.i={ 128, 128, 128, 255 } })
 
-vec3 qtransform(quat q, vec3 v);
+// The trivial constructors and arithmetic are defined in vec_inline.h. With
+// MCLIB_INLINE_MATH defined they're static inline in every including file,
+// otherwise they're regular functions compiled into vec.c.
+#ifdef MCLIB_INLINE_MATH
+#include "vec_inline.h"
+#else
+vec3  qtransform(quat q, vec3 v);
 
 vec3b v3b(byte r, byte g, byte b);
 vec4b v4b(byte r, byte g, byte b, byte a);
@@ -253,18 +259,7 @@ float v2dot(vec2 a, vec2 b);
 vec2  v2had(vec2 a, vec2 b);
 float v2cross(vec2 a, vec2 b);
 vec2  v2perp(vec2 v);
-vec2  v2reflect(vec2 a, vec2 b);
-float v2angle(vec2 a, vec2 b);
-vec2  v2dir(float theta);
-vec2  v2rot(vec2 v, float theta);
 vec2  v2lerp(vec2 P, vec2 Q, float t);
-float v2line_dist(vec2 P, vec2 v, vec2 Q);
-float v2line_closest(vec2 P, vec2 v, vec2 Q, vec2* R_out);
-bool  v2line_line(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out, float* s_out);
-bool  v2ray_line(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out);
-bool  v2ray_ray(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out, float* s_out);
-bool  v2ray_seg(vec2 P, vec2 v, vec2 Q1, vec2 Q2, float* t_out);
-bool  v2seg_seg(vec2 P1, vec2 P2, vec2 Q1, vec2 Q2, vec2* out);
 vec2  v2f(float x, float y);
 vec3  v23(vec2 xy);
 vec4  v24(vec2 xy);
@@ -283,19 +278,54 @@ vec3  v3scale(vec3 a, float f);
 float v3dot(vec3 a, vec3 b);
 vec3  v3had(vec3 a, vec3 b);
 vec3  v3cross(vec3 a, vec3 b);
-vec3  v3perp(vec3 v);
-float v3angle(vec3 a, vec3 b);
-bool  v3line_plane(vec3 P, vec3 v, vec3 R, vec3 n, float* t_out);
-bool  v3ray_plane(vec3 P, vec3 v, vec3 R, vec3 n, float* t_out);
 vec3  v3f(float x, float y, float z);
 vec4  v34(vec3 xyz);
 vec4  p34(vec3 xyz);
 vec4  v34f(vec3 xyz, float w);
 
 vec4  v4f(float x, float y, float z, float w);
+#endif
+
+vec2  v2reflect(vec2 a, vec2 b);
+float v2angle(vec2 a, vec2 b);
+vec2  v2dir(float theta);
+vec2  v2rot(vec2 v, float theta);
+float v2line_dist(vec2 P, vec2 v, vec2 Q);
+float v2line_closest(vec2 P, vec2 v, vec2 Q, vec2* R_out);
+bool  v2line_line(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out, float* s_out);
+bool  v2ray_line(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out);
+bool  v2ray_ray(vec2 P, vec2 v, vec2 Q, vec2 u, float* t_out, float* s_out);
+bool  v2ray_seg(vec2 P, vec2 v, vec2 Q1, vec2 Q2, float* t_out);
+bool  v2seg_seg(vec2 P1, vec2 P2, vec2 Q1, vec2 Q2, vec2* out);
+
+vec3  v3perp(vec3 v);
+float v3angle(vec3 a, vec3 b);
+bool  v3line_plane(vec3 P, vec3 v, vec3 R, vec3 n, float* t_out);
+bool  v3ray_plane(vec3 P, vec3 v, vec3 R, vec3 n, float* t_out);
 
 //vec2  v2orbit(vec2 a, vec2 center, float theta);
 //vec3  v3reflect(vec3 v, vec3 axis);
 //vec3  v3rot(vec3 v, vec3 axis, float theta);
 
+// Typed arrays for point sets (Array_vec2 -> arr_v2_push_back, etc.)
+#include "array.h"
+
+#define con_type vec2
+#define con_prefix v2
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#define con_type vec3
+#define con_prefix v3
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#define con_type vec4
+#define con_prefix v4
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
 #endif
@@ -0,0 +1,241 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_VECTOR_INLINE_H_
+#define _MCLIB_VECTOR_INLINE_H_
+
+// Definitions for the trivial vector functions declared in vec.h.
+//
+// With MCLIB_INLINE_MATH defined, vec.h includes this file directly and every
+// function here becomes static inline, so calls fuse into the caller without
+// needing LTO. Otherwise vec.c includes it once to compile the regular
+// out-of-line versions. Definitions are ordered so callees come first.
+
+#include "vec.h"
+
+#include <math.h>
+
+#ifndef _math_fn
+# ifdef MCLIB_INLINE_MATH
+#  define _math_fn static inline
+# else
+#  define _math_fn
+# endif
+#endif
+
+_math_fn vec2 v2f(float x, float y) {
+  return (vec2){.f = {x, y} };
+}
+
+// Constructs a vec3 out of floats.
+// Generally would prefer to use the form "(vec3){x, y, z}", but gcc is annoying
+// about that syntax, throwing -Wmissing-braces because it actaully wants the
+// form "(vec3){ .f = {x, y, z}}", which is annoying to type, so here we are.
+_math_fn vec3 v3f(float x, float y, float z) {
+  return (vec3){.f = {x, y, z} };
+}
+
+_math_fn vec4 v4f(float x, float y, float z, float w) {
+  return (vec4){ .f = {x, y, z, w} };
+}
+
+_math_fn vec3b v3b(byte r, byte g, byte b) {
+  return (vec3b){.i={r, g, b}};
+}
+
+_math_fn vec4b v4b(byte r, byte g, byte b, byte a) {
+  return (vec4b){.i={r, g, b, a}};
+}
+
+_math_fn float i2aspect(vec2i v) {
+  return (float)v.w / (float)v.h;
+}
+
+_math_fn vec2i v2i(int x, int y) {
+  return (vec2i){.i={x, y}};
+}
+
+_math_fn vec3i v3i(int x, int y, int z) {
+  return (vec3i){.i={x, y, z}};
+}
+
+_math_fn float v2magsq(vec2 v) {
+  return v.x * v.x + v.y * v.y;
+}
+
+_math_fn float v2mag(vec2 v) {
+  return sqrtf(v2magsq(v));
+}
+
+_math_fn vec2 v2neg(vec2 v) {
+  return v2f(-v.x, -v.y);
+}
+
+_math_fn vec2 v2add(vec2 a, vec2 b) {
+  return v2f(a.x + b.x, a.y + b.y);
+}
+
+_math_fn vec2 v2sub(vec2 a, vec2 b) {
+  return v2f(a.x - b.x, a.y - b.y);
+}
+
+_math_fn vec2 v2scale(vec2 v, float f) {
+  return v2f(v.x * f, v.y * f);
+}
+
+_math_fn float v2dot(vec2 a, vec2 b) {
+  return a.x * b.x + a.y * b.y;
+}
+
+_math_fn vec2 v2had(vec2 a, vec2 b) {
+  return v2f(a.x * b.x, a.y * b.y);
+}
+
+_math_fn float v2cross(vec2 a, vec2 b) {
+  return a.x * b.y - a.y * b.x;
+}
+
+_math_fn vec2 v2perp(vec2 v) {
+  return v2f(-v.y, v.x);
+}
+
+_math_fn float v2distsq(vec2 P, vec2 Q) {
+  return v2magsq(v2sub(Q, P));
+}
+
+_math_fn float v2dist(vec2 P, vec2 Q) {
+  return sqrtf(v2distsq(P, Q));
+}
+
+_math_fn vec2 v2norm(vec2 v) {
+  float mag = v2mag(v);
+  return v2f(v.x / mag, v.y / mag);
+}
+
+_math_fn vec2 v2lerp(vec2 P, vec2 Q, float t) {
+  vec2 v = v2scale(v2sub(Q, P), t);
+  return v2add(P, v);
+}
+
+_math_fn vec3 v23(vec2 v) {
+  return v3f(v.x, v.y, 0);
+}
+
+_math_fn vec4 v24(vec2 v) {
+  return v4f(v.x, v.y, 0, 0);
+}
+
+_math_fn vec4 p24(vec2 v) {
+  return v4f(v.x, v.y, 0, 1);
+}
+
+_math_fn vec3 v23f(vec2 v, float z) {
+  return v3f(v.x, v.y, z);
+}
+
+_math_fn vec4 v24f(vec2 v, float z, float w) {
+  return v4f(v.x, v.y, z, w);
+}
+
+_math_fn vec4 p24f(vec2 v, float z) {
+  return v4f(v.x, v.y, z, 1);
+}
+
+_math_fn float v3magsq(vec3 v) {
+  return v.x * v.x + v.y * v.y + v.z * v.z;
+}
+
+_math_fn float v3mag(vec3 v) {
+  return sqrtf(v3magsq(v));
+}
+
+_math_fn vec3 v3norm(vec3 v) {
+  float mag = v3mag(v);
+  return v3f( v.x / mag, v.y / mag, v.z / mag );
+}
+
+_math_fn vec3 v3neg(vec3 v) {
+  return v3f( -v.x, -v.y, -v.z );
+}
+
+_math_fn vec3 v3add(vec3 a, vec3 b) {
+  return v3f( a.x + b.x, a.y + b.y, a.z + b.z );
+}
+
+_math_fn vec3 v3sub(vec3 a, vec3 b) {
+  return v3f( a.x - b.x, a.y - b.y, a.z - b.z );
+}
+
+_math_fn vec3 v3scale(vec3 a, float f) {
+  return v3f( a.x * f, a.y * f, a.z * f );
+}
+
+_math_fn float v3dot(vec3 a, vec3 b) {
+  return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+_math_fn vec3 v3had(vec3 a, vec3 b) {
+  return v3f( a.x * b.x, a.y * b.y, a.z * b.z );
+}
+
+_math_fn vec3 v3cross(vec3 a, vec3 b) {
+  return v3f(
+    a.y * b.z - a.z * b.y,
+    a.z * b.x - a.x * b.z,
+    a.x * b.y - a.y * b.x
+  );
+}
+
+// Converts a vec3 to a vec4 with homogeneous w component set to 0
+_math_fn vec4 v34(vec3 v) {
+  return v4f(v.x, v.y, v.z, 0);
+}
+
+// Converts a vec3 to a vec4 with homogeneous w component set to 1
+_math_fn vec4 p34(vec3 p) {
+  return v4f(p.x, p.y, p.z, 1);
+}
+
+// Converts a vec3 and a given float w to a vec4
+_math_fn vec4 v34f(vec3 v, float w) {
+  return v4f(v.x, v.y, v.z, w);
+}
+
+// Based on community post from:
+// https://community.khronos.org/t/quaternion-functions-for-glsl/50140/2
+_math_fn vec3 qtransform(quat q, vec3 v) {
+  return v3add(
+    v, v3scale(
+      v3cross(
+        v3add(v3cross(v, q.ijk), v3scale(v, q.w)),
+        q.ijk
+      )
+    , 2)
+  );
+  //return v + 2.0*cross(cross(v, q.xyz ) + q.w*v, q.xyz);
+}
+
+#undef _math_fn
+
+#endif
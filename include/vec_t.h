@@ -0,0 +1,633 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// No include guard - this header is a template, see below.
+
+// In order to define vector and matrix types over a scalar type other than
+// float, include or re-include this header after #defining vec_scalar with the
+// component type and vec_prefix with the prefix for the generated names.
+//
+// The following hooks are optional and default to the built-in operators,
+// which is what floating point types want. Fixed point types must set them.
+//
+// #define vec_scalar T
+// #define vec_prefix p
+// #define vec_one         // 1 in the scalar's representation (default 1)
+// #define vec_add(a, b)   // sum of two scalars
+// #define vec_sub(a, b)   // difference of two scalars
+// #define vec_neg(a)      // negation of a scalar
+// #define vec_mul(a, b)   // product of two scalars
+// #define vec_div(a, b)   // quotient of two scalars
+// #define vec_sqrt(a)     // square root of a scalar
+// #define vec_from_float  // float -> scalar conversion
+// #define vec_to_float    // scalar -> float conversion
+// #define vec_simd_double // enables SSE2/AVX paths, only valid for double
+// #include "vec_t.h"
+//
+// When defined, the following will be created (inline, with no overhead):
+//
+// // Types (with the same x/y/z/w, r/g/b/a aliases as the float versions,
+// // component arrays are named e and matrices have e, m[4][4] and col[4])
+// pvec2, pvec3, pvec4, pmat4
+//
+// // Construction and conversion to and from the float types
+// pvec2    pv2(T x, T y);           pvec2  pv2from(vec2);  vec2  pv2tof(pvec2);
+// pvec3    pv3(T x, T y, T z);      pvec3  pv3from(vec3);  vec3  pv3tof(pvec3);
+// pvec4    pv4(T x, T y, T z, T w); pvec4  pv4from(vec4);  vec4  pv4tof(pvec4);
+// pmat4    pm4from(mat4);           mat4   pm4tof(pmat4);
+//
+// // Vector functions, for N in 2, 3, 4
+// pvecN    pvNadd, pvNsub, pvNhad, pvNneg, pvNnorm,
+//          pvNscale(pvecN, T), pvNlerp(pvecN, pvecN, T)
+// T        pvNdot, pvNmag, pvNmagsq, pvNdist, pvNdistsq
+// T        pv2cross(pvec2, pvec2);  pvec2 pv2perp(pvec2);
+// pvec3    pv3cross(pvec3, pvec3);
+//
+// // Matrix functions
+// pmat4    pm4identity(void);
+// pmat4    pm4translation(pvec3);
+// pmat4    pm4scalar(pvec3);
+// pmat4    pm4uniform(T);
+// pmat4    pm4transpose(pmat4);
+// pmat4    pm4mul(pmat4, pmat4);
+// pvec4    pmv4mul(pmat4, pvec4);
+//
+
+#ifdef vec_scalar
+
+#include <math.h>
+
+#include "mat.h"
+
+#ifndef vec_prefix
+# error "vec_t.h requires vec_prefix to be defined along with vec_scalar"
+#endif
+
+#ifndef vec_one
+# define vec_one 1
+# define _vt_undef_one
+#endif
+
+#ifndef vec_add
+# define vec_add(a, b) ((a) + (b))
+# define _vt_undef_add
+#endif
+
+#ifndef vec_sub
+# define vec_sub(a, b) ((a) - (b))
+# define _vt_undef_sub
+#endif
+
+#ifndef vec_neg
+# define vec_neg(a) (-(a))
+# define _vt_undef_neg
+#endif
+
+#ifndef vec_mul
+# define vec_mul(a, b) ((a) * (b))
+# define _vt_undef_mul
+#endif
+
+#ifndef vec_div
+# define vec_div(a, b) ((a) / (b))
+# define _vt_undef_div
+#endif
+
+#ifndef vec_sqrt
+# define vec_sqrt(a) ((vec_scalar)sqrt((double)(a)))
+# define _vt_undef_sqrt
+#endif
+
+#ifndef vec_from_float
+# define vec_from_float(f) ((vec_scalar)(f))
+# define _vt_undef_from_float
+#endif
+
+#ifndef vec_to_float
+# define vec_to_float(s) ((float)(s))
+# define _vt_undef_to_float
+#endif
+
+#if defined(vec_simd_double) \
+  && (defined(__SSE2__) || defined(_M_X64) || defined(__AVX__))
+# define _vt_simd
+# ifdef __AVX__
+#  include <immintrin.h>
+# else
+#  include <emmintrin.h>
+# endif
+#endif
+
+#define _vt_name(NAME) MACRO_CONCAT(vec_prefix, NAME)
+#define _vt_vec2 _vt_name(vec2)
+#define _vt_vec3 _vt_name(vec3)
+#define _vt_vec4 _vt_name(vec4)
+#define _vt_mat4 _vt_name(mat4)
+#define _vt_T vec_scalar
+
+// m4identity is a macro in mat.h, so build the name in two steps to keep it
+//    from expanding
+#define _vt_m4identity MACRO_CONCAT(_vt_name(m4), identity)
+
+typedef struct {
+  union {
+    _vt_T e[2];
+    struct {
+      union { _vt_T x; _vt_T w; _vt_T u; };
+      union { _vt_T y; _vt_T h; _vt_T v; };
+    };
+  };
+} _vt_vec2;
+
+typedef struct {
+  union {
+    _vt_T e[3];
+    struct {
+      union {        _vt_T r; _vt_T u; };
+      union { _vt_T y; _vt_T g; _vt_T v; };
+      union { _vt_T z; _vt_T b; _vt_T w; };
+    };
+    struct {
+      _vt_T x;
+      _vt_vec2 yz;
+    };
+    _vt_vec2 xy;
+  };
+} _vt_vec3;
+
+typedef struct {
+  union {
+    _vt_T e[4];
+    struct {
+      union {          _vt_T r; };
+      union { _vt_T y; _vt_T g; };
+      union { _vt_T z; _vt_T b; };
+      union { _vt_T w; _vt_T a; };
+    };
+    struct {
+      _vt_T x;
+      union {
+        _vt_vec3 yzw;
+        _vt_vec2 yz;
+      };
+    };
+    struct {
+      _vt_vec2 xy;
+      _vt_vec2 zw;
+    };
+    _vt_vec3 xyz;
+    _vt_vec3 rgb;
+  };
+} _vt_vec4;
+
+typedef struct {
+  union {
+    _vt_T e[16];
+    _vt_T m[4][4];
+    _vt_vec4 col[4];
+  };
+} _vt_mat4;
+
+////////////////////////////////////////////////////////////////////////////////
+// Construction and conversion
+////////////////////////////////////////////////////////////////////////////////
+
+static inline _vt_vec2 _vt_name(v2)(_vt_T x, _vt_T y) {
+  return (_vt_vec2){.e={ x, y }};
+}
+
+static inline _vt_vec3 _vt_name(v3)(_vt_T x, _vt_T y, _vt_T z) {
+  return (_vt_vec3){.e={ x, y, z }};
+}
+
+static inline _vt_vec4 _vt_name(v4)(_vt_T x, _vt_T y, _vt_T z, _vt_T w) {
+  return (_vt_vec4){.e={ x, y, z, w }};
+}
+
+static inline _vt_vec2 _vt_name(v2from)(vec2 v) {
+  return _vt_name(v2)(vec_from_float(v.x), vec_from_float(v.y));
+}
+
+static inline _vt_vec3 _vt_name(v3from)(vec3 v) {
+  return _vt_name(v3)(
+    vec_from_float(v.x), vec_from_float(v.y), vec_from_float(v.z)
+  );
+}
+
+static inline _vt_vec4 _vt_name(v4from)(vec4 v) {
+  return _vt_name(v4)(
+    vec_from_float(v.x), vec_from_float(v.y),
+    vec_from_float(v.z), vec_from_float(v.w)
+  );
+}
+
+static inline vec2 _vt_name(v2tof)(_vt_vec2 v) {
+  return (vec2){.f={ vec_to_float(v.x), vec_to_float(v.y) }};
+}
+
+static inline vec3 _vt_name(v3tof)(_vt_vec3 v) {
+  return (vec3){.f={
+    vec_to_float(v.x), vec_to_float(v.y), vec_to_float(v.z)
+  }};
+}
+
+static inline vec4 _vt_name(v4tof)(_vt_vec4 v) {
+  return (vec4){.f={
+    vec_to_float(v.x), vec_to_float(v.y), vec_to_float(v.z), vec_to_float(v.w)
+  }};
+}
+
+static inline _vt_mat4 _vt_name(m4from)(mat4 m) {
+  _vt_mat4 ret;
+  for (int i = 0; i < 16; ++i) ret.e[i] = vec_from_float(m.f[i]);
+  return ret;
+}
+
+static inline mat4 _vt_name(m4tof)(_vt_mat4 m) {
+  mat4 ret;
+  for (int i = 0; i < 16; ++i) ret.f[i] = vec_to_float(m.e[i]);
+  return ret;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// vec2
+////////////////////////////////////////////////////////////////////////////////
+
+static inline _vt_vec2 _vt_name(v2add)(_vt_vec2 a, _vt_vec2 b) {
+  return _vt_name(v2)(vec_add(a.x, b.x), vec_add(a.y, b.y));
+}
+
+static inline _vt_vec2 _vt_name(v2sub)(_vt_vec2 a, _vt_vec2 b) {
+  return _vt_name(v2)(vec_sub(a.x, b.x), vec_sub(a.y, b.y));
+}
+
+static inline _vt_vec2 _vt_name(v2neg)(_vt_vec2 v) {
+  return _vt_name(v2)(vec_neg(v.x), vec_neg(v.y));
+}
+
+static inline _vt_vec2 _vt_name(v2scale)(_vt_vec2 v, _vt_T s) {
+  return _vt_name(v2)(vec_mul(v.x, s), vec_mul(v.y, s));
+}
+
+static inline _vt_vec2 _vt_name(v2had)(_vt_vec2 a, _vt_vec2 b) {
+  return _vt_name(v2)(vec_mul(a.x, b.x), vec_mul(a.y, b.y));
+}
+
+static inline _vt_T _vt_name(v2dot)(_vt_vec2 a, _vt_vec2 b) {
+  return vec_add(vec_mul(a.x, b.x), vec_mul(a.y, b.y));
+}
+
+static inline _vt_T _vt_name(v2cross)(_vt_vec2 a, _vt_vec2 b) {
+  return vec_sub(vec_mul(a.x, b.y), vec_mul(a.y, b.x));
+}
+
+static inline _vt_vec2 _vt_name(v2perp)(_vt_vec2 v) {
+  return _vt_name(v2)(vec_neg(v.y), v.x);
+}
+
+static inline _vt_T _vt_name(v2magsq)(_vt_vec2 v) {
+  return _vt_name(v2dot)(v, v);
+}
+
+static inline _vt_T _vt_name(v2mag)(_vt_vec2 v) {
+  return vec_sqrt(_vt_name(v2magsq)(v));
+}
+
+static inline _vt_vec2 _vt_name(v2norm)(_vt_vec2 v) {
+  _vt_T mag = _vt_name(v2mag)(v);
+  return _vt_name(v2)(vec_div(v.x, mag), vec_div(v.y, mag));
+}
+
+static inline _vt_T _vt_name(v2distsq)(_vt_vec2 P, _vt_vec2 Q) {
+  return _vt_name(v2magsq)(_vt_name(v2sub)(Q, P));
+}
+
+static inline _vt_T _vt_name(v2dist)(_vt_vec2 P, _vt_vec2 Q) {
+  return vec_sqrt(_vt_name(v2distsq)(P, Q));
+}
+
+static inline _vt_vec2 _vt_name(v2lerp)(_vt_vec2 P, _vt_vec2 Q, _vt_T t) {
+  return _vt_name(v2add)(P, _vt_name(v2scale)(_vt_name(v2sub)(Q, P), t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// vec3
+////////////////////////////////////////////////////////////////////////////////
+
+static inline _vt_vec3 _vt_name(v3add)(_vt_vec3 a, _vt_vec3 b) {
+  return _vt_name(v3)(
+    vec_add(a.x, b.x), vec_add(a.y, b.y), vec_add(a.z, b.z)
+  );
+}
+
+static inline _vt_vec3 _vt_name(v3sub)(_vt_vec3 a, _vt_vec3 b) {
+  return _vt_name(v3)(
+    vec_sub(a.x, b.x), vec_sub(a.y, b.y), vec_sub(a.z, b.z)
+  );
+}
+
+static inline _vt_vec3 _vt_name(v3neg)(_vt_vec3 v) {
+  return _vt_name(v3)(vec_neg(v.x), vec_neg(v.y), vec_neg(v.z));
+}
+
+static inline _vt_vec3 _vt_name(v3scale)(_vt_vec3 v, _vt_T s) {
+  return _vt_name(v3)(vec_mul(v.x, s), vec_mul(v.y, s), vec_mul(v.z, s));
+}
+
+static inline _vt_vec3 _vt_name(v3had)(_vt_vec3 a, _vt_vec3 b) {
+  return _vt_name(v3)(vec_mul(a.x, b.x), vec_mul(a.y, b.y), vec_mul(a.z, b.z));
+}
+
+static inline _vt_T _vt_name(v3dot)(_vt_vec3 a, _vt_vec3 b) {
+  return vec_add(vec_add(vec_mul(a.x, b.x), vec_mul(a.y, b.y)),
+    vec_mul(a.z, b.z)
+  );
+}
+
+static inline _vt_vec3 _vt_name(v3cross)(_vt_vec3 a, _vt_vec3 b) {
+  return _vt_name(v3)(
+    vec_sub(vec_mul(a.y, b.z), vec_mul(a.z, b.y)),
+    vec_sub(vec_mul(a.z, b.x), vec_mul(a.x, b.z)),
+    vec_sub(vec_mul(a.x, b.y), vec_mul(a.y, b.x))
+  );
+}
+
+static inline _vt_T _vt_name(v3magsq)(_vt_vec3 v) {
+  return _vt_name(v3dot)(v, v);
+}
+
+static inline _vt_T _vt_name(v3mag)(_vt_vec3 v) {
+  return vec_sqrt(_vt_name(v3magsq)(v));
+}
+
+static inline _vt_vec3 _vt_name(v3norm)(_vt_vec3 v) {
+  _vt_T mag = _vt_name(v3mag)(v);
+  return _vt_name(v3)(vec_div(v.x, mag), vec_div(v.y, mag), vec_div(v.z, mag));
+}
+
+static inline _vt_T _vt_name(v3distsq)(_vt_vec3 P, _vt_vec3 Q) {
+  return _vt_name(v3magsq)(_vt_name(v3sub)(Q, P));
+}
+
+static inline _vt_T _vt_name(v3dist)(_vt_vec3 P, _vt_vec3 Q) {
+  return vec_sqrt(_vt_name(v3distsq)(P, Q));
+}
+
+static inline _vt_vec3 _vt_name(v3lerp)(_vt_vec3 P, _vt_vec3 Q, _vt_T t) {
+  return _vt_name(v3add)(P, _vt_name(v3scale)(_vt_name(v3sub)(Q, P), t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// vec4
+////////////////////////////////////////////////////////////////////////////////
+
+static inline _vt_vec4 _vt_name(v4add)(_vt_vec4 a, _vt_vec4 b) {
+  return _vt_name(v4)(
+    vec_add(a.x, b.x), vec_add(a.y, b.y), vec_add(a.z, b.z), vec_add(a.w, b.w)
+  );
+}
+
+static inline _vt_vec4 _vt_name(v4sub)(_vt_vec4 a, _vt_vec4 b) {
+  return _vt_name(v4)(
+    vec_sub(a.x, b.x), vec_sub(a.y, b.y), vec_sub(a.z, b.z), vec_sub(a.w, b.w)
+  );
+}
+
+static inline _vt_vec4 _vt_name(v4neg)(_vt_vec4 v) {
+  return _vt_name(v4)(
+    vec_neg(v.x), vec_neg(v.y), vec_neg(v.z), vec_neg(v.w)
+  );
+}
+
+static inline _vt_vec4 _vt_name(v4scale)(_vt_vec4 v, _vt_T s) {
+  return _vt_name(v4)(
+    vec_mul(v.x, s), vec_mul(v.y, s), vec_mul(v.z, s), vec_mul(v.w, s)
+  );
+}
+
+static inline _vt_vec4 _vt_name(v4had)(_vt_vec4 a, _vt_vec4 b) {
+  return _vt_name(v4)(
+    vec_mul(a.x, b.x), vec_mul(a.y, b.y), vec_mul(a.z, b.z), vec_mul(a.w, b.w)
+  );
+}
+
+static inline _vt_T _vt_name(v4dot)(_vt_vec4 a, _vt_vec4 b) {
+  return vec_add(vec_add(vec_add(vec_mul(a.x, b.x), vec_mul(a.y, b.y)),
+    vec_mul(a.z, b.z)), vec_mul(a.w, b.w)
+  );
+}
+
+static inline _vt_T _vt_name(v4magsq)(_vt_vec4 v) {
+  return _vt_name(v4dot)(v, v);
+}
+
+static inline _vt_T _vt_name(v4mag)(_vt_vec4 v) {
+  return vec_sqrt(_vt_name(v4magsq)(v));
+}
+
+static inline _vt_vec4 _vt_name(v4norm)(_vt_vec4 v) {
+  _vt_T mag = _vt_name(v4mag)(v);
+  return _vt_name(v4)(
+    vec_div(v.x, mag), vec_div(v.y, mag), vec_div(v.z, mag), vec_div(v.w, mag)
+  );
+}
+
+static inline _vt_T _vt_name(v4distsq)(_vt_vec4 P, _vt_vec4 Q) {
+  return _vt_name(v4magsq)(_vt_name(v4sub)(Q, P));
+}
+
+static inline _vt_T _vt_name(v4dist)(_vt_vec4 P, _vt_vec4 Q) {
+  return vec_sqrt(_vt_name(v4distsq)(P, Q));
+}
+
+static inline _vt_vec4 _vt_name(v4lerp)(_vt_vec4 P, _vt_vec4 Q, _vt_T t) {
+  return _vt_name(v4add)(P, _vt_name(v4scale)(_vt_name(v4sub)(Q, P), t));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// mat4
+////////////////////////////////////////////////////////////////////////////////
+
+static inline _vt_mat4 _vt_m4identity(void) {
+  _vt_mat4 ret = {.e={ 0 }};
+  ret.m[0][0] = ret.m[1][1] = ret.m[2][2] = ret.m[3][3] = vec_one;
+  return ret;
+}
+
+static inline _vt_mat4 _vt_name(m4translation)(_vt_vec3 v) {
+  _vt_mat4 ret = _vt_m4identity();
+  ret.col[3].xyz = v;
+  return ret;
+}
+
+static inline _vt_mat4 _vt_name(m4scalar)(_vt_vec3 v) {
+  _vt_mat4 ret = _vt_m4identity();
+  ret.m[0][0] = v.x;
+  ret.m[1][1] = v.y;
+  ret.m[2][2] = v.z;
+  return ret;
+}
+
+static inline _vt_mat4 _vt_name(m4uniform)(_vt_T s) {
+  return _vt_name(m4scalar)(_vt_name(v3)(s, s, s));
+}
+
+static inline _vt_mat4 _vt_name(m4transpose)(_vt_mat4 m) {
+  _vt_mat4 ret;
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) {
+      ret.m[x][y] = m.m[y][x];
+    }
+  }
+  return ret;
+}
+
+// Same layout and semantics as m4mul: column x of the result is the sum of the
+//    columns of a weighted by column x of b.
+static inline _vt_mat4 _vt_name(m4mul)(_vt_mat4 a, _vt_mat4 b) {
+  _vt_mat4 ret;
+#if defined(_vt_simd) && defined(__AVX__)
+  for (int x = 0; x < 4; ++x) {
+    __m256d sum = _mm256_mul_pd(
+      _mm256_loadu_pd(a.m[0]), _mm256_set1_pd(b.m[x][0]));
+    for (int i = 1; i < 4; ++i) {
+      __m256d col = _mm256_loadu_pd(a.m[i]);
+      sum = _mm256_add_pd(sum, _mm256_mul_pd(col, _mm256_set1_pd(b.m[x][i])));
+    }
+    _mm256_storeu_pd(ret.m[x], sum);
+  }
+#elif defined(_vt_simd)
+  for (int x = 0; x < 4; ++x) {
+    __m128d s = _mm_set1_pd(b.m[x][0]);
+    __m128d lo = _mm_mul_pd(_mm_loadu_pd(a.m[0]), s);
+    __m128d hi = _mm_mul_pd(_mm_loadu_pd(a.m[0] + 2), s);
+    for (int i = 1; i < 4; ++i) {
+      s = _mm_set1_pd(b.m[x][i]);
+      lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(a.m[i]), s));
+      hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(a.m[i] + 2), s));
+    }
+    _mm_storeu_pd(ret.m[x], lo);
+    _mm_storeu_pd(ret.m[x] + 2, hi);
+  }
+#else
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) {
+      _vt_T sum = vec_mul(a.m[0][y], b.m[x][0]);
+      for (int i = 1; i < 4; ++i) {
+        sum = vec_add(sum, vec_mul(a.m[i][y], b.m[x][i]));
+      }
+      ret.m[x][y] = sum;
+    }
+  }
+#endif
+  return ret;
+}
+
+static inline _vt_vec4 _vt_name(mv4mul)(_vt_mat4 m, _vt_vec4 v) {
+  _vt_vec4 ret;
+#if defined(_vt_simd) && defined(__AVX__)
+  __m256d sum = _mm256_mul_pd(_mm256_loadu_pd(m.m[0]), _mm256_set1_pd(v.e[0]));
+  for (int x = 1; x < 4; ++x) {
+    __m256d col = _mm256_loadu_pd(m.m[x]);
+    sum = _mm256_add_pd(sum, _mm256_mul_pd(col, _mm256_set1_pd(v.e[x])));
+  }
+  _mm256_storeu_pd(ret.e, sum);
+#elif defined(_vt_simd)
+  __m128d s = _mm_set1_pd(v.e[0]);
+  __m128d lo = _mm_mul_pd(_mm_loadu_pd(m.m[0]), s);
+  __m128d hi = _mm_mul_pd(_mm_loadu_pd(m.m[0] + 2), s);
+  for (int x = 1; x < 4; ++x) {
+    s = _mm_set1_pd(v.e[x]);
+    lo = _mm_add_pd(lo, _mm_mul_pd(_mm_loadu_pd(m.m[x]), s));
+    hi = _mm_add_pd(hi, _mm_mul_pd(_mm_loadu_pd(m.m[x] + 2), s));
+  }
+  _mm_storeu_pd(ret.e, lo);
+  _mm_storeu_pd(ret.e + 2, hi);
+#else
+  for (int y = 0; y < 4; ++y) {
+    _vt_T sum = vec_mul(m.m[0][y], v.e[0]);
+    for (int x = 1; x < 4; ++x) {
+      sum = vec_add(sum, vec_mul(m.m[x][y], v.e[x]));
+    }
+    ret.e[y] = sum;
+  }
+#endif
+  return ret;
+}
+
+#undef _vt_m4identity
+#undef _vt_T
+#undef _vt_mat4
+#undef _vt_vec4
+#undef _vt_vec3
+#undef _vt_vec2
+#undef _vt_name
+#undef _vt_simd
+
+#ifdef _vt_undef_one
+# undef vec_one
+# undef _vt_undef_one
+#endif
+
+#ifdef _vt_undef_add
+# undef vec_add
+# undef _vt_undef_add
+#endif
+
+#ifdef _vt_undef_sub
+# undef vec_sub
+# undef _vt_undef_sub
+#endif
+
+#ifdef _vt_undef_neg
+# undef vec_neg
+# undef _vt_undef_neg
+#endif
+
+#ifdef _vt_undef_mul
+# undef vec_mul
+# undef _vt_undef_mul
+#endif
+
+#ifdef _vt_undef_div
+# undef vec_div
+# undef _vt_undef_div
+#endif
+
+#ifdef _vt_undef_sqrt
+# undef vec_sqrt
+# undef _vt_undef_sqrt
+#endif
+
+#ifdef _vt_undef_from_float
+# undef vec_from_float
+# undef _vt_undef_from_float
+#endif
+
+#ifdef _vt_undef_to_float
+# undef vec_to_float
+# undef _vt_undef_to_float
+#endif
+
+#endif
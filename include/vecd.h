@@ -0,0 +1,46 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_VECTOR_DOUBLE_H_
+#define _MCLIB_VECTOR_DOUBLE_H_
+
+#include <math.h>
+
+#include "mat.h"
+
+// Double precision vectors and matrices for large worlds, where float loses
+// precision far from the origin. See vec_t.h for the full list of generated
+// types and functions, ex: dvec3, dv3add, dv3from(vec3), dm4mul, dmv4mul.
+
+#define vec_scalar double
+#define vec_prefix d
+#define vec_sqrt sqrt
+#define vec_simd_double
+#include "vec_t.h"
+#undef vec_scalar
+#undef vec_prefix
+#undef vec_sqrt
+#undef vec_simd_double
+
+#endif
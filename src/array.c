@@ -29,6 +29,9 @@
 #include <string.h>
 
 #include "types.h"
+#include "memstats.h"
+#include "trace.h"
+#include "utility.h"
 
 // internal opaque structure:
 typedef struct Array_Internal {
@@ -40,6 +43,7 @@ typedef struct Array_Internal {
 
   // private
   byte* data;
+  bool view;                  // data isn't owned and can't be resized
 } Array_Internal;
 
 #define DARRAY_STARTING_SIZE 2
@@ -56,7 +60,7 @@ typedef struct Array_Internal {
   const Array_Internal* a = (const Array_Internal*)(a_in)
 
 Array _array_new_(index_s element_size) {
-  Array_Internal* ret = malloc(sizeof(Array_Internal));
+  Array_Internal* ret = mem_malloc(sizeof(Array_Internal));
   assert(ret);
   *ret = (Array_Internal) {
     .element_size = element_size,
@@ -69,14 +73,33 @@ Array _array_new_(index_s element_size) {
 }
 
 Array _array_new_reserve_(index_s element_size, index_s capacity) {
-  Array_Internal* ret = malloc(sizeof(Array_Internal));
+  Array_Internal* ret = mem_malloc(sizeof(Array_Internal));
   assert(ret);
   *ret = (Array_Internal) {
     .element_size = element_size,
     .capacity = capacity,
     .size = 0,
     .size_bytes = 0,
-    .data = malloc(element_size * capacity),
+    .data = mem_malloc(element_size * capacity),
+  };
+  return (Array)ret;
+}
+
+// A view presents existing memory (like a mapped file) as a fixed-size Array.
+//    Elements can be read and overwritten in place if the memory allows it,
+//    but anything that would reallocate is an error. Deleting the view leaves
+//    the memory alone.
+Array _array_view_(index_s element_size, const void* data, index_s count) {
+  assert(data || !count);
+  Array_Internal* ret = mem_malloc(sizeof(Array_Internal));
+  assert(ret);
+  *ret = (Array_Internal) {
+    .element_size = element_size,
+    .capacity = count,
+    .size = count,
+    .size_bytes = count * element_size,
+    .data = (byte*)data,
+    .view = true,
   };
   return (Array)ret;
 }
@@ -84,7 +107,10 @@ Array _array_new_reserve_(index_s element_size, index_s capacity) {
 void array_reserve(Array a_in, index_s capacity) {
   DARRAY_INTERNAL;
   if (!a || a->size >= capacity) return;
-  void* new_data = realloc(a->data, a->element_size * capacity);
+  assert(!a->view);
+  TRACE_BEGIN("array_reserve");
+  void* new_data = mem_realloc(a->data, a->element_size * capacity);
+  TRACE_END();
   assert(new_data); // TODO: better handling of critical memory situations
   a->data = new_data;
   a->capacity = capacity;
@@ -93,7 +119,8 @@ void array_reserve(Array a_in, index_s capacity) {
 void array_truncate(Array a_in, index_s max_size) {
   DARRAY_INTERNAL;
   if (!a || a->capacity < max_size) return;
-  void* new_data = realloc(a->data, a->element_size * max_size);
+  assert(!a->view);
+  void* new_data = mem_realloc(a->data, a->element_size * max_size);
   if (!new_data) return;
   a->data = new_data;
   a->capacity = max_size;
@@ -114,7 +141,7 @@ void array_free(Array a_in) {
   DARRAY_INTERNAL;
   if (!a->data) return;
   array_clear(a_in);
-  free(a->data);
+  if (!a->view) mem_free(a->data);
   a->capacity = 0;
   a->data = NULL;
 }
@@ -122,16 +149,18 @@ void array_free(Array a_in) {
 void array_delete(Array* a_in) {
   if (!a_in || !*a_in) return;
   Array_Internal* a = (Array_Internal*)*a_in;
-  free(a->data);
-  free(a);
+  if (!a->view) mem_free(a->data);
+  mem_free(a);
   *a_in = NULL;
 }
 
 void* array_release(Array* a_in) {
   if (!a_in || !*a_in) return NULL;
   Array_Internal* a = (Array_Internal*)*a_in;
+  assert(!a->view);
   void* ret = a->data;
-  free(a);
+  mem_disown(ret); // the caller owns the buffer now
+  mem_free(a);
   *a_in = NULL;
   return ret;
 }
@@ -232,10 +261,10 @@ index_s array_remove_range(Array a_in, index_s position, index_s count) {
   }
   byte* pos = a->data + position * a->element_size;
   ptrdiff_t count_bytes = count * a->element_size;
-  ptrdiff_t remainder_size = (a->size - position + count) * a->element_size;
+  ptrdiff_t remainder_size = (a->size - position - count) * a->element_size;
   memmove(pos, pos + count_bytes, remainder_size);
   a->size -= count;
-  a->size_bytes = a->size * a->size_bytes;
+  a->size_bytes = a->size * a->element_size;
   return a->size;
 }
 
@@ -313,3 +342,8 @@ bool array_contains(const Array a_in, const void* element) {
   }
   return false;
 }
+
+void array_reverse(Array a_in) {
+  DARRAY_INTERNAL;
+  memrev_elements(a->data, a->element_size, a->size);
+}
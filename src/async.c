@@ -0,0 +1,705 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "async.h"
+#include "array.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Platform
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+# include <malloc.h>
+
+typedef HANDLE AsyncFd;
+# define ASYNC_NO_FD INVALID_HANDLE_VALUE
+
+static bool async_open(const char* path, AsyncFd* fd, index_s* size) {
+  *fd = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+    FILE_FLAG_SEQUENTIAL_SCAN, NULL
+  );
+  if (*fd == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(*fd, &file_size)) {
+    CloseHandle(*fd);
+    return false;
+  }
+
+  *size = (index_s)file_size.QuadPart;
+  return true;
+}
+
+static void async_close(AsyncFd fd) {
+  CloseHandle(fd);
+}
+
+static index_s async_pread(AsyncFd fd, char* buffer, index_s size, index_s at) {
+  unsigned long long offset = (unsigned long long)at;
+  OVERLAPPED overlapped = {
+    .Offset = (DWORD)(offset & 0xffffffff),
+    .OffsetHigh = (DWORD)(offset >> 32),
+  };
+  DWORD read = 0;
+  if (!ReadFile(fd, buffer, (DWORD)size, &read, &overlapped)) {
+    return GetLastError() == ERROR_HANDLE_EOF ? 0 : -1;
+  }
+  return (index_s)read;
+}
+
+static char* async_buffer_alloc(index_s size) {
+  return _aligned_malloc((size_t)size, 4096);
+}
+
+static void async_buffer_free(char* buffer) {
+  _aligned_free(buffer);
+}
+
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+typedef int AsyncFd;
+# define ASYNC_NO_FD -1
+
+static bool async_open(const char* path, AsyncFd* fd, index_s* size) {
+  *fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (*fd < 0) return false;
+
+  struct stat st;
+  if (fstat(*fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(*fd);
+    return false;
+  }
+
+  *size = (index_s)st.st_size;
+  return true;
+}
+
+static void async_close(AsyncFd fd) {
+  close(fd);
+}
+
+static index_s async_pread(AsyncFd fd, char* buffer, index_s size, index_s at) {
+  loop {
+    ssize_t got = pread(fd, buffer, (size_t)size, (off_t)at);
+    if (got >= 0) return (index_s)got;
+    until (errno != EINTR);
+  }
+  return -1;
+}
+
+static char* async_buffer_alloc(index_s size) {
+  return aligned_alloc(4096, (size_t)size);
+}
+
+static void async_buffer_free(char* buffer) {
+  free(buffer);
+}
+#endif
+
+// io_uring through raw system calls, so there's no liburing dependency
+#if defined(__linux__) && !defined(MCLIB_NO_URING) && defined(__has_include)
+# if __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <sys/uio.h>
+#  ifdef __NR_io_uring_setup
+#   define ASYNC_URING
+#  endif
+# endif
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Internal types
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  char* path;
+  AsyncReadFn fn;
+  void* data;
+  AsyncFd fd;
+  index_s size;
+  index_s scheduled;          // bytes handed to a slot so far
+  index_s outstanding;        // chunks in slots
+  bool opened;
+} AsyncFile;
+
+typedef enum {
+  SLOT_FREE,
+  SLOT_READING,               // io_uring read in flight
+  SLOT_JOB,                   // read and/or callback running on the pool
+} AsyncSlotState;
+
+typedef struct AsyncReader_Internal AsyncReader_Internal;
+
+typedef struct {
+  AsyncReader_Internal* reader;
+  AsyncFile* file;
+  char* buffer;
+  index_s offset;
+  index_s length;             // requested
+  index_s filled;             // read so far, -1 on error
+  AsyncSlotState state;
+  Job job;
+} AsyncSlot;
+
+#ifdef ASYNC_URING
+typedef struct {
+  int fd;
+  unsigned* sq_tail;
+  unsigned* sq_mask;
+  unsigned* sq_array;
+  unsigned* cq_head;
+  unsigned* cq_tail;
+  unsigned* cq_mask;
+  struct io_uring_sqe* sqes;
+  struct io_uring_cqe* cqes;
+  void* sq_ring;
+  void* cq_ring;
+  size_t sq_ring_size;
+  size_t cq_ring_size;
+  size_t sqes_size;
+  unsigned to_submit;
+  index_s in_flight;
+  bool fixed;                 // buffers are registered
+} AsyncUring;
+#endif
+
+// internal opaque structure:
+struct AsyncReader_Internal {
+  // public (read only)
+  index_s pending;
+  bool uring;
+
+  // private
+  JobPool pool;
+  AsyncSlot* slots;
+  index_s slot_count;
+  index_s buffer_size;
+  char* buffers;
+
+  Array files;                // AsyncFile*, queued in order
+  index_s next_file;          // first file with bytes left to schedule
+
+#ifdef ASYNC_URING
+  AsyncUring ring;
+#endif
+};
+
+#define ASYNCREADER_INTERNAL \
+  assert(reader_in); \
+  AsyncReader_Internal* reader = (AsyncReader_Internal*)(reader_in)
+
+////////////////////////////////////////////////////////////////////////////////
+// io_uring
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef ASYNC_URING
+
+static bool uring_init(AsyncUring* ring, AsyncSlot* slots, index_s count,
+  index_s buffer_size
+) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+
+  ring->fd = (int)syscall(__NR_io_uring_setup, (unsigned)count, &params);
+  if (ring->fd < 0) return false;
+
+  ring->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size = params.cq_off.cqes
+    + params.cq_entries * sizeof(struct io_uring_cqe);
+
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    ring->sq_ring_size = MAX(ring->sq_ring_size, ring->cq_ring_size);
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  ring->sq_ring = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING
+  );
+  ring->cq_ring = single_mmap ? ring->sq_ring : mmap(NULL, ring->cq_ring_size,
+    PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd,
+    IORING_OFF_CQ_RING
+  );
+  ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES
+  );
+
+  if (ring->sq_ring == MAP_FAILED || ring->cq_ring == MAP_FAILED
+    || ring->sqes == MAP_FAILED
+  ) {
+    if (ring->sq_ring != MAP_FAILED) munmap(ring->sq_ring, ring->sq_ring_size);
+    if (!single_mmap && ring->cq_ring != MAP_FAILED) {
+      munmap(ring->cq_ring, ring->cq_ring_size);
+    }
+    if (ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+    close(ring->fd);
+    return false;
+  }
+
+  byte* sq = ring->sq_ring;
+  byte* cq = ring->cq_ring;
+  ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+  ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+  ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+  ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+  ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  ring->to_submit = 0;
+  ring->in_flight = 0;
+
+  // registering can fail on the locked memory limit, plain reads still work
+  struct iovec* iovecs = malloc(count * sizeof(struct iovec));
+  assert(iovecs);
+  for (index_s i = 0; i < count; ++i) {
+    iovecs[i] = (struct iovec) { slots[i].buffer, (size_t)buffer_size };
+  }
+  ring->fixed = syscall(__NR_io_uring_register, ring->fd,
+    IORING_REGISTER_BUFFERS, iovecs, (unsigned)count) == 0;
+  free(iovecs);
+
+  return true;
+}
+
+static void uring_free(AsyncUring* ring) {
+  munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring != ring->sq_ring) munmap(ring->cq_ring, ring->cq_ring_size);
+  munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+}
+
+// queues a read of the rest of the slot's chunk
+static void uring_prep_read(AsyncUring* ring, AsyncSlot* slot, index_s index) {
+  unsigned tail = *ring->sq_tail;
+  unsigned entry = tail & *ring->sq_mask;
+  struct io_uring_sqe* sqe = &ring->sqes[entry];
+
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = ring->fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+  sqe->fd = slot->file->fd;
+  sqe->addr = (unsigned long long)(uintptr_t)(slot->buffer + slot->filled);
+  sqe->len = (unsigned)(slot->length - slot->filled);
+  sqe->off = (unsigned long long)(slot->offset + slot->filled);
+  sqe->buf_index = ring->fixed ? (unsigned short)index : 0;
+  sqe->user_data = (unsigned long long)index;
+
+  ring->sq_array[entry] = entry;
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ++ring->to_submit;
+  ++ring->in_flight;
+}
+
+// submits queued reads, and blocks for at least one completion if wait is set.
+//    Returns false if the ring failed and can't be used any more.
+static bool uring_enter(AsyncUring* ring, bool wait) {
+  unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+  unsigned submit = ring->to_submit;
+  if (!submit && !wait) return true;
+
+  loop {
+    long ret = syscall(__NR_io_uring_enter, ring->fd, submit,
+      wait ? 1u : 0u, flags, NULL, 0
+    );
+    if (ret >= 0) {
+      ring->to_submit -= (unsigned)ret;
+      return true;
+    }
+
+    // no room for more reads until completions are reaped: wait on the reads
+    //    already submitted, if any, and leave the rest for the next call
+    if (errno == EAGAIN || errno == EBUSY) {
+      bool submitted = ring->in_flight > (index_s)ring->to_submit;
+      if (!wait || !submit || !submitted) return true;
+      submit = 0;
+      continue;
+    }
+
+    until (errno != EINTR);
+  }
+
+  return false;
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+////////////////////////////////////////////////////////////////////////////////
+
+static void async_call(AsyncFile* file, index_s offset, const char* bytes,
+  index_s size, bool last, bool error
+) {
+  AsyncChunk chunk = {
+    .path = file->path,
+    .data = file->data,
+    .offset = offset,
+    .file_size = file->size,
+    .contents = str_range_s(bytes, size),
+    .last = last,
+    .error = error,
+  };
+  file->fn(&chunk);
+}
+
+static void async_slot_callback(AsyncSlot* slot) {
+  AsyncFile* file = slot->file;
+  bool error = slot->filled < 0;
+  async_call(file, slot->offset, slot->buffer, error ? 0 : slot->filled,
+    error || slot->offset + slot->length >= file->size, error
+  );
+}
+
+static void async_read_slot(AsyncSlot* slot) {
+  slot->filled = 0;
+  while (slot->filled < slot->length) {
+    index_s got = async_pread(slot->file->fd, slot->buffer + slot->filled,
+      slot->length - slot->filled, slot->offset + slot->filled
+    );
+    if (got < 0) slot->filled = -1;
+    if (got <= 0) break;
+    slot->filled += got;
+  }
+}
+
+static void async_callback_job(void* data) {
+  async_slot_callback(data);
+}
+
+static void async_read_job(void* data) {
+  async_read_slot(data);
+  async_slot_callback(data);
+}
+
+static void async_file_done(AsyncReader_Internal* reader, AsyncFile* file) {
+  if (file->opened) async_close(file->fd);
+  free(file->path);
+  free(file);
+  --reader->pending;
+}
+
+// Returns the slot to the free list, and retires its file once every chunk
+//    has been through a slot
+static void async_slot_finish(AsyncReader_Internal* reader, AsyncSlot* slot) {
+  AsyncFile* file = slot->file;
+  slot->state = SLOT_FREE;
+  slot->file = NULL;
+
+  if (--file->outstanding == 0 && file->scheduled >= file->size) {
+    async_file_done(reader, file);
+  }
+}
+
+// Runs the callback for a slot with its data, on the pool if there is one
+static void async_dispatch(AsyncReader_Internal* reader, AsyncSlot* slot) {
+  if (reader->pool) {
+    slot->state = SLOT_JOB;
+    slot->job = job_run(reader->pool, async_callback_job, slot);
+    return;
+  }
+
+  async_slot_callback(slot);
+  async_slot_finish(reader, slot);
+}
+
+static void async_start_read(AsyncReader_Internal* reader, AsyncSlot* slot) {
+  slot->filled = 0;
+
+#ifdef ASYNC_URING
+  if (reader->uring) {
+    slot->state = SLOT_READING;
+    uring_prep_read(&reader->ring, slot, slot - reader->slots);
+    return;
+  }
+#endif
+
+  if (reader->pool) {
+    slot->state = SLOT_JOB;
+    slot->job = job_run(reader->pool, async_read_job, slot);
+    return;
+  }
+
+  async_read_slot(slot);
+  async_slot_callback(slot);
+  async_slot_finish(reader, slot);
+}
+
+// Opens the next file if needed, returns NULL once every file is scheduled.
+//    Files that fail to open or are empty get their one callback right here.
+static AsyncFile* async_next_file(AsyncReader_Internal* reader) {
+  AsyncFile** files = reader->files->arr;
+
+  while (reader->next_file < reader->files->size) {
+    AsyncFile* file = files[reader->next_file];
+
+    if (!file->opened) {
+      file->opened = async_open(file->path, &file->fd, &file->size);
+
+      if (!file->opened || file->size == 0) {
+        ++reader->next_file;
+        async_call(file, 0, NULL, 0, true, !file->opened);
+        async_file_done(reader, file);
+        continue;
+      }
+    }
+
+    return file;
+  }
+
+  return NULL;
+}
+
+// Hands the next chunks to free slots
+static void async_schedule(AsyncReader_Internal* reader) {
+  for (index_s i = 0; i < reader->slot_count; ++i) {
+    AsyncSlot* slot = &reader->slots[i];
+    if (slot->state != SLOT_FREE) continue;
+
+    AsyncFile* file = async_next_file(reader);
+    if (!file) break;
+
+    slot->file = file;
+    slot->offset = file->scheduled;
+    slot->length = MIN(reader->buffer_size, file->size - file->scheduled);
+    file->scheduled += slot->length;
+    ++file->outstanding;
+    if (file->scheduled >= file->size) ++reader->next_file;
+
+    async_start_read(reader, slot);
+  }
+
+  // compact the queue once the files scheduled so far are a large part of it
+  if (reader->next_file > 64 && reader->next_file * 2 > reader->files->size) {
+    array_remove_range(reader->files, 0, reader->next_file);
+    reader->next_file = 0;
+  }
+}
+
+#ifdef ASYNC_URING
+static index_s async_reap(AsyncReader_Internal* reader) {
+  AsyncUring* ring = &reader->ring;
+  unsigned head = *ring->cq_head;
+  unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  index_s completed = 0;
+
+  for (; head != tail; ++head) {
+    struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+    AsyncSlot* slot = &reader->slots[cqe->user_data];
+    int result = cqe->res;
+    --ring->in_flight;
+
+    if (result < 0) {
+      slot->filled = -1;
+    } else {
+      slot->filled += result;
+
+      // short read before the end of the file, read the rest
+      if (result > 0 && slot->filled < slot->length) {
+        uring_prep_read(ring, slot, slot - reader->slots);
+        continue;
+      }
+    }
+
+    // release the entry before the callback runs, it may take a while
+    __atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+    async_dispatch(reader, slot);
+    ++completed;
+  }
+
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+  return completed;
+}
+#endif
+
+#ifdef ASYNC_URING
+// The ring stopped taking reads: fail every read still on it, and carry on
+//    with the pread path for the rest
+static index_s async_uring_fail(AsyncReader_Internal* reader) {
+  uring_free(&reader->ring);
+  reader->uring = false;
+
+  index_s failed = 0;
+  for (index_s i = 0; i < reader->slot_count; ++i) {
+    AsyncSlot* slot = &reader->slots[i];
+    if (slot->state != SLOT_READING) continue;
+    slot->filled = -1;
+    async_dispatch(reader, slot);
+    ++failed;
+  }
+  return failed;
+}
+#endif
+
+// One round of progress. Returns the number of chunks finished.
+static index_s async_step(AsyncReader_Internal* reader, bool block) {
+  index_s completed = 0;
+
+  for (index_s i = 0; i < reader->slot_count; ++i) {
+    AsyncSlot* slot = &reader->slots[i];
+    if (slot->state != SLOT_JOB || !job_done(slot->job)) continue;
+    job_release(&slot->job);
+    async_slot_finish(reader, slot);
+    ++completed;
+  }
+
+#ifdef ASYNC_URING
+  if (reader->uring) completed += async_reap(reader);
+#endif
+
+  async_schedule(reader);
+
+#ifdef ASYNC_URING
+  if (reader->uring) {
+    bool wait = block && !completed && reader->ring.in_flight > 0;
+    if (!uring_enter(&reader->ring, wait)) return async_uring_fail(reader);
+    if (wait) return async_reap(reader);
+  }
+#endif
+
+  if (!block || completed) return completed;
+
+  // nothing finished, help the pool with the oldest running job
+  for (index_s i = 0; i < reader->slot_count; ++i) {
+    AsyncSlot* slot = &reader->slots[i];
+    if (slot->state != SLOT_JOB) continue;
+    job_wait(reader->pool, &slot->job);
+    async_slot_finish(reader, slot);
+    return 1;
+  }
+
+  return 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reader
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Creates a reader with buffer_count buffers of buffer_size bytes each
+//    (rounded up to 4KB), which bounds both memory use and the number of reads
+//    in flight. The pool may be NULL to run every callback on the calling
+//    thread.
+AsyncReader async_reader_new(
+  JobPool pool, index_s buffer_count, index_s buffer_size
+) {
+  assert(buffer_count > 0 && buffer_size > 0);
+  buffer_size = (buffer_size + 4095) / 4096 * 4096;
+
+  AsyncReader_Internal* ret = malloc(sizeof(AsyncReader_Internal));
+  assert(ret);
+
+  *ret = (AsyncReader_Internal) {
+    .pool = pool,
+    .slots = calloc(buffer_count, sizeof(AsyncSlot)),
+    .slot_count = buffer_count,
+    .buffer_size = buffer_size,
+    .buffers = async_buffer_alloc(buffer_count * buffer_size),
+    .files = array_new(AsyncFile*),
+  };
+  assert(ret->slots && ret->buffers);
+
+  for (index_s i = 0; i < buffer_count; ++i) {
+    ret->slots[i] = (AsyncSlot) {
+      .reader = ret,
+      .buffer = ret->buffers + i * buffer_size,
+    };
+  }
+
+#ifdef ASYNC_URING
+  ret->uring = uring_init(&ret->ring, ret->slots, buffer_count, buffer_size);
+#endif
+
+  return (AsyncReader)ret;
+}
+
+// \brief Finishes all queued files, then frees the reader.
+void async_reader_delete(AsyncReader* reader_ptr) {
+  if (!reader_ptr || !*reader_ptr) return;
+  AsyncReader_Internal* reader = (AsyncReader_Internal*)*reader_ptr;
+
+  async_reader_wait(*reader_ptr);
+
+#ifdef ASYNC_URING
+  if (reader->uring) uring_free(&reader->ring);
+#endif
+
+  array_delete(&reader->files);
+  async_buffer_free(reader->buffers);
+  free(reader->slots);
+  free(reader);
+  *reader_ptr = NULL;
+}
+
+// \brief Queues a file to be read. Nothing is opened until a buffer is free;
+//    call async_reader_poll or async_reader_wait to make progress. The path
+//    is copied.
+void async_read_file(
+  AsyncReader reader_in, const char* path, AsyncReadFn fn, void* data
+) {
+  ASYNCREADER_INTERNAL;
+  assert(path && fn);
+
+  AsyncFile* file = malloc(sizeof(AsyncFile));
+  size_t path_size = strlen(path) + 1;
+  char* path_copy = malloc(path_size);
+  assert(file && path_copy);
+  memcpy(path_copy, path, path_size);
+
+  *file = (AsyncFile) {
+    .path = path_copy,
+    .fn = fn,
+    .data = data,
+    .fd = ASYNC_NO_FD,
+  };
+
+  array_write_back(reader->files, &file);
+  ++reader->pending;
+}
+
+// \brief Handles whatever has completed and starts more reads, without
+//    blocking on I/O.
+//
+// \returns The number of chunks finished.
+index_s async_reader_poll(AsyncReader reader_in) {
+  ASYNCREADER_INTERNAL;
+  return async_step(reader, false);
+}
+
+// \brief Blocks until every queued file has been read and every callback has
+//    returned, helping the pool in the meantime.
+void async_reader_wait(AsyncReader reader_in) {
+  ASYNCREADER_INTERNAL;
+  while (reader->pending > 0) async_step(reader, true);
+}
@@ -0,0 +1,477 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "blob.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Format
+////////////////////////////////////////////////////////////////////////////////
+
+#define BLOB_VERSION 1
+#define BLOB_ENDIAN_MARK 0x01020304u
+
+// Headers themselves are placed on 8-byte boundaries
+#define BLOB_HEADER_ALIGN 8
+
+typedef struct {
+  char magic[4];                // "MCLB"
+  unsigned int endian;          // BLOB_ENDIAN_MARK in the writer's byte order
+  unsigned int version;
+  unsigned int kind;            // BlobKind
+  long long element_size;
+  long long count;
+  long long alignment;
+  long long payload_offset;     // from the start of the file
+  long long payload_size;
+  unsigned long long checksum;  // of the payload
+} BlobHeader;
+
+typedef struct {
+  const BlobHeader* header;
+  Array view;                   // for BLOB_ARRAY sections
+} BlobSection;
+
+// internal opaque structure:
+typedef struct {
+  // public (read only)
+  index_s section_count;
+  StringRange range;
+
+  // private
+  MappedFile file;
+  BlobSection* sections;
+} BlobFile_Internal;
+
+#define BLOBFILE_INTERNAL \
+  assert(blob_in); \
+  BlobFile_Internal* blob = (BlobFile_Internal*)(blob_in)
+
+static index_s blob_align_up(index_s value, index_s alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Checksum
+////////////////////////////////////////////////////////////////////////////////
+
+// XXH64, which runs at memory speed so verifying doesn't dominate load times
+
+#define XXH_P1 0x9E3779B185EBCA87ull
+#define XXH_P2 0xC2B2AE3D27D4EB4Full
+#define XXH_P3 0x165667B19E3779F9ull
+#define XXH_P4 0x85EBCA77C2B2AE63ull
+#define XXH_P5 0x27D4EB2F165667C5ull
+
+typedef unsigned long long xxh_u64;
+
+static inline xxh_u64 xxh_rotl(xxh_u64 x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline xxh_u64 xxh_read64(const byte* p) {
+  xxh_u64 ret;
+  memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+static inline xxh_u64 xxh_read32(const byte* p) {
+  unsigned int ret;
+  memcpy(&ret, p, sizeof(ret));
+  return ret;
+}
+
+static inline xxh_u64 xxh_round(xxh_u64 acc, xxh_u64 input) {
+  acc += input * XXH_P2;
+  acc = xxh_rotl(acc, 31);
+  return acc * XXH_P1;
+}
+
+static inline xxh_u64 xxh_merge(xxh_u64 acc, xxh_u64 val) {
+  acc ^= xxh_round(0, val);
+  return acc * XXH_P1 + XXH_P4;
+}
+
+// \brief Computes the XXH64 hash (seed 0) of a block of memory, as stored in
+//    the blob section headers.
+unsigned long long blob_checksum(const void* data, index_s size) {
+  assert(data || !size);
+  const byte* p = data;
+  const byte* end = p + size;
+  xxh_u64 h;
+
+  if (size >= 32) {
+    const byte* limit = end - 32;
+    xxh_u64 v1 = XXH_P1 + XXH_P2;
+    xxh_u64 v2 = XXH_P2;
+    xxh_u64 v3 = 0;
+    xxh_u64 v4 = 0 - XXH_P1;
+
+    do {
+      v1 = xxh_round(v1, xxh_read64(p));
+      v2 = xxh_round(v2, xxh_read64(p + 8));
+      v3 = xxh_round(v3, xxh_read64(p + 16));
+      v4 = xxh_round(v4, xxh_read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+
+    h = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+    h = xxh_merge(h, v1);
+    h = xxh_merge(h, v2);
+    h = xxh_merge(h, v3);
+    h = xxh_merge(h, v4);
+  } else {
+    h = XXH_P5;
+  }
+
+  h += (xxh_u64)size;
+
+  for (; p + 8 <= end; p += 8) {
+    h ^= xxh_round(0, xxh_read64(p));
+    h = xxh_rotl(h, 27) * XXH_P1 + XXH_P4;
+  }
+
+  if (p + 4 <= end) {
+    h ^= xxh_read32(p) * XXH_P1;
+    h = xxh_rotl(h, 23) * XXH_P2 + XXH_P3;
+    p += 4;
+  }
+
+  for (; p < end; ++p) {
+    h ^= *p * XXH_P5;
+    h = xxh_rotl(h, 11) * XXH_P1;
+  }
+
+  h ^= h >> 33;
+  h *= XXH_P2;
+  h ^= h >> 29;
+  h *= XXH_P3;
+  h ^= h >> 32;
+  return h;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Writing
+////////////////////////////////////////////////////////////////////////////////
+
+static void blob_pad(FileWriter writer, index_s alignment) {
+  static const char zeros[BLOB_MAX_ALIGN] = { 0 };
+  index_s padding = blob_align_up(writer->written, alignment) - writer->written;
+  if (padding) file_write_range(writer, str_range_s(zeros, padding));
+}
+
+// Writes a section header for a payload that will be written right after it
+static void blob_write_header(FileWriter writer, BlobKind kind,
+  index_s element_size, index_s count, index_s alignment, index_s payload_size,
+  unsigned long long checksum
+) {
+  blob_pad(writer, BLOB_HEADER_ALIGN);
+
+  BlobHeader header = {
+    .magic = { 'M', 'C', 'L', 'B' },
+    .endian = BLOB_ENDIAN_MARK,
+    .version = BLOB_VERSION,
+    .kind = kind,
+    .element_size = element_size,
+    .count = count,
+    .alignment = alignment,
+    .payload_offset =
+      blob_align_up(writer->written + (index_s)sizeof(header), alignment),
+    .payload_size = payload_size,
+    .checksum = checksum,
+  };
+
+  file_write_range(writer, str_range_s((const char*)&header, sizeof(header)));
+  blob_pad(writer, alignment);
+}
+
+// \brief Writes the contents of an Array as a section. The file must have been
+//    written from its start by this writer, since payload offsets and
+//    alignment are taken from writer->written.
+//
+// \param alignment - of the payload within the file, a power of 2 no larger
+//    than BLOB_MAX_ALIGN, or 0 for BLOB_DEFAULT_ALIGN
+//
+// \returns false if the writer has failed.
+bool blob_write_array(FileWriter writer, Array array, index_s alignment) {
+  assert(array);
+  return blob_write_array_s(writer, array->arr, array->element_size,
+    array->size, alignment
+  );
+}
+
+// \brief Writes count elements of element_size bytes as an array section.
+bool blob_write_array_s(FileWriter writer, const void* data,
+  index_s element_size, index_s count, index_s alignment
+) {
+  assert(writer && element_size > 0 && count >= 0);
+  if (!alignment) alignment = BLOB_DEFAULT_ALIGN;
+  assert(alignment > 0 && isPow2(alignment) && alignment <= BLOB_MAX_ALIGN);
+
+  index_s size = element_size * count;
+  blob_write_header(writer, BLOB_ARRAY, element_size, count, alignment, size,
+    blob_checksum(data, size)
+  );
+  file_write_range(writer, str_range_s(data, size));
+  return !writer->error;
+}
+
+// \brief Writes an Array of StringRanges as a string table section.
+bool blob_write_strings(FileWriter writer, Array_StrR strings) {
+  assert(strings);
+  return blob_write_strings_s(writer, strings->arr, strings->size);
+}
+
+// \brief Writes a string table section: count + 1 offsets followed by the
+//    characters of every string, each with a '\0' after it.
+bool blob_write_strings_s(
+  FileWriter writer, const StringRange* strings, index_s count
+) {
+  assert(writer && (strings || !count));
+
+  index_s offsets_size = (count + 1) * (index_s)sizeof(long long);
+  index_s chars_size = 0;
+  for (index_s i = 0; i < count; ++i) chars_size += strings[i].size + 1;
+
+  // laid out in memory first so the checksum is taken over exactly the bytes
+  //    that get written
+  index_s size = offsets_size + chars_size;
+  byte* payload = malloc(size);
+  assert(payload);
+  long long* offsets = (long long*)payload;
+  char* chars = (char*)payload + offsets_size;
+
+  long long offset = 0;
+  for (index_s i = 0; i < count; ++i) {
+    offsets[i] = offset;
+    if (strings[i].size) {
+      memcpy(chars + offset, strings[i].begin, strings[i].size);
+    }
+    offset += strings[i].size;
+    chars[offset++] = '\0';
+  }
+  offsets[count] = offset;
+
+  blob_write_header(writer, BLOB_STRINGS, 1, count, sizeof(long long), size,
+    blob_checksum(payload, size)
+  );
+  file_write_range(writer, str_range_s((const char*)payload, size));
+
+  free(payload);
+  return !writer->error;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Loading
+////////////////////////////////////////////////////////////////////////////////
+
+// Checks everything needed to safely hand out views of the section. String
+//    table offsets are walked once to make sure every string lies inside the
+//    payload, the rest of it is left untouched until it's used (see
+//    blob_verify).
+static bool blob_section_valid(const char* base, index_s file_size,
+  const BlobHeader* header
+) {
+  if (memcmp(header->magic, "MCLB", 4) != 0) return false;
+  if (header->endian != BLOB_ENDIAN_MARK) return false;
+  if (header->version != BLOB_VERSION) return false;
+
+  long long alignment = header->alignment;
+  if (alignment <= 0 || alignment > BLOB_MAX_ALIGN || !isPow2(alignment)) {
+    return false;
+  }
+
+  long long offset = header->payload_offset;
+  long long size = header->payload_size;
+  long long count = header->count;
+  long long header_end = (const char*)(header + 1) - base;
+  if (offset < header_end || offset % alignment) return false;
+  if (size < 0 || count < 0) return false;
+  if (offset > file_size || size > file_size - offset) return false;
+
+  switch (header->kind) {
+    case BLOB_ARRAY:
+      return header->element_size > 0
+        && count <= size / header->element_size
+        && count * header->element_size == size;
+
+    case BLOB_STRINGS: {
+      if (alignment < (long long)sizeof(long long)) return false;
+      if (count >= size / (long long)sizeof(long long)) return false;
+      const long long* offsets = (const long long*)(base + offset);
+      long long chars_size = size - (count + 1) * (long long)sizeof(long long);
+      if (offsets[0] != 0 || offsets[count] != chars_size) return false;
+
+      // every string has at least its '\0', so offsets strictly increase
+      for (long long s = 0; s < count; ++s) {
+        if (offsets[s + 1] <= offsets[s]) return false;
+      }
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+static void blob_free(BlobFile_Internal* blob) {
+  for (index_s i = 0; i < blob->section_count; ++i) {
+    array_delete(&blob->sections[i].view);
+  }
+  free(blob->sections);
+  str_unmap_file(&blob->file);
+  free(blob);
+}
+
+// \brief Maps a blob file and checks the section headers. Payloads aren't
+//    read until they're used, call blob_verify to check them against their
+//    checksums.
+//
+// \returns A new BlobFile, or NULL if the file couldn't be mapped or isn't a
+//    well-formed blob file.
+BlobFile blob_open(const char* path) {
+  assert(path);
+
+  MappedFile file = str_map_file(path);
+  if (!file) return NULL;
+
+  // views are typically looked up here and there rather than streamed
+  str_map_advise(file, FILE_ACCESS_NORMAL);
+
+  BlobFile_Internal* blob = malloc(sizeof(BlobFile_Internal));
+  assert(blob);
+  *blob = (BlobFile_Internal) {
+    .range = file->range,
+    .file = file,
+  };
+
+  const char* base = file->range.begin;
+  index_s size = file->range.size;
+  index_s capacity = 0;
+  index_s offset = 0;
+
+  while (offset < size) {
+    const BlobHeader* header = (const BlobHeader*)(base + offset);
+    if (size - offset < (index_s)sizeof(BlobHeader)
+      || !blob_section_valid(base, size, header)
+    ) {
+      blob_free(blob);
+      return NULL;
+    }
+
+    if (blob->section_count == capacity) {
+      capacity = MAX(8, capacity * 2);
+      blob->sections = realloc(blob->sections, capacity * sizeof(BlobSection));
+      assert(blob->sections);
+    }
+
+    BlobSection* section = &blob->sections[blob->section_count++];
+    *section = (BlobSection) { .header = header };
+    if (header->kind == BLOB_ARRAY) {
+      section->view = _array_view_((index_s)header->element_size,
+        base + header->payload_offset, (index_s)header->count
+      );
+    }
+
+    offset = blob_align_up(
+      (index_s)(header->payload_offset + header->payload_size),
+      BLOB_HEADER_ALIGN
+    );
+  }
+
+  return (BlobFile)blob;
+}
+
+// \brief Unmaps the file. Every view taken from it becomes invalid.
+void blob_close(BlobFile* blob_ptr) {
+  if (!blob_ptr || !*blob_ptr) return;
+  blob_free((BlobFile_Internal*)*blob_ptr);
+  *blob_ptr = NULL;
+}
+
+// \brief Checks every section's payload against its checksum, and that the
+//    strings of string tables are terminated. This reads the whole file.
+bool blob_verify(BlobFile blob_in) {
+  BLOBFILE_INTERNAL;
+  const char* base = blob->range.begin;
+
+  for (index_s i = 0; i < blob->section_count; ++i) {
+    const BlobHeader* header = blob->sections[i].header;
+    const char* payload = base + header->payload_offset;
+    index_s size = (index_s)header->payload_size;
+
+    if (blob_checksum(payload, size) != header->checksum) return false;
+
+    if (header->kind == BLOB_STRINGS) {
+      const long long* offsets = (const long long*)payload;
+      const char* chars = (const char*)(offsets + header->count + 1);
+      for (long long s = 0; s < header->count; ++s) {
+        if (chars[offsets[s + 1] - 1] != '\0') return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+// \brief Gets the kind of a section, or BLOB_NONE if it's out of range.
+BlobKind blob_kind(BlobFile blob_in, index_s section) {
+  BLOBFILE_INTERNAL;
+  if (section < 0 || section >= blob->section_count) return BLOB_NONE;
+  return (BlobKind)blob->sections[section].header->kind;
+}
+
+// \brief Gets a read-only Array view of an array section. It belongs to the
+//    BlobFile, so it must not be deleted or resized. Cast it to the matching
+//    Array_T to access the elements.
+//
+// \returns The view, or NULL if the section isn't an array.
+Array blob_array(BlobFile blob_in, index_s section) {
+  BLOBFILE_INTERNAL;
+  if (blob_kind(blob_in, section) != BLOB_ARRAY) return NULL;
+  return blob->sections[section].view;
+}
+
+// \brief Gets a string table section.
+//
+// \returns The table, which is empty if the section isn't a string table.
+BlobStrings blob_strings(BlobFile blob_in, index_s section) {
+  BLOBFILE_INTERNAL;
+  if (blob_kind(blob_in, section) != BLOB_STRINGS) {
+    static const long long no_offsets[1] = { 0 };
+    return (BlobStrings) { .offsets = no_offsets, .data = "" };
+  }
+
+  const BlobHeader* header = blob->sections[section].header;
+  const long long* offsets =
+    (const long long*)(blob->range.begin + header->payload_offset);
+
+  return (BlobStrings) {
+    .count = (index_s)header->count,
+    .offsets = offsets,
+    .data = (const char*)(offsets + header->count + 1),
+  };
+}
@@ -0,0 +1,348 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "camera.h"
+
+#include <stdlib.h>
+#include <math.h>
+
+// Each flag marks a cached value (or pair computed together) as stale
+#define CAM_DIRTY_VIEW          0x01 // view and its inverse
+#define CAM_DIRTY_PROJ          0x02 // projection and its inverse
+#define CAM_DIRTY_VIEWPROJ      0x04
+#define CAM_DIRTY_VIEWPROJ_INV  0x08
+#define CAM_DIRTY_PLANES        0x10
+
+#define CAM_DIRTY_ALL           0x1f
+
+// Everything derived from both the view and projection
+#define CAM_DIRTY_COMBINED \
+  (CAM_DIRTY_VIEWPROJ | CAM_DIRTY_VIEWPROJ_INV | CAM_DIRTY_PLANES)
+
+// internal opaque structure:
+typedef struct Camera_Internal {
+  // public (read only)
+  vec3 pos;
+  vec3 target;
+  vec3 up;
+
+  // private
+  bool ortho;
+  float fov, aspect;              // perspective only
+  float left, right, top, bottom; // ortho only
+  float near, far;
+  uint dirty;
+
+  mat4 view, view_inv;
+  mat4 proj, proj_inv;
+  mat4 viewproj, viewproj_inv;
+  vec4 planes[CAM_PLANE_COUNT];
+} Camera_Internal;
+
+#define CAMERA_INTERNAL \
+  assert(cam_in); \
+  Camera_Internal* cam = (Camera_Internal*)(cam_in)
+
+static Camera cam_new(void) {
+  Camera_Internal* ret = malloc(sizeof(Camera_Internal));
+  assert(ret);
+
+  *ret = (Camera_Internal) {
+    .pos = v3f(0, 0, 0),
+    .target = v3f(0, 0, -1),
+    .up = v3f(0, 1, 0),
+    .dirty = CAM_DIRTY_ALL,
+  };
+
+  return (Camera)ret;
+}
+
+// \brief Creates a camera at the origin looking down -z with a perspective
+//    projection, see m4perspective.
+Camera cam_new_perspective(float fov_rads, float aspect, float near, float far) {
+  Camera ret = cam_new();
+  cam_set_perspective(ret, fov_rads, aspect, near, far);
+  return ret;
+}
+
+// \brief Creates a camera at the origin looking down -z with an orthographic
+//    projection, see m4ortho.
+Camera cam_new_ortho(
+  float left, float right, float top, float bottom, float near, float far
+) {
+  Camera ret = cam_new();
+  cam_set_ortho(ret, left, right, top, bottom, near, far);
+  return ret;
+}
+
+void cam_delete(Camera* cam) {
+  if (!cam || !*cam) return;
+  free(*cam);
+  *cam = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Setters
+////////////////////////////////////////////////////////////////////////////////
+
+static inline bool cam_v3eq(vec3 a, vec3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+// \brief Places the camera at pos facing target. The up vector only needs to
+//    be roughly up, but must not be parallel to the view direction.
+void cam_look(Camera cam_in, vec3 pos, vec3 target, vec3 up) {
+  CAMERA_INTERNAL;
+
+  if (cam_v3eq(cam->pos, pos)
+  &&  cam_v3eq(cam->target, target)
+  &&  cam_v3eq(cam->up, up)
+  ) {
+    return;
+  }
+
+  cam->pos = pos;
+  cam->target = target;
+  cam->up = up;
+  cam->dirty |= CAM_DIRTY_VIEW | CAM_DIRTY_COMBINED;
+}
+
+void cam_set_perspective(
+  Camera cam_in, float fov_rads, float aspect, float near, float far
+) {
+  CAMERA_INTERNAL;
+
+  if (!cam->ortho
+  &&  cam->fov == fov_rads && cam->aspect == aspect
+  &&  cam->near == near && cam->far == far
+  ) {
+    return;
+  }
+
+  cam->ortho = false;
+  cam->fov = fov_rads;
+  cam->aspect = aspect;
+  cam->near = near;
+  cam->far = far;
+  cam->dirty |= CAM_DIRTY_PROJ | CAM_DIRTY_COMBINED;
+}
+
+void cam_set_ortho(Camera cam_in,
+  float left, float right, float top, float bottom, float near, float far
+) {
+  CAMERA_INTERNAL;
+
+  if (cam->ortho
+  &&  cam->left == left && cam->right == right
+  &&  cam->top == top && cam->bottom == bottom
+  &&  cam->near == near && cam->far == far
+  ) {
+    return;
+  }
+
+  cam->ortho = true;
+  cam->left = left;
+  cam->right = right;
+  cam->top = top;
+  cam->bottom = bottom;
+  cam->near = near;
+  cam->far = far;
+  cam->dirty |= CAM_DIRTY_PROJ | CAM_DIRTY_COMBINED;
+}
+
+// \brief Updates the aspect ratio, such as after a window resize. For an
+//    orthographic camera the height is kept and the width is fit around the
+//    current horizontal center.
+void cam_set_aspect(Camera cam_in, float aspect) {
+  CAMERA_INTERNAL;
+
+  if (!cam->ortho) {
+    cam_set_perspective(cam_in, cam->fov, aspect, cam->near, cam->far);
+    return;
+  }
+
+  float center = (cam->left + cam->right) * 0.5f;
+  float half = fabsf(cam->top - cam->bottom) * aspect * 0.5f;
+  if (cam->right < cam->left) half = -half;
+  cam_set_ortho(cam_in, center - half, center + half,
+    cam->top, cam->bottom, cam->near, cam->far
+  );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cached values
+////////////////////////////////////////////////////////////////////////////////
+
+static void cam_update_view(Camera_Internal* cam) {
+  if (!(cam->dirty & CAM_DIRTY_VIEW)) return;
+
+  vec3 back = v3norm(v3sub(cam->pos, cam->target));
+  vec3 right = v3norm(v3cross(cam->up, back));
+  vec3 up = v3cross(back, right);
+
+  // rigid transform, so the inverse is the transposed rotation
+  cam->view = m4basis(right, up, back, cam->pos);
+  cam->view_inv = (mat4) {.f={
+    right.x,    right.y,    right.z,    0,
+    up.x,       up.y,       up.z,       0,
+    back.x,     back.y,     back.z,     0,
+    cam->pos.x, cam->pos.y, cam->pos.z, 1
+  }};
+
+  cam->dirty &= ~CAM_DIRTY_VIEW;
+}
+
+static void cam_update_proj(Camera_Internal* cam) {
+  if (!(cam->dirty & CAM_DIRTY_PROJ)) return;
+
+  mat4 p, inv = m4zero;
+
+  if (cam->ortho) {
+    // scale and offset per axis, inverted axis by axis
+    p = m4ortho(
+      cam->left, cam->right, cam->top, cam->bottom, cam->near, cam->far);
+    for (int i = 0; i < 3; ++i) {
+      inv.m[i][i] = 1 / p.m[i][i];
+      inv.m[3][i] = -p.m[3][i] / p.m[i][i];
+    }
+    inv.m[3][3] = 1;
+  } else {
+    // x and y are scaled, and z, w only depend on each other:
+    //    z' = a z + b w, w' = -z  =>  z = -w', w = (z' + a w') / b
+    p = m4perspective(cam->fov, cam->aspect, cam->near, cam->far);
+    float a = p.m[2][2], b = p.m[3][2];
+    inv.m[0][0] = 1 / p.m[0][0];
+    inv.m[1][1] = 1 / p.m[1][1];
+    inv.m[3][2] = -1;
+    inv.m[2][3] = 1 / b;
+    inv.m[3][3] = a / b;
+  }
+
+  cam->proj = p;
+  cam->proj_inv = inv;
+  cam->dirty &= ~CAM_DIRTY_PROJ;
+}
+
+static void cam_update_viewproj(Camera_Internal* cam) {
+  if (!(cam->dirty & CAM_DIRTY_VIEWPROJ)) return;
+  cam_update_view(cam);
+  cam_update_proj(cam);
+  cam->viewproj = m4mul(cam->proj, cam->view);
+  cam->dirty &= ~CAM_DIRTY_VIEWPROJ;
+}
+
+static void cam_update_viewproj_inv(Camera_Internal* cam) {
+  if (!(cam->dirty & CAM_DIRTY_VIEWPROJ_INV)) return;
+  cam_update_view(cam);
+  cam_update_proj(cam);
+  cam->viewproj_inv = m4mul(cam->view_inv, cam->proj_inv);
+  cam->dirty &= ~CAM_DIRTY_VIEWPROJ_INV;
+}
+
+// Extracts the planes from the rows of the view-projection (Gribb/Hartmann)
+static void cam_update_planes(Camera_Internal* cam) {
+  if (!(cam->dirty & CAM_DIRTY_PLANES)) return;
+  cam_update_viewproj(cam);
+
+  const mat4* m = &cam->viewproj;
+  vec4 row[4];
+  for (int r = 0; r < 4; ++r) {
+    row[r] = v4f(m->m[0][r], m->m[1][r], m->m[2][r], m->m[3][r]);
+  }
+
+  // left/right from x, bottom/top from y, near/far from z
+  for (int i = 0; i < CAM_PLANE_COUNT; ++i) {
+    float sign = i % 2 ? -1.f : 1.f;
+    vec4 plane;
+    for (int c = 0; c < 4; ++c) {
+      plane.f[c] = row[3].f[c] + sign * row[i / 2].f[c];
+    }
+
+    // m4perspective maps depth to [0, 1] rather than [-1, 1] like m4ortho
+    if (i == CAM_PLANE_NEAR && !cam->ortho) plane = row[2];
+    float len = v3mag(plane.xyz);
+    float inv = len > 0 ? 1 / len : 0;
+    for (int c = 0; c < 4; ++c) plane.f[c] *= inv;
+    cam->planes[i] = plane;
+  }
+
+  cam->dirty &= ~CAM_DIRTY_PLANES;
+}
+
+mat4 cam_view(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_view(cam);
+  return cam->view;
+}
+
+mat4 cam_projection(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_proj(cam);
+  return cam->proj;
+}
+
+mat4 cam_viewproj(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_viewproj(cam);
+  return cam->viewproj;
+}
+
+mat4 cam_view_inverse(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_view(cam);
+  return cam->view_inv;
+}
+
+mat4 cam_projection_inverse(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_proj(cam);
+  return cam->proj_inv;
+}
+
+mat4 cam_viewproj_inverse(Camera cam_in) {
+  CAMERA_INTERNAL;
+  cam_update_viewproj_inv(cam);
+  return cam->viewproj_inv;
+}
+
+vec4 cam_plane(Camera cam_in, CameraPlane plane) {
+  CAMERA_INTERNAL;
+  assert(plane >= 0 && plane < CAM_PLANE_COUNT);
+  cam_update_planes(cam);
+  return cam->planes[plane];
+}
+
+// \brief Checks a bounding sphere against the frustum planes. Conservative:
+//    spheres near a frustum corner may pass without actually being visible.
+bool cam_sphere_visible(Camera cam_in, vec3 center, float radius) {
+  CAMERA_INTERNAL;
+  cam_update_planes(cam);
+
+  for (int i = 0; i < CAM_PLANE_COUNT; ++i) {
+    vec4 p = cam->planes[i];
+    if (v3dot(p.xyz, center) + p.w < -radius) return false;
+  }
+
+  return true;
+}
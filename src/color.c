@@ -0,0 +1,396 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "color.h"
+
+#include <math.h>
+
+#include "pack.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define COLOR_SSE2
+# include <emmintrin.h>
+#endif
+
+// Linear value of each sRGB byte
+static const float color_srgb8_to_linear[256] = {
+  0.0f, 0.000303526991f, 0.000607053982f, 0.000910580973f,
+  0.00121410796f, 0.00151763496f, 0.00182116195f, 0.00212468882f,
+  0.00242821593f, 0.0027317428f, 0.00303526991f, 0.00334653584f,
+  0.00367650739f, 0.00402471703f, 0.00439144205f, 0.00477695325f,
+  0.00518151652f, 0.00560539169f, 0.00604883302f, 0.00651209056f,
+  0.00699541019f, 0.00749903219f, 0.00802319311f, 0.00856812578f,
+  0.00913405884f, 0.00972121768f, 0.010329823f, 0.0109600937f,
+  0.0116122449f, 0.012286488f, 0.0129830325f, 0.0137020834f,
+  0.0144438436f, 0.0152085144f, 0.0159962941f, 0.0168073755f,
+  0.0176419541f, 0.01850022f, 0.0193823613f, 0.0202885624f,
+  0.0212190095f, 0.0221738853f, 0.0231533665f, 0.0241576321f,
+  0.0251868591f, 0.0262412224f, 0.0273208916f, 0.02842604f,
+  0.0295568351f, 0.0307134446f, 0.0318960324f, 0.0331047662f,
+  0.0343398079f, 0.0356013142f, 0.0368894488f, 0.0382043719f,
+  0.0395462364f, 0.0409151986f, 0.0423114114f, 0.043735031f,
+  0.045186203f, 0.0466650873f, 0.0481718257f, 0.0497065671f,
+  0.0512694567f, 0.0528606474f, 0.054480277f, 0.0561284907f,
+  0.0578054301f, 0.0595112368f, 0.0612460524f, 0.0630100146f,
+  0.064803265f, 0.0666259378f, 0.0684781671f, 0.0703600943f,
+  0.0722718537f, 0.0742135718f, 0.0761853829f, 0.078187421f,
+  0.0802198201f, 0.0822827071f, 0.0843762085f, 0.0865004584f,
+  0.0886555836f, 0.0908417106f, 0.0930589661f, 0.0953074694f,
+  0.097587347f, 0.0998987257f, 0.102241732f, 0.104616486f,
+  0.107023105f, 0.10946171f, 0.111932427f, 0.114435375f,
+  0.116970666f, 0.119538426f, 0.122138776f, 0.124771819f,
+  0.127437681f, 0.130136475f, 0.13286832f, 0.135633335f,
+  0.138431609f, 0.141263291f, 0.144128472f, 0.147027269f,
+  0.149959788f, 0.152926147f, 0.155926466f, 0.158960834f,
+  0.162029371f, 0.165132195f, 0.168269396f, 0.171441108f,
+  0.174647406f, 0.177888423f, 0.18116425f, 0.18447499f,
+  0.187820777f, 0.191201687f, 0.194617838f, 0.198069319f,
+  0.20155625f, 0.205078736f, 0.208636865f, 0.212230757f,
+  0.215860501f, 0.219526201f, 0.223227963f, 0.226965874f,
+  0.230740055f, 0.23455058f, 0.238397568f, 0.242281124f,
+  0.246201321f, 0.25015828f, 0.254152089f, 0.258182853f,
+  0.262250662f, 0.266355604f, 0.270497799f, 0.274677306f,
+  0.278894275f, 0.283148736f, 0.287440836f, 0.291770637f,
+  0.296138257f, 0.300543785f, 0.304987311f, 0.309468925f,
+  0.313988715f, 0.318546772f, 0.323143214f, 0.327778101f,
+  0.332451522f, 0.337163627f, 0.341914415f, 0.346704066f,
+  0.351532608f, 0.356400132f, 0.361306787f, 0.366252601f,
+  0.371237695f, 0.376262128f, 0.38132602f, 0.386429429f,
+  0.391572475f, 0.396755219f, 0.401977777f, 0.407240212f,
+  0.412542611f, 0.417885065f, 0.423267663f, 0.428690493f,
+  0.434153646f, 0.439657182f, 0.445201188f, 0.450785786f,
+  0.456411034f, 0.462076992f, 0.467783809f, 0.473531485f,
+  0.479320168f, 0.48514995f, 0.491020858f, 0.496932983f,
+  0.502886474f, 0.50888133f, 0.514917672f, 0.520995557f,
+  0.527115107f, 0.533276379f, 0.539479494f, 0.545724452f,
+  0.55201143f, 0.558340371f, 0.564711511f, 0.571124852f,
+  0.577580452f, 0.584078431f, 0.590618849f, 0.597201765f,
+  0.603827357f, 0.610495567f, 0.617206573f, 0.623960376f,
+  0.630757153f, 0.637596846f, 0.644479692f, 0.651405632f,
+  0.658374846f, 0.665387273f, 0.672443151f, 0.679542482f,
+  0.686685324f, 0.693871737f, 0.701101899f, 0.708375752f,
+  0.715693474f, 0.723055124f, 0.730460763f, 0.73791039f,
+  0.745404184f, 0.752942204f, 0.760524511f, 0.768151164f,
+  0.775822222f, 0.783537805f, 0.791297913f, 0.799102724f,
+  0.806952238f, 0.814846575f, 0.822785735f, 0.830769897f,
+  0.838799f, 0.846873224f, 0.854992628f, 0.863157213f,
+  0.871367097f, 0.8796224f, 0.887923121f, 0.896269381f,
+  0.904661179f, 0.913098633f, 0.921581864f, 0.930110872f,
+  0.938685715f, 0.947306514f, 0.955973327f, 0.964686275f,
+  0.973445296f, 0.982250571f, 0.991102099f, 1.0f,
+};
+// Linear value at the lower rounding boundary of each sRGB byte, such that
+//    byte b is the correct encoding for x in [threshold[b], threshold[b + 1])
+static const float color_srgb8_threshold[256] = {
+  0.0f, 0.000151763496f, 0.000455290487f, 0.000758817478f,
+  0.00106234441f, 0.0013658714f, 0.00166939839f, 0.00197292538f,
+  0.00227645249f, 0.00257997937f, 0.00288350624f, 0.00318830088f,
+  0.00350925932f, 0.00384831498f, 0.00420574797f, 0.00458183279f,
+  0.00497683743f, 0.00539102405f, 0.00582465064f, 0.00627796957f,
+  0.00675122766f, 0.00724466844f, 0.00775853032f, 0.00829304848f,
+  0.00884845294f, 0.00942497049f, 0.0100228256f, 0.010642237f,
+  0.011283421f, 0.0119465925f, 0.0126319602f, 0.0133397318f,
+  0.0140701123f, 0.0148233026f, 0.0155995032f, 0.0163989104f,
+  0.0172217153f, 0.0180681143f, 0.0189382937f, 0.0198324434f,
+  0.0207507443f, 0.0216933824f, 0.0226605386f, 0.0236523896f,
+  0.0246691145f, 0.0257108882f, 0.0267778821f, 0.0278702695f,
+  0.0289882198f, 0.0301319025f, 0.0313014798f, 0.0324971229f,
+  0.0337189883f, 0.0349672437f, 0.0362420455f, 0.0375435539f,
+  0.0388719253f, 0.04022732f, 0.041609887f, 0.0430197865f,
+  0.0444571637f, 0.0459221713f, 0.0474149622f, 0.0489356853f,
+  0.0504844859f, 0.0520615056f, 0.0536668971f, 0.055300802f,
+  0.0569633618f, 0.0586547181f, 0.0603750125f, 0.0621243827f,
+  0.0639029741f, 0.0657109171f, 0.0675483495f, 0.0694154128f,
+  0.0713122338f, 0.0732389539f, 0.0751957074f, 0.0771826133f,
+  0.0791998208f, 0.0812474415f, 0.0833256245f, 0.085434489f,
+  0.0875741541f, 0.089744769f, 0.091946438f, 0.0941793025f,
+  0.0964434743f, 0.098739095f, 0.101066269f, 0.10342513f,
+  0.105815805f, 0.108238399f, 0.110693045f, 0.113179862f,
+  0.115698971f, 0.118250482f, 0.120834522f, 0.123451203f,
+  0.126100644f, 0.128782958f, 0.131498262f, 0.134246677f,
+  0.137028307f, 0.13984327f, 0.142691687f, 0.145573661f,
+  0.148489311f, 0.151438728f, 0.15442206f, 0.157439381f,
+  0.160490826f, 0.163576499f, 0.166696489f, 0.169850931f,
+  0.173039913f, 0.176263571f, 0.179521978f, 0.182815254f,
+  0.186143503f, 0.189506829f, 0.192905352f, 0.196339145f,
+  0.199808344f, 0.203313038f, 0.206853345f, 0.210429341f,
+  0.214041144f, 0.217688844f, 0.22137256f, 0.225092396f,
+  0.228848428f, 0.232640758f, 0.236469507f, 0.240334779f,
+  0.244236633f, 0.248175204f, 0.252150565f, 0.256162852f,
+  0.260212123f, 0.264298469f, 0.268422037f, 0.272582889f,
+  0.276781112f, 0.281016797f, 0.285290092f, 0.289601028f,
+  0.293949723f, 0.298336297f, 0.30276081f, 0.30722335f,
+  0.311724037f, 0.31626296f, 0.32084018f, 0.325455844f,
+  0.330109984f, 0.334802747f, 0.339534163f, 0.344304383f,
+  0.349113464f, 0.353961498f, 0.358848572f, 0.363774776f,
+  0.368740231f, 0.373744965f, 0.378789127f, 0.383872777f,
+  0.388996005f, 0.3941589f, 0.399361521f, 0.404604018f,
+  0.40988642f, 0.415208817f, 0.420571357f, 0.425974041f,
+  0.431417018f, 0.436900347f, 0.442424119f, 0.447988421f,
+  0.453593314f, 0.459238917f, 0.464925289f, 0.470652521f,
+  0.476420701f, 0.482229918f, 0.488080233f, 0.493971765f,
+  0.499904543f, 0.505878687f, 0.511894286f, 0.517951429f,
+  0.524050117f, 0.530190527f, 0.536372721f, 0.542596757f,
+  0.548862696f, 0.555170655f, 0.561520696f, 0.567912877f,
+  0.574347317f, 0.580824137f, 0.587343335f, 0.593904972f,
+  0.600509226f, 0.607156098f, 0.613845706f, 0.62057811f,
+  0.62735337f, 0.634171605f, 0.641032875f, 0.647937238f,
+  0.654884815f, 0.661875665f, 0.668909788f, 0.675987363f,
+  0.683108449f, 0.690273106f, 0.697481334f, 0.704733372f,
+  0.712029159f, 0.719368815f, 0.72675246f, 0.734180033f,
+  0.741651773f, 0.749167681f, 0.756727815f, 0.764332294f,
+  0.77198112f, 0.779674411f, 0.787412286f, 0.795194745f,
+  0.803021908f, 0.810893834f, 0.818810523f, 0.826772213f,
+  0.834778786f, 0.842830479f, 0.850927293f, 0.859069228f,
+  0.867256522f, 0.875489056f, 0.883767068f, 0.892090559f,
+  0.900459588f, 0.908874214f, 0.917334557f, 0.925840616f,
+  0.934392571f, 0.942990363f, 0.951634169f, 0.960324049f,
+  0.969060004f, 0.977842152f, 0.986670554f, 0.995545268f,
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar transfer functions
+////////////////////////////////////////////////////////////////////////////////
+
+float srgb_to_linear(float s) {
+  if (s <= 0.04045f) return s / 12.92f;
+  return powf((s + 0.055f) / 1.055f, 2.4f);
+}
+
+float linear_to_srgb(float l) {
+  if (l <= 0.0031308f) return l * 12.92f;
+  return 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+}
+
+// Polynomial fits from Ian Taylor:
+// http://chilliant.blogspot.com/2012/08/srgb-approximations-for-hlsl.html
+float srgb_to_linear_fast(float s) {
+  return s * (s * (s * 0.305306011f + 0.682171111f) + 0.012522878f);
+}
+
+float linear_to_srgb_fast(float l) {
+  if (!(l > 0)) return 0;
+  float s1 = sqrtf(l);
+  float s2 = sqrtf(s1);
+  float s3 = sqrtf(s2);
+  float s = 0.585122381f * s1 + 0.783140355f * s2 - 0.368262736f * s3;
+  return s > 0 ? (s < 1 ? s : 1) : 0;
+}
+
+static inline byte color_linear_to_srgb8(float l) {
+  if (!(l > 0)) return 0;
+  if (l >= 1) return 255;
+  // estimate from the linear segment or the polynomial, then the threshold
+  //    table settles it exactly (usually within a step)
+  float s = l <= 0.0031308f ? l * 12.92f : linear_to_srgb_fast(l);
+  int b = (int)lrintf(s * 255.0f);
+  while (b > 0 && l < color_srgb8_threshold[b]) --b;
+  while (b < 255 && l >= color_srgb8_threshold[b + 1]) ++b;
+  return (byte)b;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Batch conversions
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Converts 8-bit colors to floats in [0, 1] with no transfer function.
+void c4b_to_c4(color4* out, const color4b* in, index_s count) {
+  unpack_unorm8(out->f, in->i, count * 4);
+}
+
+// \brief Converts float colors to 8-bit, clamping to [0, 1] with no transfer
+//    function.
+void c4_to_c4b(color4b* out, const color4* in, index_s count) {
+  pack_unorm8(out->i, in->f, count * 4);
+}
+
+void c4_premultiply(color4* colors, index_s count) {
+  index_s i = 0;
+#ifdef COLOR_SSE2
+  const __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  for (; i < count; ++i) {
+    __m128 v = _mm_loadu_ps(colors[i].f);
+    __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 p = _mm_mul_ps(v, a);
+    p = _mm_or_ps(_mm_and_ps(rgb, p), _mm_andnot_ps(rgb, v));
+    _mm_storeu_ps(colors[i].f, p);
+  }
+#endif
+  for (; i < count; ++i) {
+    color4* c = &colors[i];
+    c->r *= c->a;
+    c->g *= c->a;
+    c->b *= c->a;
+  }
+}
+
+void c4_unpremultiply(color4* colors, index_s count) {
+  index_s i = 0;
+#ifdef COLOR_SSE2
+  const __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 zero = _mm_setzero_ps();
+  for (; i < count; ++i) {
+    __m128 v = _mm_loadu_ps(colors[i].f);
+    __m128 a = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    __m128 mask = _mm_and_ps(rgb, _mm_cmpgt_ps(a, zero));
+    __m128 p = _mm_div_ps(v, a);
+    p = _mm_or_ps(_mm_and_ps(mask, p), _mm_andnot_ps(mask, v));
+    _mm_storeu_ps(colors[i].f, p);
+  }
+#endif
+  for (; i < count; ++i) {
+    color4* c = &colors[i];
+    if (!(c->a > 0)) continue;
+    c->r /= c->a;
+    c->g /= c->a;
+    c->b /= c->a;
+  }
+}
+
+// exact round(c * a / 255) without a divide
+static inline byte color_mul8(uint c, uint a) {
+  uint t = c * a + 128;
+  return (byte)((t + (t >> 8)) >> 8);
+}
+
+void c4b_premultiply(color4b* colors, index_s count) {
+  index_s i = 0;
+#ifdef COLOR_SSE2
+  // processes 4 pixels at once as 16-bit lanes. The alpha lane multiplies by
+  //    255, which the rounding divide turns back into the original alpha.
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha_lanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+  const __m128i alpha_255 = _mm_and_si128(alpha_lanes, _mm_set1_epi16(255));
+  const __m128i round = _mm_set1_epi16(128);
+  for (; i + 4 <= count; i += 4) {
+    __m128i px = _mm_loadu_si128((const __m128i*)colors[i].i);
+    __m128i half[2] = {
+      _mm_unpacklo_epi8(px, zero), _mm_unpackhi_epi8(px, zero)
+    };
+    for (int h = 0; h < 2; ++h) {
+      __m128i a = _mm_shufflelo_epi16(half[h], _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm_shufflehi_epi16(a, _MM_SHUFFLE(3, 3, 3, 3));
+      a = _mm_or_si128(_mm_andnot_si128(alpha_lanes, a), alpha_255);
+      __m128i t = _mm_add_epi16(_mm_mullo_epi16(half[h], a), round);
+      half[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    }
+    _mm_storeu_si128((__m128i*)colors[i].i, _mm_packus_epi16(half[0], half[1]));
+  }
+#endif
+  for (; i < count; ++i) {
+    color4b* c = &colors[i];
+    c->r = color_mul8(c->r, c->a);
+    c->g = color_mul8(c->g, c->a);
+    c->b = color_mul8(c->b, c->a);
+  }
+}
+
+void c4b_unpremultiply(color4b* colors, index_s count) {
+  for (index_s i = 0; i < count; ++i) {
+    color4b* c = &colors[i];
+    uint a = c->a;
+    if (a == 0 || a == 255) continue;
+    c->r = (byte)MIN(255u, (c->r * 255u + a / 2) / a);
+    c->g = (byte)MIN(255u, (c->g * 255u + a / 2) / a);
+    c->b = (byte)MIN(255u, (c->b * 255u + a / 2) / a);
+  }
+}
+
+void c4b_srgb_to_linear(color4* out, const color4b* in, index_s count) {
+  for (index_s i = 0; i < count; ++i) {
+    color4b c = in[i];
+    out[i] = v4f(
+      color_srgb8_to_linear[c.r],
+      color_srgb8_to_linear[c.g],
+      color_srgb8_to_linear[c.b],
+      un8tof(c.a)
+    );
+  }
+}
+
+void c4_linear_to_srgb(color4b* out, const color4* in, index_s count) {
+  for (index_s i = 0; i < count; ++i) {
+    color4 c = in[i];
+    out[i] = (color4b){.i={
+      color_linear_to_srgb8(c.r),
+      color_linear_to_srgb8(c.g),
+      color_linear_to_srgb8(c.b),
+      ftoun8(c.a)
+    }};
+  }
+}
+
+void c4_srgb_to_linear_fast(color4* colors, index_s count) {
+  index_s i = 0;
+#ifdef COLOR_SSE2
+  const __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 c0 = _mm_set1_ps(0.305306011f);
+  const __m128 c1 = _mm_set1_ps(0.682171111f);
+  const __m128 c2 = _mm_set1_ps(0.012522878f);
+  for (; i < count; ++i) {
+    __m128 s = _mm_loadu_ps(colors[i].f);
+    __m128 l = _mm_add_ps(_mm_mul_ps(s, c0), c1);
+    l = _mm_add_ps(_mm_mul_ps(s, l), c2);
+    l = _mm_mul_ps(s, l);
+    l = _mm_or_ps(_mm_and_ps(rgb, l), _mm_andnot_ps(rgb, s));
+    _mm_storeu_ps(colors[i].f, l);
+  }
+#endif
+  for (; i < count; ++i) {
+    color4* c = &colors[i];
+    c->r = srgb_to_linear_fast(c->r);
+    c->g = srgb_to_linear_fast(c->g);
+    c->b = srgb_to_linear_fast(c->b);
+  }
+}
+
+void c4_linear_to_srgb_fast(color4* colors, index_s count) {
+  index_s i = 0;
+#ifdef COLOR_SSE2
+  const __m128 rgb = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one = _mm_set1_ps(1.0f);
+  const __m128 c0 = _mm_set1_ps(0.585122381f);
+  const __m128 c1 = _mm_set1_ps(0.783140355f);
+  const __m128 c2 = _mm_set1_ps(0.368262736f);
+  for (; i < count; ++i) {
+    __m128 v = _mm_loadu_ps(colors[i].f);
+    __m128 l = _mm_max_ps(v, zero);
+    __m128 s1 = _mm_sqrt_ps(l);
+    __m128 s2 = _mm_sqrt_ps(s1);
+    __m128 s3 = _mm_sqrt_ps(s2);
+    __m128 s = _mm_add_ps(_mm_mul_ps(c0, s1), _mm_mul_ps(c1, s2));
+    s = _mm_min_ps(_mm_sub_ps(s, _mm_mul_ps(c2, s3)), one);
+    s = _mm_max_ps(s, zero);
+    s = _mm_or_ps(_mm_and_ps(rgb, s), _mm_andnot_ps(rgb, v));
+    _mm_storeu_ps(colors[i].f, s);
+  }
+#endif
+  for (; i < count; ++i) {
+    color4* c = &colors[i];
+    c->r = linear_to_srgb_fast(c->r);
+    c->g = linear_to_srgb_fast(c->g);
+    c->b = linear_to_srgb_fast(c->b);
+  }
+}
@@ -0,0 +1,907 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "file.h"
+#include "utility.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Platform
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+# include <malloc.h>
+
+typedef struct {
+  HANDLE file;
+  HANDLE mapping;
+} FileOs;
+
+static bool file_os_open(const char* path, FileOs* os, index_s* out_size) {
+  *os = (FileOs) { INVALID_HANDLE_VALUE, NULL };
+
+  os->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL
+  );
+  if (os->file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(os->file, &size) || size.QuadPart > PTRDIFF_MAX) {
+    CloseHandle(os->file);
+    return false;
+  }
+  *out_size = (index_s)size.QuadPart;
+
+  // empty files can't be mapped, but there's nothing to map anyway
+  if (*out_size == 0) return true;
+
+  os->mapping = CreateFileMappingA(os->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!os->mapping) {
+    CloseHandle(os->file);
+    return false;
+  }
+
+  return true;
+}
+
+static void file_os_close(FileOs* os) {
+  if (os->mapping) CloseHandle(os->mapping);
+  if (os->file != INVALID_HANDLE_VALUE) CloseHandle(os->file);
+  *os = (FileOs) { INVALID_HANDLE_VALUE, NULL };
+}
+
+static const char* file_os_map(FileOs* os, index_s offset, index_s size) {
+  unsigned long long off = (unsigned long long)offset;
+  return MapViewOfFile(os->mapping, FILE_MAP_READ,
+    (DWORD)(off >> 32), (DWORD)(off & 0xffffffff), (SIZE_T)size
+  );
+}
+
+static void file_os_unmap(const char* view, index_s size) {
+  PARAM_UNUSED(size);
+  UnmapViewOfFile(view);
+}
+
+// views must start on a multiple of the allocation granularity, not the page
+static index_s file_os_granularity(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (index_s)info.dwAllocationGranularity;
+}
+
+// Streams don't get a mapping. Standard handles are returned as-is.
+static bool file_os_open_stream(const char* path, FileOs* os, bool write) {
+  *os = (FileOs) { INVALID_HANDLE_VALUE, NULL };
+
+  if (!path) {
+    os->file = GetStdHandle(write ? STD_OUTPUT_HANDLE : STD_INPUT_HANDLE);
+    return os->file != INVALID_HANDLE_VALUE && os->file != NULL;
+  }
+
+  os->file = write
+    ? CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_NORMAL, NULL)
+    : CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+  return os->file != INVALID_HANDLE_VALUE;
+}
+
+// returns the bytes read, 0 at the end of the file or -1 on error
+static index_s file_os_read(FileOs* os, void* buffer, index_s size) {
+  DWORD read = 0;
+  DWORD request = (DWORD)MIN(size, 1 << 30);
+  if (!ReadFile(os->file, buffer, request, &read, NULL)) {
+    return GetLastError() == ERROR_BROKEN_PIPE ? 0 : -1;
+  }
+  return (index_s)read;
+}
+
+static bool file_os_write(FileOs* os, const void* buffer, index_s size) {
+  const char* bytes = buffer;
+  while (size > 0) {
+    DWORD written = 0;
+    DWORD request = (DWORD)MIN(size, 1 << 30);
+    if (!WriteFile(os->file, bytes, request, &written, NULL)) return false;
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+static void file_os_advise(const char* view, index_s size, FileAccess access) {
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+  if (access == FILE_ACCESS_WILLNEED) {
+    WIN32_MEMORY_RANGE_ENTRY entry = { (PVOID)view, (SIZE_T)size };
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+  }
+#else
+  PARAM_UNUSED(view);
+  PARAM_UNUSED(size);
+  PARAM_UNUSED(access);
+#endif
+}
+
+#else
+# include <errno.h>
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+
+typedef struct {
+  int fd;
+} FileOs;
+
+static bool file_os_open(const char* path, FileOs* os, index_s* out_size) {
+  os->fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (os->fd < 0) return false;
+
+  struct stat st;
+  if (fstat(os->fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(os->fd);
+    os->fd = -1;
+    return false;
+  }
+
+  *out_size = (index_s)st.st_size;
+  return true;
+}
+
+static void file_os_close(FileOs* os) {
+  if (os->fd >= 0) close(os->fd);
+  os->fd = -1;
+}
+
+static const char* file_os_map(FileOs* os, index_s offset, index_s size) {
+  void* view = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, os->fd,
+    (off_t)offset
+  );
+  return view == MAP_FAILED ? NULL : view;
+}
+
+static void file_os_unmap(const char* view, index_s size) {
+  munmap((void*)view, (size_t)size);
+}
+
+static index_s file_os_granularity(void) {
+  return (index_s)sysconf(_SC_PAGESIZE);
+}
+
+// Streams may be pipes or terminals. Null paths give stdin or stdout.
+static bool file_os_open_stream(const char* path, FileOs* os, bool write) {
+  if (!path) {
+    os->fd = write ? STDOUT_FILENO : STDIN_FILENO;
+    return true;
+  }
+
+  os->fd = write
+    ? open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666)
+    : open(path, O_RDONLY | O_CLOEXEC);
+
+  return os->fd >= 0;
+}
+
+// returns the bytes read, 0 at the end of the file or -1 on error
+static index_s file_os_read(FileOs* os, void* buffer, index_s size) {
+  loop {
+    ssize_t got = read(os->fd, buffer, (size_t)size);
+    if (got >= 0) return (index_s)got;
+    until (errno != EINTR);
+  }
+  return -1;
+}
+
+static bool file_os_write(FileOs* os, const void* buffer, index_s size) {
+  const char* bytes = buffer;
+  while (size > 0) {
+    ssize_t written = write(os->fd, bytes, (size_t)size);
+    if (written < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  return true;
+}
+
+static void file_os_advise(const char* view, index_s size, FileAccess access) {
+  static const int advice[] = {
+    [FILE_ACCESS_NORMAL]      = POSIX_MADV_NORMAL,
+    [FILE_ACCESS_SEQUENTIAL]  = POSIX_MADV_SEQUENTIAL,
+    [FILE_ACCESS_RANDOM]      = POSIX_MADV_RANDOM,
+    [FILE_ACCESS_WILLNEED]    = POSIX_MADV_WILLNEED,
+  };
+  posix_madvise((void*)view, (size_t)size, advice[access]);
+}
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Mapped files
+////////////////////////////////////////////////////////////////////////////////
+
+// internal opaque structure:
+typedef struct {
+  // public (read only)
+  StringRange range;
+
+  // private
+  bool mapped;                // false for empty files
+} MappedFile_Internal;
+
+#define MAPPEDFILE_INTERNAL \
+  assert(file_in); \
+  MappedFile_Internal* file = (MappedFile_Internal*)(file_in)
+
+MappedFile str_map_file(const char* path) {
+  assert(path);
+
+  FileOs os;
+  index_s size;
+  if (!file_os_open(path, &os, &size)) return NULL;
+
+  MappedFile_Internal* ret = malloc(sizeof(MappedFile_Internal));
+  assert(ret);
+  *ret = (MappedFile_Internal) { .range = str_empty->range };
+
+  if (size > 0) {
+    const char* view = file_os_map(&os, 0, size);
+    if (!view) {
+      file_os_close(&os);
+      free(ret);
+      return NULL;
+    }
+
+    ret->range = str_range_s(view, size);
+    ret->mapped = true;
+    file_os_advise(view, size, FILE_ACCESS_SEQUENTIAL);
+  }
+
+  // the mapping holds its own reference to the file
+  file_os_close(&os);
+  return (MappedFile)ret;
+}
+
+void str_unmap_file(MappedFile* file_ptr) {
+  if (!file_ptr || !*file_ptr) return;
+  MappedFile_Internal* file = (MappedFile_Internal*)*file_ptr;
+  if (file->mapped) file_os_unmap(file->range.begin, file->range.size);
+  free(file);
+  *file_ptr = NULL;
+}
+
+// \brief Changes the OS paging hint for the whole file. Only WILLNEED has an
+//    effect on Windows.
+void str_map_advise(MappedFile file_in, FileAccess access) {
+  MAPPEDFILE_INTERNAL;
+  if (!file->mapped) return;
+  file_os_advise(file->range.begin, file->range.size, access);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Line reader
+////////////////////////////////////////////////////////////////////////////////
+
+// internal opaque structure:
+typedef struct {
+  // public (read only)
+  index_s line_number;
+  index_s offset;
+  index_s file_size;
+
+  // private
+  FileOs os;
+  index_s granularity;
+  index_s window_size;
+  index_s next;               // file offset of the next line
+  const char* view;
+  index_s view_offset;        // file offset of the view, granularity aligned
+  index_s view_size;
+} LineReader_Internal;
+
+#define LINEREADER_INTERNAL \
+  assert(reader_in); \
+  LineReader_Internal* reader = (LineReader_Internal*)(reader_in)
+
+// \brief Opens a file for line by line reading, mapping window_size bytes at
+//    a time (rounded up to the mapping granularity).
+//
+// \returns A new LineReader, or NULL if the file couldn't be opened.
+LineReader line_reader_new_window(const char* path, index_s window_size) {
+  assert(path);
+
+  LineReader_Internal* ret = malloc(sizeof(LineReader_Internal));
+  assert(ret);
+  *ret = (LineReader_Internal) { 0 };
+
+  if (!file_os_open(path, &ret->os, &ret->file_size)) {
+    free(ret);
+    return NULL;
+  }
+
+  ret->granularity = file_os_granularity();
+  window_size = MAX(window_size, ret->granularity);
+  ret->window_size = (window_size + ret->granularity - 1)
+    / ret->granularity * ret->granularity;
+
+  return (LineReader)ret;
+}
+
+void line_reader_delete(LineReader* reader_ptr) {
+  if (!reader_ptr || !*reader_ptr) return;
+  LineReader_Internal* reader = (LineReader_Internal*)*reader_ptr;
+  if (reader->view) file_os_unmap(reader->view, reader->view_size);
+  file_os_close(&reader->os);
+  free(reader);
+  *reader_ptr = NULL;
+}
+
+// Maps the window holding the next line, returns false if mapping failed
+static bool line_reader_slide(LineReader_Internal* reader) {
+  index_s offset = reader->next - reader->next % reader->granularity;
+
+  // the line didn't fit in a window starting at the same place, grow it
+  if (reader->view && reader->view_offset == offset) {
+    reader->window_size *= 2;
+  }
+
+  if (reader->view) file_os_unmap(reader->view, reader->view_size);
+
+  reader->view_offset = offset;
+  reader->view_size = MIN(reader->window_size, reader->file_size - offset);
+  reader->view = file_os_map(&reader->os, offset, reader->view_size);
+  if (!reader->view) return false;
+
+  file_os_advise(reader->view, reader->view_size, FILE_ACCESS_SEQUENTIAL);
+  return true;
+}
+
+// \brief Reads the next line into out_line.
+//
+// \returns False at the end of the file, or if the file couldn't be mapped.
+bool line_reader_next(LineReader reader_in, StringRange* out_line) {
+  LINEREADER_INTERNAL;
+  assert(out_line);
+
+  if (reader->next >= reader->file_size) return false;
+
+  loop {
+    index_s view_end = reader->view_offset + reader->view_size;
+
+    if (reader->view && reader->next < view_end) {
+      const char* begin = reader->view + (reader->next - reader->view_offset);
+      index_s available = view_end - reader->next;
+      const char* newline = memchr(begin, '\n', available);
+
+      if (newline || view_end == reader->file_size) {
+        index_s length = newline ? newline - begin : available;
+        reader->offset = reader->next;
+        reader->next += newline ? length + 1 : length;
+        ++reader->line_number;
+
+        if (newline && length > 0 && begin[length - 1] == '\r') --length;
+        *out_line = str_range_s(begin, length);
+        return true;
+      }
+    }
+
+    until (!line_reader_slide(reader));
+  }
+
+  return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffers
+////////////////////////////////////////////////////////////////////////////////
+
+static char* file_buffer_alloc(index_s size) {
+  size = (size + FILE_BUFFER_ALIGN - 1) / FILE_BUFFER_ALIGN * FILE_BUFFER_ALIGN;
+#ifdef _WIN32
+  char* ret = _aligned_malloc((size_t)size, FILE_BUFFER_ALIGN);
+#else
+  char* ret = aligned_alloc(FILE_BUFFER_ALIGN, (size_t)size);
+#endif
+  return ret;
+}
+
+static void file_buffer_free(char* buffer) {
+#ifdef _WIN32
+  _aligned_free(buffer);
+#else
+  free(buffer);
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffered reader
+////////////////////////////////////////////////////////////////////////////////
+
+// internal opaque structure:
+typedef struct {
+  // public (read only)
+  index_s position;
+
+  // private
+  FileOs os;
+  bool owned;                 // false for stdin, which is left open
+  bool eof;
+  char* buffer;
+  index_s capacity;
+  index_s start;              // unread data is [start, end)
+  index_s end;
+} FileReader_Internal;
+
+#define FILEREADER_INTERNAL \
+  assert(reader_in); \
+  FileReader_Internal* reader = (FileReader_Internal*)(reader_in)
+
+static FileReader file_reader_new(const char* path) {
+  FileOs os;
+  if (!file_os_open_stream(path, &os, false)) return NULL;
+
+  char* buffer = file_buffer_alloc(FILE_BUFFER_SIZE);
+  if (!buffer) {
+    if (path) file_os_close(&os);
+    return NULL;
+  }
+
+  FileReader_Internal* ret = malloc(sizeof(FileReader_Internal));
+  assert(ret);
+
+  *ret = (FileReader_Internal) {
+    .os = os,
+    .owned = path != NULL,
+    .buffer = buffer,
+    .capacity = FILE_BUFFER_SIZE,
+  };
+
+  return (FileReader)ret;
+}
+
+// \brief Opens a file for buffered reading.
+//
+// \returns A new FileReader, or NULL if the file couldn't be opened or its
+//    buffer allocated.
+FileReader file_reader_open(const char* path) {
+  assert(path);
+  return file_reader_new(path);
+}
+
+// \brief Wraps standard input. Closing the reader leaves stdin open.
+FileReader file_reader_stdin(void) {
+  return file_reader_new(NULL);
+}
+
+void file_reader_close(FileReader* reader_ptr) {
+  if (!reader_ptr || !*reader_ptr) return;
+  FileReader_Internal* reader = (FileReader_Internal*)*reader_ptr;
+  if (reader->owned) file_os_close(&reader->os);
+  file_buffer_free(reader->buffer);
+  free(reader);
+  *reader_ptr = NULL;
+}
+
+// Moves the unread data to the front of the buffer and grows it until it
+//    can hold at least min_capacity bytes
+static void reader_reserve(FileReader_Internal* reader, index_s min_capacity) {
+  index_s unread = reader->end - reader->start;
+
+  if (reader->start > 0) {
+    memmove(reader->buffer, reader->buffer + reader->start, unread);
+    reader->start = 0;
+    reader->end = unread;
+  }
+
+  if (reader->capacity >= min_capacity) return;
+
+  index_s capacity = reader->capacity;
+  while (capacity < min_capacity) capacity *= 2;
+
+  char* buffer = file_buffer_alloc(capacity);
+  assert(buffer);
+  memcpy(buffer, reader->buffer, unread);
+  file_buffer_free(reader->buffer);
+  reader->buffer = buffer;
+  reader->capacity = capacity;
+}
+
+// Reads more data after the unread bytes, returns false at the end of the
+//    file. Reading moves the buffer, invalidating ranges handed out before.
+static bool reader_fill(FileReader_Internal* reader) {
+  if (reader->eof) return false;
+
+  // compact once less than half the buffer is free, grow once it's all unread
+  if (reader->capacity - reader->end < reader->capacity / 2) {
+    index_s unread = reader->end - reader->start;
+    reader_reserve(reader, unread == reader->capacity ? unread + 1 : unread);
+  }
+
+  index_s got = file_os_read(&reader->os,
+    reader->buffer + reader->end, reader->capacity - reader->end
+  );
+
+  if (got <= 0) {
+    reader->eof = true;
+    return false;
+  }
+
+  reader->end += got;
+  return true;
+}
+
+static StringRange reader_take(FileReader_Internal* reader, index_s size) {
+  StringRange ret = str_range_s(reader->buffer + reader->start, size);
+  reader->start += size;
+  reader->position += size;
+  return ret;
+}
+
+static bool reader_until(FileReader_Internal* reader, char delim,
+  StringRange* out, bool* out_found
+) {
+  index_s scanned = 0;
+
+  loop {
+    const char* begin = reader->buffer + reader->start;
+    index_s unread = reader->end - reader->start;
+    const char* found = memchr(begin + scanned, delim, unread - scanned);
+
+    if (found) {
+      *out = reader_take(reader, found - begin);
+      ++reader->start;
+      ++reader->position;
+      *out_found = true;
+      return true;
+    }
+
+    scanned = unread;
+    until (!reader_fill(reader));
+  }
+
+  // end of file, the rest is the last piece
+  *out_found = false;
+  if (reader->start == reader->end) return false;
+  *out = reader_take(reader, reader->end - reader->start);
+  return true;
+}
+
+// \brief Reads up to the next delim, which is consumed but not included in
+//    the result. The last piece of the file doesn't need a delimiter.
+//
+// \returns False once the file has been fully read.
+bool file_read_until(FileReader reader_in, char delim, StringRange* out) {
+  FILEREADER_INTERNAL;
+  assert(out);
+  bool found;
+  return reader_until(reader, delim, out, &found);
+}
+
+// \brief Reads the next line, without its "\n" or "\r\n". A final newline
+//    doesn't start another, empty line.
+//
+// \returns False once the file has been fully read.
+bool file_read_line(FileReader reader_in, StringRange* out_line) {
+  FILEREADER_INTERNAL;
+  assert(out_line);
+
+  bool found;
+  if (!reader_until(reader, '\n', out_line, &found)) return false;
+
+  index_s size = out_line->size;
+  if (found && size > 0 && out_line->begin[size - 1] == '\r') {
+    --out_line->size;
+  }
+
+  return true;
+}
+
+// \brief Reads exactly count bytes.
+//
+// \returns False if the file ends first, in which case nothing is consumed.
+bool file_read_exact(FileReader reader_in, index_s count, StringRange* out) {
+  FILEREADER_INTERNAL;
+  assert(out && count >= 0);
+
+  if (reader->end - reader->start < count) {
+    if (reader->capacity - reader->start < count) {
+      reader_reserve(reader, count);
+    }
+
+    while (reader->end - reader->start < count) {
+      if (!reader_fill(reader)) return false;
+    }
+  }
+
+  *out = reader_take(reader, count);
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Buffered writer
+////////////////////////////////////////////////////////////////////////////////
+
+// internal opaque structure:
+typedef struct {
+  // public (read only)
+  index_s written;
+  bool error;
+
+  // private
+  FileOs os;
+  bool owned;                 // false for stdout, which is left open
+  char* buffer;
+  index_s capacity;
+  index_s size;
+} FileWriter_Internal;
+
+#define FILEWRITER_INTERNAL \
+  assert(writer_in); \
+  FileWriter_Internal* writer = (FileWriter_Internal*)(writer_in)
+
+static FileWriter file_writer_new(const char* path) {
+  FileOs os;
+  if (!file_os_open_stream(path, &os, true)) return NULL;
+
+  char* buffer = file_buffer_alloc(FILE_BUFFER_SIZE);
+  if (!buffer) {
+    if (path) file_os_close(&os);
+    return NULL;
+  }
+
+  FileWriter_Internal* ret = malloc(sizeof(FileWriter_Internal));
+  assert(ret);
+
+  *ret = (FileWriter_Internal) {
+    .os = os,
+    .owned = path != NULL,
+    .buffer = buffer,
+    .capacity = FILE_BUFFER_SIZE,
+  };
+
+  return (FileWriter)ret;
+}
+
+// \brief Creates or truncates a file for buffered writing.
+//
+// \returns A new FileWriter, or NULL if the file couldn't be opened or its
+//    buffer allocated.
+FileWriter file_writer_open(const char* path) {
+  assert(path);
+  return file_writer_new(path);
+}
+
+// \brief Wraps standard output. Closing the writer flushes it but leaves
+//    stdout open. Don't mix with printf without flushing both.
+FileWriter file_writer_stdout(void) {
+  return file_writer_new(NULL);
+}
+
+// \brief Writes out everything buffered so far.
+//
+// \returns False if this or any earlier write failed.
+bool file_writer_flush(FileWriter writer_in) {
+  FILEWRITER_INTERNAL;
+
+  if (writer->size > 0 && !writer->error) {
+    if (!file_os_write(&writer->os, writer->buffer, writer->size)) {
+      writer->error = true;
+    }
+  }
+
+  writer->size = 0;
+  return !writer->error;
+}
+
+// \brief Flushes and closes the writer.
+//
+// \returns False if any write failed.
+bool file_writer_close(FileWriter* writer_ptr) {
+  if (!writer_ptr || !*writer_ptr) return false;
+  FileWriter_Internal* writer = (FileWriter_Internal*)*writer_ptr;
+  bool ok = file_writer_flush(*writer_ptr);
+  if (writer->owned) file_os_close(&writer->os);
+  file_buffer_free(writer->buffer);
+  free(writer);
+  *writer_ptr = NULL;
+  return ok;
+}
+
+void file_write_range(FileWriter writer_in, StringRange str) {
+  FILEWRITER_INTERNAL;
+  if (writer->error || str.size <= 0) return;
+
+  writer->written += str.size;
+
+  if (writer->size + str.size > writer->capacity) {
+    file_writer_flush(writer_in);
+
+    // too big to be worth buffering
+    if (str.size >= writer->capacity) {
+      if (!file_os_write(&writer->os, str.begin, str.size)) {
+        writer->error = true;
+      }
+      return;
+    }
+  }
+
+  memcpy(writer->buffer + writer->size, str.begin, str.size);
+  writer->size += str.size;
+}
+
+void file_write_char(FileWriter writer_in, char c) {
+  FILEWRITER_INTERNAL;
+  if (writer->error) return;
+  if (writer->size == writer->capacity) file_writer_flush(writer_in);
+  writer->buffer[writer->size++] = c;
+  ++writer->written;
+}
+
+void file_write_int(FileWriter writer_in, long long value) {
+  char digits[LLTOS_BUFFER_SIZE];
+  file_write_range(writer_in, str_range_s(digits, lltos_to(digits, value)));
+}
+
+// Fixed-point formatting straight from the bits of the double. A double is
+//    m * 2^e with m below 2^53, so its integer part and its fraction are both
+//    exact in 32-bit limbs: up to 1024 bits for the integer, and up to
+//    1074 + 32 for the fraction. Ties round to even, as printf does.
+#define FILE_FLOAT_LIMBS 36
+
+// Sign, the 309 integer digits of the largest double, a carry from rounding,
+//    the point and 20 decimal places
+#define FILE_FLOAT_BUFFER_SIZE 352
+
+// Writes the integer part m * 2^shift backwards, ending at end
+static char* file_float_integer(char* end, unsigned long long m, int shift) {
+  if (shift <= 11) {
+    unsigned long long n = m << shift;
+    do {
+      *--end = (char)('0' + n % 10);
+      n /= 10;
+    } while (n);
+    return end;
+  }
+
+  // too big for 64 bits: divide limbs by 10^9, nine digits at a time
+  unsigned limbs[FILE_FLOAT_LIMBS] = { 0 };
+  int count = (shift + 53 + 31) / 32;
+  for (int i = 0; i < 3; ++i) {
+    int bit = 32 * i - shift % 32;
+    if (bit >= 64 || shift / 32 + i >= count) break;
+    limbs[shift / 32 + i] = (unsigned)(bit >= 0 ? m >> bit : m << -bit);
+  }
+
+  while (count) {
+    unsigned long long rem = 0;
+    for (int i = count - 1; i >= 0; --i) {
+      unsigned long long x = (rem << 32) | limbs[i];
+      limbs[i] = (unsigned)(x / 1000000000);
+      rem = x % 1000000000;
+    }
+    while (count && !limbs[count - 1]) --count;
+
+    for (int d = 0; d < 9 && (count || rem); ++d) {
+      *--end = (char)('0' + rem % 10);
+      rem /= 10;
+    }
+  }
+  return end;
+}
+
+// Writes value with precision decimal places, returns the length
+static index_s file_float_fixed(char* out, double value, int precision) {
+  unsigned long long bits;
+  memcpy(&bits, &value, sizeof(bits));
+
+  char* c = out;
+  if (bits >> 63) *c++ = '-';
+
+  int biased = (int)(bits >> 52) & 0x7FF;
+  unsigned long long m = bits & ((1ull << 52) - 1);
+  if (biased == 0x7FF) {
+    memcpy(c, m ? "nan" : "inf", 3);
+    return c - out + 3;
+  }
+  int e = biased ? biased - 1075 : -1074;
+  if (biased) m |= 1ull << 52;
+
+  // the fraction as 0.limbs, most significant limb first
+  unsigned frac[FILE_FLOAT_LIMBS] = { 0 };
+  int frac_limbs = 0;
+  unsigned long long integer = m;
+  int shift = MAX(e, 0);
+  if (e < 0) {
+    int k = -e;
+    unsigned long long f = k < 64 ? m & ((1ull << k) - 1) : m;
+    integer = k < 64 ? m >> k : 0;
+    frac_limbs = (k + 31) / 32;
+    int s = frac_limbs * 32 - k;
+    for (int i = 0; i < 3 && i < frac_limbs; ++i) {
+      int bit = 32 * i - s;
+      if (bit < 64) {
+        frac[frac_limbs - 1 - i] = (unsigned)(bit >= 0 ? f >> bit : f << -bit);
+      }
+    }
+  }
+
+  char digits[FILE_FLOAT_BUFFER_SIZE];
+  char* end = digits + sizeof(digits);
+  char* begin = file_float_integer(end - precision, integer, shift);
+
+  for (int d = 0; d < precision; ++d) {
+    unsigned long long carry = 0;
+    for (int i = frac_limbs - 1; i >= 0; --i) {
+      unsigned long long x = (unsigned long long)frac[i] * 10 + carry;
+      frac[i] = (unsigned)x;
+      carry = x >> 32;
+    }
+    end[d - precision] = (char)('0' + carry);
+  }
+
+  // round on what's left of the fraction, carrying into the digits before
+  bool half = frac_limbs && frac[0] >= 0x80000000u;
+  if (half && frac[0] == 0x80000000u) {
+    bool exact = true;
+    for (int i = 1; i < frac_limbs && exact; ++i) exact = !frac[i];
+    half = !exact || (end[-1] - '0') % 2;
+  }
+  if (half) {
+    char* d = end - 1;
+    while (d >= begin && *d == '9') *d-- = '0';
+    if (d >= begin) ++*d;
+    else *--begin = '1';
+  }
+
+  index_s integer_size = end - precision - begin;
+  memcpy(c, begin, integer_size);
+  c += integer_size;
+  if (precision) {
+    *c++ = '.';
+    memcpy(c, end - precision, precision);
+    c += precision;
+  }
+  return c - out;
+}
+
+// \brief Writes value with a fixed number of decimal places, clamped to 0-20.
+void file_write_float(FileWriter writer_in, double value, int precision) {
+  char text[FILE_FLOAT_BUFFER_SIZE];
+  precision = MAX(0, MIN(precision, 20));
+  file_write_range(writer_in,
+    str_range_s(text, file_float_fixed(text, value, precision))
+  );
+}
+
+// \brief Writes and then deletes a string, used by file_write_format.
+void _file_write_owned(FileWriter writer_in, String str) {
+  if (!str) return;
+  file_write_range(writer_in, str->range);
+  str_delete(&str);
+}
@@ -0,0 +1,838 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "geom.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define GEOM_SSE2
+# include <emmintrin.h>
+#endif
+
+// Twice the signed area of the triangle ABC, positive when counter-clockwise.
+//    Evaluated in double so the products of float differences are exact.
+static double geom_orient(vec2 A, vec2 B, vec2 C) {
+  return ((double)B.x - A.x) * ((double)C.y - A.y)
+       - ((double)B.y - A.y) * ((double)C.x - A.x);
+}
+
+// \brief Gets the signed area of a polygon, positive if its vertices wind
+//    counter-clockwise.
+float geom_area_s(const vec2* polygon, index_s count) {
+  assert(polygon || !count);
+  double sum = 0;
+  for (index_s i = 0, j = count - 1; i < count; j = i++) {
+    sum += (double)polygon[j].x * polygon[i].y
+         - (double)polygon[i].x * polygon[j].y;
+  }
+  return (float)(sum / 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Convex hull
+////////////////////////////////////////////////////////////////////////////////
+
+static int geom_cmp_xy(const void* lhs, const void* rhs) {
+  const vec2* a = lhs;
+  const vec2* b = rhs;
+  if (a->x != b->x) return a->x < b->x ? -1 : 1;
+  if (a->y != b->y) return a->y < b->y ? -1 : 1;
+  return 0;
+}
+
+// \brief Computes the convex hull of a point set with Andrew's monotone chain
+//    algorithm in O(n log n).
+//
+// \brief Hull vertices are appended to out in counter-clockwise order starting
+//    from the point with the lowest x (then lowest y). Duplicate points and
+//    points lying along a hull edge are not included.
+//
+// \returns The number of vertices appended.
+index_s geom_hull_s(const vec2* points, index_s count, Array_vec2 out) {
+  assert(points || !count);
+  assert(out);
+  if (count <= 0) return 0;
+
+  // sorted copy of the input followed by the hull stack, which can hold up to
+  //    one more than the number of points while the chains are closed
+  vec2* sorted = malloc(sizeof(vec2) * (2 * count + 1));
+  vec2* hull = sorted + count;
+  memcpy(sorted, points, sizeof(vec2) * count);
+  qsort(sorted, count, sizeof(vec2), geom_cmp_xy);
+
+  index_s n = 1;
+  for (index_s i = 1; i < count; ++i) {
+    if (geom_cmp_xy(&sorted[i], &sorted[n - 1])) sorted[n++] = sorted[i];
+  }
+
+  index_s k = 0;
+  if (n == 1) {
+    hull[k++] = sorted[0];
+  } else {
+    // lower chain, left to right
+    for (index_s i = 0; i < n; ++i) {
+      while (k >= 2 && geom_orient(hull[k - 2], hull[k - 1], sorted[i]) <= 0) {
+        --k;
+      }
+      hull[k++] = sorted[i];
+    }
+
+    // upper chain, right to left, ending on the first point again
+    for (index_s i = n - 2, lower = k + 1; i >= 0; --i) {
+      while (k >= lower && geom_orient(hull[k-2], hull[k-1], sorted[i]) <= 0) {
+        --k;
+      }
+      hull[k++] = sorted[i];
+    }
+    --k;
+  }
+
+  memcpy(arr_v2_emplace_back_range(out, k), hull, sizeof(vec2) * k);
+  free(sorted);
+  return k;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Triangulation
+////////////////////////////////////////////////////////////////////////////////
+
+// Ear clipping state. Remaining vertices form a circular list in
+//    counter-clockwise order, and reflex vertices are also kept in their own
+//    list since they're the only ones that can invalidate an ear.
+typedef struct {
+  const vec2* points;
+  index_s* prev;
+  index_s* next;
+  index_s* reflex_prev;
+  index_s* reflex_next;
+  index_s reflex_head;
+  byte* is_reflex;
+} GeomEarList;
+
+static void geom_unlink_reflex(GeomEarList* list, index_s i) {
+  index_s p = list->reflex_prev[i], n = list->reflex_next[i];
+  if (p >= 0) list->reflex_next[p] = n;
+  else list->reflex_head = n;
+  if (n >= 0) list->reflex_prev[n] = p;
+  list->is_reflex[i] = FALSE;
+}
+
+// Collinear vertices count as reflex, since they can't be the tip of an ear.
+static double geom_ear_orient(const GeomEarList* list, index_s i) {
+  return geom_orient(
+    list->points[list->prev[i]], list->points[i], list->points[list->next[i]]
+  );
+}
+
+static bool geom_is_ear(const GeomEarList* list, index_s i) {
+  if (list->is_reflex[i]) return FALSE;
+
+  index_s ip = list->prev[i], in = list->next[i];
+  vec2 A = list->points[ip], B = list->points[i], C = list->points[in];
+
+  for (index_s r = list->reflex_head; r >= 0; r = list->reflex_next[r]) {
+    if (r == ip || r == in) continue;
+    vec2 P = list->points[r];
+    if (geom_orient(A, B, P) >= 0 &&
+        geom_orient(B, C, P) >= 0 &&
+        geom_orient(C, A, P) >= 0
+    ) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+// \brief Triangulates a simple polygon by ear clipping.
+//
+// \brief Only reflex vertices are tested against each candidate ear, so convex
+//    polygons are triangulated in linear time and the general case is O(n * r)
+//    for r reflex vertices.
+//
+// \param out - an array created with array_new(index_s) that receives three
+//    polygon vertex indices per triangle, each triangle wound
+//    counter-clockwise. Collinear vertices don't produce degenerate triangles,
+//    so there may be fewer than count - 2 triangles.
+//
+// \returns The number of triangles appended.
+index_s geom_triangulate_s(const vec2* polygon, index_s count, Array out) {
+  assert(polygon || !count);
+  assert(out);
+  assert(out->element_size == sizeof(index_s));
+  if (count < 3) return 0;
+
+  index_s* links = malloc(sizeof(index_s) * count * 4 + count);
+  GeomEarList list = {
+    .points = polygon,
+    .prev = links,
+    .next = links + count,
+    .reflex_prev = links + count * 2,
+    .reflex_next = links + count * 3,
+    .reflex_head = -1,
+    .is_reflex = (byte*)(links + count * 4),
+  };
+
+  // link the vertices so that traversal by next is always counter-clockwise
+  bool ccw = geom_area_s(polygon, count) >= 0;
+  for (index_s i = 0; i < count; ++i) {
+    index_s a = i == 0 ? count - 1 : i - 1;
+    index_s b = i == count - 1 ? 0 : i + 1;
+    list.prev[i] = ccw ? a : b;
+    list.next[i] = ccw ? b : a;
+  }
+
+  for (index_s i = count - 1; i >= 0; --i) {
+    list.is_reflex[i] = geom_ear_orient(&list, i) <= 0;
+    if (!list.is_reflex[i]) continue;
+    list.reflex_prev[i] = -1;
+    list.reflex_next[i] = list.reflex_head;
+    if (list.reflex_head >= 0) list.reflex_prev[list.reflex_head] = i;
+    list.reflex_head = i;
+  }
+
+  index_s start_size = out->size;
+  index_s remaining = count;
+  index_s i = 0;
+  index_s misses = 0;
+
+  while (remaining > 2) {
+    index_s ip = list.prev[i], in = list.next[i];
+    double area = geom_ear_orient(&list, i);
+
+    // a full lap without an ear means the input wasn't simple, so clip
+    //    anyway rather than looping forever
+    if (area != 0 && !geom_is_ear(&list, i) && misses++ < remaining) {
+      i = in;
+      continue;
+    }
+
+    if (area > 0) {
+      index_s* tri = array_emplace_back_range(out, 3);
+      tri[0] = ip; tri[1] = i; tri[2] = in;
+    }
+
+    if (list.is_reflex[i]) geom_unlink_reflex(&list, i);
+    list.next[ip] = in;
+    list.prev[in] = ip;
+    --remaining;
+    misses = 0;
+
+    // removing the ear can only make its neighbours convex, not reflex
+    if (list.is_reflex[ip] && geom_ear_orient(&list, ip) > 0) {
+      geom_unlink_reflex(&list, ip);
+    }
+    if (list.is_reflex[in] && geom_ear_orient(&list, in) > 0) {
+      geom_unlink_reflex(&list, in);
+    }
+
+    // step back so the previous vertex, which may have just become an ear,
+    //    is retested first
+    i = ip;
+  }
+
+  free(links);
+  return (out->size - start_size) / 3;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Point in polygon
+////////////////////////////////////////////////////////////////////////////////
+
+// Edges are tested with a half-open crossing rule against the ray towards +x,
+//    with the crossing point computed from a precomputed inverse slope so the
+//    scalar and SIMD paths agree on every point.
+static float geom_edge_slope(vec2 A, vec2 B) {
+  return A.y == B.y ? 0 : (B.x - A.x) / (B.y - A.y);
+}
+
+// \brief Tests if P is inside the polygon using the even-odd rule.
+bool geom_contains_s(const vec2* polygon, index_s count, vec2 P) {
+  assert(polygon || !count);
+  bool inside = FALSE;
+
+  for (index_s i = 0, j = count - 1; i < count; j = i++) {
+    vec2 A = polygon[j], B = polygon[i];
+    if ((A.y > P.y) != (B.y > P.y) &&
+        P.x < A.x + (P.y - A.y) * geom_edge_slope(A, B)
+    ) {
+      inside = !inside;
+    }
+  }
+
+  return inside;
+}
+
+// \brief Tests many points against the same polygon, with the same results as
+//    geom_contains_s. The polygon edges are set up once, then tested against
+//    four points at a time with SSE2 when available.
+//
+// \param out - buffer of at least count elements that receives the results.
+void geom_contains_batch_s(
+  const vec2* polygon, index_s poly_count,
+  const vec2* points, index_s count, bool* out
+) {
+  assert(polygon || !poly_count);
+  assert(points || !count);
+  assert(out || !count);
+  if (count <= 0) return;
+
+  // edges as structure of arrays: start x, start y, end y, inverse slope
+  float* edges = malloc(sizeof(float) * 4 * (poly_count ? poly_count : 1));
+  float* ax = edges;
+  float* ay = edges + poly_count;
+  float* by = edges + poly_count * 2;
+  float* slope = edges + poly_count * 3;
+
+  for (index_s i = 0, j = poly_count - 1; i < poly_count; j = i++) {
+    ax[i] = polygon[j].x;
+    ay[i] = polygon[j].y;
+    by[i] = polygon[i].y;
+    slope[i] = geom_edge_slope(polygon[j], polygon[i]);
+  }
+
+  index_s p = 0;
+
+#ifdef GEOM_SSE2
+  for (; p + 4 <= count; p += 4) {
+    __m128 lo = _mm_loadu_ps(points[p].f);
+    __m128 hi = _mm_loadu_ps(points[p + 2].f);
+    __m128 px = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    __m128 py = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+    __m128 inside = _mm_setzero_ps();
+
+    for (index_s e = 0; e < poly_count; ++e) {
+      __m128 eay = _mm_set1_ps(ay[e]);
+      __m128 cross_y = _mm_xor_ps(
+        _mm_cmpgt_ps(eay, py), _mm_cmpgt_ps(_mm_set1_ps(by[e]), py)
+      );
+      __m128 x = _mm_add_ps(_mm_set1_ps(ax[e]),
+        _mm_mul_ps(_mm_sub_ps(py, eay), _mm_set1_ps(slope[e]))
+      );
+      inside = _mm_xor_ps(inside, _mm_and_ps(cross_y, _mm_cmplt_ps(px, x)));
+    }
+
+    int mask = _mm_movemask_ps(inside);
+    out[p + 0] = (mask & 1) != 0;
+    out[p + 1] = (mask & 2) != 0;
+    out[p + 2] = (mask & 4) != 0;
+    out[p + 3] = (mask & 8) != 0;
+  }
+#endif
+
+  for (; p < count; ++p) {
+    vec2 P = points[p];
+    bool inside = FALSE;
+    for (index_s e = 0; e < poly_count; ++e) {
+      if ((ay[e] > P.y) != (by[e] > P.y) &&
+          P.x < ax[e] + (P.y - ay[e]) * slope[e]
+      ) {
+        inside = !inside;
+      }
+    }
+    out[p] = inside;
+  }
+
+  free(edges);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Segment intersection (Bentley-Ottmann)
+////////////////////////////////////////////////////////////////////////////////
+
+// The sweep line moves in increasing x, with ties broken by increasing y, and
+//    segments are normalized so a comes before b in that order.
+//
+// The status (segments crossing the sweep line, bottom to top) is a treap
+//    threaded with a linked list for neighbour access. Treap nodes are owned
+//    by segments, and a crossing swaps the segments of two adjacent nodes
+//    rather than moving nodes around.
+//
+// Orientation tests on input points are exact in double, so segments are only
+//    ever compared against exact endpoints. Computed crossing points are only
+//    used to order crossing events and for the reported location. Touching,
+//    collinear and shared-endpoint cases are all handled when the sweep
+//    reaches the endpoint involved, by scanning the run of status segments
+//    passing through it.
+
+typedef struct {
+  double x, y;
+  index_s lo, hi;
+} GeomCross;
+
+typedef struct {
+  vec2 P;
+  index_s seg;
+  bool start;
+} GeomEndpoint;
+
+typedef struct {
+  seg2* segs;
+  index_s count;
+
+  // status treap, indexed by node
+  index_s* left;
+  index_s* right;
+  index_s* parent;
+  index_s* prev;
+  index_s* next;
+  index_s* node_seg;
+  uint* priority;
+  index_s root;
+
+  // indexed by segment
+  index_s* seg_node;
+  byte* in_status;
+
+  // pending crossings as a min-heap, and the set of pairs already reported
+  Array crosses;
+  unsigned long long* pairs;
+  index_s pairs_capacity;
+  index_s pairs_size;
+
+  double sweep_x, sweep_y;
+  Array_seg2hit out;
+} GeomSweep;
+
+static bool geom_sweep_less(double ax, double ay, double bx, double by) {
+  return ax < bx || (ax == bx && ay < by);
+}
+
+static int geom_cmp_endpoint(const void* lhs, const void* rhs) {
+  return geom_cmp_xy(&((const GeomEndpoint*)lhs)->P,
+                     &((const GeomEndpoint*)rhs)->P);
+}
+
+static bool geom_on_segment(const seg2* s, vec2 P) {
+  return MIN(s->a.x, s->b.x) <= P.x && P.x <= MAX(s->a.x, s->b.x)
+      && MIN(s->a.y, s->b.y) <= P.y && P.y <= MAX(s->a.y, s->b.y);
+}
+
+static double geom_seg_orient(const GeomSweep* S, index_s node, vec2 P) {
+  const seg2* s = &S->segs[S->node_seg[node]];
+  return geom_orient(s->a, s->b, P);
+}
+
+// Orders segment u, which passes through P, against segment s in the status:
+//    by which side of s P is on, then by direction after P, then by index.
+static bool geom_status_below(const GeomSweep* S, index_s u, index_s s, vec2 P) {
+  const seg2* ss = &S->segs[s];
+  double o = geom_orient(ss->a, ss->b, P);
+  if (o == 0) o = geom_orient(ss->a, ss->b, S->segs[u].b);
+  if (o == 0) return u < s;
+  return o < 0;
+}
+
+////////////////////////////////////////
+// Status treap
+
+static void geom_rotate_up(GeomSweep* S, index_s x) {
+  index_s p = S->parent[x], g = S->parent[p];
+
+  if (S->left[p] == x) {
+    S->left[p] = S->right[x];
+    if (S->right[x] >= 0) S->parent[S->right[x]] = p;
+    S->right[x] = p;
+  } else {
+    S->right[p] = S->left[x];
+    if (S->left[x] >= 0) S->parent[S->left[x]] = p;
+    S->left[x] = p;
+  }
+
+  S->parent[p] = x;
+  S->parent[x] = g;
+  if (g < 0) S->root = x;
+  else if (S->left[g] == p) S->left[g] = x;
+  else S->right[g] = x;
+}
+
+static void geom_status_insert(GeomSweep* S, index_s seg, vec2 P) {
+  index_s x = S->seg_node[seg];
+  index_s pred = -1, succ = -1, cur = S->root;
+  S->left[x] = S->right[x] = S->parent[x] = -1;
+
+  while (cur >= 0) {
+    if (geom_status_below(S, seg, S->node_seg[cur], P)) {
+      succ = cur;
+      if (S->left[cur] < 0) { S->left[cur] = x; break; }
+      cur = S->left[cur];
+    } else {
+      pred = cur;
+      if (S->right[cur] < 0) { S->right[cur] = x; break; }
+      cur = S->right[cur];
+    }
+  }
+
+  S->parent[x] = cur;
+  if (cur < 0) S->root = x;
+
+  S->prev[x] = pred;
+  S->next[x] = succ;
+  if (pred >= 0) S->next[pred] = x;
+  if (succ >= 0) S->prev[succ] = x;
+  S->in_status[seg] = TRUE;
+
+  while (S->parent[x] >= 0 && S->priority[x] > S->priority[S->parent[x]]) {
+    geom_rotate_up(S, x);
+  }
+}
+
+static void geom_status_remove(GeomSweep* S, index_s seg) {
+  index_s x = S->seg_node[seg];
+
+  // rotate down to a leaf, keeping the heap order of the children
+  while (S->left[x] >= 0 || S->right[x] >= 0) {
+    index_s l = S->left[x], r = S->right[x];
+    geom_rotate_up(S, r < 0 || (l >= 0 && S->priority[l] > S->priority[r])
+      ? l : r);
+  }
+
+  index_s p = S->parent[x];
+  if (p < 0) S->root = -1;
+  else if (S->left[p] == x) S->left[p] = -1;
+  else S->right[p] = -1;
+
+  if (S->prev[x] >= 0) S->next[S->prev[x]] = S->next[x];
+  if (S->next[x] >= 0) S->prev[S->next[x]] = S->prev[x];
+  S->in_status[seg] = FALSE;
+}
+
+// Finds the lowest node with P below it (or on it, if inclusive), and the
+//    highest node below that.
+static index_s geom_status_find(
+  const GeomSweep* S, vec2 P, bool inclusive, index_s* pred_out
+) {
+  index_s cur = S->root, above = -1, below = -1;
+  while (cur >= 0) {
+    double o = geom_seg_orient(S, cur, P);
+    if (o < 0 || (inclusive && o == 0)) {
+      above = cur;
+      cur = S->left[cur];
+    } else {
+      below = cur;
+      cur = S->right[cur];
+    }
+  }
+  if (pred_out) *pred_out = below;
+  return above;
+}
+
+////////////////////////////////////////
+// Results and crossing events
+
+static void geom_report(GeomSweep* S, index_s a, index_s b, double x, double y) {
+  if (a > b) { index_s t = a; a = b; b = t; }
+  unsigned long long key = (unsigned long long)a * S->count + b + 1;
+
+  if (S->pairs_size * 2 >= S->pairs_capacity) {
+    index_s old_capacity = S->pairs_capacity;
+    unsigned long long* old = S->pairs;
+    S->pairs_capacity = old_capacity ? old_capacity * 2 : 64;
+    S->pairs = calloc(S->pairs_capacity, sizeof(*S->pairs));
+    for (index_s i = 0; i < old_capacity; ++i) {
+      if (!old[i]) continue;
+      size_t h = (size_t)(old[i] * 0x9E3779B97F4A7C15ull);
+      while (S->pairs[h & (S->pairs_capacity - 1)]) ++h;
+      S->pairs[h & (S->pairs_capacity - 1)] = old[i];
+    }
+    free(old);
+  }
+
+  size_t h = (size_t)(key * 0x9E3779B97F4A7C15ull);
+  for (;; ++h) {
+    unsigned long long* slot = &S->pairs[h & (S->pairs_capacity - 1)];
+    if (*slot == key) return;
+    if (!*slot) { *slot = key; break; }
+  }
+  ++S->pairs_size;
+
+  *arr_seg2hit_emplace_back(S->out) = (seg2hit) {
+    .point = v2f((float)x, (float)y), .a = a, .b = b
+  };
+}
+
+static bool geom_cross_less(const GeomCross* a, const GeomCross* b) {
+  return geom_sweep_less(a->x, a->y, b->x, b->y);
+}
+
+static void geom_cross_push(GeomSweep* S, GeomCross c) {
+  // rounding can put the point just behind the sweep line, but the crossing
+  //    still has to happen from here on
+  if (geom_sweep_less(c.x, c.y, S->sweep_x, S->sweep_y)) {
+    c.x = S->sweep_x;
+    c.y = S->sweep_y;
+  }
+
+  array_write_back(S->crosses, &c);
+  GeomCross* heap = S->crosses->arr;
+  for (index_s i = S->crosses->size - 1; i > 0;) {
+    index_s p = (i - 1) / 2;
+    if (!geom_cross_less(&heap[i], &heap[p])) break;
+    GeomCross t = heap[i]; heap[i] = heap[p]; heap[p] = t;
+    i = p;
+  }
+}
+
+static GeomCross geom_cross_pop(GeomSweep* S) {
+  GeomCross* heap = S->crosses->arr;
+  GeomCross ret = heap[0];
+  index_s size = S->crosses->size - 1;
+  heap[0] = heap[size];
+  array_pop_back(S->crosses);
+
+  for (index_s i = 0;;) {
+    index_s l = i * 2 + 1, r = l + 1, min = i;
+    if (l < size && geom_cross_less(&heap[l], &heap[min])) min = l;
+    if (r < size && geom_cross_less(&heap[r], &heap[min])) min = r;
+    if (min == i) break;
+    GeomCross t = heap[i]; heap[i] = heap[min]; heap[min] = t;
+    i = min;
+  }
+
+  return ret;
+}
+
+// Tests two status neighbours (lo below hi), reporting any intersection and
+//    scheduling a swap if they properly cross.
+static void geom_test(GeomSweep* S, index_s lo_node, index_s hi_node) {
+  if (lo_node < 0 || hi_node < 0) return;
+  index_s lo = S->node_seg[lo_node], hi = S->node_seg[hi_node];
+  const seg2* L = &S->segs[lo];
+  const seg2* H = &S->segs[hi];
+
+  double d1 = geom_orient(H->a, H->b, L->a);
+  double d2 = geom_orient(H->a, H->b, L->b);
+  double d3 = geom_orient(L->a, L->b, H->a);
+  double d4 = geom_orient(L->a, L->b, H->b);
+
+  if (((d1 < 0 && d2 > 0) || (d1 > 0 && d2 < 0)) &&
+      ((d3 < 0 && d4 > 0) || (d3 > 0 && d4 < 0))
+  ) {
+    double t = d3 / (d3 - d4);
+    GeomCross c = {
+      .x = H->a.x + ((double)H->b.x - H->a.x) * t,
+      .y = H->a.y + ((double)H->b.y - H->a.y) * t,
+      .lo = lo, .hi = hi,
+    };
+
+    // rounding can't be allowed to push the crossing outside either segment,
+    //    or past an end that would then be processed first
+    c.x = MAX(c.x, MAX(L->a.x, H->a.x));
+    c.x = MIN(c.x, MIN(L->b.x, H->b.x));
+    c.y = MAX(c.y, MAX(MIN(L->a.y, L->b.y), MIN(H->a.y, H->b.y)));
+    c.y = MIN(c.y, MIN(MAX(L->a.y, L->b.y), MAX(H->a.y, H->b.y)));
+    for (int i = 0; i < 2; ++i) {
+      vec2 end = i ? H->b : L->b;
+      if (geom_sweep_less(end.x, end.y, c.x, c.y)) { c.x = end.x; c.y = end.y; }
+    }
+
+    geom_report(S, lo, hi, c.x, c.y);
+
+    // only schedule the swap if lo still has to rise above hi, since the pair
+    //    can be tested again after they've already crossed
+    double turn = ((double)H->b.x - H->a.x) * ((double)L->b.y - L->a.y)
+                - ((double)H->b.y - H->a.y) * ((double)L->b.x - L->a.x);
+    if (turn > 0) geom_cross_push(S, c);
+    return;
+  }
+
+  // touching or collinear; checking starts first means an overlap reports the
+  //    first point shared by both
+  vec2 P;
+  if (d1 == 0 && geom_on_segment(H, L->a)) P = L->a;
+  else if (d3 == 0 && geom_on_segment(L, H->a)) P = H->a;
+  else if (d2 == 0 && geom_on_segment(H, L->b)) P = L->b;
+  else if (d4 == 0 && geom_on_segment(L, H->b)) P = H->b;
+  else return;
+
+  geom_report(S, lo, hi, P.x, P.y);
+}
+
+// Handles every segment starting, ending or passing through the endpoint P.
+static void geom_sweep_point(
+  GeomSweep* S, vec2 P, const GeomEndpoint* events, index_s event_count,
+  index_s* through
+) {
+  S->sweep_x = P.x;
+  S->sweep_y = P.y;
+
+  // status segments through P are contiguous, followed by those starting here
+  index_s count = 0;
+  index_s node = geom_status_find(S, P, TRUE, NULL);
+  while (node >= 0 && geom_seg_orient(S, node, P) == 0) {
+    through[count++] = S->node_seg[node];
+    node = S->next[node];
+  }
+  index_s existing = count;
+
+  for (index_s i = 0; i < event_count; ++i) {
+    if (events[i].start) through[count++] = events[i].seg;
+  }
+
+  for (index_s i = 0; i < count; ++i) {
+    for (index_s j = i + 1; j < count; ++j) {
+      geom_report(S, through[i], through[j], P.x, P.y);
+    }
+  }
+
+  // everything through P is pulled out and the continuing segments are put
+  //    back in their order after P
+  for (index_s i = 0; i < existing; ++i) {
+    geom_status_remove(S, through[i]);
+  }
+  for (index_s i = 0; i < event_count; ++i) {
+    if (!events[i].start && S->in_status[events[i].seg]) {
+      geom_status_remove(S, events[i].seg);
+    }
+  }
+
+  index_s pred;
+  index_s succ = geom_status_find(S, P, FALSE, &pred);
+  bool inserted = FALSE;
+
+  for (index_s i = 0; i < count; ++i) {
+    vec2 end = S->segs[through[i]].b;
+    if (end.x == P.x && end.y == P.y) continue;
+    geom_status_insert(S, through[i], P);
+    inserted = TRUE;
+  }
+
+  if (!inserted) {
+    geom_test(S, pred, succ);
+    return;
+  }
+
+  index_s lowest = pred >= 0 ? S->next[pred] : S->root;
+  if (pred < 0) while (S->left[lowest] >= 0) lowest = S->left[lowest];
+  index_s highest = succ >= 0 ? S->prev[succ] : S->root;
+  if (succ < 0) while (S->right[highest] >= 0) highest = S->right[highest];
+
+  geom_test(S, pred, lowest);
+  geom_test(S, highest, succ);
+}
+
+static void geom_sweep_cross(GeomSweep* S, GeomCross c) {
+  if (!S->in_status[c.lo] || !S->in_status[c.hi]) return;
+  index_s lo_node = S->seg_node[c.lo], hi_node = S->seg_node[c.hi];
+  if (S->next[lo_node] != hi_node) return;
+
+  S->sweep_x = c.x;
+  S->sweep_y = c.y;
+
+  S->node_seg[lo_node] = c.hi;
+  S->node_seg[hi_node] = c.lo;
+  S->seg_node[c.hi] = lo_node;
+  S->seg_node[c.lo] = hi_node;
+
+  geom_test(S, S->prev[lo_node], lo_node);
+  geom_test(S, hi_node, S->next[hi_node]);
+}
+
+// \brief Finds every pair of intersecting segments with a Bentley-Ottmann
+//    sweep in O((n + k) log n) for k intersections.
+//
+// \brief Segments that touch, share an endpoint or overlap collinearly count
+//    as intersecting, so for connected polylines filter out neighbouring edges
+//    as needed. Overlaps report the first point shared by both segments, and
+//    each pair is reported once, roughly in sweep order.
+//
+// \returns The number of intersections appended to out.
+index_s geom_intersect_all_s(
+  const seg2* segments, index_s count, Array_seg2hit out
+) {
+  assert(segments || !count);
+  assert(out);
+  if (count <= 0) return 0;
+  index_s start_size = out->size;
+
+  seg2* segs = malloc(sizeof(seg2) * count);
+  GeomEndpoint* events = malloc(sizeof(GeomEndpoint) * count * 2);
+  index_s* links = malloc(sizeof(index_s) * count * 8);
+  uint* priority = malloc(sizeof(uint) * count);
+  byte* in_status = calloc(count, sizeof(byte));
+
+  GeomSweep S = {
+    .segs = segs,
+    .count = count,
+    .left = links,
+    .right = links + count,
+    .parent = links + count * 2,
+    .prev = links + count * 3,
+    .next = links + count * 4,
+    .node_seg = links + count * 5,
+    .seg_node = links + count * 6,
+    .priority = priority,
+    .root = -1,
+    .in_status = in_status,
+    .crosses = array_new(GeomCross),
+    .out = out,
+  };
+  index_s* through = links + count * 7;
+
+  uint rng = 0x9E3779B9u;
+  for (index_s i = 0; i < count; ++i) {
+    seg2 s = segments[i];
+    if (geom_cmp_xy(&s.b, &s.a) < 0) s = (seg2) { .a = s.b, .b = s.a };
+    segs[i] = s;
+    events[i * 2 + 0] = (GeomEndpoint) { .P = s.a, .seg = i, .start = TRUE };
+    events[i * 2 + 1] = (GeomEndpoint) { .P = s.b, .seg = i, .start = FALSE };
+    S.node_seg[i] = S.seg_node[i] = i;
+    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+    priority[i] = rng;
+  }
+
+  qsort(events, count * 2, sizeof(GeomEndpoint), geom_cmp_endpoint);
+
+  index_s e = 0;
+  while (e < count * 2 || S.crosses->size) {
+    // crossings go first when they land exactly on an endpoint
+    if (S.crosses->size) {
+      const GeomCross* top = S.crosses->arr;
+      if (e == count * 2 ||
+          !geom_sweep_less(events[e].P.x, events[e].P.y, top->x, top->y)
+      ) {
+        geom_sweep_cross(&S, geom_cross_pop(&S));
+        continue;
+      }
+    }
+
+    index_s group = e + 1;
+    while (group < count * 2 && !geom_cmp_xy(&events[group].P, &events[e].P)) {
+      ++group;
+    }
+    geom_sweep_point(&S, events[e].P, events + e, group - e, through);
+    e = group;
+  }
+
+  array_delete(&S.crosses);
+  free(S.pairs);
+  free(in_status);
+  free(priority);
+  free(links);
+  free(events);
+  free(segs);
+  return out->size - start_size;
+}
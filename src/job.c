@@ -0,0 +1,671 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "job.h"
+#include "array.h"
+
+#include <stdlib.h>
+#include <stdint.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Platform
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+# define WIN32_LEAN_AND_MEAN
+# include <windows.h>
+
+typedef HANDLE              JobThread;
+typedef SRWLOCK             JobMutex;
+typedef CONDITION_VARIABLE  JobCond;
+# define JOB_THREAD_FN(NAME) DWORD WINAPI NAME(LPVOID arg)
+# define JOB_THREAD_RETURN  0
+
+static bool job_thread_start(JobThread* t, LPTHREAD_START_ROUTINE fn, void* arg) {
+  *t = CreateThread(NULL, 0, fn, arg, 0, NULL);
+  return *t != NULL;
+}
+
+static void job_thread_join(JobThread t) {
+  WaitForSingleObject(t, INFINITE);
+  CloseHandle(t);
+}
+
+# define job_thread_yield()   SwitchToThread()
+# define job_mutex_init(m)    InitializeSRWLock(m)
+# define job_mutex_destroy(m) ((void)(m))
+# define job_mutex_lock(m)    AcquireSRWLockExclusive(m)
+# define job_mutex_unlock(m)  ReleaseSRWLockExclusive(m)
+# define job_cond_init(c)     InitializeConditionVariable(c)
+# define job_cond_destroy(c)  ((void)(c))
+# define job_cond_wait(c, m)  SleepConditionVariableSRW(c, m, INFINITE, 0)
+# define job_cond_signal(c)   WakeConditionVariable(c)
+# define job_cond_broadcast(c) WakeAllConditionVariable(c)
+
+#else
+# include <pthread.h>
+# include <sched.h>
+# include <unistd.h>
+
+typedef pthread_t           JobThread;
+typedef pthread_mutex_t     JobMutex;
+typedef pthread_cond_t      JobCond;
+# define JOB_THREAD_FN(NAME) void* NAME(void* arg)
+# define JOB_THREAD_RETURN  NULL
+
+static bool job_thread_start(JobThread* t, void* (*fn)(void*), void* arg) {
+  return pthread_create(t, NULL, fn, arg) == 0;
+}
+
+# define job_thread_join(t)   pthread_join(t, NULL)
+# define job_thread_yield()   sched_yield()
+# define job_mutex_init(m)    pthread_mutex_init(m, NULL)
+# define job_mutex_destroy(m) pthread_mutex_destroy(m)
+# define job_mutex_lock(m)    pthread_mutex_lock(m)
+# define job_mutex_unlock(m)  pthread_mutex_unlock(m)
+# define job_cond_init(c)     pthread_cond_init(c, NULL)
+# define job_cond_destroy(c)  pthread_cond_destroy(c)
+# define job_cond_wait(c, m)  pthread_cond_wait(c, m)
+# define job_cond_signal(c)   pthread_cond_signal(c)
+# define job_cond_broadcast(c) pthread_cond_broadcast(c)
+#endif
+
+// MSVC's C mode has no stdatomic.h, so every operation there is a full-barrier
+//    interlocked call and the memory order argument is ignored
+#if defined(_MSC_VER) && !defined(__clang__)
+# include <intrin.h>
+# define JOB_THREAD_LOCAL __declspec(thread)
+
+typedef volatile long     JobAtomicInt;
+typedef volatile __int64  JobAtomicIndex;
+typedef void* volatile    JobAtomicPtr;
+
+# define atomic_int_load(p)           _InterlockedOr((p), 0)
+# define atomic_int_store(p, v)       _InterlockedExchange((p), (v))
+# define atomic_int_add(p, v)         _InterlockedExchangeAdd((p), (v))
+# define atomic_index_load(p, o)      _InterlockedOr64((p), 0)
+# define atomic_index_store(p, v, o)  _InterlockedExchange64((p), (v))
+# define atomic_index_cas(p, e, d)                                            \
+  (_InterlockedCompareExchange64((p), (d), (e)) == (e))                       //
+# define atomic_ptr_load(p, o)                                                \
+  _InterlockedCompareExchangePointer((p), NULL, NULL)                         //
+# define atomic_ptr_store(p, v, o)    _InterlockedExchangePointer((p), (v))
+# define atomic_ptr_exchange(p, v)    _InterlockedExchangePointer((p), (v))
+# define atomic_ptr_cas(p, e, d)                                              \
+  (_InterlockedCompareExchangePointer((p), (d), (e)) == (e))                  //
+# define atomic_fence(o)              MemoryBarrier()
+
+#else
+# include <stdatomic.h>
+# define JOB_THREAD_LOCAL _Thread_local
+
+typedef atomic_int        JobAtomicInt;
+typedef _Atomic(int64_t)  JobAtomicIndex;
+typedef _Atomic(void*)    JobAtomicPtr;
+
+# define atomic_int_load(p)           atomic_load(p)
+# define atomic_int_store(p, v)       atomic_store((p), (v))
+# define atomic_int_add(p, v)         atomic_fetch_add((p), (v))
+# define atomic_index_load(p, o)                                              \
+  atomic_load_explicit((p), memory_order_##o)                                 //
+# define atomic_index_store(p, v, o)                                          \
+  atomic_store_explicit((p), (v), memory_order_##o)                           //
+# define atomic_index_cas(p, e, d)                                            \
+  atomic_compare_exchange_strong((p), &(int64_t){ (e) }, (d))                 //
+# define atomic_ptr_load(p, o)                                                \
+  atomic_load_explicit((p), memory_order_##o)                                 //
+# define atomic_ptr_store(p, v, o)                                            \
+  atomic_store_explicit((p), (v), memory_order_##o)                           //
+# define atomic_ptr_exchange(p, v)    atomic_exchange((p), (v))
+# define atomic_ptr_cas(p, e, d)                                              \
+  atomic_compare_exchange_strong((p), &(void*){ (e) }, (d))                   //
+# define atomic_fence(o)              atomic_thread_fence(memory_order_##o)
+#endif
+
+// \brief Returns the number of logical processors, or 1 if it can't be found.
+int job_hardware_threads(void) {
+#ifdef _WIN32
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return MAX(1, (int)info.dwNumberOfProcessors);
+#else
+  long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Internal types
+////////////////////////////////////////////////////////////////////////////////
+
+_Static_assert((JOB_DEQUE_SIZE & (JOB_DEQUE_SIZE - 1)) == 0,
+  "JOB_DEQUE_SIZE must be a power of two");
+
+// Yields before a worker with nothing to do goes to sleep
+#define JOB_SPIN_COUNT 64
+
+typedef struct Job_Internal {
+  JobFn fn;
+  void* data;
+
+  // set for the pieces of a parallel_for, which split themselves further
+  JobRangeFn range_fn;
+  index_s begin, end, grain;
+
+  struct Job_Internal* parent;
+  struct Job_Internal* next;  // link in a dependency's continuation list
+
+  JobAtomicPtr continuations; // jobs to submit on completion, or JOB_CLOSED
+  JobAtomicInt unfinished;    // 1 until run, plus one per running child
+  JobAtomicInt refs;
+} Job_Internal;
+
+// Marks a continuation list as closed: the job is done and runs nothing more
+#define JOB_CLOSED ((void*)&job_closed_marker)
+static const char job_closed_marker = 0;
+
+// Chase-Lev deque, after "Correct and Efficient Work-Stealing for Weak Memory
+//    Models" (Le et al. 2013). Fixed size, the owner runs jobs inline when full.
+typedef struct {
+  JobAtomicIndex top;
+  char pad[64];               // keep thieves off the owner's cache line
+  JobAtomicIndex bottom;
+  JobAtomicPtr jobs[JOB_DEQUE_SIZE];
+} JobDeque;
+
+typedef struct JobPool_Internal JobPool_Internal;
+
+typedef struct {
+  JobDeque deque;
+  JobThread thread;
+  JobPool_Internal* pool;
+  int index;
+} JobWorker;
+
+// internal opaque structure:
+struct JobPool_Internal {
+  // public (read only)
+  int worker_count;
+
+  // private
+  JobWorker* workers;
+
+  // jobs submitted from threads outside the pool, guarded by lock
+  Array injected_jobs;
+  JobAtomicInt injected;
+
+  JobAtomicInt outstanding;   // jobs created and not yet finished
+  JobAtomicInt sleeping;
+  JobAtomicInt running;
+
+  JobMutex lock;
+  JobCond wake;
+};
+
+#define JOBPOOL_INTERNAL \
+  assert(pool_in); \
+  JobPool_Internal* pool = (JobPool_Internal*)(pool_in)
+
+// The pool and worker slot of the current thread, if it's a worker
+static JOB_THREAD_LOCAL JobPool_Internal* job_local_pool = NULL;
+static JOB_THREAD_LOCAL int job_local_worker = -1;
+static JOB_THREAD_LOCAL uint job_local_seed = 0;
+static JOB_THREAD_LOCAL Job_Internal* job_local_current = NULL;
+
+////////////////////////////////////////////////////////////////////////////////
+// Deque
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Owner only. Returns false when the deque is full.
+static bool deque_push(JobDeque* d, Job_Internal* job) {
+  int64_t b = atomic_index_load(&d->bottom, relaxed);
+  int64_t t = atomic_index_load(&d->top, acquire);
+  if (b - t >= JOB_DEQUE_SIZE) return false;
+  atomic_ptr_store(&d->jobs[b & (JOB_DEQUE_SIZE - 1)], job, relaxed);
+  atomic_index_store(&d->bottom, b + 1, release);
+  return true;
+}
+
+// \brief Owner only. Takes the most recently pushed job.
+static Job_Internal* deque_pop(JobDeque* d) {
+  int64_t b = atomic_index_load(&d->bottom, relaxed) - 1;
+  atomic_index_store(&d->bottom, b, relaxed);
+  atomic_fence(seq_cst);
+  int64_t t = atomic_index_load(&d->top, relaxed);
+
+  if (t > b) {
+    atomic_index_store(&d->bottom, b + 1, relaxed);
+    return NULL;
+  }
+
+  Job_Internal* job = atomic_ptr_load(&d->jobs[b & (JOB_DEQUE_SIZE - 1)], relaxed);
+
+  // last job, race any thieves for it
+  if (t == b) {
+    if (!atomic_index_cas(&d->top, t, t + 1)) job = NULL;
+    atomic_index_store(&d->bottom, b + 1, relaxed);
+  }
+
+  return job;
+}
+
+// \brief Any thread. Takes the oldest job, or NULL if empty or contended.
+static Job_Internal* deque_steal(JobDeque* d) {
+  int64_t t = atomic_index_load(&d->top, acquire);
+  atomic_fence(seq_cst);
+  int64_t b = atomic_index_load(&d->bottom, acquire);
+  if (t >= b) return NULL;
+
+  Job_Internal* job = atomic_ptr_load(&d->jobs[t & (JOB_DEQUE_SIZE - 1)], relaxed);
+  if (!atomic_index_cas(&d->top, t, t + 1)) return NULL;
+  return job;
+}
+
+static bool deque_empty(JobDeque* d) {
+  int64_t t = atomic_index_load(&d->top, acquire);
+  int64_t b = atomic_index_load(&d->bottom, acquire);
+  return t >= b;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scheduling
+////////////////////////////////////////////////////////////////////////////////
+
+static Job_Internal* job_alloc(
+  JobPool_Internal* pool, JobFn fn, void* data, int refs
+) {
+  Job_Internal* job = malloc(sizeof(Job_Internal));
+  assert(job);
+
+  *job = (Job_Internal) {
+    .fn = fn,
+    .data = data,
+  };
+
+  atomic_ptr_store(&job->continuations, NULL, relaxed);
+  atomic_int_store(&job->unfinished, 1);
+  atomic_int_store(&job->refs, refs);
+  atomic_int_add(&pool->outstanding, 1);
+
+  return job;
+}
+
+static void job_unref(Job_Internal* job) {
+  if (atomic_int_add(&job->refs, -1) == 1) free(job);
+}
+
+static bool job_pending(JobPool_Internal* pool) {
+  if (atomic_int_load(&pool->injected) > 0) return true;
+  for (int i = 0; i < pool->worker_count; ++i) {
+    if (!deque_empty(&pool->workers[i].deque)) return true;
+  }
+  return false;
+}
+
+static void job_execute(JobPool_Internal* pool, Job_Internal* job);
+
+static void job_submit(JobPool_Internal* pool, Job_Internal* job) {
+  if (job_local_pool == pool) {
+    JobDeque* deque = &pool->workers[job_local_worker].deque;
+    if (!deque_push(deque, job)) {
+      job_execute(pool, job);
+      return;
+    }
+  } else {
+    job_mutex_lock(&pool->lock);
+    array_write_back(pool->injected_jobs, &job);
+    atomic_int_add(&pool->injected, 1);
+    job_mutex_unlock(&pool->lock);
+  }
+
+  // pairs with the fence in job_worker_main, one side always sees the other
+  atomic_fence(seq_cst);
+  if (atomic_int_load(&pool->sleeping) > 0) {
+    job_mutex_lock(&pool->lock);
+    job_cond_signal(&pool->wake);
+    job_mutex_unlock(&pool->lock);
+  }
+}
+
+static Job_Internal* job_next(JobPool_Internal* pool) {
+  Job_Internal* job = NULL;
+  int self = job_local_pool == pool ? job_local_worker : -1;
+
+  if (self >= 0) {
+    job = deque_pop(&pool->workers[self].deque);
+    if (job) return job;
+  }
+
+  if (atomic_int_load(&pool->injected) > 0) {
+    job_mutex_lock(&pool->lock);
+    if (array_read_back(pool->injected_jobs, &job)) {
+      array_pop_back(pool->injected_jobs);
+      atomic_int_add(&pool->injected, -1);
+    }
+    job_mutex_unlock(&pool->lock);
+    if (job) return job;
+  }
+
+  // steal, starting from a random victim so thieves spread out
+  if (!job_local_seed) job_local_seed = (uint)(uintptr_t)&job_local_seed | 1;
+  job_local_seed ^= job_local_seed << 13;
+  job_local_seed ^= job_local_seed >> 17;
+  job_local_seed ^= job_local_seed << 5;
+
+  int start = (int)(job_local_seed % (uint)pool->worker_count);
+  for (int i = 0; i < pool->worker_count; ++i) {
+    int victim = (start + i) % pool->worker_count;
+    if (victim == self) continue;
+    job = deque_steal(&pool->workers[victim].deque);
+    if (job) return job;
+  }
+
+  return NULL;
+}
+
+static void job_finish(JobPool_Internal* pool, Job_Internal* job) {
+  if (atomic_int_add(&job->unfinished, -1) != 1) return;
+
+  Job_Internal* next = atomic_ptr_exchange(&job->continuations, JOB_CLOSED);
+  while (next) {
+    Job_Internal* after = next->next;
+    job_submit(pool, next);
+    next = after;
+  }
+
+  Job_Internal* parent = job->parent;
+  if (parent) {
+    job_finish(pool, parent);
+    job_unref(parent);
+  }
+
+  atomic_int_add(&pool->outstanding, -1);
+  job_unref(job);
+}
+
+static Job_Internal* job_spawn_child(
+  JobPool_Internal* pool, Job_Internal* parent, JobFn fn, void* data, int refs
+) {
+  assert(atomic_int_load(&parent->unfinished) > 0);
+  Job_Internal* job = job_alloc(pool, fn, data, refs);
+  atomic_int_add(&parent->unfinished, 1);
+  atomic_int_add(&parent->refs, 1);
+  job->parent = parent;
+  return job;
+}
+
+// Splits off the upper half of the range as a child until it's under the
+//    grain size, so idle workers steal the biggest remaining pieces
+static void job_run_range(JobPool_Internal* pool, Job_Internal* job) {
+  while (job->end - job->begin > job->grain) {
+    index_s mid = job->begin + (job->end - job->begin) / 2;
+    Job_Internal* half = job_spawn_child(pool, job, NULL, job->data, 1);
+    half->range_fn = job->range_fn;
+    half->begin = mid;
+    half->end = job->end;
+    half->grain = job->grain;
+    job->end = mid;
+    job_submit(pool, half);
+  }
+
+  job->range_fn(job->data, job->begin, job->end);
+}
+
+static void job_execute(JobPool_Internal* pool, Job_Internal* job) {
+  Job_Internal* outer = job_local_current;
+  job_local_current = job;
+  if (job->range_fn) job_run_range(pool, job);
+  else job->fn(job->data);
+  job_local_current = outer;
+  job_finish(pool, job);
+}
+
+static JOB_THREAD_FN(job_worker_main) {
+  JobWorker* worker = arg;
+  JobPool_Internal* pool = worker->pool;
+  job_local_pool = pool;
+  job_local_worker = worker->index;
+
+  int idle = 0;
+
+  while (atomic_int_load(&pool->running)) {
+    Job_Internal* job = job_next(pool);
+
+    if (job) {
+      job_execute(pool, job);
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < JOB_SPIN_COUNT) {
+      job_thread_yield();
+      continue;
+    }
+
+    job_mutex_lock(&pool->lock);
+    atomic_int_add(&pool->sleeping, 1);
+    atomic_fence(seq_cst);
+    if (atomic_int_load(&pool->running) && !job_pending(pool)) {
+      job_cond_wait(&pool->wake, &pool->lock);
+    }
+    atomic_int_add(&pool->sleeping, -1);
+    job_mutex_unlock(&pool->lock);
+    idle = 0;
+  }
+
+  return JOB_THREAD_RETURN;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Pool
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Starts a pool with the given number of worker threads. Zero picks one
+//    per logical processor, less one for the thread that waits on the jobs.
+JobPool job_pool_new(int worker_count) {
+  if (worker_count <= 0) worker_count = MAX(1, job_hardware_threads() - 1);
+
+  JobPool_Internal* pool = malloc(sizeof(JobPool_Internal));
+  assert(pool);
+
+  *pool = (JobPool_Internal) {
+    .worker_count = worker_count,
+    .workers = calloc(worker_count, sizeof(JobWorker)),
+    .injected_jobs = array_new(Job_Internal*),
+  };
+  assert(pool->workers);
+
+  atomic_int_store(&pool->injected, 0);
+  atomic_int_store(&pool->outstanding, 0);
+  atomic_int_store(&pool->sleeping, 0);
+  atomic_int_store(&pool->running, 1);
+  job_mutex_init(&pool->lock);
+  job_cond_init(&pool->wake);
+
+  for (int i = 0; i < worker_count; ++i) {
+    JobWorker* worker = &pool->workers[i];
+    worker->pool = pool;
+    worker->index = i;
+    atomic_index_store(&worker->deque.top, 0, relaxed);
+    atomic_index_store(&worker->deque.bottom, 0, relaxed);
+  }
+
+  for (int i = 0; i < worker_count; ++i) {
+    bool started = job_thread_start(
+      &pool->workers[i].thread, job_worker_main, &pool->workers[i]
+    );
+    assert(started);
+    PARAM_UNUSED(started);
+  }
+
+  return (JobPool)pool;
+}
+
+// \brief Runs every job still queued or waiting on a dependency, then stops
+//    the workers and frees the pool.
+void job_pool_delete(JobPool* pool_ptr) {
+  if (!pool_ptr || !*pool_ptr) return;
+  JobPool_Internal* pool = (JobPool_Internal*)*pool_ptr;
+
+  while (atomic_int_load(&pool->outstanding) > 0) {
+    Job_Internal* job = job_next(pool);
+    if (job) job_execute(pool, job);
+    else job_thread_yield();
+  }
+
+  job_mutex_lock(&pool->lock);
+  atomic_int_store(&pool->running, 0);
+  job_cond_broadcast(&pool->wake);
+  job_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->worker_count; ++i) {
+    job_thread_join(pool->workers[i].thread);
+  }
+
+  job_cond_destroy(&pool->wake);
+  job_mutex_destroy(&pool->lock);
+  array_delete(&pool->injected_jobs);
+  free(pool->workers);
+  free(pool);
+  *pool_ptr = NULL;
+}
+
+// \brief Returns the calling thread's worker index in [0, worker_count), or -1
+//    if it isn't one of this pool's workers. Useful for per-worker scratch.
+int job_worker_index(JobPool pool_in) {
+  JOBPOOL_INTERNAL;
+  return job_local_pool == pool ? job_local_worker : -1;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Jobs
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Queues fn(data) to run on the pool.
+Job job_run(JobPool pool_in, JobFn fn, void* data) {
+  JOBPOOL_INTERNAL;
+  assert(fn);
+  Job_Internal* job = job_alloc(pool, fn, data, 2);
+  job_submit(pool, job);
+  return (Job)job;
+}
+
+// \brief Queues fn(data) as a child of parent, which isn't done until all its
+//    children are. Parent must not have finished yet, so this is normally
+//    called from inside the parent job with job_current() as the parent.
+Job job_run_child(JobPool pool_in, Job parent, JobFn fn, void* data) {
+  JOBPOOL_INTERNAL;
+  assert(parent && fn);
+  Job_Internal* job = job_spawn_child(pool, (Job_Internal*)parent, fn, data, 2);
+  job_submit(pool, job);
+  return (Job)job;
+}
+
+// \brief Queues fn(data) to run once dependency is done, including all of
+//    the dependency's children.
+Job job_run_after(JobPool pool_in, Job dependency, JobFn fn, void* data) {
+  JOBPOOL_INTERNAL;
+  assert(dependency && fn);
+  Job_Internal* dep = (Job_Internal*)dependency;
+  Job_Internal* job = job_alloc(pool, fn, data, 2);
+
+  void* head = atomic_ptr_load(&dep->continuations, acquire);
+  loop {
+    if (head == JOB_CLOSED) {
+      job_submit(pool, job);
+      break;
+    }
+
+    job->next = head;
+    until (atomic_ptr_cas(&dep->continuations, head, job));
+    head = atomic_ptr_load(&dep->continuations, acquire);
+  }
+
+  return (Job)job;
+}
+
+// \brief Returns the job running on the calling thread, or NULL outside of
+//    one. The handle is borrowed, don't wait on or release it.
+Job job_current(void) {
+  return (Job)job_local_current;
+}
+
+// \brief Returns true once the job and all of its children have run.
+bool job_done(Job job) {
+  assert(job);
+  return atomic_int_load(&((Job_Internal*)job)->unfinished) == 0;
+}
+
+// \brief Runs other jobs on the calling thread until this one is done, then
+//    releases the handle.
+void job_wait(JobPool pool_in, Job* job_ptr) {
+  JOBPOOL_INTERNAL;
+  if (!job_ptr || !*job_ptr) return;
+
+  while (!job_done(*job_ptr)) {
+    Job_Internal* job = job_next(pool);
+    if (job) job_execute(pool, job);
+    else job_thread_yield();
+  }
+
+  job_release(job_ptr);
+}
+
+// \brief Gives up the handle without waiting. The job still runs.
+void job_release(Job* job_ptr) {
+  if (!job_ptr || !*job_ptr) return;
+  job_unref((Job_Internal*)*job_ptr);
+  *job_ptr = NULL;
+}
+
+// \brief Calls fn(data, begin, end) over sub-ranges of [begin, end) no larger
+//    than grain, in parallel, and returns once all of them are done. A grain
+//    of zero or less picks about four pieces per worker.
+void parallel_for(JobPool pool_in, index_s begin, index_s end, index_s grain,
+  JobRangeFn fn, void* data
+) {
+  JOBPOOL_INTERNAL;
+  assert(fn);
+  if (end <= begin) return;
+
+  if (grain <= 0) {
+    grain = MAX(1, (end - begin) / ((index_s)pool->worker_count * 4));
+  }
+
+  // not worth a job
+  if (end - begin <= grain) {
+    fn(data, begin, end);
+    return;
+  }
+
+  Job_Internal* job = job_alloc(pool, NULL, data, 2);
+  job->range_fn = fn;
+  job->begin = begin;
+  job->end = end;
+  job->grain = grain;
+
+  job_submit(pool, job);
+  Job handle = (Job)job;
+  job_wait(pool_in, &handle);
+}
@@ -0,0 +1,425 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "kdtree.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// internal opaque structure:
+typedef struct KdTree_Internal {
+  // public (read only)
+  index_s dimensions;
+  index_s size;
+
+  // private
+  float* coords;    // interleaved point coordinates in tree order
+  index_s* indices; // original index of each point in tree order
+  byte* axes;       // split axis of the node at each position
+} KdTree_Internal;
+
+// Ranges at or below this size aren't split further and are scanned linearly
+#define KD_LEAF_SIZE 8
+
+// Enough to hold the traversal of any tree addressable by index_s
+#define KD_STACK_SIZE 128
+
+// Queries for up to this many points without a distance buffer keep their
+//    distances on the stack
+#define KD_KNN_LOCAL 32
+
+#define KDTREE_INTERNAL \
+  assert(tree_in); \
+  const KdTree_Internal* tree = (const KdTree_Internal*)(tree_in)
+
+#define KD_POINT(T, I) ((T)->coords + (I) * (T)->dimensions)
+
+static void kd_swap(KdTree_Internal* tree, index_s a, index_s b) {
+  float* pa = KD_POINT(tree, a);
+  float* pb = KD_POINT(tree, b);
+  for (index_s d = 0; d < tree->dimensions; ++d) {
+    float t = pa[d]; pa[d] = pb[d]; pb[d] = t;
+  }
+  index_s i = tree->indices[a];
+  tree->indices[a] = tree->indices[b];
+  tree->indices[b] = i;
+}
+
+// Hoare-style quickselect that places the nth element of [lo, hi) by the given
+//    axis into position n, with smaller values before and larger after.
+static void kd_select(
+  KdTree_Internal* tree, index_s lo, index_s hi, index_s n, index_s axis
+) {
+  --hi;
+  while (lo < hi) {
+    // median of three for the pivot to avoid degrading on sorted input
+    index_s mid = lo + (hi - lo) / 2;
+    if (KD_POINT(tree, mid)[axis] < KD_POINT(tree, lo)[axis])
+      kd_swap(tree, mid, lo);
+    if (KD_POINT(tree, hi)[axis] < KD_POINT(tree, lo)[axis])
+      kd_swap(tree, hi, lo);
+    if (KD_POINT(tree, hi)[axis] < KD_POINT(tree, mid)[axis])
+      kd_swap(tree, hi, mid);
+
+    float pivot = KD_POINT(tree, mid)[axis];
+    index_s i = lo, j = hi;
+
+    while (i <= j) {
+      while (KD_POINT(tree, i)[axis] < pivot) ++i;
+      while (KD_POINT(tree, j)[axis] > pivot) --j;
+      if (i <= j) kd_swap(tree, i++, j--);
+    }
+
+    if (n <= j) hi = j;
+    else if (n >= i) lo = i;
+    else return;
+  }
+}
+
+// Each call only touches [lo, hi), so the two recursive halves are independent
+//    and can be built concurrently.
+static void kd_build(KdTree_Internal* tree, index_s lo, index_s hi) {
+  if (hi - lo <= KD_LEAF_SIZE) return;
+
+  // split along the axis with the largest extent in this range
+  float min[3], max[3];
+  memcpy(min, KD_POINT(tree, lo), sizeof(float) * tree->dimensions);
+  memcpy(max, min, sizeof(float) * tree->dimensions);
+
+  for (index_s i = lo + 1; i < hi; ++i) {
+    const float* p = KD_POINT(tree, i);
+    for (index_s d = 0; d < tree->dimensions; ++d) {
+      if (p[d] < min[d]) min[d] = p[d];
+      if (p[d] > max[d]) max[d] = p[d];
+    }
+  }
+
+  index_s axis = 0;
+  for (index_s d = 1; d < tree->dimensions; ++d) {
+    if (max[d] - min[d] > max[axis] - min[axis]) axis = d;
+  }
+
+  index_s mid = lo + (hi - lo) / 2;
+  kd_select(tree, lo, hi, mid, axis);
+  tree->axes[mid] = (byte)axis;
+
+  kd_build(tree, lo, mid);
+  kd_build(tree, mid + 1, hi);
+}
+
+static KdTree kd_new(const float* points, index_s count, index_s dimensions) {
+  assert(count >= 0);
+  assert(points || count == 0);
+
+  // keep the tree in a single allocation: header, indices, coords, then axes
+  size_t coord_bytes = sizeof(float) * count * dimensions;
+  size_t index_bytes = sizeof(index_s) * count;
+  KdTree_Internal* ret = malloc(
+    sizeof(KdTree_Internal) + index_bytes + coord_bytes + count
+  );
+  assert(ret);
+
+  byte* data = (byte*)(ret + 1);
+  *ret = (KdTree_Internal) {
+    .dimensions = dimensions,
+    .size = count,
+    .indices = (index_s*)data,
+    .coords = (float*)(data + index_bytes),
+    .axes = data + index_bytes + coord_bytes,
+  };
+
+  if (count) memcpy(ret->coords, points, coord_bytes);
+  for (index_s i = 0; i < count; ++i) {
+    ret->indices[i] = i;
+  }
+
+  kd_build(ret, 0, count);
+  return (KdTree)ret;
+}
+
+KdTree kd_new_v2_s(const vec2* points, index_s count) {
+  return kd_new(points ? points->f : NULL, count, 2);
+}
+
+KdTree kd_new_v3_s(const vec3* points, index_s count) {
+  return kd_new(points ? points->f : NULL, count, 3);
+}
+
+void kd_delete(KdTree* tree) {
+  if (!tree || !*tree) return;
+  free(*tree);
+  *tree = NULL;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queries
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  index_s lo;
+  index_s hi;
+  float plane_dist_sq;
+} KdRange;
+
+static inline float kd_dist_sq(
+  const KdTree_Internal* tree, const float* P, index_s i
+) {
+  const float* Q = KD_POINT(tree, i);
+  float dist = 0;
+  for (index_s d = 0; d < tree->dimensions; ++d) {
+    float delta = Q[d] - P[d];
+    dist += delta * delta;
+  }
+  return dist;
+}
+
+// Result set for k-nearest queries, kept as a max-heap on distance so the
+//    current worst candidate can be replaced in log(k).
+typedef struct {
+  index_s* indices;
+  float* dists;
+  index_s count;
+  index_s k;
+} KdHeap;
+
+static void kd_heap_sift_down(KdHeap* heap, index_s i) {
+  loop {
+    index_s largest = i;
+    index_s l = i * 2 + 1, r = l + 1;
+    if (l < heap->count && heap->dists[l] > heap->dists[largest]) largest = l;
+    if (r < heap->count && heap->dists[r] > heap->dists[largest]) largest = r;
+    until (largest == i);
+    float d = heap->dists[i];
+    index_s n = heap->indices[i];
+    heap->dists[i] = heap->dists[largest];
+    heap->indices[i] = heap->indices[largest];
+    heap->dists[largest] = d;
+    heap->indices[largest] = n;
+    i = largest;
+  }
+}
+
+static void kd_heap_push(KdHeap* heap, index_s index, float dist) {
+  if (heap->count < heap->k) {
+    index_s i = heap->count++;
+    while (i > 0) {
+      index_s parent = (i - 1) / 2;
+      until (heap->dists[parent] >= dist);
+      heap->dists[i] = heap->dists[parent];
+      heap->indices[i] = heap->indices[parent];
+      i = parent;
+    }
+    heap->dists[i] = dist;
+    heap->indices[i] = index;
+  } else if (dist < heap->dists[0]) {
+    heap->dists[0] = dist;
+    heap->indices[0] = index;
+    kd_heap_sift_down(heap, 0);
+  }
+}
+
+static inline float kd_heap_bound(const KdHeap* heap) {
+  return heap->count < heap->k ? (float)INFINITY : heap->dists[0];
+}
+
+static index_s kd_knn(
+  const KdTree_Internal* tree, const float* P, index_s k,
+  index_s* out_indices, float* out_dist_sq
+) {
+  assert(out_indices);
+  if (k <= 0 || tree->size == 0) return 0;
+
+  float local_dists[KD_KNN_LOCAL];
+  float* dists = out_dist_sq;
+  if (!dists) {
+    dists = k <= KD_KNN_LOCAL ? local_dists : malloc(sizeof(float) * k);
+    assert(dists);
+  }
+  KdHeap heap = { .indices = out_indices, .dists = dists, .k = k };
+
+  KdRange stack[KD_STACK_SIZE];
+  index_s top = 0;
+  stack[top++] = (KdRange) { .lo = 0, .hi = tree->size, .plane_dist_sq = 0 };
+
+  while (top) {
+    KdRange range = stack[--top];
+    if (range.plane_dist_sq > kd_heap_bound(&heap)) continue;
+
+    if (range.hi - range.lo <= KD_LEAF_SIZE) {
+      for (index_s i = range.lo; i < range.hi; ++i) {
+        kd_heap_push(&heap, i, kd_dist_sq(tree, P, i));
+      }
+      continue;
+    }
+
+    index_s mid = range.lo + (range.hi - range.lo) / 2;
+    kd_heap_push(&heap, mid, kd_dist_sq(tree, P, mid));
+
+    float delta = P[tree->axes[mid]] - KD_POINT(tree, mid)[tree->axes[mid]];
+    KdRange lower = { .lo = range.lo, .hi = mid };
+    KdRange upper = { .lo = mid + 1, .hi = range.hi };
+
+    // push the far side first so the near side is visited first
+    if (delta < 0) {
+      upper.plane_dist_sq = delta * delta;
+      stack[top++] = upper;
+      stack[top++] = lower;
+    } else {
+      lower.plane_dist_sq = delta * delta;
+      stack[top++] = lower;
+      stack[top++] = upper;
+    }
+  }
+
+  // heap-sort the results into ascending order and remap to input indices
+  index_s count = heap.count;
+  while (heap.count > 1) {
+    --heap.count;
+    float d = dists[0]; dists[0] = dists[heap.count]; dists[heap.count] = d;
+    index_s n = out_indices[0];
+    out_indices[0] = out_indices[heap.count];
+    out_indices[heap.count] = n;
+    kd_heap_sift_down(&heap, 0);
+  }
+
+  for (index_s i = 0; i < count; ++i) {
+    out_indices[i] = tree->indices[out_indices[i]];
+  }
+
+  if (dists != out_dist_sq && dists != local_dists) free(dists);
+  return count;
+}
+
+static index_s kd_radius(
+  const KdTree_Internal* tree, const float* P, float radius, Array out
+) {
+  assert(out);
+  assert(out->element_size == sizeof(index_s));
+  float radius_sq = radius * radius;
+  index_s start_size = out->size;
+
+  if (tree->size == 0) return 0;
+
+  KdRange stack[KD_STACK_SIZE];
+  index_s top = 0;
+  stack[top++] = (KdRange) { .lo = 0, .hi = tree->size, .plane_dist_sq = 0 };
+
+  while (top) {
+    KdRange range = stack[--top];
+    if (range.plane_dist_sq > radius_sq) continue;
+
+    if (range.hi - range.lo <= KD_LEAF_SIZE) {
+      for (index_s i = range.lo; i < range.hi; ++i) {
+        if (kd_dist_sq(tree, P, i) <= radius_sq) {
+          array_write_back(out, &tree->indices[i]);
+        }
+      }
+      continue;
+    }
+
+    index_s mid = range.lo + (range.hi - range.lo) / 2;
+    if (kd_dist_sq(tree, P, mid) <= radius_sq) {
+      array_write_back(out, &tree->indices[mid]);
+    }
+
+    float delta = P[tree->axes[mid]] - KD_POINT(tree, mid)[tree->axes[mid]];
+    float delta_sq = delta * delta;
+    stack[top++] = (KdRange) {
+      .lo = range.lo, .hi = mid, .plane_dist_sq = delta < 0 ? 0 : delta_sq
+    };
+    stack[top++] = (KdRange) {
+      .lo = mid + 1, .hi = range.hi, .plane_dist_sq = delta < 0 ? delta_sq : 0
+    };
+  }
+
+  return out->size - start_size;
+}
+
+// \brief Finds the closest point in the tree to P.
+//
+// \param dist_sq_out - if non-null, set to the squared distance to the point.
+//
+// \returns The index in the input array of the nearest point, or -1 if the
+//    tree is empty.
+index_s kd_nearest_v2(KdTree tree_in, vec2 P, float* dist_sq_out) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 2);
+  index_s ret = -1;
+  float dist_sq;
+  kd_knn(tree, P.f, 1, &ret, dist_sq_out ? dist_sq_out : &dist_sq);
+  return ret;
+}
+
+index_s kd_nearest_v3(KdTree tree_in, vec3 P, float* dist_sq_out) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 3);
+  index_s ret = -1;
+  float dist_sq;
+  kd_knn(tree, P.f, 1, &ret, dist_sq_out ? dist_sq_out : &dist_sq);
+  return ret;
+}
+
+// \brief Finds the k closest points in the tree to P, sorted from nearest to
+//    farthest.
+//
+// \param out_indices - buffer of at least k elements for the results.
+//
+// \param out_dist_sq - optional buffer of at least k elements that receives
+//    the squared distance to each result.
+//
+// \returns The number of points found, which is less than k only if the tree
+//    contains fewer than k points.
+index_s kd_knn_v2(
+  KdTree tree_in, vec2 P, index_s k, index_s* out_indices, float* out_dist_sq
+) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 2);
+  return kd_knn(tree, P.f, k, out_indices, out_dist_sq);
+}
+
+index_s kd_knn_v3(
+  KdTree tree_in, vec3 P, index_s k, index_s* out_indices, float* out_dist_sq
+) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 3);
+  return kd_knn(tree, P.f, k, out_indices, out_dist_sq);
+}
+
+// \brief Appends the indices of all points within radius of P to the given
+//    array, which must have been created with array_new(index_s). Results are
+//    in no particular order.
+//
+// \returns The number of indices appended.
+index_s kd_radius_v2(KdTree tree_in, vec2 P, float radius, Array out) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 2);
+  return kd_radius(tree, P.f, radius, out);
+}
+
+index_s kd_radius_v3(KdTree tree_in, vec3 P, float radius, Array out) {
+  KDTREE_INTERNAL;
+  assert(tree->dimensions == 3);
+  return kd_radius(tree, P.f, radius, out);
+}
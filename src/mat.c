@@ -23,9 +23,12 @@
 */
 
 #include "mat.h"
+#include "mat_inline.h" // no-op with MCLIB_INLINE_MATH
 
 #include <math.h>
 
+#include "trace.h"
+
 mat4 m4ortho(
   float left, float right, float top, float bottom, float near, float far
 ) {
@@ -59,27 +62,19 @@ mat4 m4perspective(float fov_rads, float aspect, float near, float far) {
   return ret;
 }
 
-mat4 m4basis(vec3 x, vec3 y, vec3 z, vec3 origin) {
-  return (mat4) {.f={
-    x.x, y.x, z.x, 0,
-    x.y, y.y, z.y, 0,
-    x.z, y.z, z.z, 0,
-    -v3dot(x, origin), -v3dot(y, origin), -v3dot(z, origin), 1
-  }};
-}
-
 mat4 m4look(vec3 pos, vec3 target, vec3 up) {
   vec3 cz = v3norm(v3sub(target, pos)); // front
   vec3 cx = v3norm(v3cross(up, cz)); // left
   vec3 cy = v3cross(cz, cx); // up
 
-  return m4inverse(m4basis(cx, cy, cz, pos));
-}
-
-mat4 m4translation(vec3 vec) {
-  mat4 ret = m4identity;
-  ret.col[3].xyz = vec;
-  return ret;
+  // the inverse of m4basis(cx, cy, cz, pos), which for an orthonormal basis is
+  //    just the basis vectors as columns with the position as translation
+  return (mat4) {.f={
+    cx.x,  cx.y,  cx.z,  0,
+    cy.x,  cy.y,  cy.z,  0,
+    cz.x,  cz.y,  cz.z,  0,
+    pos.x, pos.y, pos.z, 1
+  }};
 }
 
 mat4 m4rotation(vec3 axis, float angle) {
@@ -104,50 +99,9 @@ mat4 m4rotation(vec3 axis, float angle) {
   return ret;
 }
 
-mat4 m4scalar(vec3 scalar) {
-  mat4 ret = m4identity;
-  ret.m[0][0] = scalar.x;
-  ret.m[1][1] = scalar.y;
-  ret.m[2][2] = scalar.z;
-  return ret;
-}
-
-mat4 m4uniform(float scalar) {
-  mat4 ret = m4identity;
-  ret.m[0][0] = scalar;
-  ret.m[1][1] = scalar;
-  ret.m[2][2] = scalar;
-  return ret;
-}
-
-mat4 m4mul(mat4 a, mat4 b) {
-  mat4 ret = m4zero;
-
-  for (int x = 0; x < 4; ++x) {
-    for (int y = 0; y < 4; ++y) {
-      for (int i = 0; i < 4; ++i) {
-        ret.m[x][y] += a.m[i][y] * b.m[x][i];
-      }
-    }
-  }
-
-  return ret;
-}
-
-vec4 mv4mul(mat4 m, vec4 v) {
-  vec4 ret = v4zero;
-
-  for (int y = 0; y < 4; ++y) {
-    for (int x = 0; x < 4; ++x) {
-      ret.f[y] += m.m[x][y] * v.f[x];
-    }
-  }
-
-  return ret;
-}
-
 mat4 m4inverse(mat4 m) {
-  return (mat4) {.f={
+  TRACE_BEGIN("m4inverse");
+  mat4 ret = {.f={
     m.f[5] * m.f[10] * m.f[15] - m.f[5] * m.f[11] * m.f[14] -
     m.f[9] * m.f[6] * m.f[15] + m.f[9] * m.f[7] * m.f[14] +
     m.f[13] * m.f[6] * m.f[11] - m.f[13] * m.f[7] * m.f[10]
@@ -212,4 +166,6 @@ mat4 m4inverse(mat4 m) {
     m.f[4] * m.f[1] * m.f[10] + m.f[4] * m.f[2] * m.f[9] +
     m.f[8] * m.f[1] * m.f[6] - m.f[8] * m.f[2] * m.f[5]
   }};
+  TRACE_END();
+  return ret;
 }
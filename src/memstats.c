@@ -0,0 +1,457 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "memstats.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#ifndef MCLIB_MEMSTATS
+
+MemStats memstats_get(void) {
+  return (MemStats) { 0 };
+}
+
+index_s memstats_sites(MemSite* out, index_s capacity) {
+  PARAM_UNUSED(out);
+  PARAM_UNUSED(capacity);
+  return 0;
+}
+
+void memstats_reset_peak(void) { }
+
+void memstats_set_hook(MemHook hook, void* user_data) {
+  PARAM_UNUSED(hook);
+  PARAM_UNUSED(user_data);
+}
+
+void memstats_dump(void) {
+  printf("memstats: disabled, build with MCLIB_MEMSTATS to enable\n");
+}
+
+bool memstats_dump_every(double seconds) {
+  PARAM_UNUSED(seconds);
+  return false;
+}
+
+#else
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+# include <intrin.h>
+# define MEM_THREAD_LOCAL __declspec(thread)
+static volatile long mem_lock_flag = 0;
+static inline void mem_lock(void) {
+  while (_InterlockedExchange(&mem_lock_flag, 1)) _mm_pause();
+}
+static inline void mem_unlock(void) {
+  _InterlockedExchange(&mem_lock_flag, 0);
+}
+#else
+# include <stdatomic.h>
+# define MEM_THREAD_LOCAL _Thread_local
+static atomic_flag mem_lock_flag = ATOMIC_FLAG_INIT;
+static inline void mem_lock(void) {
+  while (atomic_flag_test_and_set_explicit(&mem_lock_flag, memory_order_acquire));
+}
+static inline void mem_unlock(void) {
+  atomic_flag_clear_explicit(&mem_lock_flag, memory_order_release);
+}
+#endif
+
+// Sites past this many share the unattributed entry
+#define MEMSTATS_MAX_SITES 1024
+#define MEMSTATS_SITE_SLOTS (MEMSTATS_MAX_SITES * 2)
+#define MEMSTATS_SITE_DEPTH 16
+#define MEMSTATS_DUMP_SITES 10
+
+// Each live allocation's size and site, in an open addressing table keyed by
+//    address. The table uses the system allocator directly.
+typedef struct {
+  const void* ptr;
+  index_s size;
+  int site;
+} MemEntry;
+
+static char mem_tombstone_marker;
+#define MEM_TOMBSTONE ((const void*)&mem_tombstone_marker)
+
+static MemEntry* mem_table = NULL;
+static index_s mem_table_capacity = 0;
+static index_s mem_table_used = 0; // live entries and tombstones
+
+static MemStats mem_stats = { 0 };
+
+// Site 0 collects allocations made outside of any site
+static MemSite mem_sites[MEMSTATS_MAX_SITES] = { 0 };
+static int mem_site_count = 1;
+static short mem_site_slots[MEMSTATS_SITE_SLOTS] = { 0 }; // site index + 1
+
+static MemHook mem_hook = NULL;
+static void* mem_hook_data = NULL;
+
+// The sites active on this thread, innermost last
+static MEM_THREAD_LOCAL int mem_site_stack[MEMSTATS_SITE_DEPTH];
+static MEM_THREAD_LOCAL int mem_site_depth = 0;
+
+static inline size_t mem_hash(const void* ptr) {
+  uint64_t h = (uint64_t)(uintptr_t)ptr >> 4;
+  return (size_t)(h * 0x9e3779b97f4a7c15ull >> 17);
+}
+
+static MemEntry* mem_find(const void* ptr) {
+  if (!mem_table_capacity) return NULL;
+
+  size_t mask = mem_table_capacity - 1;
+  for (size_t i = mem_hash(ptr) & mask; ; i = (i + 1) & mask) {
+    if (mem_table[i].ptr == ptr) return &mem_table[i];
+    if (!mem_table[i].ptr) return NULL;
+  }
+}
+
+static void mem_insert_raw(const void* ptr, index_s size, int site) {
+  size_t mask = mem_table_capacity - 1;
+  size_t i = mem_hash(ptr) & mask;
+  while (mem_table[i].ptr && mem_table[i].ptr != MEM_TOMBSTONE) {
+    i = (i + 1) & mask;
+  }
+  if (!mem_table[i].ptr) ++mem_table_used;
+  mem_table[i] = (MemEntry) { .ptr = ptr, .size = size, .site = site };
+}
+
+// Keeps the table under 70% full counting tombstones, which are dropped here
+static bool mem_reserve(void) {
+  if ((mem_table_used + 1) * 10 < mem_table_capacity * 7) return true;
+
+  index_s old_capacity = mem_table_capacity;
+  MemEntry* old = mem_table;
+
+  index_s capacity = old_capacity ? old_capacity : 1024;
+  while (mem_stats.live_count * 2 >= capacity) capacity *= 2;
+
+  MemEntry* table = calloc(capacity, sizeof(MemEntry));
+  if (!table) return false;
+
+  mem_table = table;
+  mem_table_capacity = capacity;
+  mem_table_used = 0;
+
+  for (index_s i = 0; i < old_capacity; ++i) {
+    if (old[i].ptr && old[i].ptr != MEM_TOMBSTONE) {
+      mem_insert_raw(old[i].ptr, old[i].size, old[i].site);
+    }
+  }
+
+  free(old);
+  return true;
+}
+
+static int mem_site_lookup(const char* file, int line) {
+  size_t h = mem_hash(file) ^ (size_t)line * 0x9e3779b1u;
+
+  for (size_t n = 0; n < MEMSTATS_SITE_SLOTS; ++n) {
+    short* slot = &mem_site_slots[(h + n) % MEMSTATS_SITE_SLOTS];
+
+    if (*slot) {
+      MemSite* site = &mem_sites[*slot - 1];
+      if (site->file == file && site->line == line) return *slot - 1;
+      continue;
+    }
+
+    if (mem_site_count == MEMSTATS_MAX_SITES) return 0;
+    int index = mem_site_count++;
+    mem_sites[index] = (MemSite) { .file = file, .line = line };
+    *slot = (short)(index + 1);
+    return index;
+  }
+
+  return 0;
+}
+
+static inline int mem_current_site(void) {
+  return mem_site_depth ? mem_site_stack[mem_site_depth - 1] : 0;
+}
+
+static void mem_track(const void* ptr, index_s size, int site) {
+  if (!mem_reserve()) return;
+  mem_insert_raw(ptr, size, site);
+
+  mem_stats.live_bytes += size;
+  mem_stats.live_count += 1;
+  if (mem_stats.live_bytes > mem_stats.peak_bytes) {
+    mem_stats.peak_bytes = mem_stats.live_bytes;
+  }
+
+  mem_sites[site].live_bytes += size;
+  mem_sites[site].live_count += 1;
+}
+
+static void mem_count_alloc(index_s size, int site) {
+  mem_stats.alloc_count += 1;
+  mem_sites[site].total_bytes += size;
+  mem_sites[site].alloc_count += 1;
+}
+
+// Removes the entry, returning its size, or -1 when the pointer isn't tracked
+static index_s mem_untrack(const void* ptr, int* site_out) {
+  MemEntry* entry = mem_find(ptr);
+  if (!entry) return -1;
+
+  index_s size = entry->size;
+  MemSite* s = &mem_sites[entry->site];
+  s->live_bytes -= size;
+  s->live_count -= 1;
+  *site_out = entry->site;
+
+  mem_stats.live_bytes -= size;
+  mem_stats.live_count -= 1;
+  entry->ptr = MEM_TOMBSTONE;
+  return size;
+}
+
+static void mem_notify(
+  MemEventType type, const void* ptr, uintptr_t old_addr,
+  index_s size, index_s old_size, int site
+) {
+  MemHook hook = mem_hook;
+  if (!hook) return;
+
+  MemEvent event = {
+    .type = type,
+    .ptr = ptr,
+    .old_addr = old_addr,
+    .size = size,
+    .old_size = old_size,
+    .site = &mem_sites[site],
+  };
+  hook(&event, mem_hook_data);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation wrappers
+////////////////////////////////////////////////////////////////////////////////
+
+void* memstats_malloc(size_t size) {
+  void* ret = malloc(size);
+  if (!ret) return NULL;
+
+  int site = mem_current_site();
+  mem_lock();
+  mem_track(ret, (index_s)size, site);
+  mem_count_alloc((index_s)size, site);
+  mem_unlock();
+
+  mem_notify(MEM_EVENT_ALLOC, ret, 0, (index_s)size, 0, site);
+  return ret;
+}
+
+void* memstats_realloc(void* ptr, size_t size) {
+  if (!ptr) return memstats_malloc(size);
+
+  // untrack first, since once realloc returns another thread may be handed
+  //    the old address. The address is kept opaque for the event so the
+  //    compiler doesn't see the released pointer being used.
+  const volatile uintptr_t old_addr = (uintptr_t)ptr;
+  int site = mem_current_site();
+  mem_lock();
+  index_s old_size = mem_untrack(ptr, &site);
+  mem_unlock();
+
+  void* ret = realloc(ptr, size);
+
+  mem_lock();
+  if (!ret) {
+    if (old_size >= 0) mem_track((void*)old_addr, old_size, site);
+    mem_unlock();
+    return NULL;
+  }
+  mem_track(ret, (index_s)size, site);
+  mem_stats.realloc_count += 1;
+  if ((uintptr_t)ret != old_addr && old_size > 0) {
+    mem_stats.realloc_copy_bytes += MIN(old_size, (index_s)size);
+  }
+  mem_unlock();
+
+  mem_notify(MEM_EVENT_REALLOC, ret, old_addr,
+    (index_s)size, MAX(old_size, 0), site
+  );
+  return ret;
+}
+
+void memstats_free(void* ptr) {
+  if (!ptr) return;
+
+  const volatile uintptr_t addr = (uintptr_t)ptr;
+  int site = 0;
+  mem_lock();
+  index_s size = mem_untrack(ptr, &site);
+  if (size >= 0) mem_stats.free_count += 1;
+  mem_unlock();
+
+  free(ptr);
+  if (size < 0) return;
+  mem_notify(MEM_EVENT_FREE, NULL, addr, 0, size, site);
+}
+
+// \brief Starts tracking a block that was disowned earlier, without counting
+//    it as a new allocation.
+void memstats_adopt(void* ptr, size_t size) {
+  if (!ptr) return;
+
+  int site = mem_current_site();
+  mem_lock();
+  mem_track(ptr, (index_s)size, site);
+  mem_unlock();
+}
+
+// \brief Stops tracking a block being handed to the caller, which will free it
+//    without going through memstats_free.
+void memstats_disown(void* ptr) {
+  if (!ptr) return;
+
+  int site;
+  mem_lock();
+  mem_untrack(ptr, &site);
+  mem_unlock();
+}
+
+// \brief Attributes allocations on this thread to the given call site until
+//    the matching memstats_site_end. Sites nest, with the innermost winning.
+void memstats_site_begin(const char* file, int line) {
+  mem_lock();
+  int site = mem_site_lookup(file, line);
+  mem_unlock();
+
+  if (mem_site_depth < MEMSTATS_SITE_DEPTH) {
+    mem_site_stack[mem_site_depth] = site;
+  }
+  ++mem_site_depth;
+}
+
+void memstats_site_end(void) {
+  if (mem_site_depth > 0) --mem_site_depth;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Queries
+////////////////////////////////////////////////////////////////////////////////
+
+MemStats memstats_get(void) {
+  mem_lock();
+  MemStats ret = mem_stats;
+  mem_unlock();
+  return ret;
+}
+
+static int mem_site_cmp(const void* lhs, const void* rhs) {
+  const MemSite* a = lhs;
+  const MemSite* b = rhs;
+  if (a->live_bytes != b->live_bytes) {
+    return a->live_bytes < b->live_bytes ? 1 : -1;
+  }
+  return (a->total_bytes < b->total_bytes) - (a->total_bytes > b->total_bytes);
+}
+
+// \brief Copies out up to capacity sites, ordered by live bytes with the most
+//    memory first. Returns the number copied.
+index_s memstats_sites(MemSite* out, index_s capacity) {
+  static MemSite sorted[MEMSTATS_MAX_SITES];
+
+  // sorted is shared between callers, so it's only touched under the lock
+  mem_lock();
+  index_s count = mem_site_count;
+  memcpy(sorted, mem_sites, sizeof(MemSite) * count);
+  qsort(sorted, count, sizeof(MemSite), mem_site_cmp);
+
+  // leave out sites that never allocated (the unattributed entry, usually)
+  index_s written = 0;
+  for (index_s i = 0; i < count && written < capacity; ++i) {
+    if (sorted[i].alloc_count) out[written++] = sorted[i];
+  }
+  mem_unlock();
+  return written;
+}
+
+void memstats_reset_peak(void) {
+  mem_lock();
+  mem_stats.peak_bytes = mem_stats.live_bytes;
+  mem_unlock();
+}
+
+void memstats_set_hook(MemHook hook, void* user_data) {
+  mem_lock();
+  mem_hook = hook;
+  mem_hook_data = user_data;
+  mem_unlock();
+}
+
+// \brief Prints the totals and the sites holding the most memory.
+void memstats_dump(void) {
+  MemStats stats = memstats_get();
+  MemSite sites[MEMSTATS_DUMP_SITES];
+  index_s count = memstats_sites(sites, MEMSTATS_DUMP_SITES);
+
+  printf(
+    "memstats: %lld live bytes in %lld blocks, peak %lld\n"
+    "          %lld allocs, %lld frees, %lld reallocs moving %lld bytes\n",
+    (long long)stats.live_bytes, (long long)stats.live_count,
+    (long long)stats.peak_bytes, (long long)stats.alloc_count,
+    (long long)stats.free_count, (long long)stats.realloc_count,
+    (long long)stats.realloc_copy_bytes
+  );
+
+  for (index_s i = 0; i < count; ++i) {
+    const MemSite* s = &sites[i];
+    printf("  %12lld bytes %8lld live %8lld allocs  %s:%d\n",
+      (long long)s->live_bytes, (long long)s->live_count,
+      (long long)s->alloc_count, s->file ? s->file : "(no site)", s->line
+    );
+  }
+
+  fflush(stdout);
+}
+
+// \brief Dumps if at least the given number of seconds have passed since the
+//    last dump from this function, for calling once per frame or tick.
+bool memstats_dump_every(double seconds) {
+  static double last = -1;
+
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  double now = (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+
+  mem_lock();
+  bool due = last < 0 || now - last >= seconds;
+  if (due) last = now;
+  mem_unlock();
+
+  if (!due) return false;
+  memstats_dump();
+  return true;
+}
+
+#endif
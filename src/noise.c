@@ -0,0 +1,582 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "noise.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define NOISE_SSE2
+# include <emmintrin.h>
+#endif
+
+// Skew factors between the simplex and square/cube lattices
+#define NOISE_F2 0.366025403784f // (sqrt(3) - 1) / 2
+#define NOISE_G2 0.211324865405f // (3 - sqrt(3)) / 6
+#define NOISE_F3 (1.0f / 3.0f)
+#define NOISE_G3 (1.0f / 6.0f)
+
+// Ken Perlin's reference permutation, indexed modulo 256
+static const byte noise_p[256] = {
+  151, 160, 137,  91,  90,  15, 131,  13, 201,  95,  96,  53, 194, 233,   7, 225,
+  140,  36, 103,  30,  69, 142,   8,  99,  37, 240,  21,  10,  23, 190,   6, 148,
+  247, 120, 234,  75,   0,  26, 197,  62,  94, 252, 219, 203, 117,  35,  11,  32,
+   57, 177,  33,  88, 237, 149,  56,  87, 174,  20, 125, 136, 171, 168,  68, 175,
+   74, 165,  71, 134, 139,  48,  27, 166,  77, 146, 158, 231,  83, 111, 229, 122,
+   60, 211, 133, 230, 220, 105,  92,  41,  55,  46, 245,  40, 244, 102, 143,  54,
+   65,  25,  63, 161,   1, 216,  80,  73, 209,  76, 132, 187, 208,  89,  18, 169,
+  200, 196, 135, 130, 116, 188, 159,  86, 164, 100, 109, 198, 173, 186,   3,  64,
+   52, 217, 226, 250, 124, 123,   5, 202,  38, 147, 118, 126, 255,  82,  85, 212,
+  207, 206,  59, 227,  47,  16,  58,  17, 182, 189,  28,  42, 223, 183, 170, 213,
+  119, 248, 152,   2,  44, 154, 163,  70, 221, 153, 101, 155, 167,  43, 172,   9,
+  129,  22,  39, 253,  19,  98, 108, 110,  79, 113, 224, 232, 178, 185, 112, 104,
+  218, 246,  97, 228, 251,  34, 242, 193, 238, 210, 144,  12, 191, 179, 162, 241,
+   81,  51, 145, 235, 249,  14, 239, 107,  49, 192, 214,  31, 181, 199, 106, 157,
+  184,  84, 204, 176, 115, 121,  50,  45, 127,   4, 150, 254, 138, 236, 205,  93,
+  222, 114,  67,  29,  24,  72, 243, 141, 128, 195,  78,  66, 215,  61, 156, 180,
+};
+
+#define noise_perm(i) noise_p[(i) & 255]
+
+// Gradient directions, selected by the low bits of a hash
+static const float noise_grad2[8][2] = {
+  { 1,  1 }, { -1,  1 }, { 1, -1 }, { -1, -1 },
+  { 1,  0 }, { -1,  0 }, { 0,  1 }, {  0, -1 },
+};
+
+// The 12 cube edge directions, padded to 16 as in the improved noise paper
+static const float noise_grad3[16][3] = {
+  { 1,  1,  0 }, { -1,  1,  0 }, { 1, -1,  0 }, { -1, -1,  0 },
+  { 1,  0,  1 }, { -1,  0,  1 }, { 1,  0, -1 }, { -1,  0, -1 },
+  { 0,  1,  1 }, {  0, -1,  1 }, { 0,  1, -1 }, {  0, -1, -1 },
+  { 1,  1,  0 }, {  0, -1,  1 }, { -1, 1,  0 }, {  0, -1, -1 },
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Shared helpers
+////////////////////////////////////////////////////////////////////////////////
+
+// The SIMD paths below repeat these operations in the same order, so both give
+//    bit-identical results.
+
+static inline int noise_floor(float x) {
+  int i = (int)x;
+  return i - (x < (float)i);
+}
+
+static inline float noise_fade(float t) {
+  return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+static inline float noise_lerp(float a, float b, float t) {
+  return a + t * (b - a);
+}
+
+static inline float noise_dot2(int h, float x, float y) {
+  const float* g = noise_grad2[h & 7];
+  return g[0] * x + g[1] * y;
+}
+
+static inline float noise_dot3(int h, float x, float y, float z) {
+  const float* g = noise_grad3[h & 15];
+  return g[0] * x + g[1] * y + g[2] * z;
+}
+
+// Hashes of the cell corners, where bit 0 of the index is the x offset and so on
+static inline void noise_hash_cell2(int x, int y, int h[4]) {
+  int a = noise_perm(x) + y;
+  int b = noise_perm(x + 1) + y;
+  h[0] = noise_perm(a);
+  h[1] = noise_perm(b);
+  h[2] = noise_perm(a + 1);
+  h[3] = noise_perm(b + 1);
+}
+
+static inline void noise_hash_cell3(int x, int y, int z, int h[8]) {
+  int a = noise_perm(x) + y;
+  int b = noise_perm(x + 1) + y;
+  int aa = noise_perm(a) + z, ab = noise_perm(a + 1) + z;
+  int ba = noise_perm(b) + z, bb = noise_perm(b + 1) + z;
+  h[0] = noise_perm(aa);
+  h[1] = noise_perm(ba);
+  h[2] = noise_perm(ab);
+  h[3] = noise_perm(bb);
+  h[4] = noise_perm(aa + 1);
+  h[5] = noise_perm(ba + 1);
+  h[6] = noise_perm(ab + 1);
+  h[7] = noise_perm(bb + 1);
+}
+
+static inline int noise_hash2(int x, int y) {
+  return noise_perm(x + noise_perm(y));
+}
+
+static inline int noise_hash3(int x, int y, int z) {
+  return noise_perm(x + noise_perm(y + noise_perm(z)));
+}
+
+// Orders the simplex corners by which offset is largest
+static inline void noise_simplex3_order(
+  float x, float y, float z, int o1[3], int o2[3]
+) {
+  bool xy = x >= y, xz = x >= z, yz = y >= z;
+  o1[0] = xy && xz;
+  o1[1] = !xy && yz;
+  o1[2] = !xz && !yz;
+  o2[0] = xy || xz;
+  o2[1] = !xy || yz;
+  o2[2] = !xz || !yz;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar noise
+////////////////////////////////////////////////////////////////////////////////
+
+float perlin2(vec2 P) {
+  int xi = noise_floor(P.x), yi = noise_floor(P.y);
+  float x = P.x - (float)xi, y = P.y - (float)yi;
+  float u = noise_fade(x), v = noise_fade(y);
+
+  int h[4];
+  noise_hash_cell2(xi & 255, yi & 255, h);
+
+  float n00 = noise_dot2(h[0], x, y);
+  float n10 = noise_dot2(h[1], x - 1, y);
+  float n01 = noise_dot2(h[2], x, y - 1);
+  float n11 = noise_dot2(h[3], x - 1, y - 1);
+
+  return noise_lerp(noise_lerp(n00, n10, u), noise_lerp(n01, n11, u), v);
+}
+
+float perlin3(vec3 P) {
+  int xi = noise_floor(P.x), yi = noise_floor(P.y), zi = noise_floor(P.z);
+  float x = P.x - (float)xi, y = P.y - (float)yi, z = P.z - (float)zi;
+  float u = noise_fade(x), v = noise_fade(y), w = noise_fade(z);
+
+  int h[8];
+  noise_hash_cell3(xi & 255, yi & 255, zi & 255, h);
+
+  float n000 = noise_dot3(h[0], x, y, z);
+  float n100 = noise_dot3(h[1], x - 1, y, z);
+  float n010 = noise_dot3(h[2], x, y - 1, z);
+  float n110 = noise_dot3(h[3], x - 1, y - 1, z);
+  float n001 = noise_dot3(h[4], x, y, z - 1);
+  float n101 = noise_dot3(h[5], x - 1, y, z - 1);
+  float n011 = noise_dot3(h[6], x, y - 1, z - 1);
+  float n111 = noise_dot3(h[7], x - 1, y - 1, z - 1);
+
+  float n0 = noise_lerp(
+    noise_lerp(n000, n100, u), noise_lerp(n010, n110, u), v);
+  float n1 = noise_lerp(
+    noise_lerp(n001, n101, u), noise_lerp(n011, n111, u), v);
+  return noise_lerp(n0, n1, w);
+}
+
+static inline float noise_corner2(int h, float x, float y) {
+  float t = 0.5f - x * x - y * y;
+  if (t < 0) return 0;
+  t *= t;
+  return t * t * noise_dot2(h, x, y);
+}
+
+static inline float noise_corner3(int h, float x, float y, float z) {
+  float t = 0.6f - x * x - y * y - z * z;
+  if (t < 0) return 0;
+  t *= t;
+  return t * t * noise_dot3(h, x, y, z);
+}
+
+float simplex2(vec2 P) {
+  float s = (P.x + P.y) * NOISE_F2;
+  int i = noise_floor(P.x + s), j = noise_floor(P.y + s);
+  float t = (float)(i + j) * NOISE_G2;
+  float x0 = P.x - ((float)i - t), y0 = P.y - ((float)j - t);
+
+  int i1 = x0 > y0, j1 = !i1;
+  float x1 = x0 - (float)i1 + NOISE_G2, y1 = y0 - (float)j1 + NOISE_G2;
+  float x2 = x0 - 1 + 2 * NOISE_G2, y2 = y0 - 1 + 2 * NOISE_G2;
+
+  i &= 255;
+  j &= 255;
+  float n0 = noise_corner2(noise_hash2(i, j), x0, y0);
+  float n1 = noise_corner2(noise_hash2(i + i1, j + j1), x1, y1);
+  float n2 = noise_corner2(noise_hash2(i + 1, j + 1), x2, y2);
+
+  return 70 * (n0 + n1 + n2);
+}
+
+float simplex3(vec3 P) {
+  float s = (P.x + P.y + P.z) * NOISE_F3;
+  int i = noise_floor(P.x + s), j = noise_floor(P.y + s);
+  int k = noise_floor(P.z + s);
+  float t = (float)(i + j + k) * NOISE_G3;
+  float x0 = P.x - ((float)i - t);
+  float y0 = P.y - ((float)j - t);
+  float z0 = P.z - ((float)k - t);
+
+  int o1[3], o2[3];
+  noise_simplex3_order(x0, y0, z0, o1, o2);
+  float x1 = x0 - (float)o1[0] + NOISE_G3;
+  float y1 = y0 - (float)o1[1] + NOISE_G3;
+  float z1 = z0 - (float)o1[2] + NOISE_G3;
+  float x2 = x0 - (float)o2[0] + 2 * NOISE_G3;
+  float y2 = y0 - (float)o2[1] + 2 * NOISE_G3;
+  float z2 = z0 - (float)o2[2] + 2 * NOISE_G3;
+  float x3 = x0 - 1 + 3 * NOISE_G3;
+  float y3 = y0 - 1 + 3 * NOISE_G3;
+  float z3 = z0 - 1 + 3 * NOISE_G3;
+
+  i &= 255;
+  j &= 255;
+  k &= 255;
+  float n0 = noise_corner3(noise_hash3(i, j, k), x0, y0, z0);
+  float n1 = noise_corner3(
+    noise_hash3(i + o1[0], j + o1[1], k + o1[2]), x1, y1, z1);
+  float n2 = noise_corner3(
+    noise_hash3(i + o2[0], j + o2[1], k + o2[2]), x2, y2, z2);
+  float n3 = noise_corner3(noise_hash3(i + 1, j + 1, k + 1), x3, y3, z3);
+
+  return 32 * (n0 + n1 + n2 + n3);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// SSE2 helpers
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef NOISE_SSE2
+
+// Lattice hashing and the gradient table lookups stay scalar per lane, the
+//    surrounding arithmetic runs four points wide.
+
+static inline __m128i noise_floor4(__m128 x) {
+  __m128i i = _mm_cvttps_epi32(x);
+  __m128 below = _mm_cmplt_ps(x, _mm_cvtepi32_ps(i));
+  return _mm_add_epi32(i, _mm_castps_si128(below));
+}
+
+static inline __m128 noise_fade4(__m128 t) {
+  __m128 t3 = _mm_mul_ps(_mm_mul_ps(t, t), t);
+  __m128 p = _mm_sub_ps(_mm_mul_ps(t, _mm_set1_ps(6)), _mm_set1_ps(15));
+  p = _mm_add_ps(_mm_mul_ps(t, p), _mm_set1_ps(10));
+  return _mm_mul_ps(t3, p);
+}
+
+static inline __m128 noise_lerp4(__m128 a, __m128 b, __m128 t) {
+  return _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a)));
+}
+
+static inline __m128 noise_dot2x4(const int h[4], __m128 x, __m128 y) {
+  const float* g0 = noise_grad2[h[0] & 7];
+  const float* g1 = noise_grad2[h[1] & 7];
+  const float* g2 = noise_grad2[h[2] & 7];
+  const float* g3 = noise_grad2[h[3] & 7];
+  __m128 gx = _mm_setr_ps(g0[0], g1[0], g2[0], g3[0]);
+  __m128 gy = _mm_setr_ps(g0[1], g1[1], g2[1], g3[1]);
+  return _mm_add_ps(_mm_mul_ps(gx, x), _mm_mul_ps(gy, y));
+}
+
+static inline __m128 noise_dot3x4(const int h[4], __m128 x, __m128 y, __m128 z) {
+  const float* g0 = noise_grad3[h[0] & 15];
+  const float* g1 = noise_grad3[h[1] & 15];
+  const float* g2 = noise_grad3[h[2] & 15];
+  const float* g3 = noise_grad3[h[3] & 15];
+  __m128 gx = _mm_setr_ps(g0[0], g1[0], g2[0], g3[0]);
+  __m128 gy = _mm_setr_ps(g0[1], g1[1], g2[1], g3[1]);
+  __m128 gz = _mm_setr_ps(g0[2], g1[2], g2[2], g3[2]);
+  return _mm_add_ps(_mm_add_ps(
+    _mm_mul_ps(gx, x), _mm_mul_ps(gy, y)), _mm_mul_ps(gz, z));
+}
+
+// Zero where t < 0, otherwise t^4 * dot
+static inline __m128 noise_falloff4(__m128 t, __m128 dot) {
+  __m128 t2 = _mm_mul_ps(t, t);
+  __m128 n = _mm_mul_ps(_mm_mul_ps(t2, t2), dot);
+  return _mm_andnot_ps(_mm_cmplt_ps(t, _mm_setzero_ps()), n);
+}
+
+static inline __m128 noise_corner2x4(const int h[4], __m128 x, __m128 y) {
+  __m128 t = _mm_sub_ps(_mm_sub_ps(
+    _mm_set1_ps(0.5f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y));
+  return noise_falloff4(t, noise_dot2x4(h, x, y));
+}
+
+static inline __m128 noise_corner3x4(
+  const int h[4], __m128 x, __m128 y, __m128 z
+) {
+  __m128 t = _mm_sub_ps(_mm_sub_ps(_mm_sub_ps(
+    _mm_set1_ps(0.6f), _mm_mul_ps(x, x)), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+  return noise_falloff4(t, noise_dot3x4(h, x, y, z));
+}
+
+// Converts a 0/1 flag per lane to float
+static inline __m128 noise_flag4(__m128 mask) {
+  return _mm_and_ps(mask, _mm_set1_ps(1));
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Batch noise
+////////////////////////////////////////////////////////////////////////////////
+
+// \brief Evaluates perlin2 at each point.
+void perlin2_batch_s(const vec2* points, index_s count, float* out) {
+  assert(points || !count);
+  assert(out || !count);
+
+  index_s i = 0;
+
+#ifdef NOISE_SSE2
+  const __m128 one = _mm_set1_ps(1);
+  const __m128i mask = _mm_set1_epi32(255);
+
+  for (; i + 4 <= count; i += 4) {
+    const vec2* p = points + i;
+    __m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+    __m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+
+    __m128i xi = noise_floor4(px), yi = noise_floor4(py);
+    __m128 x = _mm_sub_ps(px, _mm_cvtepi32_ps(xi));
+    __m128 y = _mm_sub_ps(py, _mm_cvtepi32_ps(yi));
+    __m128 u = noise_fade4(x), v = noise_fade4(y);
+
+    int cx[4], cy[4], h[4][4], hl[4];
+    _mm_storeu_si128((__m128i*)cx, _mm_and_si128(xi, mask));
+    _mm_storeu_si128((__m128i*)cy, _mm_and_si128(yi, mask));
+
+    // h[corner][lane]
+    for (int l = 0; l < 4; ++l) {
+      noise_hash_cell2(cx[l], cy[l], hl);
+      for (int c = 0; c < 4; ++c) h[c][l] = hl[c];
+    }
+
+    __m128 x1 = _mm_sub_ps(x, one), y1 = _mm_sub_ps(y, one);
+    __m128 n00 = noise_dot2x4(h[0], x, y);
+    __m128 n10 = noise_dot2x4(h[1], x1, y);
+    __m128 n01 = noise_dot2x4(h[2], x, y1);
+    __m128 n11 = noise_dot2x4(h[3], x1, y1);
+
+    _mm_storeu_ps(out + i, noise_lerp4(
+      noise_lerp4(n00, n10, u), noise_lerp4(n01, n11, u), v));
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = perlin2(points[i]);
+}
+
+// \brief Evaluates perlin3 at each point.
+void perlin3_batch_s(const vec3* points, index_s count, float* out) {
+  assert(points || !count);
+  assert(out || !count);
+
+  index_s i = 0;
+
+#ifdef NOISE_SSE2
+  const __m128 one = _mm_set1_ps(1);
+  const __m128i mask = _mm_set1_epi32(255);
+
+  for (; i + 4 <= count; i += 4) {
+    const vec3* p = points + i;
+    __m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+    __m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+    __m128 pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+    __m128i xi = noise_floor4(px), yi = noise_floor4(py), zi = noise_floor4(pz);
+    __m128 x = _mm_sub_ps(px, _mm_cvtepi32_ps(xi));
+    __m128 y = _mm_sub_ps(py, _mm_cvtepi32_ps(yi));
+    __m128 z = _mm_sub_ps(pz, _mm_cvtepi32_ps(zi));
+    __m128 u = noise_fade4(x), v = noise_fade4(y), w = noise_fade4(z);
+
+    int cx[4], cy[4], cz[4], h[8][4], hl[8];
+    _mm_storeu_si128((__m128i*)cx, _mm_and_si128(xi, mask));
+    _mm_storeu_si128((__m128i*)cy, _mm_and_si128(yi, mask));
+    _mm_storeu_si128((__m128i*)cz, _mm_and_si128(zi, mask));
+
+    for (int l = 0; l < 4; ++l) {
+      noise_hash_cell3(cx[l], cy[l], cz[l], hl);
+      for (int c = 0; c < 8; ++c) h[c][l] = hl[c];
+    }
+
+    __m128 x1 = _mm_sub_ps(x, one);
+    __m128 y1 = _mm_sub_ps(y, one);
+    __m128 z1 = _mm_sub_ps(z, one);
+    __m128 n000 = noise_dot3x4(h[0], x, y, z);
+    __m128 n100 = noise_dot3x4(h[1], x1, y, z);
+    __m128 n010 = noise_dot3x4(h[2], x, y1, z);
+    __m128 n110 = noise_dot3x4(h[3], x1, y1, z);
+    __m128 n001 = noise_dot3x4(h[4], x, y, z1);
+    __m128 n101 = noise_dot3x4(h[5], x1, y, z1);
+    __m128 n011 = noise_dot3x4(h[6], x, y1, z1);
+    __m128 n111 = noise_dot3x4(h[7], x1, y1, z1);
+
+    __m128 n0 = noise_lerp4(
+      noise_lerp4(n000, n100, u), noise_lerp4(n010, n110, u), v);
+    __m128 n1 = noise_lerp4(
+      noise_lerp4(n001, n101, u), noise_lerp4(n011, n111, u), v);
+    _mm_storeu_ps(out + i, noise_lerp4(n0, n1, w));
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = perlin3(points[i]);
+}
+
+// \brief Evaluates simplex2 at each point.
+void simplex2_batch_s(const vec2* points, index_s count, float* out) {
+  assert(points || !count);
+  assert(out || !count);
+
+  index_s i = 0;
+
+#ifdef NOISE_SSE2
+  const __m128 one = _mm_set1_ps(1);
+  const __m128 g2 = _mm_set1_ps(NOISE_G2);
+  const __m128 g2x2 = _mm_set1_ps(2 * NOISE_G2);
+  const __m128i mask = _mm_set1_epi32(255);
+
+  for (; i + 4 <= count; i += 4) {
+    const vec2* p = points + i;
+    __m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+    __m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+
+    __m128 s = _mm_mul_ps(_mm_add_ps(px, py), _mm_set1_ps(NOISE_F2));
+    __m128i ci = noise_floor4(_mm_add_ps(px, s));
+    __m128i cj = noise_floor4(_mm_add_ps(py, s));
+    __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(_mm_add_epi32(ci, cj)), g2);
+    __m128 x0 = _mm_sub_ps(px, _mm_sub_ps(_mm_cvtepi32_ps(ci), t));
+    __m128 y0 = _mm_sub_ps(py, _mm_sub_ps(_mm_cvtepi32_ps(cj), t));
+
+    __m128 upper = _mm_cmpgt_ps(x0, y0);
+    __m128 i1 = noise_flag4(upper);
+    __m128 j1 = noise_flag4(_mm_cmple_ps(x0, y0));
+    __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, i1), g2);
+    __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, j1), g2);
+    __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, one), g2x2);
+    __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, one), g2x2);
+
+    int li[4], lj[4], lu[4], h[3][4];
+    _mm_storeu_si128((__m128i*)li, _mm_and_si128(ci, mask));
+    _mm_storeu_si128((__m128i*)lj, _mm_and_si128(cj, mask));
+    _mm_storeu_si128((__m128i*)lu, _mm_castps_si128(upper));
+
+    for (int l = 0; l < 4; ++l) {
+      int di = lu[l] & 1;
+      h[0][l] = noise_hash2(li[l], lj[l]);
+      h[1][l] = noise_hash2(li[l] + di, lj[l] + !di);
+      h[2][l] = noise_hash2(li[l] + 1, lj[l] + 1);
+    }
+
+    __m128 n = _mm_add_ps(_mm_add_ps(
+      noise_corner2x4(h[0], x0, y0), noise_corner2x4(h[1], x1, y1)),
+      noise_corner2x4(h[2], x2, y2)
+    );
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_set1_ps(70), n));
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = simplex2(points[i]);
+}
+
+// \brief Evaluates simplex3 at each point.
+void simplex3_batch_s(const vec3* points, index_s count, float* out) {
+  assert(points || !count);
+  assert(out || !count);
+
+  index_s i = 0;
+
+#ifdef NOISE_SSE2
+  const __m128 one = _mm_set1_ps(1);
+  const __m128 g3 = _mm_set1_ps(NOISE_G3);
+  const __m128 g3x2 = _mm_set1_ps(2 * NOISE_G3);
+  const __m128 g3x3 = _mm_set1_ps(3 * NOISE_G3);
+  const __m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  const __m128i mask = _mm_set1_epi32(255);
+
+  for (; i + 4 <= count; i += 4) {
+    const vec3* p = points + i;
+    __m128 px = _mm_setr_ps(p[0].x, p[1].x, p[2].x, p[3].x);
+    __m128 py = _mm_setr_ps(p[0].y, p[1].y, p[2].y, p[3].y);
+    __m128 pz = _mm_setr_ps(p[0].z, p[1].z, p[2].z, p[3].z);
+
+    __m128 s = _mm_mul_ps(
+      _mm_add_ps(_mm_add_ps(px, py), pz), _mm_set1_ps(NOISE_F3));
+    __m128i ci = noise_floor4(_mm_add_ps(px, s));
+    __m128i cj = noise_floor4(_mm_add_ps(py, s));
+    __m128i ck = noise_floor4(_mm_add_ps(pz, s));
+    __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(
+      _mm_add_epi32(_mm_add_epi32(ci, cj), ck)), g3);
+    __m128 x0 = _mm_sub_ps(px, _mm_sub_ps(_mm_cvtepi32_ps(ci), t));
+    __m128 y0 = _mm_sub_ps(py, _mm_sub_ps(_mm_cvtepi32_ps(cj), t));
+    __m128 z0 = _mm_sub_ps(pz, _mm_sub_ps(_mm_cvtepi32_ps(ck), t));
+
+    // same ordering as noise_simplex3_order
+    __m128 xy = _mm_cmpge_ps(x0, y0);
+    __m128 xz = _mm_cmpge_ps(x0, z0);
+    __m128 yz = _mm_cmpge_ps(y0, z0);
+    __m128 o1[3] = {
+      _mm_and_ps(xy, xz),
+      _mm_andnot_ps(xy, yz),
+      _mm_andnot_ps(_mm_or_ps(xz, yz), all),
+    };
+    __m128 o2[3] = {
+      _mm_or_ps(xy, xz),
+      _mm_or_ps(_mm_andnot_ps(xy, all), yz),
+      _mm_andnot_ps(_mm_and_ps(xz, yz), all),
+    };
+
+    __m128 x1 = _mm_add_ps(_mm_sub_ps(x0, noise_flag4(o1[0])), g3);
+    __m128 y1 = _mm_add_ps(_mm_sub_ps(y0, noise_flag4(o1[1])), g3);
+    __m128 z1 = _mm_add_ps(_mm_sub_ps(z0, noise_flag4(o1[2])), g3);
+    __m128 x2 = _mm_add_ps(_mm_sub_ps(x0, noise_flag4(o2[0])), g3x2);
+    __m128 y2 = _mm_add_ps(_mm_sub_ps(y0, noise_flag4(o2[1])), g3x2);
+    __m128 z2 = _mm_add_ps(_mm_sub_ps(z0, noise_flag4(o2[2])), g3x2);
+    __m128 x3 = _mm_add_ps(_mm_sub_ps(x0, one), g3x3);
+    __m128 y3 = _mm_add_ps(_mm_sub_ps(y0, one), g3x3);
+    __m128 z3 = _mm_add_ps(_mm_sub_ps(z0, one), g3x3);
+
+    int li[4], lj[4], lk[4], f1[3][4], f2[3][4], h[4][4];
+    _mm_storeu_si128((__m128i*)li, _mm_and_si128(ci, mask));
+    _mm_storeu_si128((__m128i*)lj, _mm_and_si128(cj, mask));
+    _mm_storeu_si128((__m128i*)lk, _mm_and_si128(ck, mask));
+    for (int a = 0; a < 3; ++a) {
+      _mm_storeu_si128((__m128i*)f1[a], _mm_castps_si128(o1[a]));
+      _mm_storeu_si128((__m128i*)f2[a], _mm_castps_si128(o2[a]));
+    }
+
+    for (int l = 0; l < 4; ++l) {
+      h[0][l] = noise_hash3(li[l], lj[l], lk[l]);
+      h[1][l] = noise_hash3(
+        li[l] + (f1[0][l] & 1), lj[l] + (f1[1][l] & 1), lk[l] + (f1[2][l] & 1));
+      h[2][l] = noise_hash3(
+        li[l] + (f2[0][l] & 1), lj[l] + (f2[1][l] & 1), lk[l] + (f2[2][l] & 1));
+      h[3][l] = noise_hash3(li[l] + 1, lj[l] + 1, lk[l] + 1);
+    }
+
+    __m128 n = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+      noise_corner3x4(h[0], x0, y0, z0), noise_corner3x4(h[1], x1, y1, z1)),
+      noise_corner3x4(h[2], x2, y2, z2)), noise_corner3x4(h[3], x3, y3, z3)
+    );
+    _mm_storeu_ps(out + i, _mm_mul_ps(_mm_set1_ps(32), n));
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = simplex3(points[i]);
+}
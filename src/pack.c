@@ -0,0 +1,409 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "pack.h"
+
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define PACK_SSE2
+# include <emmintrin.h>
+#endif
+
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX2__))
+# define PACK_F16C
+# include <immintrin.h>
+#endif
+
+typedef union {
+  uint u;
+  float f;
+} pack_bits;
+
+////////////////////////////////////////////////////////////////////////////////
+// Scalar conversions
+////////////////////////////////////////////////////////////////////////////////
+
+// Based on float_to_half_fast3_rtne from Fabian Giesen:
+// https://gist.github.com/rygorous/2156668
+u16 ftoh(float f) {
+  pack_bits in = { .f = f };
+  uint sign = (in.u >> 16) & 0x8000u;
+  uint u = in.u & 0x7FFFFFFFu;
+
+  // too large for a half becomes infinity. NaN keeps the top of its payload
+  //    and is made quiet, the same as F16C's vcvtps2ph.
+  if (u >= 0x47800000u) {
+    if (u > 0x7F800000u) {
+      return (u16)(sign | 0x7E00u | ((u >> 13) & 0x3FFu));
+    }
+    return (u16)(sign | 0x7C00u);
+  }
+
+  // subnormal results: let the float adder do the rounding by aligning the
+  //    mantissa against 0.5f
+  if (u < 0x38800000u) {
+    pack_bits denorm = { .u = u };
+    denorm.f += 0.5f;
+    return (u16)(sign | (denorm.u - 0x3F000000u));
+  }
+
+  // rebias the exponent and round to nearest even on the dropped bits
+  uint mant_odd = (u >> 13) & 1u;
+  u += (uint)(15 - 127) * (1u << 23) + 0xFFFu + mant_odd;
+  return (u16)(sign | (u >> 13));
+}
+
+// Based on half_to_float from Fabian Giesen (link above)
+float htof(u16 h) {
+  static const pack_bits magic = { .u = (254u - 15u) << 23 };
+  static const pack_bits was_infnan = { .u = (127u + 16u) << 23 };
+  pack_bits out = { .u = (uint)(h & 0x7FFFu) << 13 };
+  out.f *= magic.f;
+  if (out.f >= was_infnan.f) {
+    out.u |= 255u << 23;
+    if (out.u & 0x7FFFFFu) out.u |= 0x400000u; // quiet NaN, as F16C does
+  }
+  out.u |= (uint)(h & 0x8000u) << 16;
+  return out.f;
+}
+
+// The scalar encoders round with lrintf so they match the SIMD conversions,
+//    which round to nearest even.
+
+byte ftoun8(float f) {
+  f = f > 0 ? (f < 1 ? f : 1) : 0;
+  return (byte)lrintf(f * 255.0f);
+}
+
+float un8tof(byte b) {
+  return (float)b * (1.0f / 255.0f);
+}
+
+signed char ftosn8(float f) {
+  f = f > -1 ? (f < 1 ? f : 1) : -1;
+  return (signed char)lrintf(f * 127.0f);
+}
+
+float sn8tof(signed char b) {
+  return MAX((float)b * (1.0f / 127.0f), -1.0f);
+}
+
+u16 ftoun16(float f) {
+  f = f > 0 ? (f < 1 ? f : 1) : 0;
+  return (u16)lrintf(f * 65535.0f);
+}
+
+float un16tof(u16 s) {
+  return (float)s * (1.0f / 65535.0f);
+}
+
+short ftosn16(float f) {
+  f = f > -1 ? (f < 1 ? f : 1) : -1;
+  return (short)lrintf(f * 32767.0f);
+}
+
+float sn16tof(short s) {
+  return MAX((float)s * (1.0f / 32767.0f), -1.0f);
+}
+
+// Octahedral normal encoding, from "A Survey of Efficient Representations for
+//    Independent Unit Vectors" (Cigolle et al., JCGT 2014).
+static inline float oct_sign(float f) {
+  return f >= 0 ? 1.0f : -1.0f;
+}
+
+// \brief Projects a unit vector onto the octahedron and unfolds it into the
+//    [-1, 1] square.
+vec2 oct_encode(vec3 n) {
+  float l1 = fabsf(n.x) + fabsf(n.y) + fabsf(n.z);
+  vec2 p = v2f(n.x / l1, n.y / l1);
+  if (n.z < 0) {
+    return v2f(
+      (1 - fabsf(p.y)) * oct_sign(p.x),
+      (1 - fabsf(p.x)) * oct_sign(p.y)
+    );
+  }
+  return p;
+}
+
+// \brief Reverses oct_encode, returning a normalized vector.
+vec3 oct_decode(vec2 e) {
+  vec3 n = v3f(e.x, e.y, 1 - fabsf(e.x) - fabsf(e.y));
+  float t = MAX(-n.z, 0);
+  n.x += n.x >= 0 ? -t : t;
+  n.y += n.y >= 0 ? -t : t;
+  return v3norm(n);
+}
+
+// \brief Encodes a unit vector into 32 bits as two snorm16 values (x in the low
+//    half, y in the high half).
+uint oct_pack16(vec3 n) {
+  vec2 e = oct_encode(n);
+  return (u16)ftosn16(e.x) | ((uint)(u16)ftosn16(e.y) << 16);
+}
+
+vec3 oct_unpack16(uint packed) {
+  return oct_decode(v2f(
+    sn16tof((short)(packed & 0xFFFFu)),
+    sn16tof((short)(packed >> 16))
+  ));
+}
+
+vec3b b3from_v3(vec3 v) {
+  return (vec3b){.i={ ftoun8(v.x), ftoun8(v.y), ftoun8(v.z) }};
+}
+
+vec3 v3from_b3(vec3b b) {
+  return v3f(un8tof(b.x), un8tof(b.y), un8tof(b.z));
+}
+
+vec4b b4from_v4(vec4 v) {
+  return (vec4b){.i={ ftoun8(v.x), ftoun8(v.y), ftoun8(v.z), ftoun8(v.w) }};
+}
+
+vec4 v4from_b4(vec4b b) {
+  return v4f(un8tof(b.x), un8tof(b.y), un8tof(b.z), un8tof(b.w));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Batch conversions
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef PACK_SSE2
+// clamps and scales 4 floats, then converts with round-to-nearest-even
+static inline __m128i pack_scale_epi32(
+  const float* in, __m128 lo, __m128 hi, __m128 scale
+) {
+  __m128 v = _mm_loadu_ps(in);
+  v = _mm_min_ps(_mm_max_ps(v, lo), hi);
+  return _mm_cvtps_epi32(_mm_mul_ps(v, scale));
+}
+#endif
+
+void pack_f16(u16* out, const float* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_F16C
+  for (; i + 4 <= count; i += 4) {
+    __m128i h = _mm_cvtps_ph(_mm_loadu_ps(in + i), _MM_FROUND_TO_NEAREST_INT);
+    _mm_storel_epi64((__m128i*)(out + i), h);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = ftoh(in[i]);
+  }
+}
+
+void unpack_f16(float* out, const u16* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_F16C
+  for (; i + 4 <= count; i += 4) {
+    __m128i h = _mm_loadl_epi64((const __m128i*)(in + i));
+    _mm_storeu_ps(out + i, _mm_cvtph_ps(h));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = htof(in[i]);
+  }
+}
+
+void pack_unorm8(byte* out, const float* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 lo = _mm_setzero_ps();
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(255.0f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = pack_scale_epi32(in + i, lo, hi, scale);
+    __m128i b = pack_scale_epi32(in + i + 4, lo, hi, scale);
+    __m128i c = pack_scale_epi32(in + i + 8, lo, hi, scale);
+    __m128i d = pack_scale_epi32(in + i + 12, lo, hi, scale);
+    __m128i ab = _mm_packs_epi32(a, b);
+    __m128i cd = _mm_packs_epi32(c, d);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(ab, cd));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = ftoun8(in[i]);
+  }
+}
+
+void unpack_unorm8(float* out, const byte* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i lo16 = _mm_unpacklo_epi8(b, zero);
+    __m128i hi16 = _mm_unpackhi_epi8(b, zero);
+    __m128i v[4] = {
+      _mm_unpacklo_epi16(lo16, zero), _mm_unpackhi_epi16(lo16, zero),
+      _mm_unpacklo_epi16(hi16, zero), _mm_unpackhi_epi16(hi16, zero),
+    };
+    for (int j = 0; j < 4; ++j) {
+      _mm_storeu_ps(out + i + j * 4, _mm_mul_ps(_mm_cvtepi32_ps(v[j]), scale));
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = un8tof(in[i]);
+  }
+}
+
+void pack_snorm8(signed char* out, const float* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(127.0f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = pack_scale_epi32(in + i, lo, hi, scale);
+    __m128i b = pack_scale_epi32(in + i + 4, lo, hi, scale);
+    __m128i c = pack_scale_epi32(in + i + 8, lo, hi, scale);
+    __m128i d = pack_scale_epi32(in + i + 12, lo, hi, scale);
+    __m128i ab = _mm_packs_epi32(a, b);
+    __m128i cd = _mm_packs_epi32(c, d);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi16(ab, cd));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = ftosn8(in[i]);
+  }
+}
+
+void unpack_snorm8(float* out, const signed char* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 scale = _mm_set1_ps(1.0f / 127.0f);
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  for (; i + 16 <= count; i += 16) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(in + i));
+    // sign extend by placing each byte in the high half and shifting down
+    __m128i lo16 = _mm_srai_epi16(_mm_unpacklo_epi8(b, b), 8);
+    __m128i hi16 = _mm_srai_epi16(_mm_unpackhi_epi8(b, b), 8);
+    __m128i v[4] = {
+      _mm_srai_epi32(_mm_unpacklo_epi16(lo16, lo16), 16),
+      _mm_srai_epi32(_mm_unpackhi_epi16(lo16, lo16), 16),
+      _mm_srai_epi32(_mm_unpacklo_epi16(hi16, hi16), 16),
+      _mm_srai_epi32(_mm_unpackhi_epi16(hi16, hi16), 16),
+    };
+    for (int j = 0; j < 4; ++j) {
+      __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(v[j]), scale);
+      _mm_storeu_ps(out + i + j * 4, _mm_max_ps(f, lo));
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = sn8tof(in[i]);
+  }
+}
+
+void pack_unorm16(u16* out, const float* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 lo = _mm_setzero_ps();
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(65535.0f);
+  // SSE2 only has a signed 32->16 pack, so bias into signed range and back
+  const __m128i bias32 = _mm_set1_epi32(32768);
+  const __m128i bias16 = _mm_set1_epi16((short)0x8000);
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = _mm_sub_epi32(pack_scale_epi32(in + i, lo, hi, scale), bias32);
+    __m128i b = _mm_sub_epi32(pack_scale_epi32(in + i + 4, lo, hi, scale), bias32);
+    __m128i v = _mm_xor_si128(_mm_packs_epi32(a, b), bias16);
+    _mm_storeu_si128((__m128i*)(out + i), v);
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = ftoun16(in[i]);
+  }
+}
+
+void unpack_unorm16(float* out, const u16* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+  for (; i + 8 <= count; i += 8) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128 a = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, zero));
+    __m128 b = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, zero));
+    _mm_storeu_ps(out + i, _mm_mul_ps(a, scale));
+    _mm_storeu_ps(out + i + 4, _mm_mul_ps(b, scale));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = un16tof(in[i]);
+  }
+}
+
+void pack_snorm16(short* out, const float* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  const __m128 hi = _mm_set1_ps(1.0f);
+  const __m128 scale = _mm_set1_ps(32767.0f);
+  for (; i + 8 <= count; i += 8) {
+    __m128i a = pack_scale_epi32(in + i, lo, hi, scale);
+    __m128i b = pack_scale_epi32(in + i + 4, lo, hi, scale);
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = ftosn16(in[i]);
+  }
+}
+
+void unpack_snorm16(float* out, const short* in, index_s count) {
+  index_s i = 0;
+#ifdef PACK_SSE2
+  const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+  const __m128 lo = _mm_set1_ps(-1.0f);
+  for (; i + 8 <= count; i += 8) {
+    __m128i s = _mm_loadu_si128((const __m128i*)(in + i));
+    __m128i a = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+    __m128i b = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+    __m128 fa = _mm_mul_ps(_mm_cvtepi32_ps(a), scale);
+    __m128 fb = _mm_mul_ps(_mm_cvtepi32_ps(b), scale);
+    _mm_storeu_ps(out + i, _mm_max_ps(fa, lo));
+    _mm_storeu_ps(out + i + 4, _mm_max_ps(fb, lo));
+  }
+#endif
+  for (; i < count; ++i) {
+    out[i] = sn16tof(in[i]);
+  }
+}
+
+void pack_oct16(uint* out, const vec3* in, index_s count) {
+  for (index_s i = 0; i < count; ++i) {
+    out[i] = oct_pack16(in[i]);
+  }
+}
+
+void unpack_oct16(vec3* out, const uint* in, index_s count) {
+  for (index_s i = 0; i < count; ++i) {
+    out[i] = oct_unpack16(in[i]);
+  }
+}
@@ -0,0 +1,815 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "parallel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Chunking
+////////////////////////////////////////////////////////////////////////////////
+
+// A few chunks per thread (the workers plus the waiting caller) lets faster
+//    threads pick up the slack without making the serial combine step long
+#define PAR_CHUNKS_PER_THREAD 4
+
+static index_s par_chunk_count_min(
+  JobPool pool, index_s count, index_s min_chunk
+) {
+  index_s max_chunks = ((index_s)pool->worker_count + 1) * PAR_CHUNKS_PER_THREAD;
+  return MAX(1, MIN(count / min_chunk, max_chunks));
+}
+
+static index_s par_chunk_count(JobPool pool, index_s count) {
+  return par_chunk_count_min(pool, count, PAR_MIN_CHUNK);
+}
+
+static inline index_s par_chunk_begin(index_s count, index_s chunks, index_s c) {
+  return count * c / chunks;
+}
+
+static inline void elem_copy(void* dst, const void* src, index_s size) {
+  switch (size) {
+    case 4: memcpy(dst, src, 4); break;
+    case 8: memcpy(dst, src, 8); break;
+    case 16: memcpy(dst, src, 16); break;
+    default: memcpy(dst, src, size); break;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// For each
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  byte* elements;
+  index_s element_size;
+  ParChunkFn fn;
+  void* data;
+} ParForeach;
+
+static void par_foreach_range(void* data, index_s begin, index_s end) {
+  ParForeach* ctx = data;
+  ctx->fn(ctx->data, ctx->elements + begin * ctx->element_size, begin, end);
+}
+
+// \brief Calls fn over pieces of the buffer no larger than grain, in parallel.
+//    A grain of zero or less picks a size from the worker count.
+void par_foreach_s(JobPool pool, void* elements, index_s count,
+  index_s element_size, index_s grain, ParChunkFn fn, void* data
+) {
+  assert(pool && fn);
+  if (count <= 0) return;
+
+  if (grain <= 0) grain = MAX(PAR_MIN_CHUNK, count / par_chunk_count(pool, count));
+
+  ParForeach ctx = {
+    .elements = elements,
+    .element_size = element_size,
+    .fn = fn,
+    .data = data,
+  };
+
+  parallel_for(pool, 0, count, grain, par_foreach_range, &ctx);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reduce
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  const byte* elements;
+  index_s count, chunks, element_size;
+  byte* accs;
+  index_s acc_size;
+  ParReduceFn reduce;
+  void* data;
+} ParReduce;
+
+static void par_reduce_chunks(void* data, index_s begin, index_s end) {
+  ParReduce* ctx = data;
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = par_chunk_begin(ctx->count, ctx->chunks, c);
+    index_s last = par_chunk_begin(ctx->count, ctx->chunks, c + 1);
+    ctx->reduce(ctx->data, ctx->accs + c * ctx->acc_size,
+      ctx->elements + first * ctx->element_size, last - first
+    );
+  }
+}
+
+// \brief Map-reduce: acc holds the identity on entry. Each chunk folds its
+//    elements into a copy of the identity with reduce, then the chunk results
+//    are folded into acc with combine, in order.
+void par_reduce_s(JobPool pool, const void* elements, index_s count,
+  index_s element_size, void* acc, index_s acc_size,
+  ParReduceFn reduce, ParCombineFn combine, void* data
+) {
+  assert(pool && acc && reduce && combine);
+  if (count <= 0) return;
+
+  index_s chunks = par_chunk_count(pool, count);
+
+  if (chunks == 1) {
+    reduce(data, acc, elements, count);
+    return;
+  }
+
+  byte* accs = malloc(chunks * acc_size);
+  assert(accs);
+
+  for (index_s c = 0; c < chunks; ++c) {
+    memcpy(accs + c * acc_size, acc, acc_size);
+  }
+
+  ParReduce ctx = {
+    .elements = elements,
+    .count = count,
+    .chunks = chunks,
+    .element_size = element_size,
+    .accs = accs,
+    .acc_size = acc_size,
+    .reduce = reduce,
+    .data = data,
+  };
+
+  parallel_for(pool, 0, chunks, 1, par_reduce_chunks, &ctx);
+
+  for (index_s c = 0; c < chunks; ++c) {
+    combine(data, acc, accs + c * acc_size);
+  }
+
+  free(accs);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Scan
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  const byte* in;
+  byte* out;
+  index_s count, chunks, element_size;
+  byte* sums;                 // per chunk total, then per chunk offset
+  byte* scratch;              // per chunk, holds an input overwritten in place
+  const void* identity;
+  ParScanFn op;
+  bool inclusive;
+} ParScan;
+
+static void par_scan_totals(void* data, index_s begin, index_s end) {
+  ParScan* ctx = data;
+  const index_s size = ctx->element_size;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = par_chunk_begin(ctx->count, ctx->chunks, c);
+    index_s last = par_chunk_begin(ctx->count, ctx->chunks, c + 1);
+    byte* acc = ctx->sums + c * size;
+
+    memcpy(acc, ctx->identity, size);
+    for (index_s i = first; i < last; ++i) {
+      ctx->op(acc, ctx->in + i * size);
+    }
+  }
+}
+
+static void par_scan_chunk(
+  ParScan* ctx, byte* acc, byte* scratch, index_s first, index_s last
+) {
+  const index_s size = ctx->element_size;
+
+  if (ctx->inclusive) {
+    for (index_s i = first; i < last; ++i) {
+      ctx->op(acc, ctx->in + i * size);
+      elem_copy(ctx->out + i * size, acc, size);
+    }
+    return;
+  }
+
+  for (index_s i = first; i < last; ++i) {
+    elem_copy(scratch, ctx->in + i * size, size);
+    elem_copy(ctx->out + i * size, acc, size);
+    ctx->op(acc, scratch);
+  }
+}
+
+static void par_scan_apply(void* data, index_s begin, index_s end) {
+  ParScan* ctx = data;
+  const index_s size = ctx->element_size;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = par_chunk_begin(ctx->count, ctx->chunks, c);
+    index_s last = par_chunk_begin(ctx->count, ctx->chunks, c + 1);
+    par_scan_chunk(ctx, ctx->sums + c * size, ctx->scratch + c * size,
+      first, last
+    );
+  }
+}
+
+// \brief Prefix scan of in to out, which may be the same buffer. Inclusive
+//    scans write in[0] op ... op in[i] to out[i], exclusive scans stop at
+//    in[i - 1] and write identity to out[0].
+void par_scan_s(JobPool pool, const void* in, void* out, index_s count,
+  index_s element_size, const void* identity, ParScanFn op, bool inclusive
+) {
+  assert(pool && identity && op);
+  if (count <= 0) return;
+
+  index_s chunks = par_chunk_count(pool, count);
+
+  // sums and scratch share one allocation
+  byte* buffer = malloc(chunks * element_size * 2);
+  assert(buffer);
+
+  ParScan ctx = {
+    .in = in,
+    .out = out,
+    .count = count,
+    .chunks = chunks,
+    .element_size = element_size,
+    .sums = buffer,
+    .scratch = buffer + chunks * element_size,
+    .identity = identity,
+    .op = op,
+    .inclusive = inclusive,
+  };
+
+  if (chunks == 1) {
+    memcpy(ctx.sums, identity, element_size);
+    par_scan_chunk(&ctx, ctx.sums, ctx.scratch, 0, count);
+    free(buffer);
+    return;
+  }
+
+  parallel_for(pool, 0, chunks, 1, par_scan_totals, &ctx);
+
+  // turn the chunk totals into the running value at the start of each chunk
+  byte* running = ctx.scratch;
+  memcpy(running, identity, element_size);
+  for (index_s c = 0; c < chunks; ++c) {
+    byte* sum = ctx.sums + c * element_size;
+    op(running, sum);
+    memcpy(sum, running, element_size);
+  }
+  memmove(ctx.sums + element_size, ctx.sums, (chunks - 1) * element_size);
+  memcpy(ctx.sums, identity, element_size);
+
+  parallel_for(pool, 0, chunks, 1, par_scan_apply, &ctx);
+
+  free(buffer);
+}
+
+// \brief Array version of par_scan_s, out is resized to match in.
+void _par_scan_(JobPool pool, const Array in, Array out,
+  const void* identity, ParScanFn op, bool inclusive
+) {
+  assert(in && out && in->element_size == out->element_size);
+
+  if (in != out) {
+    array_clear(out);
+    if (in->size == 0) return;
+    array_emplace_back_range(out, in->size);
+  }
+
+  par_scan_s(pool, in->arr, out->arr, in->size, in->element_size,
+    identity, op, inclusive
+  );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Filter
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  const byte* in;
+  byte* out;
+  index_s count, chunks, element_size;
+  byte* keep;                 // predicate result per element
+  index_s* offsets;           // kept per chunk, then output start per chunk
+  ParPredicateFn predicate;
+  void* data;
+} ParFilter;
+
+static void par_filter_test(void* data, index_s begin, index_s end) {
+  ParFilter* ctx = data;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = par_chunk_begin(ctx->count, ctx->chunks, c);
+    index_s last = par_chunk_begin(ctx->count, ctx->chunks, c + 1);
+    index_s kept = 0;
+
+    for (index_s i = first; i < last; ++i) {
+      bool keep = ctx->predicate(ctx->data, ctx->in + i * ctx->element_size);
+      ctx->keep[i] = keep;
+      kept += keep;
+    }
+
+    ctx->offsets[c] = kept;
+  }
+}
+
+static void par_filter_copy(void* data, index_s begin, index_s end) {
+  ParFilter* ctx = data;
+  const index_s size = ctx->element_size;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = par_chunk_begin(ctx->count, ctx->chunks, c);
+    index_s last = par_chunk_begin(ctx->count, ctx->chunks, c + 1);
+    byte* out = ctx->out + ctx->offsets[c] * size;
+
+    for (index_s i = first; i < last; ++i) {
+      if (!ctx->keep[i]) continue;
+      elem_copy(out, ctx->in + i * size, size);
+      out += size;
+    }
+  }
+}
+
+// \brief Stable compaction: replaces the contents of out with the elements of
+//    in that pass the predicate, in their original order. The predicate is
+//    called exactly once per element. Out must be a different array from in.
+//
+// \returns The number of elements kept.
+index_s _par_filter_(JobPool pool, const Array in, Array out,
+  ParPredicateFn predicate, void* data
+) {
+  assert(pool && in && out && predicate);
+  assert(in != out && in->element_size == out->element_size);
+
+  array_clear(out);
+  if (in->size == 0) return 0;
+
+  index_s count = in->size;
+  index_s chunks = par_chunk_count(pool, count);
+
+  byte* keep = malloc(count);
+  index_s* offsets = malloc(chunks * sizeof(index_s));
+  assert(keep && offsets);
+
+  ParFilter ctx = {
+    .in = in->arr,
+    .count = count,
+    .chunks = chunks,
+    .element_size = in->element_size,
+    .keep = keep,
+    .offsets = offsets,
+    .predicate = predicate,
+    .data = data,
+  };
+
+  parallel_for(pool, 0, chunks, 1, par_filter_test, &ctx);
+
+  index_s total = 0;
+  for (index_s c = 0; c < chunks; ++c) {
+    index_s kept = ctx.offsets[c];
+    ctx.offsets[c] = total;
+    total += kept;
+  }
+
+  if (total > 0) {
+    ctx.out = array_emplace_back_range(out, total);
+    parallel_for(pool, 0, chunks, 1, par_filter_copy, &ctx);
+  }
+
+  free(offsets);
+  free(keep);
+  return total;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Sort
+////////////////////////////////////////////////////////////////////////////////
+
+// Runs this short are insertion sorted before the first merge pass
+#define PAR_SORT_RUN 16
+
+typedef struct {
+  byte* src;
+  byte* dst;
+  index_s count, size;
+  index_s chunk;              // length of the runs sorted serially
+  index_s width;              // length of the runs being merged this round
+  ParLessFn less;
+} ParSort;
+
+static void sort_insertion(
+  byte* data, byte* scratch, index_s count, index_s size, ParLessFn less
+) {
+  for (index_s i = 1; i < count; ++i) {
+    byte* el = data + i * size;
+    if (!less(el, el - size)) continue;
+
+    elem_copy(scratch, el, size);
+    index_s j = i - 1;
+    while (j > 0 && less(scratch, data + (j - 1) * size)) --j;
+
+    memmove(data + (j + 1) * size, data + j * size, (i - j) * size);
+    elem_copy(data + j * size, scratch, size);
+  }
+}
+
+// Stable: takes from a unless b is strictly less
+static void sort_merge(const byte* a, index_s na, const byte* b, index_s nb,
+  byte* out, index_s size, ParLessFn less
+) {
+  const byte* a_end = a + na * size;
+  const byte* b_end = b + nb * size;
+
+  while (a < a_end && b < b_end) {
+    if (less(b, a)) {
+      elem_copy(out, b, size);
+      b += size;
+    } else {
+      elem_copy(out, a, size);
+      a += size;
+    }
+    out += size;
+  }
+
+  memcpy(out, a, a_end - a);
+  out += a_end - a;
+  memcpy(out, b, b_end - b);
+}
+
+// Serial bottom-up merge sort of data, using tmp (same length) as the other
+//    buffer. The result always ends up back in data.
+static void sort_serial(
+  byte* data, byte* tmp, index_s count, index_s size, ParLessFn less
+) {
+  for (index_s i = 0; i < count; i += PAR_SORT_RUN) {
+    index_s n = MIN(PAR_SORT_RUN, count - i);
+    sort_insertion(data + i * size, tmp, n, size, less);
+  }
+
+  byte* src = data;
+  byte* dst = tmp;
+
+  for (index_s width = PAR_SORT_RUN; width < count; width *= 2) {
+    for (index_s i = 0; i < count; i += 2 * width) {
+      index_s mid = MIN(i + width, count);
+      index_s end = MIN(i + 2 * width, count);
+      sort_merge(src + i * size, mid - i, src + mid * size, end - mid,
+        dst + i * size, size, less
+      );
+    }
+
+    byte* swap = src;
+    src = dst;
+    dst = swap;
+  }
+
+  if (src != data) memcpy(data, src, count * size);
+}
+
+static void par_sort_chunks(void* data, index_s begin, index_s end) {
+  ParSort* ctx = data;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = c * ctx->chunk;
+    index_s n = MIN(ctx->chunk, ctx->count - first);
+    sort_serial(ctx->src + first * ctx->size, ctx->dst + first * ctx->size,
+      n, ctx->size, ctx->less
+    );
+  }
+}
+
+// Merge path co-rank: how many of the first k merged elements come from a, so
+//    that each piece of the output can be merged independently
+static index_s sort_corank(index_s k, const byte* a, index_s na,
+  const byte* b, index_s nb, index_s size, ParLessFn less
+) {
+  index_s lo = MAX(0, k - nb);
+  index_s hi = MIN(k, na);
+
+  while (lo < hi) {
+    index_s i = lo + (hi - lo) / 2;
+    index_s j = k - i;
+
+    // too few from a if a[i] should come before b[j - 1]
+    if (j > 0 && !less(b + (j - 1) * size, a + i * size)) lo = i + 1;
+    else hi = i;
+  }
+
+  return lo;
+}
+
+static void par_sort_merge_range(void* data, index_s begin, index_s end) {
+  ParSort* ctx = data;
+  const index_s size = ctx->size;
+  const index_s w = ctx->width;
+
+  // a range can span the boundary between two merged pairs
+  while (begin < end) {
+    index_s pair = begin - begin % (2 * w);
+    index_s mid = MIN(pair + w, ctx->count);
+    index_s pair_end = MIN(pair + 2 * w, ctx->count);
+    index_s stop = MIN(end, pair_end);
+
+    const byte* a = ctx->src + pair * size;
+    const byte* b = ctx->src + mid * size;
+    index_s na = mid - pair;
+    index_s nb = pair_end - mid;
+
+    index_s i0 = sort_corank(begin - pair, a, na, b, nb, size, ctx->less);
+    index_s i1 = sort_corank(stop - pair, a, na, b, nb, size, ctx->less);
+    index_s j0 = begin - pair - i0;
+    index_s j1 = stop - pair - i1;
+
+    sort_merge(a + i0 * size, i1 - i0, b + j0 * size, j1 - j0,
+      ctx->dst + begin * size, size, ctx->less
+    );
+
+    begin = stop;
+  }
+}
+
+static void par_sort_copy_back(void* data, index_s begin, index_s end) {
+  ParSort* ctx = data;
+  memcpy(ctx->dst + begin * ctx->size, ctx->src + begin * ctx->size,
+    (end - begin) * ctx->size
+  );
+}
+
+// \brief Stable parallel merge sort. Each chunk is sorted serially, then pairs
+//    of runs are merged in rounds, with every merge split across the pool by
+//    co-ranking so the last rounds still use all the workers. Needs a
+//    temporary buffer the size of the input.
+void par_sort_s(JobPool pool, void* elements, index_s count,
+  index_s element_size, ParLessFn less
+) {
+  assert(pool && less);
+  if (count <= 1) return;
+
+  byte* tmp = malloc(count * element_size);
+  assert(tmp);
+
+  index_s chunks = par_chunk_count(pool, count);
+
+  if (chunks == 1) {
+    sort_serial(elements, tmp, count, element_size, less);
+    free(tmp);
+    return;
+  }
+
+  ParSort ctx = {
+    .src = elements,
+    .dst = tmp,
+    .count = count,
+    .size = element_size,
+    .chunk = (count + chunks - 1) / chunks,
+    .less = less,
+  };
+
+  parallel_for(pool, 0, chunks, 1, par_sort_chunks, &ctx);
+
+  index_s grain = MAX(PAR_MIN_CHUNK, count / chunks);
+
+  for (ctx.width = ctx.chunk; ctx.width < count; ctx.width *= 2) {
+    parallel_for(pool, 0, count, grain, par_sort_merge_range, &ctx);
+    byte* swap = ctx.src;
+    ctx.src = ctx.dst;
+    ctx.dst = swap;
+  }
+
+  if (ctx.src != elements) {
+    ctx.dst = elements;
+    parallel_for(pool, 0, count, grain, par_sort_copy_back, &ctx);
+  }
+
+  free(tmp);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Text
+////////////////////////////////////////////////////////////////////////////////
+
+typedef struct {
+  StringRange str;
+  StringRange del;
+  index_s chunks;
+  index_s* bounds;            // chunks + 1 offsets into str
+  Array* parts;               // output per chunk
+  index_s* invalid;           // fields that failed to parse, per chunk
+  bool split;
+  ParParseType type;
+
+  // stitching the parts together
+  byte* out;
+  index_s* offsets;
+} ParText;
+
+static index_s text_find(StringRange str, StringRange del, index_s from) {
+  if (del.size == 1) {
+    const char* p = memchr(str.begin + from, del.begin[0], str.size - from);
+    return p ? p - str.begin : str.size;
+  }
+
+  while (from + del.size <= str.size) {
+    const char* p = memchr(
+      str.begin + from, del.begin[0], str.size - from - del.size + 1
+    );
+    if (!p) break;
+    if (memcmp(p, del.begin, del.size) == 0) return p - str.begin;
+    from = p - str.begin + 1;
+  }
+
+  return str.size;
+}
+
+// True if a proper prefix of del is also a suffix, like "aa" or "abab". A
+//    search starting mid-text could then land inside a delimiter the serial
+//    split would have matched differently.
+static bool text_self_overlaps(StringRange del) {
+  for (index_s n = 1; n < del.size; ++n) {
+    if (memcmp(del.begin, del.begin + del.size - n, n) == 0) return true;
+  }
+  return false;
+}
+
+static void text_emit(ParText* ctx, index_s c, StringRange field) {
+  Array part = ctx->parts[c];
+
+  if (ctx->split) {
+    if (field.size == 0) field = str_empty->range; // as str_split does
+    array_write_back(part, &field);
+    return;
+  }
+
+  field = istr_trim(field);
+  if (field.size == 0) return;
+
+  bool ok = false;
+  switch (ctx->type) {
+    case PAR_PARSE_INT:
+      ok = istr_to_int(field, array_emplace_back(part));
+      break;
+    case PAR_PARSE_LONG:
+      ok = istr_to_long(field, array_emplace_back(part));
+      break;
+    case PAR_PARSE_FLOAT:
+      ok = istr_to_float(field, array_emplace_back(part));
+      break;
+    case PAR_PARSE_DOUBLE:
+      ok = istr_to_double(field, array_emplace_back(part));
+      break;
+  }
+
+  if (!ok) {
+    array_pop_back(part);
+    ++ctx->invalid[c];
+  }
+}
+
+// Every chunk but the final one ends just past a delimiter, so unlike
+//    str_split no empty field is emitted after its last delimiter
+static void par_text_chunks(void* data, index_s begin, index_s end) {
+  ParText* ctx = data;
+
+  for (index_s c = begin; c < end; ++c) {
+    index_s first = ctx->bounds[c];
+    index_s last = ctx->bounds[c + 1];
+
+    // an earlier chunk already reached the end of the text
+    if (first == ctx->str.size && first > 0) continue;
+
+    bool final = last == ctx->str.size;
+    StringRange text = str_range_s(ctx->str.begin + first, last - first);
+    index_s i = 0;
+
+    loop {
+      index_s next = text_find(text, ctx->del, i);
+      until (!final && i == text.size);
+      text_emit(ctx, c, str_range_s(text.begin + i, next - i));
+      until (next == text.size);
+      i = next + ctx->del.size;
+    }
+  }
+}
+
+static void par_text_stitch(void* data, index_s begin, index_s end) {
+  ParText* ctx = data;
+
+  for (index_s c = begin; c < end; ++c) {
+    Array part = ctx->parts[c];
+    if (part->size == 0) continue;
+    memcpy(ctx->out + ctx->offsets[c] * part->element_size, part->arr,
+      part->size_bytes
+    );
+  }
+}
+
+// Splits or parses str into out, returns the number of invalid fields
+static index_s par_text_run(JobPool pool, StringRange str, StringRange del,
+  Array out, bool split, ParParseType type
+) {
+  index_s chunks = par_chunk_count_min(pool, str.size, PAR_MIN_TEXT_CHUNK);
+  if (text_self_overlaps(del)) chunks = 1;
+
+  ParText ctx = {
+    .str = str,
+    .del = del,
+    .chunks = chunks,
+    .bounds = malloc((chunks + 1) * sizeof(index_s)),
+    .parts = malloc(chunks * sizeof(Array)),
+    .invalid = calloc(chunks, sizeof(index_s)),
+    .offsets = malloc(chunks * sizeof(index_s)),
+    .split = split,
+    .type = type,
+  };
+  assert(ctx.bounds && ctx.parts && ctx.invalid && ctx.offsets);
+
+  // cut just past the first delimiter after each even split point
+  ctx.bounds[0] = 0;
+  for (index_s c = 1; c < chunks; ++c) {
+    index_s pos = MAX(str.size * c / chunks, ctx.bounds[c - 1]);
+    index_s match = text_find(str, del, pos);
+    ctx.bounds[c] = match == str.size ? str.size : match + del.size;
+  }
+  ctx.bounds[chunks] = str.size;
+
+  for (index_s c = 0; c < chunks; ++c) {
+    ctx.parts[c] = _array_new_(out->element_size);
+  }
+
+  if (chunks == 1) par_text_chunks(&ctx, 0, 1);
+  else parallel_for(pool, 0, chunks, 1, par_text_chunks, &ctx);
+
+  index_s total = 0;
+  index_s invalid = 0;
+  for (index_s c = 0; c < chunks; ++c) {
+    ctx.offsets[c] = total;
+    total += ctx.parts[c]->size;
+    invalid += ctx.invalid[c];
+  }
+
+  array_clear(out);
+  if (total > 0) {
+    ctx.out = array_emplace_back_range(out, total);
+    if (chunks == 1) par_text_stitch(&ctx, 0, 1);
+    else parallel_for(pool, 0, chunks, 1, par_text_stitch, &ctx);
+  }
+
+  for (index_s c = 0; c < chunks; ++c) {
+    array_delete(&ctx.parts[c]);
+  }
+
+  free(ctx.offsets);
+  free(ctx.invalid);
+  free(ctx.parts);
+  free(ctx.bounds);
+  return invalid;
+}
+
+Array_StrR _par_str_split_(JobPool pool, StringRange str, StringRange del) {
+  assert(pool);
+
+  // the serial split has its own rules for these
+  if (str.size == 0 || del.size == 0) return istr_split(str, del);
+
+  Array_StrR ret = arr_str_new();
+  par_text_run(pool, str, del, (Array)ret, true, PAR_PARSE_INT);
+  return ret;
+}
+
+bool _par_str_parse_(JobPool pool, StringRange str, StringRange del,
+  Array out, ParParseType type
+) {
+  assert(pool && out && del.size > 0);
+
+  static const index_s sizes[] = {
+    [PAR_PARSE_INT] = sizeof(int),
+    [PAR_PARSE_LONG] = sizeof(index_s),
+    [PAR_PARSE_FLOAT] = sizeof(float),
+    [PAR_PARSE_DOUBLE] = sizeof(double),
+  };
+  assert(out->element_size == sizes[type]);
+  PARAM_UNUSED(sizes);
+
+  if (str.size == 0) {
+    array_clear(out);
+    return true;
+  }
+
+  return par_text_run(pool, str, del, out, false, type) == 0;
+}
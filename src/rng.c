@@ -0,0 +1,267 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "rng.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define RNG_SSE2
+# include <emmintrin.h>
+#endif
+
+#define RNG_FLOAT_UNIT (1.0f / 16777216.0f)
+
+// Expands a 64-bit seed into well mixed state words
+static unsigned long long rng_splitmix(unsigned long long* x) {
+  unsigned long long z = (*x += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+static inline uint rng_rotl(uint x, int k) {
+  return (x << k) | (x >> (32 - k));
+}
+
+// Steps every lane once, writing one output per lane
+static void rng_step(Rng* rng, uint* out) {
+  uint (*s)[RNG_LANES] = rng->state;
+
+  for (int lane = 0; lane < RNG_LANES; ++lane) {
+    uint t = s[1][lane] << 9;
+    out[lane] = rng_rotl(s[1][lane] * 5, 7) * 9;
+    s[2][lane] ^= s[0][lane];
+    s[3][lane] ^= s[1][lane];
+    s[1][lane] ^= s[2][lane];
+    s[0][lane] ^= s[3][lane];
+    s[2][lane] ^= t;
+    s[3][lane] = rng_rotl(s[3][lane], 11);
+  }
+}
+
+#ifdef RNG_SSE2
+
+static inline __m128i rng_rotl4(__m128i x, int k) {
+  return _mm_or_si128(_mm_slli_epi32(x, k), _mm_srli_epi32(x, 32 - k));
+}
+
+// SSE2 has no 32-bit multiply, so the * 5 and * 9 are shifts and adds
+static inline __m128i rng_step4(__m128i s[4]) {
+  __m128i t = _mm_slli_epi32(s[1], 9);
+  __m128i r = _mm_add_epi32(_mm_slli_epi32(s[1], 2), s[1]);
+  r = rng_rotl4(r, 7);
+  r = _mm_add_epi32(_mm_slli_epi32(r, 3), r);
+  s[2] = _mm_xor_si128(s[2], s[0]);
+  s[3] = _mm_xor_si128(s[3], s[1]);
+  s[1] = _mm_xor_si128(s[1], s[2]);
+  s[0] = _mm_xor_si128(s[0], s[3]);
+  s[2] = _mm_xor_si128(s[2], t);
+  s[3] = rng_rotl4(s[3], 11);
+  return r;
+}
+
+static inline void rng_load4(const Rng* rng, __m128i s[4]) {
+  for (int w = 0; w < 4; ++w) {
+    s[w] = _mm_loadu_si128((const __m128i*)rng->state[w]);
+  }
+}
+
+static inline void rng_store4(Rng* rng, const __m128i s[4]) {
+  for (int w = 0; w < 4; ++w) {
+    _mm_storeu_si128((__m128i*)rng->state[w], s[w]);
+  }
+}
+
+#endif
+
+// \brief Creates a generator with each lane seeded from the given value.
+Rng rng_new(unsigned long long seed) {
+  Rng rng = { .used = RNG_LANES };
+
+  for (int lane = 0; lane < RNG_LANES; ++lane) {
+    for (int w = 0; w < 4; w += 2) {
+      unsigned long long z = rng_splitmix(&seed);
+      rng.state[w][lane] = (uint)z;
+      rng.state[w + 1][lane] = (uint)(z >> 32);
+    }
+  }
+
+  return rng;
+}
+
+// \brief Advances every lane by 2^64 steps, equivalent to that many calls to
+//    the generator. Any buffered outputs are discarded.
+void rng_jump(Rng* rng) {
+  static const uint jump[4] = {
+    0x8764000b, 0xf542d2d3, 0x6fa035c3, 0x77f2db5b
+  };
+
+  assert(rng);
+
+  uint acc[4][RNG_LANES] = { 0 };
+  uint discard[RNG_LANES];
+
+  for (int j = 0; j < 4; ++j) {
+    for (int b = 0; b < 32; ++b) {
+      if (jump[j] & (1u << b)) {
+        for (int w = 0; w < 4; ++w) {
+          for (int lane = 0; lane < RNG_LANES; ++lane) {
+            acc[w][lane] ^= rng->state[w][lane];
+          }
+        }
+      }
+      rng_step(rng, discard);
+    }
+  }
+
+  for (int w = 0; w < 4; ++w) {
+    for (int lane = 0; lane < RNG_LANES; ++lane) {
+      rng->state[w][lane] = acc[w][lane];
+    }
+  }
+
+  rng->used = RNG_LANES;
+}
+
+uint rng_uint(Rng* rng) {
+  assert(rng);
+
+  if (rng->used == RNG_LANES) {
+    rng_step(rng, rng->buffer);
+    rng->used = 0;
+  }
+
+  return rng->buffer[rng->used++];
+}
+
+float rng_float(Rng* rng) {
+  return (float)(rng_uint(rng) >> 8) * RNG_FLOAT_UNIT;
+}
+
+float rng_range(Rng* rng, float lo, float hi) {
+  return lo + rng_float(rng) * (hi - lo);
+}
+
+// \brief Fills the buffer with uniform 32-bit values.
+void rng_fill_uint(Rng* rng, uint* out, index_s count) {
+  assert(rng);
+  assert(out || !count);
+
+  index_s i = 0;
+
+  // drain buffered values first so fills continue the same sequence
+  while (i < count && rng->used < RNG_LANES) {
+    out[i++] = rng->buffer[rng->used++];
+  }
+
+#ifdef RNG_SSE2
+  if (i + RNG_LANES <= count) {
+    __m128i s[4];
+    rng_load4(rng, s);
+    for (; i + RNG_LANES <= count; i += RNG_LANES) {
+      _mm_storeu_si128((__m128i*)(out + i), rng_step4(s));
+    }
+    rng_store4(rng, s);
+  }
+#else
+  for (; i + RNG_LANES <= count; i += RNG_LANES) {
+    rng_step(rng, out + i);
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = rng_uint(rng);
+}
+
+// Fills with floats in [0, 1)
+static void rng_fill_unit(Rng* rng, float* out, index_s count) {
+  index_s i = 0;
+
+  while (i < count && rng->used < RNG_LANES) {
+    out[i++] = (float)(rng->buffer[rng->used++] >> 8) * RNG_FLOAT_UNIT;
+  }
+
+#ifdef RNG_SSE2
+  if (i + RNG_LANES <= count) {
+    const __m128 unit = _mm_set1_ps(RNG_FLOAT_UNIT);
+    __m128i s[4];
+    rng_load4(rng, s);
+    for (; i + RNG_LANES <= count; i += RNG_LANES) {
+      __m128i bits = _mm_srli_epi32(rng_step4(s), 8);
+      _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(bits), unit));
+    }
+    rng_store4(rng, s);
+  }
+#else
+  uint bits[RNG_LANES];
+  for (; i + RNG_LANES <= count; i += RNG_LANES) {
+    rng_step(rng, bits);
+    for (int lane = 0; lane < RNG_LANES; ++lane) {
+      out[i + lane] = (float)(bits[lane] >> 8) * RNG_FLOAT_UNIT;
+    }
+  }
+#endif
+
+  for (; i < count; ++i) out[i] = rng_float(rng);
+}
+
+// \brief Fills the buffer with uniform floats in [lo, hi).
+void rng_fill_f(Rng* rng, float* out, index_s count, float lo, float hi) {
+  assert(rng);
+  assert(out || !count);
+
+  rng_fill_unit(rng, out, count);
+
+  float span = hi - lo;
+  for (index_s i = 0; i < count; ++i) out[i] = lo + out[i] * span;
+}
+
+// \brief Fills the buffer with points uniformly distributed in the box between
+//    lo and hi. Components are drawn in memory order (x then y per point).
+void rng_fill_v2(Rng* rng, vec2* out, index_s count, vec2 lo, vec2 hi) {
+  assert(rng);
+  assert(out || !count);
+
+  rng_fill_unit(rng, (float*)out, count * 2);
+
+  vec2 span = v2sub(hi, lo);
+  for (index_s i = 0; i < count; ++i) {
+    out[i].x = lo.x + out[i].x * span.x;
+    out[i].y = lo.y + out[i].y * span.y;
+  }
+}
+
+// \brief Fills the buffer with points uniformly distributed in the box between
+//    lo and hi. Components are drawn in memory order (x, y, z per point).
+void rng_fill_v3(Rng* rng, vec3* out, index_s count, vec3 lo, vec3 hi) {
+  assert(rng);
+  assert(out || !count);
+
+  rng_fill_unit(rng, (float*)out, count * 3);
+
+  vec3 span = v3sub(hi, lo);
+  for (index_s i = 0; i < count; ++i) {
+    out[i].x = lo.x + out[i].x * span.x;
+    out[i].y = lo.y + out[i].y * span.y;
+    out[i].z = lo.z + out[i].z * span.z;
+  }
+}
@@ -0,0 +1,466 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "skin.h"
+
+#include <math.h>
+
+#if defined(__AVX2__)
+# define SKIN_AVX2
+# include <immintrin.h>
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+// Transform helpers
+////////////////////////////////////////////////////////////////////////////////
+
+mat34 m34from_m4(mat4 m) {
+  return (mat34) {.f={
+    m.m[0][0], m.m[1][0], m.m[2][0], m.m[3][0],
+    m.m[0][1], m.m[1][1], m.m[2][1], m.m[3][1],
+    m.m[0][2], m.m[1][2], m.m[2][2], m.m[3][2],
+  }};
+}
+
+mat4 m4from_m34(mat34 m) {
+  return (mat4) {.f={
+    m.m[0][0], m.m[1][0], m.m[2][0], 0,
+    m.m[0][1], m.m[1][1], m.m[2][1], 0,
+    m.m[0][2], m.m[1][2], m.m[2][2], 0,
+    m.m[0][3], m.m[1][3], m.m[2][3], 1,
+  }};
+}
+
+vec3 m34transform(mat34 m, vec3 p) {
+  return v3f(
+    m.m[0][0] * p.x + m.m[0][1] * p.y + m.m[0][2] * p.z + m.m[0][3],
+    m.m[1][0] * p.x + m.m[1][1] * p.y + m.m[1][2] * p.z + m.m[1][3],
+    m.m[2][0] * p.x + m.m[2][1] * p.y + m.m[2][2] * p.z + m.m[2][3]
+  );
+}
+
+// The dual part is half the translation (as a pure quaternion) times the
+//    rotation, so the translation is recovered as 2 * dual * conj(real).
+dquat dq_from_rt(quat r, vec3 t) {
+  return (dquat) {
+    .real = r,
+    .dual = v4f(
+      0.5f * ( t.x * r.w + t.y * r.k - t.z * r.j),
+      0.5f * (-t.x * r.k + t.y * r.w + t.z * r.i),
+      0.5f * ( t.x * r.j - t.y * r.i + t.z * r.w),
+      0.5f * (-t.x * r.i - t.y * r.j - t.z * r.k)
+    ),
+  };
+}
+
+// Expects the upper 3x3 to be a pure rotation, any scale is lost.
+//
+// Rotation matrix to quaternion by Shepperd's method, picking the largest
+//    diagonal term to divide by for stability.
+dquat dq_from_m34(mat34 m) {
+  float trace = m.m[0][0] + m.m[1][1] + m.m[2][2];
+  quat r;
+
+  if (trace > 0) {
+    float s = sqrtf(trace + 1) * 2;
+    r = v4f(
+      (m.m[2][1] - m.m[1][2]) / s,
+      (m.m[0][2] - m.m[2][0]) / s,
+      (m.m[1][0] - m.m[0][1]) / s,
+      0.25f * s
+    );
+  } else if (m.m[0][0] > m.m[1][1] && m.m[0][0] > m.m[2][2]) {
+    float s = sqrtf(1 + m.m[0][0] - m.m[1][1] - m.m[2][2]) * 2;
+    r = v4f(
+      0.25f * s,
+      (m.m[0][1] + m.m[1][0]) / s,
+      (m.m[0][2] + m.m[2][0]) / s,
+      (m.m[2][1] - m.m[1][2]) / s
+    );
+  } else if (m.m[1][1] > m.m[2][2]) {
+    float s = sqrtf(1 + m.m[1][1] - m.m[0][0] - m.m[2][2]) * 2;
+    r = v4f(
+      (m.m[0][1] + m.m[1][0]) / s,
+      0.25f * s,
+      (m.m[1][2] + m.m[2][1]) / s,
+      (m.m[0][2] - m.m[2][0]) / s
+    );
+  } else {
+    float s = sqrtf(1 + m.m[2][2] - m.m[0][0] - m.m[1][1]) * 2;
+    r = v4f(
+      (m.m[0][2] + m.m[2][0]) / s,
+      (m.m[1][2] + m.m[2][1]) / s,
+      0.25f * s,
+      (m.m[1][0] - m.m[0][1]) / s
+    );
+  }
+
+  return dq_from_rt(r, v3f(m.m[0][3], m.m[1][3], m.m[2][3]));
+}
+
+// p' = p + 2 rv x (rv x p + rw p) + 2 (rw dv - dw rv + rv x dv)
+vec3 dq_transform(dquat dq, vec3 p) {
+  vec3 rv = dq.real.ijk, dv = dq.dual.ijk;
+  float rw = dq.real.w, dw = dq.dual.w;
+  vec3 t = v3add(v3cross(rv, p), v3scale(p, rw));
+  vec3 r = v3add(p, v3scale(v3cross(rv, t), 2));
+  vec3 d = v3add(v3sub(v3scale(dv, rw), v3scale(rv, dw)), v3cross(rv, dv));
+  return v3add(r, v3scale(d, 2));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Linear blend skinning
+////////////////////////////////////////////////////////////////////////////////
+
+static void skin_lbs_scalar(
+  const SkinMesh* mesh, const mat34* palette, index_s begin, index_s end
+) {
+  bool normals = mesh->normals.x != NULL;
+
+  for (index_s i = begin; i < end; ++i) {
+    float m[12] = { 0 };
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      float w = mesh->weights[k][i];
+      if (w == 0) continue;
+      const float* bone = palette[mesh->bones[k][i]].f;
+      for (int c = 0; c < 12; ++c) m[c] += w * bone[c];
+    }
+
+    float x = mesh->positions.x[i];
+    float y = mesh->positions.y[i];
+    float z = mesh->positions.z[i];
+    mesh->out_positions.x[i] = m[0] * x + m[1] * y + m[2] * z + m[3];
+    mesh->out_positions.y[i] = m[4] * x + m[5] * y + m[6] * z + m[7];
+    mesh->out_positions.z[i] = m[8] * x + m[9] * y + m[10] * z + m[11];
+
+    if (!normals) continue;
+
+    x = mesh->normals.x[i];
+    y = mesh->normals.y[i];
+    z = mesh->normals.z[i];
+    float nx = m[0] * x + m[1] * y + m[2] * z;
+    float ny = m[4] * x + m[5] * y + m[6] * z;
+    float nz = m[8] * x + m[9] * y + m[10] * z;
+    float len = sqrtf(nx * nx + ny * ny + nz * nz);
+    float inv = len > 0 ? 1 / len : 0;
+    mesh->out_normals.x[i] = nx * inv;
+    mesh->out_normals.y[i] = ny * inv;
+    mesh->out_normals.z[i] = nz * inv;
+  }
+}
+
+#ifdef SKIN_AVX2
+
+static inline __m256i skin_load_bones(const u16* bones, int stride) {
+  __m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)bones));
+  return _mm256_mullo_epi32(index, _mm256_set1_epi32(stride));
+}
+
+// Scales a vector to unit length, leaving zero vectors as zero
+static inline void skin_normalize8(__m256* x, __m256* y, __m256* z) {
+  __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(
+    _mm256_mul_ps(*x, *x), _mm256_mul_ps(*y, *y)), _mm256_mul_ps(*z, *z)
+  ));
+  __m256 inv = _mm256_and_ps(
+    _mm256_div_ps(_mm256_set1_ps(1), len),
+    _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ)
+  );
+  *x = _mm256_mul_ps(*x, inv);
+  *y = _mm256_mul_ps(*y, inv);
+  *z = _mm256_mul_ps(*z, inv);
+}
+
+// Blends the palette rows for eight vertices at a time, then transforms
+static index_s skin_lbs_avx2(
+  const SkinMesh* mesh, const mat34* palette, index_s begin, index_s end
+) {
+  bool normals = mesh->normals.x != NULL;
+  const float* base = palette->f;
+  index_s i = begin;
+
+  for (; i + 8 <= end; i += 8) {
+    __m256 m[12];
+    for (int c = 0; c < 12; ++c) m[c] = _mm256_setzero_ps();
+
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      __m256 w = _mm256_loadu_ps(mesh->weights[k] + i);
+      __m256 used = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+      if (_mm256_testz_ps(used, used)) continue;
+
+      __m256i offset = skin_load_bones(mesh->bones[k] + i, 12);
+      for (int c = 0; c < 12; ++c) {
+        __m256 bone = _mm256_mask_i32gather_ps(
+          _mm256_setzero_ps(), base + c, offset, used, 4
+        );
+        m[c] = _mm256_add_ps(m[c], _mm256_mul_ps(w, bone));
+      }
+    }
+
+    __m256 x = _mm256_loadu_ps(mesh->positions.x + i);
+    __m256 y = _mm256_loadu_ps(mesh->positions.y + i);
+    __m256 z = _mm256_loadu_ps(mesh->positions.z + i);
+
+    for (int r = 0; r < 3; ++r) {
+      __m256 out = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(m[r * 4 + 0], x), _mm256_mul_ps(m[r * 4 + 1], y)),
+        _mm256_mul_ps(m[r * 4 + 2], z)), m[r * 4 + 3]
+      );
+      float* dst = r == 0 ? mesh->out_positions.x
+                 : r == 1 ? mesh->out_positions.y : mesh->out_positions.z;
+      _mm256_storeu_ps(dst + i, out);
+    }
+
+    if (!normals) continue;
+
+    x = _mm256_loadu_ps(mesh->normals.x + i);
+    y = _mm256_loadu_ps(mesh->normals.y + i);
+    z = _mm256_loadu_ps(mesh->normals.z + i);
+
+    __m256 n[3];
+    for (int r = 0; r < 3; ++r) {
+      n[r] = _mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(m[r * 4 + 0], x), _mm256_mul_ps(m[r * 4 + 1], y)),
+        _mm256_mul_ps(m[r * 4 + 2], z)
+      );
+    }
+
+    skin_normalize8(&n[0], &n[1], &n[2]);
+    _mm256_storeu_ps(mesh->out_normals.x + i, n[0]);
+    _mm256_storeu_ps(mesh->out_normals.y + i, n[1]);
+    _mm256_storeu_ps(mesh->out_normals.z + i, n[2]);
+  }
+
+  return i;
+}
+
+#endif
+
+// \brief Skins the vertices in [begin, end) by blending the palette matrices
+//    of each vertex's bones by weight. Normals are transformed by the blended
+//    matrix and renormalized, which assumes the palette has no non-uniform
+//    scale.
+void skin_lbs(
+  const SkinMesh* mesh, const mat34* palette, index_s begin, index_s end
+) {
+  assert(mesh);
+  assert(palette);
+  assert(begin >= 0 && begin <= end);
+
+#ifdef SKIN_AVX2
+  begin = skin_lbs_avx2(mesh, palette, begin, end);
+#endif
+
+  skin_lbs_scalar(mesh, palette, begin, end);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Dual quaternion skinning
+////////////////////////////////////////////////////////////////////////////////
+
+static void skin_dqs_scalar(
+  const SkinMesh* mesh, const dquat* palette, index_s begin, index_s end
+) {
+  bool normals = mesh->normals.x != NULL;
+
+  for (index_s i = begin; i < end; ++i) {
+    const float* pivot = NULL;
+    float b[8] = { 0 };
+
+    // blend along the shortest arc relative to the first used influence
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      float w = mesh->weights[k][i];
+      if (w == 0) continue;
+      const float* dq = palette[mesh->bones[k][i]].real.f;
+      if (!pivot) pivot = dq;
+      float dot = dq[0] * pivot[0] + dq[1] * pivot[1]
+                + dq[2] * pivot[2] + dq[3] * pivot[3];
+      if (dot < 0) w = -w;
+      for (int c = 0; c < 4; ++c) b[c] += w * dq[c];
+      for (int c = 0; c < 4; ++c) b[c + 4] += w * dq[c + 4];
+    }
+
+    float len = sqrtf(b[0] * b[0] + b[1] * b[1] + b[2] * b[2] + b[3] * b[3]);
+    float inv = len > 0 ? 1 / len : 0;
+    for (int c = 0; c < 8; ++c) b[c] *= inv;
+
+    float rx = b[0], ry = b[1], rz = b[2], rw = b[3];
+    float dx = b[4], dy = b[5], dz = b[6], dw = b[7];
+
+    // translation: 2 (rw dv - dw rv + rv x dv)
+    float tx = 2 * (rw * dx - dw * rx + (ry * dz - rz * dy));
+    float ty = 2 * (rw * dy - dw * ry + (rz * dx - rx * dz));
+    float tz = 2 * (rw * dz - dw * rz + (rx * dy - ry * dx));
+
+    for (int s = 0; s < (normals ? 2 : 1); ++s) {
+      const SkinStream* in = s ? &mesh->normals : &mesh->positions;
+      const SkinStream* out = s ? &mesh->out_normals : &mesh->out_positions;
+      float x = in->x[i], y = in->y[i], z = in->z[i];
+
+      // rotation: v + 2 rv x (rv x v + rw v)
+      float cx = (ry * z - rz * y) + rw * x;
+      float cy = (rz * x - rx * z) + rw * y;
+      float cz = (rx * y - ry * x) + rw * z;
+      x += 2 * (ry * cz - rz * cy);
+      y += 2 * (rz * cx - rx * cz);
+      z += 2 * (rx * cy - ry * cx);
+
+      if (!s) { x += tx; y += ty; z += tz; }
+      out->x[i] = x;
+      out->y[i] = y;
+      out->z[i] = z;
+    }
+  }
+}
+
+#ifdef SKIN_AVX2
+
+static index_s skin_dqs_avx2(
+  const SkinMesh* mesh, const dquat* palette, index_s begin, index_s end
+) {
+  bool normals = mesh->normals.x != NULL;
+  const float* base = palette->real.f;
+  const __m256 sign = _mm256_set1_ps(-0.0f);
+  const __m256 two = _mm256_set1_ps(2);
+  index_s i = begin;
+
+  for (; i + 8 <= end; i += 8) {
+    __m256 b[8], pivot[4];
+    __m256 pivoted = _mm256_setzero_ps();
+    for (int c = 0; c < 8; ++c) b[c] = _mm256_setzero_ps();
+    for (int c = 0; c < 4; ++c) pivot[c] = _mm256_setzero_ps();
+
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      __m256 w = _mm256_loadu_ps(mesh->weights[k] + i);
+      __m256 used = _mm256_cmp_ps(w, _mm256_setzero_ps(), _CMP_NEQ_UQ);
+      if (_mm256_testz_ps(used, used)) continue;
+
+      __m256i offset = skin_load_bones(mesh->bones[k] + i, 8);
+      __m256 dq[8];
+      for (int c = 0; c < 8; ++c) {
+        dq[c] = _mm256_mask_i32gather_ps(
+          _mm256_setzero_ps(), base + c, offset, used, 4
+        );
+      }
+
+      // each lane's first used influence becomes its pivot
+      __m256 first = _mm256_andnot_ps(pivoted, used);
+      for (int c = 0; c < 4; ++c) {
+        pivot[c] = _mm256_blendv_ps(pivot[c], dq[c], first);
+      }
+      pivoted = _mm256_or_ps(pivoted, used);
+
+      __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(dq[0], pivot[0]), _mm256_mul_ps(dq[1], pivot[1])),
+        _mm256_mul_ps(dq[2], pivot[2])), _mm256_mul_ps(dq[3], pivot[3])
+      );
+      __m256 flip = _mm256_cmp_ps(dot, _mm256_setzero_ps(), _CMP_LT_OQ);
+      w = _mm256_xor_ps(w, _mm256_and_ps(flip, sign));
+
+      for (int c = 0; c < 8; ++c) {
+        b[c] = _mm256_add_ps(b[c], _mm256_mul_ps(w, dq[c]));
+      }
+    }
+
+    __m256 len = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+      _mm256_mul_ps(b[0], b[0]), _mm256_mul_ps(b[1], b[1])),
+      _mm256_mul_ps(b[2], b[2])), _mm256_mul_ps(b[3], b[3])
+    ));
+    __m256 inv = _mm256_and_ps(
+      _mm256_div_ps(_mm256_set1_ps(1), len),
+      _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ)
+    );
+    for (int c = 0; c < 8; ++c) b[c] = _mm256_mul_ps(b[c], inv);
+
+    __m256 rx = b[0], ry = b[1], rz = b[2], rw = b[3];
+    __m256 dx = b[4], dy = b[5], dz = b[6], dw = b[7];
+
+#define _skin_cross(a1, b2, a2, b1)                                           \
+    _mm256_sub_ps(_mm256_mul_ps(a1, b2), _mm256_mul_ps(a2, b1))               //
+
+    __m256 tx = _mm256_mul_ps(two, _mm256_add_ps(_mm256_sub_ps(
+      _mm256_mul_ps(rw, dx), _mm256_mul_ps(dw, rx)), _skin_cross(ry, dz, rz, dy)
+    ));
+    __m256 ty = _mm256_mul_ps(two, _mm256_add_ps(_mm256_sub_ps(
+      _mm256_mul_ps(rw, dy), _mm256_mul_ps(dw, ry)), _skin_cross(rz, dx, rx, dz)
+    ));
+    __m256 tz = _mm256_mul_ps(two, _mm256_add_ps(_mm256_sub_ps(
+      _mm256_mul_ps(rw, dz), _mm256_mul_ps(dw, rz)), _skin_cross(rx, dy, ry, dx)
+    ));
+
+    for (int s = 0; s < (normals ? 2 : 1); ++s) {
+      const SkinStream* in = s ? &mesh->normals : &mesh->positions;
+      const SkinStream* out = s ? &mesh->out_normals : &mesh->out_positions;
+      __m256 x = _mm256_loadu_ps(in->x + i);
+      __m256 y = _mm256_loadu_ps(in->y + i);
+      __m256 z = _mm256_loadu_ps(in->z + i);
+
+      __m256 cx = _mm256_add_ps(
+        _skin_cross(ry, z, rz, y), _mm256_mul_ps(rw, x)
+      );
+      __m256 cy = _mm256_add_ps(
+        _skin_cross(rz, x, rx, z), _mm256_mul_ps(rw, y)
+      );
+      __m256 cz = _mm256_add_ps(
+        _skin_cross(rx, y, ry, x), _mm256_mul_ps(rw, z)
+      );
+      x = _mm256_add_ps(x, _mm256_mul_ps(two, _skin_cross(ry, cz, rz, cy)));
+      y = _mm256_add_ps(y, _mm256_mul_ps(two, _skin_cross(rz, cx, rx, cz)));
+      z = _mm256_add_ps(z, _mm256_mul_ps(two, _skin_cross(rx, cy, ry, cx)));
+
+      if (!s) {
+        x = _mm256_add_ps(x, tx);
+        y = _mm256_add_ps(y, ty);
+        z = _mm256_add_ps(z, tz);
+      }
+
+      _mm256_storeu_ps(out->x + i, x);
+      _mm256_storeu_ps(out->y + i, y);
+      _mm256_storeu_ps(out->z + i, z);
+    }
+
+#undef _skin_cross
+  }
+
+  return i;
+}
+
+#endif
+
+// \brief Skins the vertices in [begin, end) by blending the dual quaternions
+//    of each vertex's bones, which avoids the volume loss linear blending has
+//    around twisting joints. Palette entries must be unit dual quaternions
+//    (rigid transforms), such as from dq_from_m34.
+void skin_dqs(
+  const SkinMesh* mesh, const dquat* palette, index_s begin, index_s end
+) {
+  assert(mesh);
+  assert(palette);
+  assert(begin >= 0 && begin <= end);
+
+#ifdef SKIN_AVX2
+  begin = skin_dqs_avx2(mesh, palette, begin, end);
+#endif
+
+  skin_dqs_scalar(mesh, palette, begin, end);
+}
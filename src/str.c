@@ -22,6 +22,8 @@
 * SOFTWARE.
 */
 
+// the library's own calls shouldn't claim a call site for memstats
+#define _MCLIB_STR_NO_SITES
 #include "str.h"
 
 #include <stdlib.h>
@@ -30,6 +32,21 @@
 #include <math.h>
 
 #include "utility.h"
+#include "memstats.h"
+#include "trace.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define STR_SSE2
+# include <emmintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX__)
+# define STR_SSSE3
+# include <tmmintrin.h>
+#endif
 
 #undef SRCV
 #define SRCV
@@ -61,7 +78,7 @@ const String str_false  = &str_constants[3];
 static String_Internal* str_new_internal(index_s length) {
   if (length == 0) return NULL; // prompt callers to return empty string
   // Include an extra byte for the null terminator
-  String_Internal* ret = malloc(sizeof(StringRange) + length + 1);
+  String_Internal* ret = mem_malloc(sizeof(StringRange) + length + 1);
   assert(ret);
   ret->begin = &ret->head;
   ret->size = length;
@@ -128,16 +145,18 @@ String str_from_bool(bool b) {
 }
 
 String str_from_int(int i) {
-  return str_new(itos(i));
+  char buffer[ITOS_BUFFER_SIZE];
+  return str_new_s(buffer, itos_to(buffer, i));
 }
 
 String str_from_float(float f) {
-  return str_new(ftos(f));
+  char buffer[FTOS_BUFFER_SIZE];
+  return str_new_s(buffer, ftos_to(buffer, f));
 }
 
 void str_delete(String* str) {
   if (!str || !*str) return;
-  if (!str_is_literal(*str)) free(*str);
+  if (!str_is_literal(*str)) mem_free(*str);
   *str = NULL;
 }
 
@@ -193,17 +212,10 @@ bool istr_contains_char(StringRange str, char check) {
 
 bool istr_to_bool(StringRange str, bool* out) {
   if (!out) return false;
-  if (str.size < 4) return false;
-  if (tolower(str.begin[0]) == 't') {
-    for (index_s i = 1; i < 4; ++i) {
-      if (tolower(str.begin[i]) != str_true->begin[i]) return false;
-    }
+  if (istr_starts_with_nocase(str, str_true->range)) {
     *out = true;
     return true;
-  } else if (tolower(str.begin[0]) == 'f') {
-    for (index_s i = 1; i < 5; ++i) {
-      if (tolower(str.begin[i]) != str_false->begin[i]) return false;
-    }
+  } else if (istr_starts_with_nocase(str, str_false->range)) {
     *out = false;
     return true;
   }
@@ -302,25 +314,62 @@ bool istr_to_double(StringRange str, double* out) {
 
 index_s istr_index_of_char(StringRange str, char c, index_s from_pos) {
   if (from_pos >= str.size) return str.size;
-  for (index_s i = from_pos; i < str.size; ++i) {
-    if (str.begin[i] == c) {
-      return i;
-    }
-  }
-  return str.size;
+  const char* at = memchr(str.begin + from_pos, c, str.size - from_pos);
+  return at ? at - str.begin : str.size;
 }
 
+#ifdef STR_SSE2
+// Index of the lowest set bit of a non-zero mask
+static inline int str_lowest_bit(unsigned mask) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return (int)index;
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+#endif
+
 index_s istr_index_of(StringRange str, StringRange to_find, index_s from_pos) {
-  if (str.size < to_find.size) return str.size;
   if (to_find.size == 0) return MIN(from_pos, str.size);
-  index_s j;
-  for (index_s i = from_pos; i <= str.size - to_find.size; ++i) {
-    j = 0;
-    while (j < to_find.size) {
-      if (str.begin[i + j] != to_find.begin[j]) break;
-      if (++j == to_find.size) return i;
+  if (from_pos < 0) from_pos = 0;
+  if (str.size - from_pos < to_find.size) return str.size;
+  if (to_find.size == 1) {
+    return istr_index_of_char(str, to_find.begin[0], from_pos);
+  }
+
+  // candidates need both the first and last characters in place, which rules
+  //    out most positions before anything is compared in full
+  const char* s = str.begin;
+  index_s n = to_find.size;
+  index_s last = str.size - n;
+  index_s i = from_pos;
+
+#ifdef STR_SSE2
+  const __m128i first_c = _mm_set1_epi8(to_find.begin[0]);
+  const __m128i last_c = _mm_set1_epi8(to_find.begin[n - 1]);
+  for (; i + 15 <= last; i += 16) {
+    __m128i head = _mm_loadu_si128((const __m128i*)(s + i));
+    __m128i tail = _mm_loadu_si128((const __m128i*)(s + i + n - 1));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(
+      _mm_cmpeq_epi8(head, first_c), _mm_cmpeq_epi8(tail, last_c)
+    ));
+
+    while (mask) {
+      index_s at = i + str_lowest_bit(mask);
+      mask &= mask - 1;
+      if (!memcmp(s + at + 1, to_find.begin + 1, n - 2)) return at;
     }
   }
+#endif
+
+  for (; i <= last; ++i) {
+    if (s[i] != to_find.begin[0] || s[i + n - 1] != to_find.begin[n - 1]) {
+      continue;
+    }
+    if (!memcmp(s + i + 1, to_find.begin + 1, n - 2)) return i;
+  }
   return str.size;
 }
 
@@ -395,6 +444,7 @@ StringRange istr_trim_end(StringRange str) {
 }
 
 Array_StrR istr_split(StringRange str, StringRange del) {
+  TRACE_BEGIN("str_split");
   Array_StrR ret = arr_str_new();
 
   // specialization for empty delimiter, return a range for each char
@@ -404,6 +454,7 @@ Array_StrR istr_split(StringRange str, StringRange del) {
       StringRange c = str_range_s(&str.begin[i], 1);
       arr_str_push_back(ret, c);
     }
+    TRACE_END();
     return ret;
   }
 
@@ -417,6 +468,7 @@ Array_StrR istr_split(StringRange str, StringRange del) {
     if (i == str.size) arr_str_push_back(ret, str_empty->range);
   } while (i < str.size);
 
+  TRACE_END();
   return ret;
 }
 
@@ -459,6 +511,187 @@ String istr_concat(StringRange left, StringRange right) {
   return str_terminate(ret);
 }
 
+String istr_replace(StringRange str, StringRange token, StringRange with) {
+  if (!token.size) return istr_copy(str);
+  index_s at = istr_index_of(str, token, 0);
+  if (at == str.size) return istr_copy(str);
+
+  String_Internal* ret = str_new_internal(str.size - token.size + with.size);
+  if (!ret) return str_empty;
+  char* out = ret->begin;
+  memcpy(out, str.begin, at);
+  memcpy(out + at, with.begin, with.size);
+  memcpy(out + at + with.size,
+    str.begin + at + token.size, str.size - at - token.size
+  );
+  return str_terminate(ret);
+}
+
+String istr_replace_all(StringRange str, StringRange token, StringRange with) {
+  if (!token.size) return istr_copy(str);
+
+  // count first so the result is allocated once at its final size
+  index_s count = 0;
+  index_s at = istr_index_of(str, token, 0);
+  while (at < str.size) {
+    ++count;
+    at = istr_index_of(str, token, at + token.size);
+  }
+  if (!count) return istr_copy(str);
+
+  String_Internal* ret =
+    str_new_internal(str.size + count * (with.size - token.size));
+  if (!ret) return str_empty;
+
+  char* out = ret->begin;
+  index_s copied = 0;
+  while (count--) {
+    at = istr_index_of(str, token, copied);
+    memcpy(out, str.begin + copied, at - copied);
+    out += at - copied;
+    memcpy(out, with.begin, with.size);
+    out += with.size;
+    copied = at + token.size;
+  }
+  memcpy(out, str.begin + copied, str.size - copied);
+  return str_terminate(ret);
+}
+
+// Tokens are chained by their first character, longest first, so each
+//    position only tries the tokens that could start there. With only a few
+//    distinct first characters, positions are skipped 16 at a time.
+#define STR_REPLACE_STACK 32
+#define STR_REPLACE_LEADS 8
+
+typedef struct {
+  const StrReplacement* table;
+  index_s head[256];
+  index_s* next;
+  char leads[STR_REPLACE_LEADS];
+  int lead_count;
+} StrReplaceIndex;
+
+// Finds the next position where some token could start
+static index_s str_replace_next(
+  const StrReplaceIndex* index, StringRange str, index_s i
+) {
+  if (!index->lead_count) return str.size;
+  if (index->lead_count == 1) {
+    const char* at = memchr(str.begin + i, index->leads[0], str.size - i);
+    return at ? at - str.begin : str.size;
+  }
+
+#ifdef STR_SSE2
+  if (index->lead_count <= STR_REPLACE_LEADS) {
+    for (; i + 16 <= str.size; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(str.begin + i));
+      __m128i hit = _mm_setzero_si128();
+      for (int l = 0; l < index->lead_count; ++l) {
+        hit = _mm_or_si128(hit,
+          _mm_cmpeq_epi8(v, _mm_set1_epi8(index->leads[l]))
+        );
+      }
+      unsigned mask = (unsigned)_mm_movemask_epi8(hit);
+      if (mask) return i + str_lowest_bit(mask);
+    }
+  }
+#endif
+
+  for (; i < str.size; ++i) {
+    if (index->head[(byte)str.begin[i]] >= 0) return i;
+  }
+  return str.size;
+}
+
+// Walks str once, returning the result size, and writes it into out if given
+static index_s str_replace_scan(
+  const StrReplaceIndex* index, StringRange str, char* out, index_s* out_count
+) {
+  index_s size = 0, count = 0, copied = 0, i = 0;
+
+  while ((i = str_replace_next(index, str, i)) < str.size) {
+    index_s k = index->head[(byte)str.begin[i]];
+    for (; k >= 0; k = index->next[k]) {
+      StringRange token = index->table[k].token;
+      if (token.size <= str.size - i
+        && !memcmp(str.begin + i, token.begin, token.size)
+      ) break;
+    }
+
+    if (k < 0) {
+      ++i;
+      continue;
+    }
+
+    StringRange with = index->table[k].with;
+    if (out) {
+      memcpy(out + size, str.begin + copied, i - copied);
+      memcpy(out + size + i - copied, with.begin, with.size);
+    }
+    size += i - copied + with.size;
+    i += index->table[k].token.size;
+    copied = i;
+    ++count;
+  }
+
+  if (out) memcpy(out + size, str.begin + copied, str.size - copied);
+  *out_count = count;
+  return size + str.size - copied;
+}
+
+String istr_replace_multi(
+  StringRange str, const StrReplacement* table, index_s count
+) {
+  assert(table || !count);
+  index_s next_stack[STR_REPLACE_STACK];
+  StrReplaceIndex index = {
+    .table = table,
+    .next = count > STR_REPLACE_STACK
+      ? mem_malloc(count * sizeof(index_s)) : next_stack,
+  };
+  assert(index.next);
+  for (int c = 0; c < 256; ++c) index.head[c] = -1;
+
+  for (index_s k = 0; k < count; ++k) {
+    StringRange token = table[k].token;
+    if (!token.size) continue;
+
+    byte c = (byte)token.begin[0];
+    if (index.head[c] < 0) {
+      if (index.lead_count < STR_REPLACE_LEADS) {
+        index.leads[index.lead_count] = (char)c;
+      }
+      ++index.lead_count;
+    }
+
+    // insert after every token at least as long, so ties keep table order
+    index_s* link = &index.head[c];
+    while (*link >= 0 && table[*link].token.size >= token.size) {
+      link = &index.next[*link];
+    }
+    index.next[k] = *link;
+    *link = k;
+  }
+
+  String ret;
+  index_s matches;
+  index_s size = str_replace_scan(&index, str, NULL, &matches);
+  if (!matches) {
+    ret = istr_copy(str);
+  } else {
+    String_Internal* result = str_new_internal(size);
+    if (result) {
+      str_replace_scan(&index, str, result->begin, &matches);
+      ret = str_terminate(result);
+    } else {
+      ret = str_empty;
+    }
+  }
+
+  if (index.next != next_stack) mem_free(index.next);
+  return ret;
+}
+
 String istr_prepend(StringRange str, index_s length, char c) {
   String_Internal* ret = str_new_internal(str.size + length);
   memset(ret->begin, c, length);
@@ -473,6 +706,678 @@ String istr_append(StringRange str, index_s length, char c) {
   return str_terminate(ret);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// UTF-8
+////////////////////////////////////////////////////////////////////////////////
+
+#define UTF8_REPLACEMENT 0xFFFD
+
+// Decodes the sequence at s, returning its length, or 0 if it's invalid
+static inline int utf8_decode(const byte* s, index_s remaining, uint* out_cp) {
+  byte c = s[0];
+  if (c < 0x80) {
+    *out_cp = c;
+    return 1;
+  }
+
+  int length;
+  uint cp;
+  byte lo = 0x80, hi = 0xBF; // allowed range of the second byte
+
+  if (c < 0xC2) return 0;
+  else if (c < 0xE0) { length = 2; cp = c & 0x1F; }
+  else if (c < 0xF0) {
+    length = 3; cp = c & 0x0F;
+    if (c == 0xE0) lo = 0xA0;       // overlong
+    else if (c == 0xED) hi = 0x9F;  // surrogates
+  }
+  else if (c < 0xF5) {
+    length = 4; cp = c & 0x07;
+    if (c == 0xF0) lo = 0x90;       // overlong
+    else if (c == 0xF4) hi = 0x8F;  // past U+10FFFF
+  }
+  else return 0;
+
+  if (remaining < length) return 0;
+  if (s[1] < lo || s[1] > hi) return 0;
+  cp = (cp << 6) | (s[1] & 0x3F);
+
+  for (int i = 2; i < length; ++i) {
+    if ((s[i] & 0xC0) != 0x80) return 0;
+    cp = (cp << 6) | (s[i] & 0x3F);
+  }
+
+  *out_cp = cp;
+  return length;
+}
+
+static inline int utf8_encode(char* out, uint cp) {
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (char)(0xC0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3F));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+  }
+  out[0] = (char)(0xF0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+  out[3] = (char)(0x80 | (cp & 0x3F));
+  return 4;
+}
+
+static inline bool utf8_is_ascii_8(const byte* s) {
+  unsigned long long word;
+  memcpy(&word, s, sizeof(word));
+  return (word & 0x8080808080808080ull) == 0;
+}
+
+// Returns the offset of the first invalid sequence at or after from, which
+//    must be the start of a sequence, or size if there is none
+static index_s utf8_validate_scalar(const byte* s, index_s size, index_s from) {
+  index_s i = from;
+  while (i < size) {
+    if (i + 8 <= size && utf8_is_ascii_8(s + i)) {
+      i += 8;
+      continue;
+    }
+    uint cp;
+    int length = utf8_decode(s + i, size - i, &cp);
+    if (!length) return i;
+    i += length;
+  }
+  return size;
+}
+
+#ifdef STR_SSSE3
+
+// The lookup algorithm from "Validating UTF-8 In Less Than One Instruction Per
+//    Byte" (Keiser, Lemire 2021). Each byte is classified by the high nibble
+//    of its predecessor, the low nibble of its predecessor and its own high
+//    nibble, and an error is any bit set in all three lookups. Bytes two and
+//    three back then decide which continuation bytes were required.
+
+#define UTF8_TOO_SHORT    (1 << 0)
+#define UTF8_TOO_LONG     (1 << 1)
+#define UTF8_OVERLONG_3   (1 << 2)
+#define UTF8_TOO_LARGE    (1 << 3)
+#define UTF8_SURROGATE    (1 << 4)
+#define UTF8_OVERLONG_2   (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4   (1 << 6)
+#define UTF8_TWO_CONTS    (1 << 7)
+#define UTF8_CARRY        (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+static const byte utf8_byte_1_high[16] = {
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+  UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+  UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+  UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+};
+
+static const byte utf8_byte_1_low[16] = {
+  UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+  UTF8_CARRY | UTF8_OVERLONG_2,
+  UTF8_CARRY,
+  UTF8_CARRY,
+  UTF8_CARRY | UTF8_TOO_LARGE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+};
+
+static const byte utf8_byte_2_high[16] = {
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+    | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE
+    | UTF8_TOO_LARGE,
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+static inline __m128i utf8_check_block(__m128i input, __m128i prev_input) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+
+  __m128i prev1 = _mm_alignr_epi8(input, prev_input, 15);
+  __m128i byte_1_high = _mm_shuffle_epi8(
+    _mm_loadu_si128((const __m128i*)utf8_byte_1_high),
+    _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)
+  );
+  __m128i byte_1_low = _mm_shuffle_epi8(
+    _mm_loadu_si128((const __m128i*)utf8_byte_1_low),
+    _mm_and_si128(prev1, nibble)
+  );
+  __m128i byte_2_high = _mm_shuffle_epi8(
+    _mm_loadu_si128((const __m128i*)utf8_byte_2_high),
+    _mm_and_si128(_mm_srli_epi16(input, 4), nibble)
+  );
+  __m128i special_cases =
+    _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+  // bytes after a 3 or 4 byte lead must be continuations, which is the one
+  //    case that sets TWO_CONTS legitimately
+  __m128i prev2 = _mm_alignr_epi8(input, prev_input, 14);
+  __m128i prev3 = _mm_alignr_epi8(input, prev_input, 13);
+  __m128i is_third = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+  __m128i is_fourth = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+  __m128i must_be_cont = _mm_and_si128(_mm_or_si128(is_third, is_fourth),
+    _mm_set1_epi8((char)0x80)
+  );
+
+  return _mm_xor_si128(must_be_cont, special_cases);
+}
+
+// Non-zero where a block ends partway through a sequence
+static inline __m128i utf8_incomplete(__m128i input) {
+  const __m128i max = _mm_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1)
+  );
+  return _mm_subs_epu8(input, max);
+}
+
+// Runs the checks over 64 bytes, carrying state between calls
+static inline void utf8_check_64(const byte* s, __m128i* error,
+  __m128i* prev_input, __m128i* prev_incomplete
+) {
+  __m128i b0 = _mm_loadu_si128((const __m128i*)s);
+  __m128i b1 = _mm_loadu_si128((const __m128i*)(s + 16));
+  __m128i b2 = _mm_loadu_si128((const __m128i*)(s + 32));
+  __m128i b3 = _mm_loadu_si128((const __m128i*)(s + 48));
+  __m128i any = _mm_or_si128(_mm_or_si128(b0, b1), _mm_or_si128(b2, b3));
+
+  if (!_mm_movemask_epi8(any)) {
+    // all ASCII, only a sequence cut off by the last block can be wrong
+    *error = _mm_or_si128(*error, *prev_incomplete);
+  } else {
+    *error = _mm_or_si128(*error, utf8_check_block(b0, *prev_input));
+    *error = _mm_or_si128(*error, utf8_check_block(b1, b0));
+    *error = _mm_or_si128(*error, utf8_check_block(b2, b1));
+    *error = _mm_or_si128(*error, utf8_check_block(b3, b2));
+    *prev_incomplete = utf8_incomplete(b3);
+  }
+
+  *prev_input = b3;
+}
+
+static inline bool utf8_any(__m128i v) {
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;
+}
+
+#endif
+
+index_s istr_utf8_validate(StringRange str) {
+  const byte* s = (const byte*)str.begin;
+  index_s i = 0;
+
+#ifdef STR_SSSE3
+  __m128i error = _mm_setzero_si128();
+  __m128i prev_input = _mm_setzero_si128();
+  __m128i prev_incomplete = _mm_setzero_si128();
+
+  for (; i + 64 <= str.size; i += 64) {
+    utf8_check_64(s + i, &error, &prev_input, &prev_incomplete);
+    until (utf8_any(error));
+  }
+
+  if (!utf8_any(error)) {
+    // the zero padding acts as ASCII, which flags anything left unfinished
+    byte tail[64] = { 0 };
+    memcpy(tail, s + i, str.size - i);
+    utf8_check_64(tail, &error, &prev_input, &prev_incomplete);
+    if (!utf8_any(error)) return str.size;
+  }
+
+  // find exactly where, starting from any sequence left open by the previous
+  //    block. A lead or ASCII byte is never inside a valid sequence.
+  index_s start = MAX(i - 3, 0);
+  while (start < i && (s[start] & 0xC0) == 0x80) ++start;
+  i = start;
+#endif
+
+  return utf8_validate_scalar(s, str.size, i);
+}
+
+bool istr_utf8_valid(StringRange str) {
+  return istr_utf8_validate(str) == str.size;
+}
+
+index_s istr_utf8_length(StringRange str) {
+  const byte* s = (const byte*)str.begin;
+  index_s count = 0;
+  index_s i = 0;
+
+#ifdef STR_SSE2
+  // every byte that isn't a continuation (0x80-0xBF, or below -64 signed)
+  //    starts a code point. Counts are gathered in bytes, so they're summed
+  //    up before they can overflow.
+  const __m128i cont_max = _mm_set1_epi8(-65);
+  while (i + 16 <= str.size) {
+    __m128i counts = _mm_setzero_si128();
+    index_s end = MIN(str.size - 15, i + 255 * 16);
+    for (; i < end; i += 16) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+      counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(v, cont_max));
+    }
+    __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+    count += _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+  }
+#endif
+
+  for (; i < str.size; ++i) {
+    count += (s[i] & 0xC0) != 0x80;
+  }
+  return count;
+}
+
+bool istr_utf8_next(StringRange str, index_s* pos, uint* out_cp) {
+  assert(pos && out_cp);
+  if (*pos >= str.size) return false;
+
+  int length = utf8_decode(
+    (const byte*)str.begin + *pos, str.size - *pos, out_cp
+  );
+  if (!length) {
+    *out_cp = UTF8_REPLACEMENT;
+    length = 1;
+  }
+
+  *pos += length;
+  return true;
+}
+
+index_s istr_utf16_length(StringRange str) {
+  // one unit per code point, plus one more for each pair from a 4-byte lead
+  index_s count = istr_utf8_length(str);
+  for (index_s i = 0; i < str.size; ++i) {
+    count += (byte)str.begin[i] >= 0xF0;
+  }
+  return count;
+}
+
+index_s istr_to_utf16(u16* out, StringRange str) {
+  assert(out || !str.size);
+  const byte* s = (const byte*)str.begin;
+  index_s i = 0;
+  u16* o = out;
+
+  while (i < str.size) {
+#ifdef STR_SSE2
+    if (i + 16 <= str.size) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+      if (!_mm_movemask_epi8(v)) {
+        _mm_storeu_si128((__m128i*)o, _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+        _mm_storeu_si128((__m128i*)(o + 8),
+          _mm_unpackhi_epi8(v, _mm_setzero_si128())
+        );
+        i += 16;
+        o += 16;
+        continue;
+      }
+    }
+#endif
+
+    uint cp;
+    int length = utf8_decode(s + i, str.size - i, &cp);
+    if (!length) return -1;
+    i += length;
+
+    if (cp < 0x10000) {
+      *o++ = (u16)cp;
+    } else {
+      cp -= 0x10000;
+      *o++ = (u16)(0xD800 | (cp >> 10));
+      *o++ = (u16)(0xDC00 | (cp & 0x3FF));
+    }
+  }
+
+  return o - out;
+}
+
+index_s istr_to_utf32(uint* out, StringRange str) {
+  assert(out || !str.size);
+  const byte* s = (const byte*)str.begin;
+  index_s i = 0;
+  uint* o = out;
+
+  while (i < str.size) {
+#ifdef STR_SSE2
+    if (i + 16 <= str.size) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+      if (!_mm_movemask_epi8(v)) {
+        const __m128i zero = _mm_setzero_si128();
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i*)o, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(o + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(o + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)(o + 12), _mm_unpackhi_epi16(hi, zero));
+        i += 16;
+        o += 16;
+        continue;
+      }
+    }
+#endif
+
+    int length = utf8_decode(s + i, str.size - i, o);
+    if (!length) return -1;
+    i += length;
+    ++o;
+  }
+
+  return o - out;
+}
+
+// Transcodes into space reserved at the end of an array, then trims it to
+//    what was actually written
+static index_s str_to_utf_array(Array out, StringRange str, index_s size,
+  index_s (*transcode)(void* out, StringRange str)
+) {
+  assert(out && out->element_size == size);
+  PARAM_UNUSED(size);
+  if (!str.size) return 0;
+
+  index_s start = out->size;
+  void* dest = array_emplace_back_range(out, str.size);
+  index_s count = transcode(dest, str);
+
+  index_s keep = MAX(count, 0);
+  if (keep < str.size) {
+    array_remove_range(out, start + keep, str.size - keep);
+  }
+  return count;
+}
+
+static index_s str_to_utf16_v(void* out, StringRange str) {
+  return istr_to_utf16(out, str);
+}
+
+static index_s str_to_utf32_v(void* out, StringRange str) {
+  return istr_to_utf32(out, str);
+}
+
+index_s istr_to_utf16_array(Array out, StringRange str) {
+  return str_to_utf_array(out, str, sizeof(u16), str_to_utf16_v);
+}
+
+index_s istr_to_utf32_array(Array out, StringRange str) {
+  return str_to_utf_array(out, str, sizeof(uint), str_to_utf32_v);
+}
+
+index_s str_utf16_to_utf8(char* out, const u16* in, index_s count) {
+  assert((out && in) || !count);
+  char* o = out;
+  index_s i = 0;
+
+  while (i < count) {
+#ifdef STR_SSE2
+    if (i + 8 <= count) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+      // all below 0x80 when nothing survives clearing the low 7 bits
+      __m128i high = _mm_andnot_si128(_mm_set1_epi16(0x7F), v);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128()))
+        == 0xFFFF
+      ) {
+        _mm_storel_epi64((__m128i*)o, _mm_packus_epi16(v, v));
+        i += 8;
+        o += 8;
+        continue;
+      }
+    }
+#endif
+
+    uint cp = in[i++];
+    if (cp >= 0xD800 && cp < 0xE000) {
+      if (cp >= 0xDC00 || i >= count) return -1;
+      uint low = in[i];
+      if (low < 0xDC00 || low >= 0xE000) return -1;
+      ++i;
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+    }
+    o += utf8_encode(o, cp);
+  }
+
+  return o - out;
+}
+
+index_s str_utf32_to_utf8(char* out, const uint* in, index_s count) {
+  assert((out && in) || !count);
+  char* o = out;
+  for (index_s i = 0; i < count; ++i) {
+    uint cp = in[i];
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000)) return -1;
+    o += utf8_encode(o, cp);
+  }
+  return o - out;
+}
+
+// Encodes into a String sized for the worst case, then shrinks it to fit
+static String str_from_utf(const void* in, index_s count, index_s max_bytes,
+  index_s (*transcode)(char* out, const void* in, index_s count)
+) {
+  if (!count) return str_empty;
+
+  String_Internal* ret = str_new_internal(max_bytes);
+  index_s size = transcode(&ret->head, in, count);
+  if (size < 0) {
+    mem_free(ret);
+    return NULL;
+  }
+
+  String_Internal* shrunk = mem_realloc(ret, sizeof(StringRange) + size + 1);
+  if (shrunk) ret = shrunk;
+  ret->begin = &ret->head;
+  ret->size = size;
+  return str_terminate(ret);
+}
+
+static index_s str_utf16_to_utf8_v(char* out, const void* in, index_s count) {
+  return str_utf16_to_utf8(out, in, count);
+}
+
+static index_s str_utf32_to_utf8_v(char* out, const void* in, index_s count) {
+  return str_utf32_to_utf8(out, in, count);
+}
+
+String str_from_utf16(const u16* in, index_s count) {
+  return str_from_utf(in, count, count * 3, str_utf16_to_utf8_v);
+}
+
+String str_from_utf32(const uint* in, index_s count) {
+  return str_from_utf(in, count, count * 4, str_utf32_to_utf8_v);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Case folding
+////////////////////////////////////////////////////////////////////////////////
+
+#define FOLD_LOWER(C) ((C) >= 'A' && (C) <= 'Z' ? (C) + 32 : (C))
+#define FOLD_UPPER(C) ((C) >= 'a' && (C) <= 'z' ? (C) - 32 : (C))
+#define FOLD_ROW(F, R)                                                        \
+  F(R + 0),  F(R + 1),  F(R + 2),  F(R + 3),                                  \
+  F(R + 4),  F(R + 5),  F(R + 6),  F(R + 7),                                  \
+  F(R + 8),  F(R + 9),  F(R + 10), F(R + 11),                                 \
+  F(R + 12), F(R + 13), F(R + 14), F(R + 15)                                  //
+#define FOLD_TABLE(F)                                                         \
+  FOLD_ROW(F, 0x00), FOLD_ROW(F, 0x10), FOLD_ROW(F, 0x20), FOLD_ROW(F, 0x30), \
+  FOLD_ROW(F, 0x40), FOLD_ROW(F, 0x50), FOLD_ROW(F, 0x60), FOLD_ROW(F, 0x70), \
+  FOLD_ROW(F, 0x80), FOLD_ROW(F, 0x90), FOLD_ROW(F, 0xA0), FOLD_ROW(F, 0xB0), \
+  FOLD_ROW(F, 0xC0), FOLD_ROW(F, 0xD0), FOLD_ROW(F, 0xE0), FOLD_ROW(F, 0xF0)  //
+
+const byte str_lower_table[256] = { FOLD_TABLE(FOLD_LOWER) };
+const byte str_upper_table[256] = { FOLD_TABLE(FOLD_UPPER) };
+
+#ifdef STR_SSE2
+// Bytes from 0x80 up are negative as signed chars, so they never fall in the
+//    letter ranges and UTF-8 passes through
+static inline __m128i str_fold_16(__m128i v, char first, char last) {
+  __m128i in_range = _mm_and_si128(
+    _mm_cmpgt_epi8(v, _mm_set1_epi8((char)(first - 1))),
+    _mm_cmplt_epi8(v, _mm_set1_epi8((char)(last + 1)))
+  );
+  return _mm_xor_si128(v, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+
+static inline __m128i str_lower_16(__m128i v) {
+  return str_fold_16(v, 'A', 'Z');
+}
+#endif
+
+// Compares n bytes of a and b with ASCII letters folded
+static bool str_eq_nocase_n(const char* a, const char* b, index_s n) {
+  index_s i = 0;
+#ifdef STR_SSE2
+  for (; i + 16 <= n; i += 16) {
+    __m128i va = str_lower_16(_mm_loadu_si128((const __m128i*)(a + i)));
+    __m128i vb = str_lower_16(_mm_loadu_si128((const __m128i*)(b + i)));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xFFFF) return false;
+  }
+#endif
+  for (; i < n; ++i) {
+    if (str_lower_table[(byte)a[i]] != str_lower_table[(byte)b[i]]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#ifdef __GNUC__
+// Same as str_terminate, gcc sees new strings as writes past their head char
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wstringop-overflow="
+#endif
+static void str_convert_case(char* out, const char* in, index_s size,
+  const byte* table
+) {
+  index_s i = 0;
+#ifdef STR_SSE2
+  bool upper = table == str_upper_table;
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(in + i));
+    v = upper ? str_fold_16(v, 'a', 'z') : str_fold_16(v, 'A', 'Z');
+    _mm_storeu_si128((__m128i*)(out + i), v);
+  }
+#endif
+  for (; i < size; ++i) {
+    out[i] = (char)table[(byte)in[i]];
+  }
+}
+#ifdef __GNUC__
+# pragma GCC diagnostic pop
+#endif
+
+bool istr_eq_nocase(StringRange lhs, StringRange rhs) {
+  if (lhs.size != rhs.size) return false;
+  return str_eq_nocase_n(lhs.begin, rhs.begin, lhs.size);
+}
+
+bool istr_starts_with_nocase(StringRange str, StringRange starts) {
+  if (str.size < starts.size) return false;
+  return str_eq_nocase_n(str.begin, starts.begin, starts.size);
+}
+
+bool istr_ends_with_nocase(StringRange str, StringRange ends) {
+  if (str.size < ends.size) return false;
+  return str_eq_nocase_n(str.begin + str.size - ends.size, ends.begin,
+    ends.size
+  );
+}
+
+bool istr_contains_nocase(StringRange str, StringRange check) {
+  return istr_index_of_nocase(str, check, 0) != str.size;
+}
+
+index_s istr_index_of_nocase(
+  StringRange str, StringRange to_find, index_s from_pos
+) {
+  if (str.size < to_find.size) return str.size;
+  if (to_find.size == 0) return MIN(from_pos, str.size);
+
+  // candidates are found by either case of the first character, then checked
+  char lower = str_char_lower(to_find.begin[0]);
+  char upper = str_char_upper(to_find.begin[0]);
+  const char* rest = to_find.begin + 1;
+  index_s rest_size = to_find.size - 1;
+  index_s last = str.size - to_find.size;
+  index_s i = MAX(from_pos, 0);
+
+#ifdef STR_SSE2
+  const __m128i v_lower = _mm_set1_epi8(lower);
+  const __m128i v_upper = _mm_set1_epi8(upper);
+  for (; i + 16 <= str.size && i <= last; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(str.begin + i));
+    unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(
+      _mm_cmpeq_epi8(v, v_lower), _mm_cmpeq_epi8(v, v_upper)
+    ));
+
+    while (mask) {
+      index_s at = i + str_lowest_bit(mask);
+      mask &= mask - 1;
+      if (at > last) return str.size;
+      if (str_eq_nocase_n(str.begin + at + 1, rest, rest_size)) return at;
+    }
+  }
+#endif
+
+  for (; i <= last; ++i) {
+    char c = str.begin[i];
+    if (c != lower && c != upper) continue;
+    if (str_eq_nocase_n(str.begin + i + 1, rest, rest_size)) return i;
+  }
+
+  return str.size;
+}
+
+String istr_to_lower(StringRange str) {
+  String_Internal* ret = str_new_internal(str.size);
+  if (!ret) return str_empty;
+  str_convert_case(ret->begin, str.begin, str.size, str_lower_table);
+  return str_terminate(ret);
+}
+
+String istr_to_upper(StringRange str) {
+  String_Internal* ret = str_new_internal(str.size);
+  if (!ret) return str_empty;
+  str_convert_case(ret->begin, str.begin, str.size, str_upper_table);
+  return str_terminate(ret);
+}
+
+index_s istr_to_lower_to(char* out, StringRange str) {
+  assert(out || !str.size);
+  str_convert_case(out, str.begin, str.size, str_lower_table);
+  return str.size;
+}
+
+index_s istr_to_upper_to(char* out, StringRange str) {
+  assert(out || !str.size);
+  str_convert_case(out, str.begin, str.size, str_upper_table);
+  return str.size;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // str_format
 ////////////////////////////////////////////////////////////////////////////////
@@ -950,6 +1855,8 @@ static String format_va(StringRange fmt, va_list args) {
   // TODO: Move this to its own section, possibly want to split out a new 
   //    header just for this function, especially if other dependent types
   //    end up being supported (such as vec3).
+  TRACE_BEGIN("str_format");
+
   Array params = array_new(_Str_FmtArg);
   index_s reserve_size = sizeof(String_Internal) + fmt.size;
 
@@ -972,6 +1879,7 @@ static String format_va(StringRange fmt, va_list args) {
 
   // Push the String header to the front of the array data
   if (!arr_byte_emplace_back_range(output, sizeof(struct _Str_Base))) {
+    TRACE_END();
     return str_empty;
   }
 
@@ -1035,12 +1943,17 @@ static String format_va(StringRange fmt, va_list args) {
   array_delete(&params);
 
   arr_byte_push_back(output, '\0');
+
+  // shrinking may move the data, so set up the header after
+  arr_byte_truncate(output, output->size);
   String_Internal* header = (String_Internal*)output->arr;
   header->size = output->size - sizeof(struct _Str_Base) - 1;
   header->begin = &header->head;
-  arr_byte_truncate(output, output->size);
+  index_s bytes = output->size;
   String ret = (String)arr_byte_release(&output);
+  mem_adopt(ret, bytes); // still ours, now as a String
 
+  TRACE_END();
   return ret;
 }
 
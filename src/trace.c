@@ -0,0 +1,317 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "trace.h"
+
+#include <stdio.h>
+
+#ifndef MCLIB_TRACE
+
+void trace_begin(const char* name) {
+  PARAM_UNUSED(name);
+}
+
+void trace_end(void) { }
+
+void trace_set_thread_name(const char* name) {
+  PARAM_UNUSED(name);
+}
+
+void trace_clear(void) { }
+
+// \brief Without MCLIB_TRACE there's nothing to write, so this always fails.
+bool trace_export(const char* path) {
+  PARAM_UNUSED(path);
+  return false;
+}
+
+#else
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+# include <intrin.h>
+# define TRACE_THREAD_LOCAL __declspec(thread)
+static volatile long trace_lock_flag = 0;
+static inline void trace_lock(void) {
+  while (_InterlockedExchange(&trace_lock_flag, 1)) _mm_pause();
+}
+static inline void trace_unlock(void) {
+  _InterlockedExchange(&trace_lock_flag, 0);
+}
+#else
+# include <stdatomic.h>
+# define TRACE_THREAD_LOCAL _Thread_local
+static atomic_flag trace_lock_flag = ATOMIC_FLAG_INIT;
+static inline void trace_lock(void) {
+  while (atomic_flag_test_and_set_explicit(&trace_lock_flag, memory_order_acquire));
+}
+static inline void trace_unlock(void) {
+  atomic_flag_clear_explicit(&trace_lock_flag, memory_order_release);
+}
+#endif
+
+// Each buffer is handed to a thread exit callback, which marks it retired so
+//    trace_clear can pass it on to a new thread
+#ifdef _WIN32
+# include <windows.h>
+# define TRACE_CALLBACK WINAPI
+static DWORD trace_exit_key = FLS_OUT_OF_INDEXES;
+#else
+# include <pthread.h>
+# define TRACE_CALLBACK
+static pthread_key_t trace_exit_key;
+static bool trace_exit_ready = false;
+#endif
+
+// Timestamps come from the TSC where there is one, converted to time on export
+//    by comparing against the wall clock at the start and end of the trace.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+# define TRACE_TSC
+# if defined(_MSC_VER) && !defined(__clang__)
+#  define trace_ticks() __rdtsc()
+# else
+#  include <x86intrin.h>
+#  define trace_ticks() __rdtsc()
+# endif
+#else
+# define trace_ticks() trace_clock_ns()
+#endif
+
+#define TRACE_MAX_DEPTH 64
+
+typedef struct {
+  const char* name;
+  uint64_t start;
+  uint64_t duration;
+} TraceEvent;
+
+typedef struct TraceBuffer {
+  struct TraceBuffer* next;
+  const char* thread_name;
+  int thread_id;
+  bool retired;                // its thread has exited
+  index_s written;             // total events, the ring holds the last ones
+  const char* names[TRACE_MAX_DEPTH];
+  uint64_t starts[TRACE_MAX_DEPTH];
+  int depth;
+  TraceEvent events[TRACE_BUFFER_EVENTS];
+} TraceBuffer;
+
+static TraceBuffer* trace_buffers = NULL;
+static TraceBuffer* trace_free = NULL;
+static int trace_thread_count = 0;
+static TRACE_THREAD_LOCAL TraceBuffer* trace_local = NULL;
+
+// Reference points to convert ticks to nanoseconds
+static uint64_t trace_epoch_ticks = 0;
+static double trace_epoch_ns = 0;
+
+static double trace_clock_ns(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+// Runs on the exiting thread. Its events stay exportable until trace_clear.
+static void TRACE_CALLBACK trace_retire(void* buffer) {
+  trace_lock();
+  ((TraceBuffer*)buffer)->retired = true;
+  trace_unlock();
+  trace_local = NULL;
+}
+
+// Called with the lock held
+static void trace_retire_on_exit(TraceBuffer* buffer) {
+#ifdef _WIN32
+  if (trace_exit_key == FLS_OUT_OF_INDEXES) {
+    trace_exit_key = FlsAlloc(trace_retire);
+  }
+  if (trace_exit_key != FLS_OUT_OF_INDEXES) {
+    FlsSetValue(trace_exit_key, buffer);
+  }
+#else
+  if (!trace_exit_ready) {
+    trace_exit_ready = pthread_key_create(&trace_exit_key, trace_retire) == 0;
+  }
+  if (trace_exit_ready) pthread_setspecific(trace_exit_key, buffer);
+#endif
+}
+
+// Buffers are registered the first time a thread records, reusing one left by
+//    an exited thread (along with its thread id) when there is one
+static TraceBuffer* trace_buffer(void) {
+  if (trace_local) return trace_local;
+
+  trace_lock();
+  TraceBuffer* buffer = trace_free;
+  if (buffer) trace_free = buffer->next;
+  trace_unlock();
+
+  if (buffer) {
+    buffer->thread_name = NULL;
+    buffer->retired = false;
+    buffer->written = 0;
+    buffer->depth = 0;
+  } else {
+    buffer = calloc(1, sizeof(TraceBuffer));
+    if (!buffer) return NULL;
+  }
+
+  trace_lock();
+  if (!trace_buffers) {
+    trace_epoch_ticks = trace_ticks();
+    trace_epoch_ns = trace_clock_ns();
+  }
+  if (!buffer->thread_id) buffer->thread_id = ++trace_thread_count;
+  buffer->next = trace_buffers;
+  trace_buffers = buffer;
+  trace_retire_on_exit(buffer);
+  trace_unlock();
+
+  trace_local = buffer;
+  return buffer;
+}
+
+// \brief Opens a zone on the calling thread, closed by the next trace_end.
+void trace_begin(const char* name) {
+  TraceBuffer* buffer = trace_buffer();
+  if (!buffer) return;
+
+  // deeper zones than can be tracked are still counted so ends stay matched
+  if (buffer->depth < TRACE_MAX_DEPTH) {
+    buffer->names[buffer->depth] = name;
+    buffer->starts[buffer->depth] = trace_ticks();
+  }
+  ++buffer->depth;
+}
+
+void trace_end(void) {
+  uint64_t now = trace_ticks();
+  TraceBuffer* buffer = trace_local;
+  if (!buffer || buffer->depth == 0) return;
+
+  int depth = --buffer->depth;
+  if (depth >= TRACE_MAX_DEPTH) return;
+
+  TraceEvent* event = &buffer->events[buffer->written % TRACE_BUFFER_EVENTS];
+  event->name = buffer->names[depth];
+  event->start = buffer->starts[depth];
+  event->duration = now - buffer->starts[depth];
+  ++buffer->written;
+}
+
+void trace_set_thread_name(const char* name) {
+  TraceBuffer* buffer = trace_buffer();
+  if (buffer) buffer->thread_name = name;
+}
+
+// \brief Drops recorded events on every thread. Zones currently open are kept.
+//    Buffers of threads that have exited are kept for new threads to reuse.
+void trace_clear(void) {
+  trace_lock();
+  TraceBuffer** link = &trace_buffers;
+  while (*link) {
+    TraceBuffer* b = *link;
+    b->written = 0;
+    if (!b->retired) {
+      link = &b->next;
+      continue;
+    }
+    *link = b->next;
+    b->next = trace_free;
+    trace_free = b;
+  }
+  trace_unlock();
+}
+
+static void trace_write_string(FILE* file, const char* str) {
+  fputc('"', file);
+  for (; *str; ++str) {
+    if (*str == '"' || *str == '\\') fputc('\\', file);
+    if ((unsigned char)*str < 0x20) continue;
+    fputc(*str, file);
+  }
+  fputc('"', file);
+}
+
+// \brief Writes every thread's recorded events as a Chrome trace. Should be
+//    called while other threads aren't recording, or their latest events may
+//    be cut off.
+bool trace_export(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (!file) return false;
+
+  trace_lock();
+
+  double ns_per_tick = 1;
+#ifdef TRACE_TSC
+  uint64_t ticks = trace_ticks() - trace_epoch_ticks;
+  double elapsed = trace_clock_ns() - trace_epoch_ns;
+  if (ticks > 0 && elapsed > 0) ns_per_tick = elapsed / (double)ticks;
+#endif
+
+  fprintf(file, "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [");
+  bool first = true;
+
+  for (TraceBuffer* b = trace_buffers; b; b = b->next) {
+    if (b->thread_name) {
+      fprintf(file, "%s\n{\"ph\": \"M\", \"name\": \"thread_name\", "
+        "\"pid\": 1, \"tid\": %d, \"args\": {\"name\": ",
+        first ? "" : ",", b->thread_id
+      );
+      trace_write_string(file, b->thread_name);
+      fprintf(file, "}}");
+      first = false;
+    }
+
+    index_s count = MIN(b->written, TRACE_BUFFER_EVENTS);
+    index_s begin = b->written - count;
+
+    for (index_s i = begin; i < b->written; ++i) {
+      const TraceEvent* e = &b->events[i % TRACE_BUFFER_EVENTS];
+      double ts = (double)(e->start - trace_epoch_ticks) * ns_per_tick / 1000;
+      double dur = (double)e->duration * ns_per_tick / 1000;
+
+      fprintf(file, "%s\n{\"ph\": \"X\", \"name\": ", first ? "" : ",");
+      trace_write_string(file, e->name);
+      fprintf(file, ", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+        b->thread_id, ts, dur
+      );
+      first = false;
+    }
+  }
+
+  trace_unlock();
+
+  fprintf(file, "\n]}\n");
+  bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
+
+#endif
@@ -22,11 +22,22 @@
 * SOFTWARE.
 */
 
+#include "utility.h"
 #include "types.h"
 
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSSE3__) || defined(__AVX__)
+# define UTIL_SSSE3
+# include <tmmintrin.h>
+#endif
+
+#ifdef __AVX2__
+# define UTIL_AVX2
+# include <immintrin.h>
+#endif
+
 // WASI doesn't support stof yet, which is annoying. Too lazy to make a function
 // right now, pulled from Karl Knechtel at:
 // https://stackoverflow.com/questions/4392665/converting-string-to-float-without-stof-in-c
@@ -54,78 +65,615 @@ int stoi(const char* s) {
   return atoi(s);
 }
 
-#define NUM_BUF_SIZE 20
-static char number_result[NUM_BUF_SIZE + 1];
+#if defined(_MSC_VER) && !defined(__clang__)
+# define UTIL_THREAD_LOCAL __declspec(thread)
+#else
+# define UTIL_THREAD_LOCAL _Thread_local
+#endif
 
-const char* itos(int i) {
-  char* c = number_result;
-  char* r = c;
+////////////////////////////////////////////////////////////////////////////////
+// Integers
+////////////////////////////////////////////////////////////////////////////////
+
+static const char digit_pairs[201] =
+  "00010203040506070809"
+  "10111213141516171819"
+  "20212223242526272829"
+  "30313233343536373839"
+  "40414243444546474849"
+  "50515253545556575859"
+  "60616263646566676869"
+  "70717273747576777879"
+  "80818283848586878889"
+  "90919293949596979899";
 
-  if (i < 0) {
-    *c++ = '-';
-    i *= -1;
-    ++r;
+// Writes the digits of n ending right before end, two at a time from a
+//    lookup table, and returns where they start
+static char* utoa_backwards(char* end, unsigned long long n) {
+  while (n >= 100) {
+    unsigned pair = (unsigned)(n % 100) * 2;
+    n /= 100;
+    *--end = digit_pairs[pair + 1];
+    *--end = digit_pairs[pair];
   }
 
-  while (i) {
-    *(c++) = '0' + i % 10;
-    i /= 10;
+  if (n >= 10) {
+    unsigned pair = (unsigned)n * 2;
+    *--end = digit_pairs[pair + 1];
+    *--end = digit_pairs[pair];
+  } else {
+    *--end = (char)('0' + n);
   }
 
-  if (c == number_result) {
-    *c++ = '0';
+  return end;
+}
+
+// Number of decimal digits in n
+static int udigits(unsigned long long n) {
+  int ret = 1;
+  loop {
+    until (n < 10);
+    if (n < 100) return ret + 1;
+    if (n < 1000) return ret + 2;
+    if (n < 10000) return ret + 3;
+    n /= 10000;
+    ret += 4;
+  }
+  return ret;
+}
+
+int lltos_to(char* out, long long i) {
+  assert(out);
+
+  // work in unsigned so the most negative value doesn't overflow
+  unsigned long long n = i < 0
+    ? 0ull - (unsigned long long)i
+    : (unsigned long long)i;
+
+  int length = udigits(n) + (i < 0);
+  out[length] = '\0';
+  utoa_backwards(out + length, n);
+  if (i < 0) out[0] = '-';
+  return length;
+}
+
+int itos_to(char* out, int i) {
+  return lltos_to(out, i);
+}
+
+const char* itos(int i) {
+  static UTIL_THREAD_LOCAL char result[ITOS_BUFFER_SIZE];
+  itos_to(result, i);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Floats
+////////////////////////////////////////////////////////////////////////////////
+
+// Shortest representation that reads back as the same float, via Ryu
+//    (Ulf Adams, PLDI 2018). All the arithmetic is in 64-bit integers.
+
+#define FLOAT_MANTISSA_BITS 23
+#define FLOAT_EXPONENT_BITS 8
+#define FLOAT_BIAS 127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT 61
+
+static const unsigned long long FLOAT_POW5_INV_SPLIT[31] = {
+  0x0800000000000001ull, 0x0666666666666667ull, 0x051eb851eb851eb9ull,
+  0x04189374bc6a7efaull, 0x068db8bac710cb2aull, 0x053e2d6238da3c22ull,
+  0x0431bde82d7b634eull, 0x06b5fca6af2bd216ull, 0x055e63b88c230e78ull,
+  0x044b82fa09b5a52dull, 0x06df37f675ef6eaeull, 0x057f5ff85e592558ull,
+  0x0465e6604b7a8447ull, 0x0709709a125da071ull, 0x05a126e1a84ae6c1ull,
+  0x0480ebe7b9d58567ull, 0x0734aca5f6226f0bull, 0x05c3bd5191b525a3ull,
+  0x049c97747490eae9ull, 0x0760f253edb4ab0eull, 0x05e72843249088d8ull,
+  0x04b8ed0283a6d3e0ull, 0x078e480405d7b966ull, 0x060b6cd004ac9452ull,
+  0x04d5f0a66a23a9dbull, 0x07bcb43d769f762bull, 0x063090312bb2c4efull,
+  0x04f3a68dbc8f03f3ull, 0x07ec3daf94180651ull, 0x065697bfa9acd1daull,
+  0x051212ffbaf0a7e2ull
+};
+
+static const unsigned long long FLOAT_POW5_SPLIT[47] = {
+  0x1000000000000000ull, 0x1400000000000000ull, 0x1900000000000000ull,
+  0x1f40000000000000ull, 0x1388000000000000ull, 0x186a000000000000ull,
+  0x1e84800000000000ull, 0x1312d00000000000ull, 0x17d7840000000000ull,
+  0x1dcd650000000000ull, 0x12a05f2000000000ull, 0x174876e800000000ull,
+  0x1d1a94a200000000ull, 0x12309ce540000000ull, 0x16bcc41e90000000ull,
+  0x1c6bf52634000000ull, 0x11c37937e0800000ull, 0x16345785d8a00000ull,
+  0x1bc16d674ec80000ull, 0x1158e460913d0000ull, 0x15af1d78b58c4000ull,
+  0x1b1ae4d6e2ef5000ull, 0x10f0cf064dd59200ull, 0x152d02c7e14af680ull,
+  0x1a784379d99db420ull, 0x108b2a2c28029094ull, 0x14adf4b7320334b9ull,
+  0x19d971e4fe8401e7ull, 0x1027e72f1f128130ull, 0x1431e0fae6d7217cull,
+  0x193e5939a08ce9dbull, 0x1f8def8808b02452ull, 0x13b8b5b5056e16b3ull,
+  0x18a6e32246c99c60ull, 0x1ed09bead87c0378ull, 0x13426172c74d822bull,
+  0x1812f9cf7920e2b6ull, 0x1e17b84357691b64ull, 0x12ced32a16a1b11eull,
+  0x178287f49c4a1d66ull, 0x1d6329f1c35ca4bfull, 0x125dfa371a19e6f7ull,
+  0x16f578c4e0a060b5ull, 0x1cb2d6f618c878e3ull, 0x11efc659cf7d4b8dull,
+  0x166bb7f0435c9e71ull, 0x1c06a5ec5433c60dull
+};
+
+// ceil(log2(5^e)), or 1 for e == 0
+static inline int pow5bits(int e) {
+  return (int)(((unsigned)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e))
+static inline unsigned log10_pow2(int e) {
+  return ((unsigned)e * 78913) >> 18;
+}
+
+// floor(log10(5^e))
+static inline unsigned log10_pow5(int e) {
+  return ((unsigned)e * 732923) >> 20;
+}
+
+static inline unsigned pow5_factor(unsigned value) {
+  unsigned count = 0;
+  for (; value % 5 == 0; value /= 5) ++count;
+  return count;
+}
+
+static inline bool multiple_of_pow5(unsigned value, unsigned p) {
+  return pow5_factor(value) >= p;
+}
+
+static inline bool multiple_of_pow2(unsigned value, unsigned p) {
+  return (value & ((1u << p) - 1)) == 0;
+}
+
+static inline unsigned mul_shift(unsigned m, unsigned long long factor,
+  int shift
+) {
+  unsigned long long lo = (unsigned long long)m * (unsigned)factor;
+  unsigned long long hi = (unsigned long long)m * (unsigned)(factor >> 32);
+  return (unsigned)(((lo >> 32) + hi) >> (shift - 32));
+}
+
+static inline unsigned mul_pow5_inv_div_pow2(unsigned m, unsigned q, int j) {
+  return mul_shift(m, FLOAT_POW5_INV_SPLIT[q], j);
+}
+
+static inline unsigned mul_pow5_div_pow2(unsigned m, unsigned i, int j) {
+  return mul_shift(m, FLOAT_POW5_SPLIT[i], j);
+}
+
+// Finds the shortest decimal digits and exponent such that
+//    digits * 10^exponent rounds back to the float
+static void f2d(unsigned ieee_mantissa, unsigned ieee_exponent,
+  unsigned* out_digits, int* out_exponent
+) {
+  int e2;
+  unsigned m2;
+  if (ieee_exponent == 0) {
+    e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = ieee_mantissa;
+  } else {
+    e2 = (int)ieee_exponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+    m2 = (1u << FLOAT_MANTISSA_BITS) | ieee_mantissa;
   }
+  bool accept_bounds = (m2 & 1) == 0;
+
+  // the float and the halfway points to its neighbours, scaled by 4
+  unsigned mv = 4 * m2;
+  unsigned mp = 4 * m2 + 2;
+  unsigned mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+  unsigned mm = 4 * m2 - 1 - mm_shift;
+
+  unsigned vr, vp, vm;
+  int e10;
+  bool vm_trailing_zeros = false;
+  bool vr_trailing_zeros = false;
+  unsigned last_removed_digit = 0;
 
-  *c-- = '\0';
+  if (e2 >= 0) {
+    unsigned q = log10_pow2(e2);
+    e10 = (int)q;
+    int k = FLOAT_POW5_INV_BITCOUNT + pow5bits((int)q) - 1;
+    int i = -e2 + (int)q + k;
+    vr = mul_pow5_inv_div_pow2(mv, q, i);
+    vp = mul_pow5_inv_div_pow2(mp, q, i);
+    vm = mul_pow5_inv_div_pow2(mm, q, i);
 
-  while (r < c) {
-    i = *r;
-    *r++ = *c;
-    *c-- = (char)i;
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      int l = FLOAT_POW5_INV_BITCOUNT + pow5bits((int)q - 1) - 1;
+      last_removed_digit =
+        mul_pow5_inv_div_pow2(mv, q - 1, -e2 + (int)q - 1 + l) % 10;
+    }
+
+    if (q <= 9) {
+      if (mv % 5 == 0) {
+        vr_trailing_zeros = multiple_of_pow5(mv, q);
+      } else if (accept_bounds) {
+        vm_trailing_zeros = multiple_of_pow5(mm, q);
+      } else {
+        vp -= multiple_of_pow5(mp, q);
+      }
+    }
+  } else {
+    unsigned q = log10_pow5(-e2);
+    e10 = (int)q + e2;
+    int i = -e2 - (int)q;
+    int k = pow5bits(i) - FLOAT_POW5_BITCOUNT;
+    int j = (int)q - k;
+    vr = mul_pow5_div_pow2(mv, (unsigned)i, j);
+    vp = mul_pow5_div_pow2(mp, (unsigned)i, j);
+    vm = mul_pow5_div_pow2(mm, (unsigned)i, j);
+
+    if (q != 0 && (vp - 1) / 10 <= vm / 10) {
+      j = (int)q - 1 - (pow5bits(i + 1) - FLOAT_POW5_BITCOUNT);
+      last_removed_digit = mul_pow5_div_pow2(mv, (unsigned)(i + 1), j) % 10;
+    }
+
+    if (q <= 1) {
+      vr_trailing_zeros = true;
+      if (accept_bounds) {
+        vm_trailing_zeros = mm_shift == 1;
+      } else {
+        --vp;
+      }
+    } else if (q < 31) {
+      vr_trailing_zeros = multiple_of_pow2(mv, q - 1);
+    }
+  }
+
+  // drop digits while the interval still contains a shorter number
+  int removed = 0;
+  unsigned output;
+
+  if (vm_trailing_zeros || vr_trailing_zeros) {
+    while (vp / 10 > vm / 10) {
+      vm_trailing_zeros &= vm % 10 == 0;
+      vr_trailing_zeros &= last_removed_digit == 0;
+      last_removed_digit = vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+
+    if (vm_trailing_zeros) {
+      while (vm % 10 == 0) {
+        vr_trailing_zeros &= last_removed_digit == 0;
+        last_removed_digit = vr % 10;
+        vr /= 10;
+        vp /= 10;
+        vm /= 10;
+        ++removed;
+      }
+    }
+
+    // exactly halfway, round to even
+    if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+      last_removed_digit = 4;
+    }
+
+    output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros))
+      || last_removed_digit >= 5);
+  } else {
+    while (vp / 10 > vm / 10) {
+      last_removed_digit = vr % 10;
+      vr /= 10;
+      vp /= 10;
+      vm /= 10;
+      ++removed;
+    }
+
+    output = vr + (vr == vm || last_removed_digit >= 5);
   }
 
-  return number_result;
+  *out_digits = output;
+  *out_exponent = e10 + removed;
 }
 
-static char float_result[NUM_BUF_SIZE + 1];
+// Output follows the same rules as JavaScript's Number.toString: plain
+//    decimals from 1e-7 up to 1e21, exponent notation outside of that.
+//    ex: 4, -2.73, 0.001, 1e+21, 1.5e-10, nan, -inf
+int ftos_to(char* out, float f) {
+  assert(out);
+
+  unsigned bits;
+  memcpy(&bits, &f, sizeof(bits));
+
+  bool sign = bits >> 31;
+  unsigned ieee_mantissa = bits & ((1u << FLOAT_MANTISSA_BITS) - 1);
+  unsigned ieee_exponent =
+    (bits >> FLOAT_MANTISSA_BITS) & ((1u << FLOAT_EXPONENT_BITS) - 1);
+
+  char* c = out;
+
+  if (ieee_exponent == (1u << FLOAT_EXPONENT_BITS) - 1) {
+    if (ieee_mantissa) {
+      memcpy(out, "nan", 4);
+      return 3;
+    }
+    if (sign) *c++ = '-';
+    memcpy(c, "inf", 4);
+    return (int)(c - out) + 3;
+  }
+
+  // zero prints without a sign, like JavaScript's (-0).toString()
+  if (ieee_exponent == 0 && ieee_mantissa == 0) {
+    memcpy(out, "0", 2);
+    return 1;
+  }
+
+  if (sign) *c++ = '-';
+
+  unsigned digits;
+  int exponent;
+  f2d(ieee_mantissa, ieee_exponent, &digits, &exponent);
+
+  char digit_buffer[ITOS_BUFFER_SIZE];
+  int length = udigits(digits);
+  utoa_backwards(digit_buffer + length, digits);
+
+  // position of the decimal point relative to the first digit
+  int point = length + exponent;
+
+  if (length <= point && point <= 21) {
+    memcpy(c, digit_buffer, length);
+    c += length;
+    memset(c, '0', point - length);
+    c += point - length;
+  } else if (0 < point && point <= 21) {
+    memcpy(c, digit_buffer, point);
+    c += point;
+    *c++ = '.';
+    memcpy(c, digit_buffer + point, length - point);
+    c += length - point;
+  } else if (-6 < point && point <= 0) {
+    *c++ = '0';
+    *c++ = '.';
+    memset(c, '0', -point);
+    c += -point;
+    memcpy(c, digit_buffer, length);
+    c += length;
+  } else {
+    *c++ = digit_buffer[0];
+    if (length > 1) {
+      *c++ = '.';
+      memcpy(c, digit_buffer + 1, length - 1);
+      c += length - 1;
+    }
+    *c++ = 'e';
+    *c++ = point - 1 < 0 ? '-' : '+';
+    c += itos_to(c, abs(point - 1));
+    return (int)(c - out);
+  }
+
+  *c = '\0';
+  return (int)(c - out);
+}
 
-#define FLOAT_PRECISION 100000
 const char* ftos(float f) {
-  uint i = 0;
-  const char* integer_part = itos((int)f);
-  if (f < 0) f *= -1;
+  static UTIL_THREAD_LOCAL char result[FTOS_BUFFER_SIZE];
+  ftos_to(result, f);
+  return result;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Reversal and byte swapping
+////////////////////////////////////////////////////////////////////////////////
+
+#ifdef UTIL_SSSE3
 
-  while (integer_part[i]) {
-    float_result[i] = integer_part[i];
-    ++i;
+// Shuffle masks for one 16-byte block: reversing the order of 1, 2, 4, 8 or
+//    16 byte elements, and swapping the bytes within 2, 4 or 8 byte elements
+#define REV_MASK(E, I) (((16 / (E)) - 1 - (I) / (E)) * (E) + (I) % (E))
+#define REV_MASK_16(E) {                                                      \
+  REV_MASK(E, 0),  REV_MASK(E, 1),  REV_MASK(E, 2),  REV_MASK(E, 3),          \
+  REV_MASK(E, 4),  REV_MASK(E, 5),  REV_MASK(E, 6),  REV_MASK(E, 7),          \
+  REV_MASK(E, 8),  REV_MASK(E, 9),  REV_MASK(E, 10), REV_MASK(E, 11),         \
+  REV_MASK(E, 12), REV_MASK(E, 13), REV_MASK(E, 14), REV_MASK(E, 15) }        //
+
+#define SWAP_MASK(E, I) ((I) / (E) * (E) + (E) - 1 - (I) % (E))
+#define SWAP_MASK_16(E) {                                                     \
+  SWAP_MASK(E, 0),  SWAP_MASK(E, 1),  SWAP_MASK(E, 2),  SWAP_MASK(E, 3),      \
+  SWAP_MASK(E, 4),  SWAP_MASK(E, 5),  SWAP_MASK(E, 6),  SWAP_MASK(E, 7),      \
+  SWAP_MASK(E, 8),  SWAP_MASK(E, 9),  SWAP_MASK(E, 10), SWAP_MASK(E, 11),     \
+  SWAP_MASK(E, 12), SWAP_MASK(E, 13), SWAP_MASK(E, 14), SWAP_MASK(E, 15) }    //
+
+// Indexed by log2 of the element size
+static const byte rev_masks[5][16] = {
+  REV_MASK_16(1), REV_MASK_16(2), REV_MASK_16(4), REV_MASK_16(8),
+  REV_MASK_16(16),
+};
+
+static const byte swap_masks[4][16] = {
+  { 0 }, SWAP_MASK_16(2), SWAP_MASK_16(4), SWAP_MASK_16(8),
+};
+
+// Swaps blocks from both ends inwards, reversing the elements inside each
+//    block with a shuffle, until less than two blocks are left in the middle.
+//    Elements are 1 to 16 bytes, so a block always holds whole elements.
+static void rev_blocks(byte** lo_ptr, byte** hi_ptr, int log2_size) {
+  byte* lo = *lo_ptr;
+  byte* hi = *hi_ptr;
+
+#ifdef UTIL_AVX2
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)rev_masks[log2_size])
+    );
+    while (hi - lo >= 64) {
+      __m256i a = _mm256_loadu_si256((const __m256i*)lo);
+      __m256i b = _mm256_loadu_si256((const __m256i*)(hi - 32));
+      a = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(a, mask), 0x4E);
+      b = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(b, mask), 0x4E);
+      _mm256_storeu_si256((__m256i*)lo, b);
+      _mm256_storeu_si256((__m256i*)(hi - 32), a);
+      lo += 32;
+      hi -= 32;
+    }
+  }
+#endif
+
+  {
+    const __m128i mask = _mm_loadu_si128((const __m128i*)rev_masks[log2_size]);
+    while (hi - lo >= 32) {
+      __m128i a = _mm_loadu_si128((const __m128i*)lo);
+      __m128i b = _mm_loadu_si128((const __m128i*)(hi - 16));
+      _mm_storeu_si128((__m128i*)lo, _mm_shuffle_epi8(b, mask));
+      _mm_storeu_si128((__m128i*)(hi - 16), _mm_shuffle_epi8(a, mask));
+      lo += 16;
+      hi -= 16;
+    }
   }
-  float_result[i] = '\0';
 
-  uint decimal = (uint)(f * FLOAT_PRECISION) % FLOAT_PRECISION;
-  if (!decimal) return float_result;
+  *lo_ptr = lo;
+  *hi_ptr = hi;
+}
 
-  float_result[i++] = '.';
+// Swaps the bytes of each 2, 4 or 8 byte element in the blocks at the start
+//    of a buffer, and returns the number of elements done
+static index_s swap_blocks(void* p, index_s count, int log2_size) {
+  index_s i = 0;
+  byte* data = p;
+  index_s per_block = 16 >> log2_size;
 
-  const char* decimal_part = itos(decimal);
-  uint j = 0;
+#ifdef UTIL_AVX2
+  {
+    const __m256i mask = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128((const __m128i*)swap_masks[log2_size])
+    );
+    for (; i + 2 * per_block <= count; i += 2 * per_block) {
+      __m256i* at = (__m256i*)(data + (i << log2_size));
+      _mm256_storeu_si256(at, _mm256_shuffle_epi8(_mm256_loadu_si256(at), mask));
+    }
+  }
+#endif
 
-  while (decimal_part[j]) {
-    float_result[i++] = decimal_part[j++];
+  {
+    const __m128i mask = _mm_loadu_si128((const __m128i*)swap_masks[log2_size]);
+    for (; i + per_block <= count; i += per_block) {
+      __m128i* at = (__m128i*)(data + (i << log2_size));
+      _mm_storeu_si128(at, _mm_shuffle_epi8(_mm_loadu_si128(at), mask));
+    }
   }
 
-  do {
-    float_result[i--] = '\0';
-  } while (float_result[i] == '0');
+  return i;
+}
+
+#else
+
+// Without shuffles everything goes through the scalar loops
+static inline void rev_blocks(byte** lo_ptr, byte** hi_ptr, int log2_size) {
+  PARAM_UNUSED(lo_ptr);
+  PARAM_UNUSED(hi_ptr);
+  PARAM_UNUSED(log2_size);
+}
+
+static inline index_s swap_blocks(void* p, index_s count, int log2_size) {
+  PARAM_UNUSED(p);
+  PARAM_UNUSED(count);
+  PARAM_UNUSED(log2_size);
+  return 0;
+}
+
+#endif
+
+static inline int log2_element(index_s element_size) {
+  switch (element_size) {
+    case 1:  return 0;
+    case 2:  return 1;
+    case 4:  return 2;
+    case 8:  return 3;
+    case 16: return 4;
+    default: return -1;
+  }
+}
 
-  return float_result;
+static void swap_bytes(byte* a, byte* b, index_s size) {
+  byte tmp[64];
+  while (size > 0) {
+    index_s n = MIN(size, (index_s)sizeof(tmp));
+    memcpy(tmp, a, n);
+    memcpy(a, b, n);
+    memcpy(b, tmp, n);
+    a += n;
+    b += n;
+    size -= n;
+  }
 }
 
+// \brief Reverses the bytes of a buffer in place.
 void memrev(void* p, unsigned size) {
-  byte* s = p;
-  byte* e = s + size - 1;
-  while (s < e) {
-    byte t = *s;
-    *s++ = *e;
-    *e-- = t;
+  byte* lo = p;
+  byte* hi = lo + size;
+
+  rev_blocks(&lo, &hi, 0);
+
+  while (hi - lo >= 16) {
+    unsigned long long a, b;
+    memcpy(&a, lo, 8);
+    memcpy(&b, hi - 8, 8);
+    a = bswap64(a);
+    b = bswap64(b);
+    memcpy(lo, &b, 8);
+    memcpy(hi - 8, &a, 8);
+    lo += 8;
+    hi -= 8;
+  }
+
+  while (lo + 1 < hi) {
+    byte t = *lo;
+    *lo++ = *--hi;
+    *hi = t;
+  }
+}
+
+// \brief Reverses the order of count elements in place, element_size bytes
+//    each.
+void memrev_elements(void* p, index_s element_size, index_s count) {
+  assert(element_size > 0 && count >= 0);
+  if (element_size == 1) {
+    memrev(p, (unsigned)count);
+    return;
+  }
+
+  byte* lo = p;
+  byte* hi = lo + element_size * count;
+
+  int log2_size = log2_element(element_size);
+  if (log2_size >= 0) rev_blocks(&lo, &hi, log2_size);
+
+  while (hi - lo >= 2 * element_size) {
+    hi -= element_size;
+    swap_bytes(lo, hi, element_size);
+    lo += element_size;
+  }
+}
+
+void bswap16_s(u16* p, index_s count) {
+  assert(p || !count);
+  for (index_s i = swap_blocks(p, count, 1); i < count; ++i) {
+    p[i] = bswap16(p[i]);
+  }
+}
+
+void bswap32_s(uint* p, index_s count) {
+  assert(p || !count);
+  for (index_s i = swap_blocks(p, count, 2); i < count; ++i) {
+    p[i] = bswap32(p[i]);
+  }
+}
+
+void bswap64_s(unsigned long long* p, index_s count) {
+  assert(p || !count);
+  for (index_s i = swap_blocks(p, count, 3); i < count; ++i) {
+    p[i] = bswap64(p[i]);
+  }
+}
+
+// Floats are swapped as raw bits, a swapped float isn't a meaningful value
+void bswapf_s(float* p, index_s count) {
+  assert(p || !count);
+  index_s i = swap_blocks(p, count, 2);
+  for (; i < count; ++i) {
+    uint bits;
+    memcpy(&bits, p + i, sizeof(bits));
+    bits = bswap32(bits);
+    memcpy(p + i, &bits, sizeof(bits));
   }
 }
@@ -23,96 +23,10 @@
 */
 
 #include "vec.h"
+#include "vec_inline.h" // no-op with MCLIB_INLINE_MATH
 
 #include <math.h>
 
-// Based on community post from:
-// https://community.khronos.org/t/quaternion-functions-for-glsl/50140/2
-vec3 qtransform(quat q, vec3 v) {
-  return v3add(
-    v, v3scale(
-      v3cross(
-        v3add(v3cross(v, q.ijk), v3scale(v, q.w)),
-        q.ijk
-      )
-    , 2)
-  );
-  //return v + 2.0*cross(cross(v, q.xyz ) + q.w*v, q.xyz);
-}
-
-vec3b v3b(byte r, byte g, byte b) {
-  return (vec3b){.i={r, g, b}};
-}
-
-vec4b v4b(byte r, byte g, byte b, byte a) {
-  return (vec4b){.i={r, g, b, a}};
-}
-
-float i2aspect(vec2i v) {
-  return (float)v.w / (float)v.h;
-}
-
-vec2i v2i(int x, int y) {
-  return (vec2i){.i={x, y}};
-}
-
-vec3i v3i(int x, int y, int z) {
-  return (vec3i){.i={x, y, z}};
-}
-
-float v2mag(vec2 v) {
-  return sqrtf(v2magsq(v));
-}
-
-float v2magsq(vec2 v) {
-  return v.x * v.x + v.y * v.y;
-}
-
-float v2dist(vec2 P, vec2 Q) {
-  return sqrtf(v2distsq(P, Q));
-}
-
-float v2distsq(vec2 P, vec2 Q) {
-  return v2magsq(v2sub(Q, P));
-}
-
-vec2 v2norm(vec2 v) {
-  float mag = v2mag(v);
-  return v2f(v.x / mag, v.y / mag);
-}
-
-vec2 v2neg(vec2 v) {
-  return v2f(-v.x, -v.y);
-}
-
-vec2 v2add(vec2 a, vec2 b) {
-  return v2f(a.x + b.x, a.y + b.y);
-}
-
-vec2 v2sub(vec2 a, vec2 b) {
-  return v2f(a.x - b.x, a.y - b.y);
-}
-
-vec2 v2scale(vec2 v, float f) {
-  return v2f(v.x * f, v.y * f);
-}
-
-float v2dot(vec2 a, vec2 b) {
-  return a.x * b.x + a.y * b.y;
-}
-
-vec2 v2had(vec2 a, vec2 b) {
-  return v2f(a.x * b.x, a.y * b.y);
-}
-
-float v2cross(vec2 a, vec2 b) {
-  return a.x * b.y - a.y * b.x;
-}
-
-vec2 v2perp(vec2 v) {
-  return v2f(-v.y, v.x);
-}
-
 vec2 v2reflect(vec2 v, vec2 mirror) {
   float t = v2dot(v, v2norm(mirror)) * v2mag(mirror);
   vec2 P = v2scale(mirror, t);
@@ -138,11 +52,6 @@ vec2 v2rot(vec2 v, float theta) {
   return v2f( cost * v.x - sint * v.y, sint * v.x + cost * v.y );
 }
 
-vec2 v2lerp(vec2 P, vec2 Q, float t) {
-  vec2 v = v2scale(v2sub(Q, P), t);
-  return v2add(P, v);
-}
-
 float v2line_dist(vec2 P, vec2 v, vec2 Q) {
   return v2cross(v2sub(Q, P), v) / v2mag(v);
 }
@@ -205,79 +114,6 @@ bool v2seg_seg(vec2 P1, vec2 P2, vec2 Q1, vec2 Q2, vec2* out) {
   return TRUE;
 }
 
-vec2 v2f(float x, float y) {
-  return (vec2){.f = {x, y} };
-}
-
-vec3 v23(vec2 v) {
-  return v3f(v.x, v.y, 0);
-}
-
-vec4 v24(vec2 v) {
-  return v4f(v.x, v.y, 0, 0);
-}
-
-vec4 p24(vec2 v) {
-  return v4f(v.x, v.y, 0, 1);
-}
-
-vec3 v23f(vec2 v, float z) {
-  return v3f(v.x, v.y, z);
-}
-
-vec4 v24f(vec2 v, float z, float w) {
-  return v4f(v.x, v.y, z, w);
-}
-
-vec4 p24f(vec2 v, float z) {
-  return v4f(v.x, v.y, z, 1);
-}
-
-float v3mag(vec3 v) {
-  return sqrtf(v3magsq(v));
-}
-
-float v3magsq(vec3 v) {
-  return v.x * v.x + v.y * v.y + v.z * v.z;
-}
-
-vec3 v3norm(vec3 v) {
-  float mag = v3mag(v);
-  return v3f( v.x / mag, v.y / mag, v.z / mag );
-}
-
-vec3 v3neg(vec3 v) {
-  return v3f( -v.x, -v.y, -v.z );
-}
-
-vec3 v3add(vec3 a, vec3 b) {
-  return v3f( a.x + b.x, a.y + b.y, a.z + b.z );
-}
-
-vec3 v3sub(vec3 a, vec3 b) {
-  return v3f( a.x - b.x, a.y - b.y, a.z - b.z );
-}
-
-vec3 v3scale(vec3 a, float f) {
-  return v3f( a.x * f, a.y * f, a.z * f );
-}
-
-float v3dot(vec3 a, vec3 b) {
-  return a.x * b.x + a.y * b.y + a.z * b.z;
-}
-
-vec3  v3had(vec3 a, vec3 b) {
-  return v3f( a.x * b.x, a.y * b.y, a.z * b.z );
-}
-
-vec3 v3cross(vec3 a, vec3 b) {
-  return v3f(
-    a.y * b.z - a.z * b.y,
-    a.z * b.x - a.x * b.z,
-    a.x * b.y - a.y * b.x
-  );
-}
-
 // Gets an arbitrary vector that's perpendicular to v
 //
 // From Ken Whatmough's post on
@@ -328,30 +164,3 @@ bool v3ray_plane(vec3 P, vec3 v, vec3 R, vec3 n, float* t_out) {
   if (t_out) *t_out = t;
   return TRUE;
 }
-
-// Constructs a vec3 out of floats.
-// Generally would prefer to use the form "(vec3){x, y, z}", but gcc is annoying
-// about that syntax, throwing -Wmissing-braces because it actaully wants the
-// form "(vec3){ .f = {x, y, z}}", which is annoying to type, so here we are.
-vec3 v3f(float x, float y, float z) {
-  return (vec3){.f = {x, y, z} };
-}
-
-// Converts a vec3 to a vec4 with homogeneous w component set to 0
-vec4 v34(vec3 v) {
-  return v4f(v.x, v.y, v.z, 0);
-}
-
-// Converts a vec3 to a vec4 with homogeneous w component set to 1
-vec4 p34(vec3 p) {
-  return v4f(p.x, p.y, p.z, 1);
-}
-
-// Converts a vec3 and a given float w to a vec4
-vec4 v34f(vec3 v, float w) {
-  return v4f(v.x, v.y, v.z, w);
-}
-
-vec4 v4f(float x, float y, float z, float w) {
-  return (vec4){ .f = {x, y, z, w} };
-}
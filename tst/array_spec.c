@@ -0,0 +1,69 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#define con_type int
+#define con_prefix int
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#include "cspec.h"
+
+describe(array_remove_range) {
+  Array_int arr = arr_int_new();
+  for (int i = 0; i < 10; ++i) arr_int_push_back(arr, i);
+
+  it("removes a range from the middle") {
+    int expected[] = { 0, 1, 2, 7, 8, 9 };
+    expect(array_remove_range((Array)arr, 3, 4), == , 6);
+    expect(arr->size, == , 6);
+    expect(arr->size_bytes, == , 6 * (index_s)sizeof(int));
+    for (int i = 0; i < 6; ++i) expect(arr->arr[i], == , expected[i]);
+  }
+
+  it("removes a range from the front") {
+    expect(array_remove_range((Array)arr, 0, 8), == , 2);
+    expect(arr->arr[0], == , 8);
+    expect(arr->arr[1], == , 9);
+  }
+
+  it("truncates when the range reaches the end") {
+    expect(array_remove_range((Array)arr, 4, 100), == , 4);
+    expect(arr->size_bytes, == , 4 * (index_s)sizeof(int));
+    expect(arr->arr[3], == , 3);
+  }
+
+  it("does nothing when the range starts past the end") {
+    expect(array_remove_range((Array)arr, 10, 2), == , 10);
+    expect(arr->arr[9], == , 9);
+  }
+
+  arr_int_delete(&arr);
+
+}
+
+test_suite(tests_array) {
+  test_group(array_remove_range),
+  test_suite_end
+};
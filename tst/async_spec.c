@@ -0,0 +1,215 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "async.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define ASYNC_SPEC_FILES 24
+
+// Sizes around the 4KB buffer rounding and a few chunks long
+static const index_s async_spec_sizes[ASYNC_SPEC_FILES] = {
+  0, 1, 100, 4095, 4096, 4097, 8191, 8192, 8193, 12288, 20000, 65536,
+  100000, 3, 0, 40000, 4096 * 7 + 5, 123456, 7, 8192 * 3, 1 << 18, 9999,
+  50, 77777,
+};
+
+typedef struct {
+  char path[32];
+  char* expected;
+  index_s size;
+  bool missing;
+
+  // indexed by chunk offset or byte, so callbacks for different chunks of
+  //    the same file never write the same entry
+  char* received;
+  unsigned char* hits;        // per byte
+  unsigned char* chunks;      // per chunk offset
+  unsigned char* lasts;       // per chunk offset, chunks flagged last
+  unsigned char* bad;         // per chunk offset, chunks with wrong fields
+} AsyncSpecFile;
+
+static unsigned async_spec_state = 71;
+
+static char async_spec_byte(void) {
+  return (char)(spec_random(&async_spec_state) >> 8);
+}
+
+static void async_spec_setup(AsyncSpecFile* files) {
+  for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+    AsyncSpecFile* f = &files[i];
+    index_s size = async_spec_sizes[i];
+    *f = (AsyncSpecFile) { .size = size, .missing = i % 10 == 9 };
+    snprintf(f->path, sizeof(f->path),
+      f->missing ? "no/such/async_%d.bin" : "async_spec_%d.bin", i
+    );
+
+    f->expected = malloc(size + 1);
+    f->received = calloc(size + 1, 1);
+    f->hits = calloc(size + 1, 1);
+    f->chunks = calloc(size + 1, 1);
+    f->lasts = calloc(size + 1, 1);
+    f->bad = calloc(size + 1, 1);
+    for (index_s b = 0; b < size; ++b) f->expected[b] = async_spec_byte();
+
+    if (f->missing) continue;
+    FILE* out = fopen(f->path, "wb");
+    if (out) {
+      fwrite(f->expected, 1, (size_t)size, out);
+      fclose(out);
+    }
+  }
+}
+
+static void async_spec_cleanup(AsyncSpecFile* files) {
+  for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+    AsyncSpecFile* f = &files[i];
+    if (!f->missing) remove(f->path);
+    free(f->expected);
+    free(f->received);
+    free(f->hits);
+    free(f->chunks);
+    free(f->lasts);
+    free(f->bad);
+  }
+}
+
+static void async_spec_chunk(const AsyncChunk* chunk) {
+  AsyncSpecFile* f = chunk->data;
+  index_s offset = chunk->offset, size = chunk->contents.size;
+
+  if (offset < 0 || offset > f->size || size > f->size - offset) {
+    f->bad[0] = 1;
+    return;
+  }
+
+  ++f->chunks[offset];
+  f->lasts[offset] += chunk->last;
+  f->bad[offset] += strcmp(chunk->path, f->path) != 0
+    || chunk->error != f->missing
+    || (!f->missing && chunk->file_size != f->size)
+    || (chunk->last && offset + size != f->size && !f->missing)
+    || (!chunk->last && size == 0);
+
+  if (size) memcpy(f->received + offset, chunk->contents.begin, size);
+  for (index_s b = offset; b < offset + size; ++b) ++f->hits[b];
+}
+
+// Every byte arrived once, and exactly one chunk (or error) ended the file
+static bool async_spec_check(const AsyncSpecFile* f) {
+  int chunks = 0, lasts = 0, bad = 0;
+  for (index_s b = 0; b <= f->size; ++b) {
+    chunks += f->chunks[b];
+    lasts += f->lasts[b];
+    bad += f->bad[b];
+  }
+  if (bad || lasts != 1 || chunks < 1) return false;
+
+  if (f->missing) return chunks == 1;
+  for (index_s b = 0; b < f->size; ++b) {
+    if (f->hits[b] != 1) return false;
+  }
+  return memcmp(f->received, f->expected, (size_t)f->size) == 0;
+}
+
+static void async_spec_run(
+  JobPool pool, index_s buffer_count, index_s buffer_size, bool poll
+) {
+  AsyncSpecFile* files = malloc(sizeof(AsyncSpecFile) * ASYNC_SPEC_FILES);
+  async_spec_setup(files);
+
+  AsyncReader reader = async_reader_new(pool, buffer_count, buffer_size);
+  for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+    async_read_file(reader, files[i].path, async_spec_chunk, &files[i]);
+  }
+  expect(reader->pending, == , ASYNC_SPEC_FILES);
+
+  if (poll) {
+    while (reader->pending > 0) async_reader_poll(reader);
+  } else {
+    async_reader_wait(reader);
+  }
+  expect(reader->pending, == , 0);
+  async_reader_delete(&reader);
+  expect(reader == NULL);
+
+  for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+    expect(async_spec_check(&files[i]));
+  }
+
+  async_spec_cleanup(files);
+  free(files);
+}
+
+describe(async_reader) {
+  JobPool pool = job_pool_new(4);
+
+  it("delivers every file on the calling thread without a pool") {
+    async_spec_run(NULL, 4, 4096, false);
+  }
+
+  it("delivers every file through the pool") {
+    async_spec_run(pool, 8, 4096, false);
+    async_spec_run(pool, 3, 10000, false);
+  }
+
+  it("delivers every file with a single buffer") {
+    async_spec_run(pool, 1, 1, false);
+  }
+
+  it("makes progress when polled") {
+    async_spec_run(pool, 5, 8192, true);
+  }
+
+  it("finishes queued files when deleted") {
+    AsyncSpecFile* files = malloc(sizeof(AsyncSpecFile) * ASYNC_SPEC_FILES);
+    async_spec_setup(files);
+
+    AsyncReader reader = async_reader_new(pool, 2, 4096);
+    for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+      async_read_file(reader, files[i].path, async_spec_chunk, &files[i]);
+    }
+    async_reader_delete(&reader);
+
+    for (int i = 0; i < ASYNC_SPEC_FILES; ++i) {
+      expect(async_spec_check(&files[i]));
+    }
+    async_spec_cleanup(files);
+    free(files);
+  }
+
+  job_pool_delete(&pool);
+
+}
+
+test_suite(tests_async) {
+  test_group(async_reader),
+  test_suite_end
+};
@@ -0,0 +1,350 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "blob.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define BLOB_SPEC_PATH "blob_spec.blob"
+#define BLOB_SPEC_BAD_PATH "blob_spec_bad.blob"
+
+typedef struct {
+  int id;
+  float weight;
+  short flags[3];
+} BlobSpecItem;
+
+#define con_type BlobSpecItem
+#define con_prefix bsi
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+static const char* blob_spec_words[] = {
+  "", "alpha", "", "", "a much longer string with spaces", "x", "\t\n",
+};
+#define BLOB_SPEC_WORDS 7
+
+static unsigned blob_spec_state = 83;
+
+static unsigned blob_spec_random(unsigned range) {
+  return spec_random_below(&blob_spec_state, range);
+}
+
+static char* blob_spec_read(const char* path, size_t* out_size) {
+  FILE* file = fopen(path, "rb");
+  if (!file) return NULL;
+  fseek(file, 0, SEEK_END);
+  long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char* ret = malloc((size_t)size + 1);
+  *out_size = fread(ret, 1, (size_t)size, file);
+  fclose(file);
+  return ret;
+}
+
+static void blob_spec_write(const char* path, const char* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  if (!file) return;
+  fwrite(data, 1, size, file);
+  fclose(file);
+}
+
+// Sections: items (default alignment), bytes (1), doubles (4096), words,
+//    an empty array and an empty string table
+static bool blob_spec_write_sample(Array_BlobSpecItem items, Array bytes) {
+  FileWriter out = file_writer_open(BLOB_SPEC_PATH);
+  if (!out) return false;
+
+  double doubles[5] = { 1.5, -2.25, 1e300, 0, -0.0 };
+  StringRange words[BLOB_SPEC_WORDS];
+  for (int i = 0; i < BLOB_SPEC_WORDS; ++i) {
+    words[i] = str_range(blob_spec_words[i]);
+  }
+
+  bool ok = blob_write_array(out, (Array)items, 0)
+    && blob_write_array(out, bytes, 1)
+    && blob_write_array_s(out, doubles, sizeof(double), 5, 4096)
+    && blob_write_strings_s(out, words, BLOB_SPEC_WORDS)
+    && blob_write_array_s(out, NULL, 8, 0, 64)
+    && blob_write_strings_s(out, NULL, 0);
+  return file_writer_close(&out) && ok;
+}
+
+// A blob that opened must only ever hand out views inside the mapping
+static bool blob_spec_views_inside(BlobFile blob) {
+  const char* begin = blob->range.begin;
+  const char* end = begin + blob->range.size;
+
+  for (index_s s = 0; s < blob->section_count; ++s) {
+    Array array = blob_array(blob, s);
+    if (array) {
+      const char* data = array->arr;
+      index_s bytes = array->size * array->element_size;
+      if (array->size && (data < begin || bytes > end - data)) return false;
+    }
+
+    BlobStrings table = blob_strings(blob, s);
+    if (blob_kind(blob, s) != BLOB_STRINGS) continue;
+    for (index_s i = 0; i < table.count; ++i) {
+      StringRange str = blob_string(table, i);
+      if (str.size < 0 || str.begin < begin || str.size >= end - str.begin) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+describe(blob_checksum) {
+
+  it("matches the published XXH64 values") {
+    const char* sentence = "Nobody inspects the spammish repetition";
+    expect(blob_checksum("", 0), == , 0xEF46DB3751D8E999ull);
+    expect(blob_checksum("a", 1), == , 0xD24EC4F1A98C6E5Bull);
+    expect(blob_checksum("abc", 3), == , 0x44BC2CF5AD770999ull);
+    expect(blob_checksum(sentence, (index_s)strlen(sentence)), == ,
+      0xFBCEA83C8A378BF1ull
+    );
+  }
+
+  it("covers every tail length") {
+    // computed with a separate implementation of the reference algorithm
+    byte data[77];
+    for (int i = 0; i < 77; ++i) data[i] = (byte)(i * 7);
+    expect(blob_checksum(data, 77), == , 0xC4CE4E3AD65F6DE0ull);
+    expect(blob_checksum(data, 15), == , 0x02C53AB1E360882Full);
+    expect(blob_checksum(NULL, 0), == , 0xEF46DB3751D8E999ull);
+  }
+
+}
+
+describe(blob_round_trip) {
+  Array_BlobSpecItem items = arr_bsi_new();
+  for (int i = 0; i < 1000; ++i) {
+    BlobSpecItem item = {
+      .id = i * 31, .weight = (float)i / 8, .flags = { (short)i, -1, 7 }
+    };
+    arr_bsi_push_back(items, item);
+  }
+  Array bytes = array_new(byte);
+  for (int i = 0; i < 333; ++i) {
+    byte b = (byte)blob_spec_random(256);
+    array_write_back(bytes, &b);
+  }
+  bool written = blob_spec_write_sample(items, bytes);
+
+  it("gives back every section as written") {
+    expect(written);
+    BlobFile blob = blob_open(BLOB_SPEC_PATH);
+    expect(blob != NULL);
+    if (!blob) return;
+
+    expect(blob->section_count, == , 6);
+    expect(blob_verify(blob));
+    expect(blob_spec_views_inside(blob));
+
+    Array_BlobSpecItem got = (Array_BlobSpecItem)blob_array(blob, 0);
+    expect(got->size, == , items->size);
+    expect(memcmp(got->arr, items->arr, sizeof(BlobSpecItem) * 1000) == 0);
+
+    Array got_bytes = blob_array(blob, 1);
+    expect(got_bytes->element_size, == , 1);
+    expect(memcmp(got_bytes->arr, bytes->arr, 333) == 0);
+
+    Array doubles = blob_array(blob, 2);
+    expect(doubles->size, == , 5);
+    expect(((const double*)doubles->arr)[2] == 1e300);
+
+    BlobStrings words = blob_strings(blob, 3);
+    expect(words.count, == , BLOB_SPEC_WORDS);
+    for (int i = 0; i < BLOB_SPEC_WORDS; ++i) {
+      StringRange word = blob_string(words, i);
+      expect(word.size, == , (index_s)strlen(blob_spec_words[i]));
+      expect(strcmp(word.begin, blob_spec_words[i]) == 0);
+    }
+
+    expect(blob_array(blob, 4)->size, == , 0);
+    expect(blob_strings(blob, 5).count, == , 0);
+    blob_close(&blob);
+    expect(blob == NULL);
+  }
+
+  it("aligns each payload from the start of the file") {
+    BlobFile blob = blob_open(BLOB_SPEC_PATH);
+    expect(blob != NULL);
+    if (!blob) return;
+
+    index_s aligns[5] = { BLOB_DEFAULT_ALIGN, 1, 4096, 0, 64 };
+    for (int s = 0; s < 5; ++s) {
+      if (!aligns[s]) continue;
+      const char* data = blob_array(blob, s)->arr;
+      expect((data - blob->range.begin) % aligns[s], == , 0);
+    }
+    const long long* offsets = blob_strings(blob, 3).offsets;
+    expect(((const char*)offsets - blob->range.begin) % 8, == , 0);
+    blob_close(&blob);
+  }
+
+  it("tells the kinds apart") {
+    BlobFile blob = blob_open(BLOB_SPEC_PATH);
+    expect(blob != NULL);
+    if (!blob) return;
+
+    expect(blob_kind(blob, 0) == BLOB_ARRAY);
+    expect(blob_kind(blob, 3) == BLOB_STRINGS);
+    expect(blob_kind(blob, -1) == BLOB_NONE);
+    expect(blob_kind(blob, 6) == BLOB_NONE);
+    expect(blob_array(blob, 3) == NULL);
+    expect(blob_array(blob, 6) == NULL);
+    expect(blob_strings(blob, 0).count, == , 0);
+    expect(blob_strings(blob, 0).offsets[0], == , 0);
+    blob_close(&blob);
+  }
+
+  it("opens an empty file with no sections") {
+    blob_spec_write(BLOB_SPEC_BAD_PATH, "", 0);
+    BlobFile blob = blob_open(BLOB_SPEC_BAD_PATH);
+    expect(blob && blob->section_count == 0 && blob_verify(blob));
+    blob_close(&blob);
+    expect(blob_open("no/such/file.blob") == NULL);
+  }
+
+  remove(BLOB_SPEC_BAD_PATH);
+  remove(BLOB_SPEC_PATH);
+  array_delete(&bytes);
+  arr_bsi_delete(&items);
+
+}
+
+describe(blob_validation) {
+  Array_BlobSpecItem items = arr_bsi_new();
+  for (int i = 0; i < 20; ++i) {
+    arr_bsi_push_back(items, ((BlobSpecItem) { .id = i, .weight = 1 }));
+  }
+  Array bytes = array_new(byte);
+  for (int i = 0; i < 9; ++i) array_write_back(bytes, &(byte) { (byte)i });
+  blob_spec_write_sample(items, bytes);
+
+  size_t size = 0;
+  char* good = blob_spec_read(BLOB_SPEC_PATH, &size);
+  char* bad = malloc(size + 1);
+
+  it("rejects every truncation") {
+    expect(good != NULL);
+    for (size_t cut = 1; cut < size; ++cut) {
+      blob_spec_write(BLOB_SPEC_BAD_PATH, good, cut);
+      BlobFile blob = blob_open(BLOB_SPEC_BAD_PATH);
+
+      // cutting exactly at the end of a section's padding leaves a valid file
+      if (blob) {
+        expect(blob->section_count < 6);
+        expect(blob_verify(blob));
+      }
+      blob_close(&blob);
+    }
+  }
+
+  it("never hands out views outside the file after a corrupted byte") {
+    int rejected = 0, failed_verify = 0;
+    for (size_t at = 0; at < size; ++at) {
+      for (int change = 0; change < 3; ++change) {
+        memcpy(bad, good, size);
+        byte values[3] = { (byte)(good[at] ^ 1), 0xFF, 0x80 };
+        if ((byte)good[at] == values[change]) continue;
+        bad[at] = (char)values[change];
+
+        blob_spec_write(BLOB_SPEC_BAD_PATH, bad, size);
+        BlobFile blob = blob_open(BLOB_SPEC_BAD_PATH);
+        if (!blob) {
+          ++rejected;
+          continue;
+        }
+        expect(blob_spec_views_inside(blob));
+        failed_verify += !blob_verify(blob);
+        blob_close(&blob);
+      }
+    }
+    expect(rejected > 0 && failed_verify > 0);
+  }
+
+  it("fails verification when any payload byte changes") {
+    BlobFile blob = blob_open(BLOB_SPEC_PATH);
+    expect(blob != NULL);
+    if (!blob) return;
+    Array array = blob_array(blob, 0);
+    index_s begin = (index_s)((const char*)array->arr - blob->range.begin);
+    index_s end = begin + array->size * array->element_size;
+    blob_close(&blob);
+
+    for (index_s at = begin; at < end; at += 7) {
+      memcpy(bad, good, size);
+      bad[at] ^= 0x10;
+      blob_spec_write(BLOB_SPEC_BAD_PATH, bad, size);
+      blob = blob_open(BLOB_SPEC_BAD_PATH);
+      expect(blob != NULL);
+      expect(not blob_verify(blob));
+      blob_close(&blob);
+    }
+  }
+
+  it("rejects a string table with a bad offset in the middle") {
+    BlobFile blob = blob_open(BLOB_SPEC_PATH);
+    expect(blob != NULL);
+    if (!blob) return;
+    const long long* offsets = blob_strings(blob, 3).offsets;
+    index_s at = (index_s)((const char*)(offsets + 3) - blob->range.begin);
+    blob_close(&blob);
+
+    const long long values[3] = { -5, 1LL << 40, 0 };
+    for (int v = 0; v < 3; ++v) {
+      memcpy(bad, good, size);
+      memcpy(bad + at, &values[v], sizeof(long long));
+      blob_spec_write(BLOB_SPEC_BAD_PATH, bad, size);
+      expect(blob_open(BLOB_SPEC_BAD_PATH) == NULL);
+    }
+  }
+
+  free(bad);
+  free(good);
+  remove(BLOB_SPEC_BAD_PATH);
+  remove(BLOB_SPEC_PATH);
+  array_delete(&bytes);
+  arr_bsi_delete(&items);
+
+}
+
+test_suite(tests_blob) {
+  test_group(blob_checksum),
+  test_group(blob_round_trip),
+  test_group(blob_validation),
+  test_suite_end
+};
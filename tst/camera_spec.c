@@ -0,0 +1,327 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "camera.h"
+
+#include <math.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define CAM_SPEC_FOV 1.1f
+#define CAM_SPEC_ASPECT 1.6f
+#define CAM_SPEC_NEAR 0.5f
+#define CAM_SPEC_FAR 60.f
+
+static unsigned cam_spec_state = 53;
+
+static float cam_spec_random(float lo, float hi) {
+  return spec_random_range(&cam_spec_state, lo, hi);
+}
+
+static vec3 cam_spec_point(float extent) {
+  return v3f(cam_spec_random(-extent, extent),
+    cam_spec_random(-extent, extent), cam_spec_random(-extent, extent)
+  );
+}
+
+// Eye space coordinates from the look basis, in double precision
+static void cam_spec_eye(
+  vec3 pos, vec3 target, vec3 up, vec3 P, double eye[3]
+) {
+  double back[3] = { pos.x - target.x, pos.y - target.y, pos.z - target.z };
+  double u[3] = { up.x, up.y, up.z }, right[3], up2[3];
+  double len = sqrt(back[0] * back[0] + back[1] * back[1] + back[2] * back[2]);
+  for (int c = 0; c < 3; ++c) back[c] /= len;
+
+  for (int c = 0; c < 3; ++c) {
+    right[c] = u[(c + 1) % 3] * back[(c + 2) % 3]
+             - u[(c + 2) % 3] * back[(c + 1) % 3];
+  }
+  len = sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+  for (int c = 0; c < 3; ++c) right[c] /= len;
+
+  for (int c = 0; c < 3; ++c) {
+    up2[c] = back[(c + 1) % 3] * right[(c + 2) % 3]
+           - back[(c + 2) % 3] * right[(c + 1) % 3];
+  }
+
+  double d[3] = { P.x - pos.x, P.y - pos.y, P.z - pos.z };
+  eye[0] = d[0] * right[0] + d[1] * right[1] + d[2] * right[2];
+  eye[1] = d[0] * up2[0] + d[1] * up2[1] + d[2] * up2[2];
+  eye[2] = d[0] * back[0] + d[1] * back[1] + d[2] * back[2];
+}
+
+// How far inside the perspective frustum an eye space point is, in eye units
+//    for the depth and scaled by the depth for the sides (negative outside)
+static double cam_spec_perspective_margin(const double eye[3]) {
+  double depth = -eye[2];
+  double half_h = tan(CAM_SPEC_FOV / 2.0) * depth;
+  double half_w = half_h * CAM_SPEC_ASPECT;
+  double margin = fmin(depth - CAM_SPEC_NEAR, CAM_SPEC_FAR - depth);
+  margin = fmin(margin, half_w - fabs(eye[0]));
+  return fmin(margin, half_h - fabs(eye[1]));
+}
+
+static bool cam_spec_inside_planes(Camera cam, vec3 P) {
+  for (int i = 0; i < CAM_PLANE_COUNT; ++i) {
+    vec4 plane = cam_plane(cam, (CameraPlane)i);
+    if (v3dot(plane.xyz, P) + plane.w < 0) return false;
+  }
+  return true;
+}
+
+static bool cam_spec_m4near(mat4 a, mat4 b, float tolerance) {
+  for (int i = 0; i < 16; ++i) {
+    if (fabsf(a.f[i] - b.f[i]) > tolerance) return false;
+  }
+  return true;
+}
+
+static bool cam_spec_m4eq(mat4 a, mat4 b) {
+  for (int i = 0; i < 16; ++i) {
+    if (a.f[i] != b.f[i]) return false;
+  }
+  return true;
+}
+
+describe(cam_matrices) {
+  vec3 pos = v3f(3, 4, 5), target = v3f(-2, 1, -7), up = v3f(0.1f, 1, 0);
+  Camera cam = cam_new_perspective(
+    CAM_SPEC_FOV, CAM_SPEC_ASPECT, CAM_SPEC_NEAR, CAM_SPEC_FAR
+  );
+  cam_look(cam, pos, target, up);
+
+  it("starts at the origin looking down -z") {
+    Camera fresh = cam_new_ortho(-1, 1, 1, -1, 0, 10);
+    expect(cam_spec_m4near(cam_view(fresh), m4identity, 0));
+    cam_delete(&fresh);
+    expect(fresh == NULL);
+  }
+
+  it("maps points into the eye space of the look basis") {
+    mat4 view = cam_view(cam);
+    for (int n = 0; n < 100; ++n) {
+      vec3 P = cam_spec_point(20);
+      double eye[3];
+      cam_spec_eye(pos, target, up, P, eye);
+      vec4 got = mv4mul(view, v4f(P.x, P.y, P.z, 1));
+      for (int c = 0; c < 3; ++c) expect(fabs(got.f[c] - eye[c]) < 1e-4);
+      expect(got.w == 1.f);
+    }
+    expect(cam->pos.x == pos.x && cam->target.z == target.z);
+  }
+
+  it("uses the projection builders") {
+    expect(cam_spec_m4eq(cam_projection(cam), m4perspective(
+      CAM_SPEC_FOV, CAM_SPEC_ASPECT, CAM_SPEC_NEAR, CAM_SPEC_FAR
+    )));
+    expect(cam_spec_m4eq(cam_viewproj(cam),
+      m4mul(cam_projection(cam), cam_view(cam))
+    ));
+
+    cam_set_ortho(cam, -4, 6, 3, -2, 1, 30);
+    expect(cam_spec_m4eq(cam_projection(cam), m4ortho(-4, 6, 3, -2, 1, 30)));
+  }
+
+  it("has inverses that undo each matrix") {
+    for (int ortho = 0; ortho < 2; ++ortho) {
+      if (ortho) cam_set_ortho(cam, -4, 6, 3, -2, 1, 30);
+      expect(cam_spec_m4near(
+        m4mul(cam_view_inverse(cam), cam_view(cam)), m4identity, 1e-5f
+      ));
+      expect(cam_spec_m4near(
+        m4mul(cam_projection_inverse(cam), cam_projection(cam)),
+        m4identity, 1e-5f
+      ));
+      expect(cam_spec_m4near(
+        m4mul(cam_viewproj_inverse(cam), cam_viewproj(cam)), m4identity, 1e-4f
+      ));
+    }
+  }
+
+  cam_delete(&cam);
+
+}
+
+describe(cam_planes) {
+  vec3 pos = v3f(-1, 2, 8), target = v3f(2, -1, -3), up = v3f(0, 1, 0.2f);
+  Camera cam = cam_new_perspective(
+    CAM_SPEC_FOV, CAM_SPEC_ASPECT, CAM_SPEC_NEAR, CAM_SPEC_FAR
+  );
+  cam_look(cam, pos, target, up);
+
+  it("bound the same region as the perspective frustum") {
+    int inside = 0, checked = 0;
+    for (int n = 0; n < 20000; ++n) {
+      vec3 P = v3add(pos, cam_spec_point(70));
+      double eye[3];
+      cam_spec_eye(pos, target, up, P, eye);
+      double margin = cam_spec_perspective_margin(eye);
+      if (fabs(margin) < 1e-3) continue;
+
+      ++checked;
+      inside += margin > 0;
+      expect(cam_spec_inside_planes(cam, P) == (margin > 0));
+    }
+    expect(checked > 19000);
+    expect(inside > 200);
+
+    // the random points rarely land near the tip, so check the near plane
+    //    along the view direction
+    vec3 forward = v3norm(v3sub(target, pos));
+    for (float depth = 0.05f; depth < 1; depth += 0.1f) {
+      vec3 P = v3add(pos, v3scale(forward, depth));
+      expect(cam_spec_inside_planes(cam, P) == (depth > CAM_SPEC_NEAR));
+    }
+  }
+
+  it("bound the same box as the orthographic projection") {
+    cam_set_ortho(cam, -4, 6, 3, -2, 1, 30);
+    for (int n = 0; n < 20000; ++n) {
+      vec3 P = v3add(pos, cam_spec_point(35));
+      double eye[3];
+      cam_spec_eye(pos, target, up, P, eye);
+      double margin = fmin(fmin(eye[0] + 4, 6 - eye[0]),
+        fmin(eye[1] + 2, 3 - eye[1])
+      );
+      margin = fmin(margin, fmin(-eye[2] - 1, 30 + eye[2]));
+      if (fabs(margin) < 1e-3) continue;
+      expect(cam_spec_inside_planes(cam, P) == (margin > 0));
+    }
+  }
+
+  it("are normalized so spheres can be tested by distance") {
+    for (int i = 0; i < CAM_PLANE_COUNT; ++i) {
+      expect(fabsf(v3mag(cam_plane(cam, (CameraPlane)i).xyz) - 1) < 1e-5f);
+    }
+  }
+
+  it("never cull a sphere with a visible point") {
+    vec3 dirs[14] = {
+      v3f(1, 0, 0), v3f(-1, 0, 0), v3f(0, 1, 0), v3f(0, -1, 0),
+      v3f(0, 0, 1), v3f(0, 0, -1),
+      v3f(1, 1, 1), v3f(1, 1, -1), v3f(1, -1, 1), v3f(1, -1, -1),
+      v3f(-1, 1, 1), v3f(-1, 1, -1), v3f(-1, -1, 1), v3f(-1, -1, -1),
+    };
+    int culled = 0;
+    for (int n = 0; n < 5000; ++n) {
+      vec3 C = v3add(pos, cam_spec_point(80));
+      float radius = cam_spec_random(0.1f, 6);
+      bool any = cam_spec_inside_planes(cam, C);
+      for (int d = 0; d < 14; ++d) {
+        vec3 P = v3add(C, v3scale(v3norm(dirs[d]), radius));
+        any |= cam_spec_inside_planes(cam, P);
+      }
+      bool visible = cam_sphere_visible(cam, C, radius);
+      if (any) expect(visible);
+      culled += !visible;
+    }
+    expect(culled > 2500);
+  }
+
+  it("cull spheres behind the camera or past the far plane") {
+    vec3 forward = v3norm(v3sub(target, pos));
+    vec3 behind = v3sub(pos, v3scale(forward, 3));
+    vec3 beyond = v3add(pos, v3scale(forward, CAM_SPEC_FAR + 3));
+    expect(not cam_sphere_visible(cam, behind, 2));
+    expect(not cam_sphere_visible(cam, beyond, 2));
+    expect(cam_sphere_visible(cam, beyond, 4));
+  }
+
+  cam_delete(&cam);
+
+}
+
+describe(cam_cache) {
+  Camera cam = cam_new_perspective(
+    CAM_SPEC_FOV, CAM_SPEC_ASPECT, CAM_SPEC_NEAR, CAM_SPEC_FAR
+  );
+  Camera fresh = NULL;
+
+  it("recomputes everything after a change") {
+    cam_look(cam, v3f(1, 1, 1), v3f(0, 0, 0), v3f(0, 1, 0));
+    cam_viewproj_inverse(cam);
+    cam_plane(cam, CAM_PLANE_LEFT);
+
+    cam_look(cam, v3f(5, 2, 0), v3f(0, 1, -3), v3f(0, 1, 0));
+    cam_set_perspective(cam, 0.7f, 2, 1, 100);
+
+    fresh = cam_new_perspective(0.7f, 2, 1, 100);
+    cam_look(fresh, v3f(5, 2, 0), v3f(0, 1, -3), v3f(0, 1, 0));
+
+    expect(cam_spec_m4eq(cam_view(cam), cam_view(fresh)));
+    expect(cam_spec_m4eq(cam_view_inverse(cam), cam_view_inverse(fresh)));
+    expect(cam_spec_m4eq(cam_projection(cam), cam_projection(fresh)));
+    expect(cam_spec_m4eq(cam_viewproj(cam), cam_viewproj(fresh)));
+    expect(cam_spec_m4eq(
+      cam_viewproj_inverse(cam), cam_viewproj_inverse(fresh)
+    ));
+    for (int i = 0; i < CAM_PLANE_COUNT; ++i) {
+      vec4 a = cam_plane(cam, (CameraPlane)i);
+      vec4 b = cam_plane(fresh, (CameraPlane)i);
+      expect(a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w);
+    }
+  }
+
+  it("switches between projections") {
+    cam_viewproj(cam);
+    cam_set_ortho(cam, -1, 1, 1, -1, 0, 10);
+    expect(cam_spec_m4eq(cam_projection(cam), m4ortho(-1, 1, 1, -1, 0, 10)));
+    expect(cam_spec_m4eq(cam_viewproj(cam),
+      m4mul(m4ortho(-1, 1, 1, -1, 0, 10), cam_view(cam))
+    ));
+
+    cam_set_perspective(cam, 0.7f, 2, 1, 100);
+    expect(cam_spec_m4eq(cam_projection(cam), m4perspective(0.7f, 2, 1, 100)));
+  }
+
+  it("updates the aspect ratio") {
+    cam_set_aspect(cam, 2.5f);
+    expect(cam_spec_m4eq(cam_projection(cam),
+      m4perspective(CAM_SPEC_FOV, 2.5f, CAM_SPEC_NEAR, CAM_SPEC_FAR)
+    ));
+
+    // ortho keeps the height and the horizontal center
+    cam_set_ortho(cam, 2, 6, 3, -1, 0, 10);
+    cam_set_aspect(cam, 2);
+    expect(cam_spec_m4eq(cam_projection(cam), m4ortho(0, 8, 3, -1, 0, 10)));
+
+    cam_set_ortho(cam, 6, 2, 3, -1, 0, 10);
+    cam_set_aspect(cam, 0.5f);
+    expect(cam_spec_m4eq(cam_projection(cam), m4ortho(5, 3, 3, -1, 0, 10)));
+  }
+
+  cam_delete(&fresh);
+  cam_delete(&cam);
+
+}
+
+test_suite(tests_camera) {
+  test_group(cam_matrices),
+  test_group(cam_planes),
+  test_group(cam_cache),
+  test_suite_end
+};
@@ -0,0 +1,310 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "color.h"
+#include "pack.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+// Odd so the batch functions also run their scalar tails
+#define COLOR_SPEC_COUNT 1027
+
+// IEC 61966-2-1 in double precision, as the reference for the float versions
+static double color_spec_to_srgb(double l) {
+  return l <= 0.0031308 ? l * 12.92 : 1.055 * pow(l, 1 / 2.4) - 0.055;
+}
+
+static double color_spec_to_linear(double s) {
+  return s <= 0.04045 ? s / 12.92 : pow((s + 0.055) / 1.055, 2.4);
+}
+
+static void color_spec_fill(color4* colors, index_s count) {
+  unsigned state = 5;
+  for (index_s i = 0; i < count; ++i) {
+    for (int c = 0; c < 4; ++c) {
+      colors[i].f[c] = spec_random_range(&state, 0, 1);
+    }
+  }
+  colors[0] = v4f(0, 0, 0, 0);
+  colors[1] = v4f(1, 1, 1, 1);
+  colors[2] = v4f(0.5f, 0.25f, 1, 0);
+}
+
+describe(srgb_to_linear) {
+
+  it("matches the double precision transfer functions") {
+    for (int i = 0; i <= 10000; ++i) {
+      float x = (float)i / 10000.f;
+      expect(fabs(srgb_to_linear(x) - color_spec_to_linear(x)) < 1e-6);
+      expect(fabs(linear_to_srgb(x) - color_spec_to_srgb(x)) < 1e-6);
+    }
+  }
+
+  it("round-trips through linear_to_srgb") {
+    for (int i = 0; i <= 1000; ++i) {
+      float x = (float)i / 1000.f;
+      expect(fabsf(linear_to_srgb(srgb_to_linear(x)) - x) < 1e-5f);
+    }
+    expect(srgb_to_linear(0) == 0.f);
+    expect(linear_to_srgb(0) == 0.f);
+  }
+
+  it("keeps the fast versions within their documented error") {
+    for (int i = 0; i <= 10000; ++i) {
+      float x = (float)i / 10000.f;
+      expect(fabs(srgb_to_linear_fast(x) - color_spec_to_linear(x)) < 0.0025);
+      expect(fabs(linear_to_srgb_fast(x) - color_spec_to_srgb(x)) < 0.0125);
+    }
+    expect(linear_to_srgb_fast(-1.f) == 0.f);
+    expect(linear_to_srgb_fast(NAN) == 0.f);
+    expect(linear_to_srgb_fast(4.f) == 1.f);
+  }
+
+}
+
+describe(c4b_srgb_to_linear) {
+  color4b bytes[256];
+  for (int b = 0; b < 256; ++b) {
+    bytes[b] = (color4b){.i={ (byte)b, (byte)(255 - b), (byte)b, (byte)b }};
+  }
+
+  it("looks up the linear value of every byte") {
+    color4 linear[256];
+    c4b_srgb_to_linear(linear, bytes, 256);
+
+    for (int b = 0; b < 256; ++b) {
+      expect(fabs(linear[b].r - color_spec_to_linear(b / 255.)) < 1e-6);
+      expect(fabs(linear[b].g - color_spec_to_linear((255 - b) / 255.)) < 1e-6);
+      expect(linear[b].a == un8tof((byte)b));
+    }
+  }
+
+  it("round-trips every byte through c4_linear_to_srgb") {
+    color4 linear[256];
+    color4b back[256];
+    c4b_srgb_to_linear(linear, bytes, 256);
+    c4_linear_to_srgb(back, linear, 256);
+
+    for (int b = 0; b < 256; ++b) {
+      expect(memcmp(&back[b], &bytes[b], sizeof(color4b)) == 0);
+    }
+  }
+
+}
+
+describe(c4_linear_to_srgb) {
+
+  it("rounds to the nearest sRGB byte") {
+    color4 linear[COLOR_SPEC_COUNT];
+    color4b out[COLOR_SPEC_COUNT];
+
+    for (int pass = 0; pass < 40; ++pass) {
+      for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+        index_s step = pass * COLOR_SPEC_COUNT + i;
+        float l = (float)step / (40.f * COLOR_SPEC_COUNT);
+        // denser near zero, where the steps are smallest
+        linear[i] = v4f(l, l * l, l * l * l, l);
+      }
+      c4_linear_to_srgb(out, linear, COLOR_SPEC_COUNT);
+
+      for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+        for (int c = 0; c < 3; ++c) {
+          double s = color_spec_to_srgb(linear[i].f[c]) * 255;
+          // too close to a rounding boundary for double precision to settle
+          if (fabs(s - floor(s) - 0.5) < 1e-4) continue;
+          expect(out[i].i[c], == , (byte)floor(s + 0.5));
+        }
+        expect(out[i].a, == , ftoun8(linear[i].a));
+      }
+    }
+  }
+
+  it("clamps out of range values") {
+    color4 linear[2] = { v4f(-1, 2, NAN, -1), v4f(1, 0, 0.5f, 2) };
+    color4b out[2];
+    c4_linear_to_srgb(out, linear, 2);
+
+    expect(out[0].r, == , 0);
+    expect(out[0].g, == , 255);
+    expect(out[0].b, == , 0);
+    expect(out[0].a, == , 0);
+    expect(out[1].r, == , 255);
+    expect(out[1].a, == , 255);
+  }
+
+}
+
+describe(c4_srgb_to_linear_fast) {
+  color4 colors[COLOR_SPEC_COUNT];
+  color4 expected[COLOR_SPEC_COUNT];
+  color_spec_fill(colors, COLOR_SPEC_COUNT);
+  color_spec_fill(expected, COLOR_SPEC_COUNT);
+
+  it("matches srgb_to_linear_fast and leaves alpha alone") {
+    c4_srgb_to_linear_fast(colors, COLOR_SPEC_COUNT);
+
+    for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+      for (int c = 0; c < 3; ++c) {
+        float ref = srgb_to_linear_fast(expected[i].f[c]);
+        expect(fabsf(colors[i].f[c] - ref) <= 1e-6f);
+      }
+      expect(colors[i].a == expected[i].a);
+    }
+  }
+
+  it("matches linear_to_srgb_fast and leaves alpha alone") {
+    c4_linear_to_srgb_fast(colors, COLOR_SPEC_COUNT);
+
+    for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+      for (int c = 0; c < 3; ++c) {
+        float ref = linear_to_srgb_fast(expected[i].f[c]);
+        expect(fabsf(colors[i].f[c] - ref) <= 1e-6f);
+      }
+      expect(colors[i].a == expected[i].a);
+    }
+  }
+
+}
+
+describe(c4_premultiply) {
+  color4 colors[COLOR_SPEC_COUNT];
+  color4 expected[COLOR_SPEC_COUNT];
+  color_spec_fill(colors, COLOR_SPEC_COUNT);
+  color_spec_fill(expected, COLOR_SPEC_COUNT);
+
+  it("multiplies rgb by alpha") {
+    c4_premultiply(colors, COLOR_SPEC_COUNT);
+
+    for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+      color4 c = expected[i];
+      expect(colors[i].r == c.r * c.a);
+      expect(colors[i].g == c.g * c.a);
+      expect(colors[i].b == c.b * c.a);
+      expect(colors[i].a == c.a);
+    }
+  }
+
+  it("reverses with c4_unpremultiply, except for transparent pixels") {
+    c4_premultiply(colors, COLOR_SPEC_COUNT);
+    c4_unpremultiply(colors, COLOR_SPEC_COUNT);
+
+    for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+      for (int c = 0; c < 4; ++c) {
+        float ref = expected[i].a > 0 ? expected[i].f[c] : 0;
+        if (c == 3) ref = expected[i].a;
+        expect(fabsf(colors[i].f[c] - ref) < 1e-5f);
+      }
+    }
+    // color_spec_fill makes pixel 2 transparent
+    expect(colors[2].r == 0.f && colors[2].a == 0.f);
+  }
+
+}
+
+describe(c4b_premultiply) {
+
+  it("rounds c * a / 255 for every channel and alpha pair") {
+    // 256 pixels per alpha value, a multiple of 4 with a tail of 3 after it
+    color4b row[259];
+
+    for (uint a = 0; a < 256; ++a) {
+      for (uint c = 0; c < 259; ++c) {
+        row[c] = (color4b){.i={ (byte)c, (byte)(255 - c % 256), 7, (byte)a }};
+      }
+      c4b_premultiply(row, 259);
+
+      for (uint c = 0; c < 259; ++c) {
+        uint r = c % 256, g = 255 - c % 256;
+        expect(row[c].r, == , (byte)((r * a * 2 + 255) / 510));
+        expect(row[c].g, == , (byte)((g * a * 2 + 255) / 510));
+        expect(row[c].b, == , (byte)((7 * a * 2 + 255) / 510));
+        expect(row[c].a, == , (byte)a);
+      }
+    }
+  }
+
+  it("is undone by c4b_unpremultiply") {
+    color4b row[256];
+
+    for (uint a = 1; a < 256; ++a) {
+      for (uint c = 0; c <= a; ++c) {
+        row[c] = (color4b){.i={ (byte)c, (byte)(a - c), 0, (byte)a }};
+      }
+
+      color4b straight[256];
+      memcpy(straight, row, sizeof(color4b) * (a + 1));
+      c4b_unpremultiply(straight, a + 1);
+      c4b_premultiply(straight, a + 1);
+
+      for (uint c = 0; c <= a; ++c) {
+        expect(memcmp(&straight[c], &row[c], sizeof(color4b)) == 0);
+      }
+    }
+  }
+
+  it("leaves transparent and opaque pixels alone when unpremultiplying") {
+    color4b row[2] = { {.i={ 9, 8, 7, 0 }}, {.i={ 9, 8, 7, 255 }} };
+    c4b_unpremultiply(row, 2);
+
+    expect(row[0].r, == , 9);
+    expect(row[1].g, == , 8);
+  }
+
+}
+
+describe(c4b_to_c4) {
+  color4 colors[COLOR_SPEC_COUNT];
+  color_spec_fill(colors, COLOR_SPEC_COUNT);
+
+  it("converts without a transfer function") {
+    color4b bytes[COLOR_SPEC_COUNT];
+    color4 back[COLOR_SPEC_COUNT];
+    c4_to_c4b(bytes, colors, COLOR_SPEC_COUNT);
+    c4b_to_c4(back, bytes, COLOR_SPEC_COUNT);
+
+    for (index_s i = 0; i < COLOR_SPEC_COUNT; ++i) {
+      for (int c = 0; c < 4; ++c) {
+        expect(bytes[i].i[c], == , ftoun8(colors[i].f[c]));
+        expect(back[i].f[c] == un8tof(bytes[i].i[c]));
+      }
+    }
+  }
+
+}
+
+test_suite(tests_color) {
+  test_group(srgb_to_linear),
+  test_group(c4b_srgb_to_linear),
+  test_group(c4_linear_to_srgb),
+  test_group(c4_srgb_to_linear_fast),
+  test_group(c4_premultiply),
+  test_group(c4b_premultiply),
+  test_group(c4b_to_c4),
+  test_suite_end
+};
@@ -0,0 +1,415 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "file.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define FILE_SPEC_PATH "file_spec.txt"
+
+static unsigned file_spec_state = 61;
+
+static unsigned file_spec_random(unsigned range) {
+  return spec_random_below(&file_spec_state, range);
+}
+
+static bool file_spec_write(const char* path, const char* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  if (!file) return false;
+  bool ok = fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+// Lines of random length, with empty lines, "\r\n" endings, stray '\r's and
+//    a few lines longer than the smallest window
+static char* file_spec_text(size_t line_count, size_t* out_size) {
+  size_t capacity = line_count * 64 + (line_count / 97 + 1) * 18000;
+  size_t size = 0;
+  char* text = malloc(capacity);
+
+  for (size_t i = 0; i < line_count; ++i) {
+    size_t length = file_spec_random(8) ? file_spec_random(80) : 0;
+    if (i % 97 == 50) length = 9000 + file_spec_random(9000);
+    if (size + length + 2 > capacity) break;
+
+    for (size_t c = 0; c < length; ++c) {
+      text[size++] = file_spec_random(40) ? 'a' + (char)(c % 26) : '\r';
+    }
+    if (i % 5 == 0) text[size++] = '\r';
+    text[size++] = '\n';
+  }
+
+  *out_size = size;
+  return text;
+}
+
+// The expected lines of a file, found one character at a time
+static Array_StrR file_spec_lines(const char* text, size_t size) {
+  Array_StrR ret = arr_str_new();
+  size_t start = 0;
+  for (size_t i = 0; i < size; ++i) {
+    if (text[i] != '\n') continue;
+    size_t end = i;
+    if (end > start && text[end - 1] == '\r') --end;
+    arr_str_push_back(ret, str_range_s(text + start, (index_s)(end - start)));
+    start = i + 1;
+  }
+  if (start < size) {
+    arr_str_push_back(ret,
+      str_range_s(text + start, (index_s)(size - start))
+    );
+  }
+  return ret;
+}
+
+static bool file_spec_range_eq(StringRange a, StringRange b) {
+  return a.size == b.size && memcmp(a.begin, b.begin, (size_t)a.size) == 0;
+}
+
+// Reads every line and checks it against the expected lines and offsets
+static bool file_spec_read_all(
+  const char* text, size_t size, index_s window
+) {
+  Array_StrR expected = file_spec_lines(text, size);
+  LineReader reader = line_reader_new_window(FILE_SPEC_PATH, window);
+  if (!reader) return false;
+
+  bool ok = reader->file_size == (index_s)size;
+  StringRange line;
+  index_s n = 0;
+  while (ok && line_reader_next(reader, &line)) {
+    ok = n < expected->size
+      && file_spec_range_eq(line, expected->arr[n])
+      && reader->line_number == n + 1
+      && reader->offset == expected->arr[n].begin - text;
+    ++n;
+  }
+
+  ok = ok && n == expected->size && !line_reader_next(reader, &line);
+  line_reader_delete(&reader);
+  arr_str_delete(&expected);
+  return ok && reader == NULL;
+}
+
+describe(str_map_file) {
+
+  it("maps the whole file") {
+    size_t size;
+    char* text = file_spec_text(3000, &size);
+    expect(file_spec_write(FILE_SPEC_PATH, text, size));
+
+    MappedFile file = str_map_file(FILE_SPEC_PATH);
+    expect(file != NULL);
+    if (file) {
+      expect(file_spec_range_eq(file->range, str_range_s(text, size)));
+      str_map_advise(file, FILE_ACCESS_RANDOM);
+      str_map_advise(file, FILE_ACCESS_WILLNEED);
+      expect(file->range.begin[size - 1] == '\n');
+    }
+    str_unmap_file(&file);
+    expect(file == NULL);
+    free(text);
+  }
+
+  it("gives an empty range for an empty file") {
+    expect(file_spec_write(FILE_SPEC_PATH, "", 0));
+    MappedFile file = str_map_file(FILE_SPEC_PATH);
+    expect(file != NULL);
+    if (file) {
+      expect(file->range.size, == , 0);
+      str_map_advise(file, FILE_ACCESS_SEQUENTIAL);
+    }
+    str_unmap_file(&file);
+  }
+
+  it("fails for missing files") {
+    expect(str_map_file("no/such/file.txt") == NULL);
+  }
+
+  remove(FILE_SPEC_PATH);
+
+}
+
+describe(line_reader) {
+
+  it("reads the same lines as a plain scan through sliding windows") {
+    size_t size;
+    char* text = file_spec_text(6000, &size);
+    expect(file_spec_write(FILE_SPEC_PATH, text, size));
+
+    // the smallest window slides and grows for the long lines
+    expect(file_spec_read_all(text, size, 1));
+    expect(file_spec_read_all(text, size, 40000));
+    expect(file_spec_read_all(text, size, LINE_READER_WINDOW));
+    free(text);
+  }
+
+  it("handles the end of the file") {
+    const char* endings[] = {
+      "last", "last\n", "last\r\n", "last\n\n", "\n", "\r\n\r\n", "a\rb",
+    };
+    for (int e = 0; e < 7; ++e) {
+      size_t size = strlen(endings[e]);
+      expect(file_spec_write(FILE_SPEC_PATH, endings[e], size));
+      expect(file_spec_read_all(endings[e], size, 1));
+    }
+  }
+
+  it("reads nothing from an empty file") {
+    expect(file_spec_write(FILE_SPEC_PATH, "", 0));
+    LineReader reader = line_reader_new(FILE_SPEC_PATH);
+    StringRange line;
+    expect(reader != NULL);
+    if (reader) expect(not line_reader_next(reader, &line));
+    line_reader_delete(&reader);
+  }
+
+  it("fails for missing files") {
+    expect(line_reader_new("no/such/file.txt") == NULL);
+  }
+
+  remove(FILE_SPEC_PATH);
+
+}
+
+describe(file_reader) {
+  size_t size;
+  char* text = file_spec_text(30000, &size);
+  expect(file_spec_write(FILE_SPEC_PATH, text, size));
+  FileReader reader = file_reader_open(FILE_SPEC_PATH);
+
+  it("reads the same lines as a plain scan") {
+    Array_StrR expected = file_spec_lines(text, size);
+    expect(size > FILE_BUFFER_SIZE * 3);
+
+    StringRange line;
+    index_s n = 0;
+    while (file_read_line(reader, &line)) {
+      expect(n < expected->size);
+      if (n >= expected->size) break;
+      expect(file_spec_range_eq(line, expected->arr[n]));
+      ++n;
+
+      // just past the newline, or at the end for the last line
+      index_s end = n < expected->size
+        ? (index_s)(expected->arr[n].begin - text) : (index_s)size;
+      expect(reader->position, == , end);
+    }
+    expect(n, == , expected->size);
+    expect(not file_read_line(reader, &line));
+    arr_str_delete(&expected);
+  }
+
+  it("splits on any delimiter") {
+    StringRange piece;
+    size_t start = 0;
+    for (size_t i = 0; i <= size; ++i) {
+      if (i < size && text[i] != '\r') continue;
+      if (i == size && start == size) break;
+
+      expect(file_read_until(reader, '\r', &piece));
+      expect(file_spec_range_eq(piece,
+        str_range_s(text + start, (index_s)(i - start))
+      ));
+      start = i + 1;
+    }
+    expect(not file_read_until(reader, '\r', &piece));
+  }
+
+  it("reads exact counts across the buffer and beyond its size") {
+    StringRange chunk;
+    size_t read = 0;
+    while (read < size) {
+      size_t count = file_spec_random(4) ? file_spec_random(5000)
+        : FILE_BUFFER_SIZE + file_spec_random(FILE_BUFFER_SIZE);
+      if (count > size - read) break;
+
+      expect(file_read_exact(reader, (index_s)count, &chunk));
+      expect(file_spec_range_eq(chunk,
+        str_range_s(text + read, (index_s)count)
+      ));
+      read += count;
+      expect(reader->position, == , (index_s)read);
+    }
+
+    // asking for more than is left consumes nothing
+    size_t left = size - read;
+    expect(not file_read_exact(reader, (index_s)left + 1, &chunk));
+    expect(reader->position, == , (index_s)read);
+    expect(file_read_exact(reader, (index_s)left, &chunk));
+    expect(file_spec_range_eq(chunk, str_range_s(text + read, (index_s)left)));
+    expect(file_read_exact(reader, 0, &chunk));
+    expect(not file_read_exact(reader, 1, &chunk));
+  }
+
+  it("grows the buffer for a line longer than it") {
+    size_t long_size = FILE_BUFFER_SIZE * 5 / 2;
+    char* long_text = malloc(long_size + 6);
+    for (size_t i = 0; i < long_size; ++i) long_text[i] = 'a' + i % 26;
+    memcpy(long_text + long_size, "\ntail", 5);
+    expect(file_spec_write(FILE_SPEC_PATH, long_text, long_size + 5));
+
+    FileReader in = file_reader_open(FILE_SPEC_PATH);
+    StringRange line;
+    expect(file_read_line(in, &line));
+    expect(file_spec_range_eq(line,
+      str_range_s(long_text, (index_s)long_size)
+    ));
+    expect(file_read_line(in, &line));
+    expect(file_spec_range_eq(line, str_range_s("tail", 4)));
+    expect(not file_read_line(in, &line));
+    file_reader_close(&in);
+    expect(in == NULL);
+    free(long_text);
+  }
+
+  it("fails for missing files") {
+    expect(file_reader_open("no/such/file.txt") == NULL);
+  }
+
+  file_reader_close(&reader);
+  remove(FILE_SPEC_PATH);
+  free(text);
+
+}
+
+describe(file_writer) {
+  FileWriter writer = file_writer_open(FILE_SPEC_PATH);
+  size_t capacity = FILE_BUFFER_SIZE * 4, size = 0;
+  char* expected = malloc(capacity);
+
+  it("writes the same bytes as the stdio formatters") {
+    size_t big_size = FILE_BUFFER_SIZE + 100;
+    char* big = malloc(big_size);
+    for (size_t i = 0; i < big_size; ++i) big[i] = 'A' + i % 26;
+
+    for (int n = 0; n < 20000; ++n) {
+      long long value = (long long)file_spec_random(60000) * 1000003 - 1000;
+      double real = value / 7.0;
+      int precision = (int)file_spec_random(8);
+      switch (n % 5) {
+        case 0:
+          file_write(writer, "text ");
+          memcpy(expected + size, "text ", 5);
+          size += 5;
+          break;
+        case 1:
+          file_write_char(writer, (char)('a' + n % 26));
+          expected[size++] = (char)('a' + n % 26);
+          break;
+        case 2:
+          file_write_int(writer, value);
+          size += snprintf(expected + size, capacity - size, "%lld", value);
+          break;
+        case 3:
+          file_write_float(writer, real, precision);
+          size += snprintf(expected + size, capacity - size, "%.*f",
+            precision, real
+          );
+          break;
+        case 4:
+          file_write_format(writer, "[{}]", n);
+          size += snprintf(expected + size, capacity - size, "[%d]", n);
+          break;
+      }
+
+      // a couple of writes too large to buffer
+      if (n == 7000 || n == 14000) {
+        file_write_range(writer, str_range_s(big, (index_s)big_size));
+        memcpy(expected + size, big, big_size);
+        size += big_size;
+      }
+    }
+
+    file_write_int(writer, -9223372036854775807LL - 1);
+    size += snprintf(expected + size, capacity - size, "%lld",
+      -9223372036854775807LL - 1
+    );
+    file_write_float(writer, 1.5, 40);
+    size += snprintf(expected + size, capacity - size, "%.20f", 1.5);
+
+    expect(writer->written, == , (index_s)size);
+    expect(file_writer_close(&writer));
+    expect(writer == NULL);
+
+    MappedFile file = str_map_file(FILE_SPEC_PATH);
+    expect(file && file_spec_range_eq(file->range,
+      str_range_s(expected, (index_s)size)
+    ));
+    str_unmap_file(&file);
+    free(big);
+  }
+
+  it("keeps earlier output when flushed") {
+    file_write(writer, "first");
+    expect(file_writer_flush(writer));
+    MappedFile file = str_map_file(FILE_SPEC_PATH);
+    expect(file && file_spec_range_eq(file->range, str_range_s("first", 5)));
+    str_unmap_file(&file);
+
+    file_write(writer, ", second");
+    expect(file_writer_close(&writer));
+    file = str_map_file(FILE_SPEC_PATH);
+    expect(file && file_spec_range_eq(file->range,
+      str_range_s("first, second", 13)
+    ));
+    str_unmap_file(&file);
+  }
+
+#ifdef __linux__
+  it("reports failed writes") {
+    FileWriter full = file_writer_open("/dev/full");
+    if (full) {
+      file_write(full, "dropped");
+      expect(not file_writer_flush(full));
+      expect(full->error);
+      file_write_char(full, 'x');
+      expect(not file_writer_close(&full));
+    }
+  }
+#endif
+
+  it("fails for paths it can't create") {
+    expect(file_writer_open("no/such/directory/file.txt") == NULL);
+  }
+
+  file_writer_close(&writer);
+  remove(FILE_SPEC_PATH);
+  free(expected);
+
+}
+
+test_suite(tests_file) {
+  test_group(str_map_file),
+  test_group(line_reader),
+  test_group(file_reader),
+  test_group(file_writer),
+  test_suite_end
+};
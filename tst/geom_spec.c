@@ -0,0 +1,428 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "geom.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+static unsigned geom_spec_state = 17;
+
+static float geom_spec_random(float lo, float hi) {
+  return spec_random_range(&geom_spec_state, lo, hi);
+}
+
+static double geom_spec_orient(vec2 A, vec2 B, vec2 C) {
+  return ((double)B.x - A.x) * ((double)C.y - A.y)
+       - ((double)B.y - A.y) * ((double)C.x - A.x);
+}
+
+// A star-shaped polygon around the origin, so it's simple but has plenty of
+// reflex vertices. Wound clockwise when cw is set.
+static Array_vec2 geom_spec_star(index_s count, bool cw) {
+  Array_vec2 ret = arr_v2_new_reserve(count);
+  for (index_s i = 0; i < count; ++i) {
+    float turn = ((float)i + geom_spec_random(0, 0.8f)) / (float)count;
+    float angle = turn * 6.2831853f;
+    float radius = geom_spec_random(10, 100);
+    if (cw) angle = -angle;
+    arr_v2_push_back(ret, v2f(cosf(angle) * radius, sinf(angle) * radius));
+  }
+  return ret;
+}
+
+static double geom_spec_area(const vec2* polygon, index_s count) {
+  double sum = 0;
+  for (index_s i = 1; i + 1 < count; ++i) {
+    sum += geom_spec_orient(polygon[0], polygon[i], polygon[i + 1]);
+  }
+  return sum / 2;
+}
+
+static double geom_spec_edge_dist(vec2 A, vec2 B, vec2 P) {
+  double dx = (double)B.x - A.x, dy = (double)B.y - A.y;
+  double len_sq = dx * dx + dy * dy;
+  double t = len_sq ? ((P.x - A.x) * dx + (P.y - A.y) * dy) / len_sq : 0;
+  t = t < 0 ? 0 : t > 1 ? 1 : t;
+  return hypot(A.x + t * dx - P.x, A.y + t * dy - P.y);
+}
+
+// Even-odd crossing test in double precision
+static bool geom_spec_contains(const vec2* polygon, index_s count, vec2 P) {
+  bool inside = false;
+  for (index_s i = 0, j = count - 1; i < count; j = i++) {
+    vec2 A = polygon[j], B = polygon[i];
+    if ((A.y > P.y) == (B.y > P.y)) continue;
+    double t = ((double)P.y - A.y) / ((double)B.y - A.y);
+    double x = A.x + t * ((double)B.x - A.x);
+    if (P.x < x) inside = !inside;
+  }
+  return inside;
+}
+
+static bool geom_spec_on_segment(vec2 A, vec2 B, vec2 P) {
+  return geom_spec_orient(A, B, P) == 0
+    && fminf(A.x, B.x) <= P.x && P.x <= fmaxf(A.x, B.x)
+    && fminf(A.y, B.y) <= P.y && P.y <= fmaxf(A.y, B.y);
+}
+
+// Closed segment intersection with exact orientation tests, including touching
+// and collinear overlaps
+static bool geom_spec_intersects(seg2 s, seg2 t) {
+  double d1 = geom_spec_orient(s.a, s.b, t.a);
+  double d2 = geom_spec_orient(s.a, s.b, t.b);
+  double d3 = geom_spec_orient(t.a, t.b, s.a);
+  double d4 = geom_spec_orient(t.a, t.b, s.b);
+  if (((d1 > 0 && d2 < 0) || (d1 < 0 && d2 > 0))
+    && ((d3 > 0 && d4 < 0) || (d3 < 0 && d4 > 0))
+  ) {
+    return true;
+  }
+  return geom_spec_on_segment(s.a, s.b, t.a)
+    || geom_spec_on_segment(s.a, s.b, t.b)
+    || geom_spec_on_segment(t.a, t.b, s.a)
+    || geom_spec_on_segment(t.a, t.b, s.b);
+}
+
+describe(geom_area) {
+
+  it("matches the fan of triangles and flips with the winding") {
+    for (int n = 0; n < 20; ++n) {
+      Array_vec2 ccw = geom_spec_star(50, false);
+      double expected = geom_spec_area(ccw->arr, ccw->size);
+      expect(expected > 0);
+      expect(fabs(geom_area(ccw) - expected) <= expected * 1e-6);
+
+      for (index_s i = 0, j = ccw->size - 1; i < j; ++i, --j) {
+        vec2 swap = ccw->arr[i];
+        ccw->arr[i] = ccw->arr[j];
+        ccw->arr[j] = swap;
+      }
+      expect(fabs(geom_area(ccw) + expected) <= expected * 1e-6);
+      arr_v2_delete(&ccw);
+    }
+  }
+
+  it("is zero for fewer than three points") {
+    vec2 line[2] = { v2f(0, 0), v2f(5, 5) };
+    expect(geom_area_s(line, 2) == 0.f);
+    expect(geom_area_s(NULL, 0) == 0.f);
+  }
+
+}
+
+describe(geom_hull) {
+  Array_vec2 points = arr_v2_new();
+  Array_vec2 hull = arr_v2_new();
+
+  it("is a strictly convex counter-clockwise polygon around every point") {
+    for (int n = 0; n < 20; ++n) {
+      arr_v2_clear(points);
+      arr_v2_clear(hull);
+      for (int i = 0; i < 300; ++i) {
+        // a coarse grid so there are duplicates and collinear points
+        vec2 P = v2f(floorf(geom_spec_random(-20, 20)),
+          floorf(geom_spec_random(-20, 20))
+        );
+        arr_v2_push_back(points, P);
+      }
+
+      index_s count = geom_hull(points, hull);
+      expect(count, == , hull->size);
+      expect(count >= 3);
+
+      for (index_s i = 0; i < count; ++i) {
+        vec2 A = hull->arr[i];
+        vec2 B = hull->arr[(i + 1) % count];
+        vec2 C = hull->arr[(i + 2) % count];
+        expect(geom_spec_orient(A, B, C) > 0);
+
+        for (index_s p = 0; p < points->size; ++p) {
+          expect(geom_spec_orient(A, B, points->arr[p]) >= 0);
+        }
+
+        bool from_input = false;
+        for (index_s p = 0; p < points->size; ++p) {
+          from_input |= points->arr[p].x == A.x && points->arr[p].y == A.y;
+        }
+        expect(from_input);
+      }
+
+      // starts from the lowest x, then lowest y
+      for (index_s p = 0; p < points->size; ++p) {
+        vec2 P = points->arr[p], S = hull->arr[0];
+        expect(S.x < P.x || (S.x == P.x && S.y <= P.y));
+      }
+    }
+  }
+
+  it("handles degenerate inputs") {
+    vec2 same[3] = { v2f(1, 2), v2f(1, 2), v2f(1, 2) };
+    expect(geom_hull_s(same, 3, hull), == , 1);
+
+    vec2 line[4] = { v2f(3, 3), v2f(0, 0), v2f(1, 1), v2f(2, 2) };
+    expect(geom_hull_s(line, 4, hull), == , 2);
+    expect(hull->arr[1].x == 0 && hull->arr[2].x == 3);
+
+    expect(geom_hull_s(NULL, 0, hull), == , 0);
+    expect(hull->size, == , 3);
+  }
+
+  arr_v2_delete(&hull);
+  arr_v2_delete(&points);
+
+}
+
+describe(geom_triangulate) {
+  Array tris = array_new(index_s);
+
+  it("covers the polygon with counter-clockwise ears") {
+    for (int n = 0; n < 40; ++n) {
+      index_s count = 3 + n * 5;
+      Array_vec2 polygon = geom_spec_star(count, n % 2 == 1);
+      double area = fabs(geom_spec_area(polygon->arr, count));
+
+      array_clear(tris);
+      index_s made = geom_triangulate(polygon, tris);
+      expect(made, == , count - 2);
+      expect(tris->size, == , made * 3);
+
+      const index_s* idx = tris->arr;
+      double sum = 0;
+      for (index_s t = 0; t < made; ++t) {
+        vec2 A = polygon->arr[idx[t * 3]];
+        vec2 B = polygon->arr[idx[t * 3 + 1]];
+        vec2 C = polygon->arr[idx[t * 3 + 2]];
+        double tri_area = geom_spec_orient(A, B, C) / 2;
+        expect(tri_area > 0);
+        sum += tri_area;
+
+        vec2 centroid = v2f((A.x + B.x + C.x) / 3, (A.y + B.y + C.y) / 3);
+        expect(geom_spec_contains(polygon->arr, count, centroid));
+      }
+
+      // ears that overlap or stick out would add up to more than the area
+      expect(fabs(sum - area) <= area * 1e-6);
+      arr_v2_delete(&polygon);
+    }
+  }
+
+  it("skips degenerate triangles from collinear vertices") {
+    vec2 square[6] = {
+      v2f(0, 0), v2f(1, 0), v2f(2, 0), v2f(2, 2), v2f(1, 2), v2f(0, 2)
+    };
+    index_s made = geom_triangulate_s(square, 6, tris);
+    expect(made <= 4);
+
+    double sum = 0;
+    const index_s* idx = tris->arr;
+    for (index_s t = 0; t < made; ++t) {
+      double tri_area = geom_spec_orient(
+        square[idx[t * 3]], square[idx[t * 3 + 1]], square[idx[t * 3 + 2]]
+      );
+      expect(tri_area > 0);
+      sum += tri_area / 2;
+    }
+    expect(sum == 4.0);
+  }
+
+  it("does nothing for fewer than three vertices") {
+    vec2 line[2] = { v2f(0, 0), v2f(1, 1) };
+    expect(geom_triangulate_s(line, 2, tris), == , 0);
+    expect(tris->size, == , 0);
+  }
+
+  array_delete(&tris);
+
+}
+
+describe(geom_contains) {
+  Array_vec2 polygon = geom_spec_star(64, false);
+  Array_vec2 points = arr_v2_new();
+  for (int i = 0; i < 4003; ++i) {
+    arr_v2_push_back(points,
+      v2f(geom_spec_random(-110, 110), geom_spec_random(-110, 110))
+    );
+  }
+  // the vertices themselves are the hardest case for the batch to agree on
+  for (index_s i = 0; i < polygon->size; ++i) {
+    arr_v2_push_back(points, polygon->arr[i]);
+  }
+
+  it("matches a double precision crossing test away from the edges") {
+    index_s checked = 0;
+    for (index_s p = 0; p < points->size; ++p) {
+      vec2 P = points->arr[p];
+      bool near_edge = false;
+      for (index_s i = 0, j = polygon->size - 1; i < polygon->size; j = i++) {
+        vec2 A = polygon->arr[j], B = polygon->arr[i];
+        near_edge |= geom_spec_edge_dist(A, B, P) < 1e-3;
+      }
+      if (near_edge) continue;
+
+      ++checked;
+      expect(geom_contains(polygon, P) ==
+        geom_spec_contains(polygon->arr, polygon->size, P)
+      );
+    }
+    expect(checked > 3900);
+  }
+
+  it("gives the same results in a batch") {
+    bool* inside = malloc(points->size);
+    geom_contains_batch(polygon, points, inside);
+
+    for (index_s p = 0; p < points->size; ++p) {
+      expect(inside[p] == geom_contains(polygon, points->arr[p]));
+    }
+    free(inside);
+  }
+
+  it("treats the polygon with the even-odd rule") {
+    // a square with a square hole, joined by a zero-width slit
+    vec2 ring[10] = {
+      v2f(0, 0), v2f(10, 0), v2f(10, 10), v2f(0, 10), v2f(0, 0),
+      v2f(3, 3), v2f(3, 7), v2f(7, 7), v2f(7, 3), v2f(3, 3),
+    };
+    expect(geom_contains_s(ring, 10, v2f(1.5f, 5.5f)));
+    expect(not geom_contains_s(ring, 10, v2f(5.5f, 5.5f)));
+    expect(not geom_contains_s(ring, 10, v2f(11.5f, 5.5f)));
+  }
+
+  arr_v2_delete(&points);
+  arr_v2_delete(&polygon);
+
+}
+
+describe(geom_intersect_all) {
+  Array_seg2 segments = arr_seg2_new();
+  Array_seg2hit hits = arr_seg2hit_new();
+
+  it("finds the same pairs as a brute-force search") {
+    for (int n = 0; n < 10; ++n) {
+      arr_seg2_clear(segments);
+      arr_seg2hit_clear(hits);
+
+      for (int i = 0; i < 150; ++i) {
+        vec2 A = v2f(geom_spec_random(0, 100), geom_spec_random(0, 100));
+        vec2 B = v2f(A.x + geom_spec_random(-30, 30),
+          A.y + geom_spec_random(-30, 30)
+        );
+        seg2 s = { .a = A, .b = B };
+        arr_seg2_push_back(segments, s);
+      }
+
+      // on a coarse grid to get shared endpoints, vertical and collinear
+      //    segments, and crossings exactly at endpoints
+      for (int i = 0; i < 100; ++i) {
+        seg2 s = { .a = v2f(floorf(geom_spec_random(0, 10)) * 10,
+          floorf(geom_spec_random(0, 10)) * 10
+        ) };
+        switch (i % 4) {
+          case 0: s.b = v2f(s.a.x, s.a.y + 20); break;
+          case 1: s.b = v2f(s.a.x + 20, s.a.y); break;
+          case 2: s.b = v2f(s.a.x + 20, s.a.y + 20); break;
+          case 3: s.b = v2f(s.a.x - 10, s.a.y + 30); break;
+        }
+        arr_seg2_push_back(segments, s);
+      }
+
+      // and a few single points
+      for (int i = 0; i < 5; ++i) {
+        vec2 P = v2f(floorf(geom_spec_random(0, 10)) * 10, 50);
+        arr_seg2_push_back(segments, ((seg2) { .a = P, .b = P }));
+      }
+
+      index_s count = segments->size;
+      bool* found = calloc(count * count, sizeof(bool));
+
+      index_s made = geom_intersect_all(segments, hits);
+      expect(made, == , hits->size);
+
+      for (index_s h = 0; h < hits->size; ++h) {
+        seg2hit hit = hits->arr[h];
+        expect(hit.a >= 0 && hit.a < hit.b && hit.b < count);
+        if (!(hit.a >= 0 && hit.a < hit.b && hit.b < count)) continue;
+
+        // each pair once
+        expect(!found[hit.a * count + hit.b]);
+        found[hit.a * count + hit.b] = true;
+
+        seg2 s = segments->arr[hit.a], t = segments->arr[hit.b];
+        expect(geom_spec_edge_dist(s.a, s.b, hit.point) < 1e-3);
+        expect(geom_spec_edge_dist(t.a, t.b, hit.point) < 1e-3);
+      }
+
+      for (index_s i = 0; i < count; ++i) {
+        for (index_s j = i + 1; j < count; ++j) {
+          bool expected = geom_spec_intersects(
+            segments->arr[i], segments->arr[j]
+          );
+          expect(found[i * count + j] == expected);
+        }
+      }
+
+      free(found);
+    }
+  }
+
+  it("reports the first shared point of collinear overlaps") {
+    seg2 overlap[2] = {
+      { .a = v2f(0, 0), .b = v2f(10, 10) },
+      { .a = v2f(12, 12), .b = v2f(4, 4) },
+    };
+    expect(geom_intersect_all_s(overlap, 2, hits), == , 1);
+    expect(hits->arr[0].a, == , 0);
+    expect(hits->arr[0].b, == , 1);
+    expect(hits->arr[0].point.x == 4.f && hits->arr[0].point.y == 4.f);
+  }
+
+  it("finds nothing for parallel or distant segments") {
+    seg2 apart[3] = {
+      { .a = v2f(0, 0), .b = v2f(10, 0) },
+      { .a = v2f(0, 1), .b = v2f(10, 1) },
+      { .a = v2f(20, 0), .b = v2f(20, 10) },
+    };
+    expect(geom_intersect_all_s(apart, 3, hits), == , 0);
+    expect(geom_intersect_all_s(NULL, 0, hits), == , 0);
+    expect(hits->size, == , 0);
+  }
+
+  arr_seg2hit_delete(&hits);
+  arr_seg2_delete(&segments);
+
+}
+
+test_suite(tests_geom) {
+  test_group(geom_area),
+  test_group(geom_hull),
+  test_group(geom_triangulate),
+  test_group(geom_contains),
+  test_group(geom_intersect_all),
+  test_suite_end
+};
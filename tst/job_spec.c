@@ -0,0 +1,222 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "job.h"
+
+#include "cspec.h"
+
+#define JOB_SPEC_COUNT 256
+
+typedef struct {
+  JobPool pool;
+  int out[JOB_SPEC_COUNT];
+  int worker[JOB_SPEC_COUNT];
+  int total;
+} JobSpecData;
+
+typedef struct {
+  JobSpecData* spec;
+  int index;
+  int* row;
+} JobSpecSlot;
+
+static void job_spec_square(void* data) {
+  JobSpecSlot* slot = data;
+  slot->spec->out[slot->index] = slot->index * slot->index;
+  slot->spec->worker[slot->index] = job_worker_index(slot->spec->pool);
+}
+
+static void job_spec_fan_out(void* data) {
+  JobSpecSlot* slots = data;
+  for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+    Job child = job_run_child(
+      slots[i].spec->pool, job_current(), job_spec_square, &slots[i]
+    );
+    job_release(&child);
+  }
+}
+
+static void job_spec_double_first(void* data) {
+  JobSpecData* spec = data;
+  spec->out[1] = spec->out[0] * 2;
+}
+
+static void job_spec_sum(void* data) {
+  JobSpecData* spec = data;
+  for (int i = 0; i < JOB_SPEC_COUNT; ++i) spec->total += spec->out[i];
+}
+
+static void job_spec_range_sizes(void* data, index_s begin, index_s end) {
+  int* sizes = data;
+  for (index_s i = begin; i < end; ++i) sizes[i] += 1;
+  sizes[JOB_SPEC_COUNT + begin] = (int)(end - begin);
+}
+
+static void job_spec_row_sum(void* data, index_s begin, index_s end) {
+  JobSpecSlot* slot = data;
+  for (index_s i = begin; i < end; ++i) slot->row[i] = slot->index * (int)i;
+}
+
+static void job_spec_nested_row(void* data) {
+  JobSpecSlot* slot = data;
+  parallel_for(slot->spec->pool, 0, 100, 10, job_spec_row_sum, slot);
+}
+
+describe(job_run) {
+  JobSpecData spec = { .pool = job_pool_new(4) };
+  JobSpecSlot slots[JOB_SPEC_COUNT];
+  for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+    slots[i] = (JobSpecSlot) { .spec = &spec, .index = i };
+  }
+
+  it("runs every job before job_wait returns") {
+    Job jobs[JOB_SPEC_COUNT];
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+      jobs[i] = job_run(spec.pool, job_spec_square, &slots[i]);
+    }
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+      job_wait(spec.pool, &jobs[i]);
+      expect(jobs[i] == NULL);
+    }
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) expect(spec.out[i], == , i * i);
+  }
+
+  it("runs jobs on workers or the waiting thread") {
+    expect(spec.pool->worker_count, == , 4);
+    expect(job_worker_index(spec.pool), == , -1);
+    expect(job_current() == NULL);
+
+    Job jobs[JOB_SPEC_COUNT];
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+      jobs[i] = job_run(spec.pool, job_spec_square, &slots[i]);
+    }
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) job_wait(spec.pool, &jobs[i]);
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+      expect(spec.worker[i] >= -1 && spec.worker[i] < 4);
+    }
+  }
+
+  it("isn't done until its children are") {
+    Job parent = job_run(spec.pool, job_spec_fan_out, slots);
+    job_wait(spec.pool, &parent);
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) expect(spec.out[i], == , i * i);
+  }
+
+  it("runs a continuation after its dependency and its children") {
+    Job parent = job_run(spec.pool, job_spec_fan_out, slots);
+    Job next = job_run_after(spec.pool, parent, job_spec_sum, &spec);
+    job_release(&parent);
+    job_wait(spec.pool, &next);
+
+    int expected = 0;
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) expected += i * i;
+    expect(spec.total, == , expected);
+  }
+
+  it("runs a continuation of a finished job right away") {
+    spec.out[0] = 21;
+    Job done = job_run(spec.pool, job_spec_square, &slots[5]);
+    while (!job_done(done)) { }
+
+    Job next = job_run_after(spec.pool, done, job_spec_double_first, &spec);
+    job_release(&done);
+    job_wait(spec.pool, &next);
+    expect(spec.out[1], == , 42);
+  }
+
+  it("runs released jobs before the pool is deleted") {
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) {
+      Job job = job_run(spec.pool, job_spec_square, &slots[i]);
+      job_release(&job);
+      expect(job == NULL);
+    }
+    job_pool_delete(&spec.pool);
+    expect(spec.pool == NULL);
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) expect(spec.out[i], == , i * i);
+  }
+
+  job_pool_delete(&spec.pool);
+
+}
+
+describe(parallel_for) {
+  JobPool pool = job_pool_new(3);
+  int sizes[JOB_SPEC_COUNT * 2] = { 0 };
+
+  it("visits every index once in pieces no larger than grain") {
+    parallel_for(pool, 0, JOB_SPEC_COUNT, 7, job_spec_range_sizes, sizes);
+
+    for (int i = 0; i < JOB_SPEC_COUNT; ++i) expect(sizes[i], == , 1);
+    for (int i = JOB_SPEC_COUNT; i < JOB_SPEC_COUNT * 2; ++i) {
+      expect(sizes[i] <= 7);
+    }
+  }
+
+  it("picks a grain when given zero") {
+    parallel_for(pool, 10, JOB_SPEC_COUNT, 0, job_spec_range_sizes, sizes);
+
+    for (int i = 0; i < 10; ++i) expect(sizes[i], == , 0);
+    for (int i = 10; i < JOB_SPEC_COUNT; ++i) expect(sizes[i], == , 1);
+  }
+
+  it("runs a small range on the calling thread") {
+    parallel_for(pool, 3, 5, 8, job_spec_range_sizes, sizes);
+
+    expect(sizes[3], == , 1);
+    expect(sizes[4], == , 1);
+    expect(sizes[JOB_SPEC_COUNT + 3], == , 2);
+  }
+
+  it("does nothing for an empty range") {
+    parallel_for(pool, 5, 5, 1, job_spec_range_sizes, sizes);
+    parallel_for(pool, 5, 2, 1, job_spec_range_sizes, sizes);
+
+    for (int i = 0; i < JOB_SPEC_COUNT * 2; ++i) expect(sizes[i], == , 0);
+  }
+
+  it("can be nested inside jobs") {
+    JobSpecData spec = { .pool = pool };
+    JobSpecSlot slots[32];
+    int rows[32][100];
+    Job jobs[32];
+    for (int i = 0; i < 32; ++i) {
+      slots[i] = (JobSpecSlot) { .spec = &spec, .index = i, .row = rows[i] };
+      jobs[i] = job_run(pool, job_spec_nested_row, &slots[i]);
+    }
+    for (int i = 0; i < 32; ++i) job_wait(pool, &jobs[i]);
+
+    for (int i = 0; i < 32; ++i) {
+      for (int j = 0; j < 100; ++j) expect(rows[i][j], == , i * j);
+    }
+  }
+
+  job_pool_delete(&pool);
+
+}
+
+test_suite(tests_job) {
+  test_group(job_run),
+  test_group(parallel_for),
+  test_suite_end
+};
@@ -0,0 +1,259 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "kdtree.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define KD_SPEC_COUNT 2000
+#define KD_SPEC_QUERIES 200
+#define KD_SPEC_K 8
+
+static float kd_spec_random(unsigned* state) {
+  return spec_random_range(state, -100, 100);
+}
+
+// Same accumulation order as the tree, so distances compare exactly
+static float kd_spec_dist_sq(const float* a, const float* b, index_s dims) {
+  float dist = 0;
+  for (index_s d = 0; d < dims; ++d) {
+    float delta = a[d] - b[d];
+    dist += delta * delta;
+  }
+  return dist;
+}
+
+static int kd_spec_float_cmp(const void* lhs, const void* rhs) {
+  float a = *(const float*)lhs, b = *(const float*)rhs;
+  return (a > b) - (a < b);
+}
+
+describe(kd_nearest) {
+  Array_vec2 points = arr_v2_new();
+  unsigned state = 1;
+  for (index_s i = 0; i < KD_SPEC_COUNT; ++i) {
+    vec2 P = { .f = { kd_spec_random(&state), kd_spec_random(&state) } };
+    // some duplicates and points on shared planes
+    if (i % 97 == 0 && i) P = points->arr[i - 1];
+    if (i % 31 == 0) P.x = 5.f;
+    arr_v2_push_back(points, P);
+  }
+
+  KdTree tree = kd_new_v2(points);
+
+  it("builds a tree over every point") {
+    expect(tree->dimensions, == , 2);
+    expect(tree->size, == , KD_SPEC_COUNT);
+  }
+
+  it("finds the same distance as a brute-force search") {
+    for (int q = 0; q < KD_SPEC_QUERIES; ++q) {
+      vec2 P = { .f = { kd_spec_random(&state), kd_spec_random(&state) } };
+
+      float best = INFINITY;
+      for (index_s i = 0; i < points->size; ++i) {
+        best = fminf(best, kd_spec_dist_sq(points->arr[i].f, P.f, 2));
+      }
+
+      float dist_sq = -1;
+      index_s index = kd_nearest_v2(tree, P, &dist_sq);
+      expect(index >= 0 && index < points->size);
+      expect(dist_sq == best);
+      expect(kd_spec_dist_sq(points->arr[index].f, P.f, 2) == best);
+    }
+  }
+
+  it("finds points exactly") {
+    for (index_s i = 0; i < points->size; i += 13) {
+      float dist_sq = -1;
+      index_s index = kd_nearest_v2(tree, points->arr[i], &dist_sq);
+      expect(dist_sq == 0.f);
+      expect(points->arr[index].x == points->arr[i].x);
+      expect(points->arr[index].y == points->arr[i].y);
+    }
+  }
+
+  it("doesn't depend on the input after construction") {
+    vec2 P = points->arr[100];
+    arr_v2_delete(&points);
+
+    float dist_sq = -1;
+    expect(kd_nearest_v2(tree, P, &dist_sq) >= 0);
+    expect(dist_sq == 0.f);
+  }
+
+  it("returns -1 for an empty tree") {
+    KdTree empty = kd_new_v2_s(NULL, 0);
+    vec2 P = { .f = { 1, 2 } };
+    expect(kd_nearest_v2(empty, P, NULL), == , -1);
+    kd_delete(&empty);
+    expect(empty == NULL);
+  }
+
+  kd_delete(&tree);
+  arr_v2_delete(&points);
+
+}
+
+describe(kd_knn) {
+  Array_vec3 points = arr_v3_new();
+  unsigned state = 2;
+  for (index_s i = 0; i < KD_SPEC_COUNT; ++i) {
+    vec3 P = { .f = {
+      kd_spec_random(&state), kd_spec_random(&state), kd_spec_random(&state)
+    } };
+    arr_v3_push_back(points, P);
+  }
+
+  KdTree tree = kd_new_v3(points);
+  float* brute = malloc(sizeof(float) * KD_SPEC_COUNT);
+
+  it("finds the k smallest distances of a brute-force search in order") {
+    for (int q = 0; q < KD_SPEC_QUERIES; ++q) {
+      vec3 P = { .f = {
+        kd_spec_random(&state), kd_spec_random(&state), kd_spec_random(&state)
+      } };
+
+      for (index_s i = 0; i < points->size; ++i) {
+        brute[i] = kd_spec_dist_sq(points->arr[i].f, P.f, 3);
+      }
+      qsort(brute, points->size, sizeof(float), kd_spec_float_cmp);
+
+      index_s indices[KD_SPEC_K];
+      float dists[KD_SPEC_K];
+      expect(kd_knn_v3(tree, P, KD_SPEC_K, indices, dists), == , KD_SPEC_K);
+
+      for (index_s i = 0; i < KD_SPEC_K; ++i) {
+        expect(dists[i] == brute[i]);
+        expect(kd_spec_dist_sq(points->arr[indices[i]].f, P.f, 3) == dists[i]);
+      }
+    }
+  }
+
+  it("finds the same points without a distance buffer, for any k") {
+    index_s ks[4] = { 1, 7, 32, 100 };
+    index_s with[100], without[100];
+    float dists[100];
+    vec3 P = { .f = { 0.25f, 0.5f, 0.75f } };
+
+    for (int i = 0; i < 4; ++i) {
+      index_s found = kd_knn_v3(tree, P, ks[i], with, dists);
+      expect(kd_knn_v3(tree, P, ks[i], without, NULL), == , found);
+      for (index_s j = 0; j < found; ++j) {
+        expect(kd_spec_dist_sq(points->arr[without[j]].f, P.f, 3) == dists[j]);
+      }
+    }
+    expect(kd_nearest_v3(tree, P, NULL), == , with[0]);
+  }
+
+  it("returns every point when k is larger than the tree") {
+    KdTree small = kd_new_v3_s(points->arr, 5);
+    index_s indices[KD_SPEC_K];
+    vec3 P = { .f = { 0, 0, 0 } };
+
+    expect(kd_knn_v3(small, P, KD_SPEC_K, indices, NULL), == , 5);
+
+    bool seen[5] = { false };
+    for (index_s i = 0; i < 5; ++i) {
+      expect(indices[i] >= 0 && indices[i] < 5);
+      if (indices[i] >= 0 && indices[i] < 5) seen[indices[i]] = true;
+    }
+    for (index_s i = 0; i < 5; ++i) expect(seen[i]);
+
+    kd_delete(&small);
+  }
+
+  free(brute);
+  kd_delete(&tree);
+  arr_v3_delete(&points);
+
+}
+
+describe(kd_radius) {
+  Array_vec3 points = arr_v3_new();
+  unsigned state = 3;
+  for (index_s i = 0; i < KD_SPEC_COUNT; ++i) {
+    vec3 P = { .f = {
+      kd_spec_random(&state), kd_spec_random(&state), kd_spec_random(&state)
+    } };
+    arr_v3_push_back(points, P);
+  }
+
+  KdTree tree = kd_new_v3(points);
+  Array out = array_new(index_s);
+  bool* found = calloc(KD_SPEC_COUNT, sizeof(bool));
+
+  it("finds the same points as a brute-force search") {
+    for (int q = 0; q < KD_SPEC_QUERIES; ++q) {
+      vec3 P = { .f = {
+        kd_spec_random(&state), kd_spec_random(&state), kd_spec_random(&state)
+      } };
+      float radius = 5.f + (float)(q % 10) * 4.f;
+
+      array_clear(out);
+      index_s count = kd_radius_v3(tree, P, radius, out);
+      expect(count, == , out->size);
+
+      for (index_s i = 0; i < KD_SPEC_COUNT; ++i) found[i] = false;
+      const index_s* indices = out->arr;
+      for (index_s i = 0; i < out->size; ++i) {
+        expect(!found[indices[i]]);
+        found[indices[i]] = true;
+      }
+
+      for (index_s i = 0; i < points->size; ++i) {
+        float dist_sq = kd_spec_dist_sq(points->arr[i].f, P.f, 3);
+        expect(found[i] == (dist_sq <= radius * radius));
+      }
+    }
+  }
+
+  it("appends to the output") {
+    index_s marker = -5;
+    array_write_back(out, &marker);
+    index_s count = kd_radius_v3(tree, points->arr[0], 1000.f, out);
+
+    expect(count, == , KD_SPEC_COUNT);
+    expect(out->size, == , KD_SPEC_COUNT + 1);
+    expect(((index_s*)out->arr)[0], == , -5);
+  }
+
+  free(found);
+  array_delete(&out);
+  kd_delete(&tree);
+  arr_v3_delete(&points);
+
+}
+
+test_suite(tests_kdtree) {
+  test_group(kd_nearest),
+  test_group(kd_knn),
+  test_group(kd_radius),
+  test_suite_end
+};
@@ -0,0 +1,284 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "memstats.h"
+
+#include <string.h>
+
+#include "array.h"
+#include "job.h"
+#include "str.h"
+
+#ifdef MCLIB_MEMSTATS
+// cspec defines free_count as a macro, so the field is read before including it
+static index_s mem_spec_frees(MemStats stats) {
+  return stats.free_count;
+}
+#endif
+
+#include "cspec.h"
+
+#define MEM_SPEC_SLOTS 256
+
+// Replays the hook events into a plain list of live blocks
+typedef struct {
+  uintptr_t addr[MEM_SPEC_SLOTS];
+  index_s size[MEM_SPEC_SLOTS];
+  index_s live_bytes, peak_bytes;
+  index_s allocs, reallocs, frees, copy_bytes;
+  bool lost;
+} MemSpecLog;
+
+static void mem_spec_add(MemSpecLog* log, uintptr_t addr, index_s size) {
+  for (int i = 0; i < MEM_SPEC_SLOTS; ++i) {
+    if (log->addr[i]) continue;
+    log->addr[i] = addr;
+    log->size[i] = size;
+    log->live_bytes += size;
+    log->peak_bytes = MAX(log->peak_bytes, log->live_bytes);
+    return;
+  }
+  log->lost = true;
+}
+
+// Returns the size of the block, or -1 for one from before the log started
+static index_s mem_spec_remove(MemSpecLog* log, uintptr_t addr) {
+  for (int i = 0; i < MEM_SPEC_SLOTS; ++i) {
+    if (log->addr[i] != addr) continue;
+    log->addr[i] = 0;
+    log->live_bytes -= log->size[i];
+    return log->size[i];
+  }
+  return -1;
+}
+
+static void mem_spec_hook(const MemEvent* event, void* user_data) {
+  MemSpecLog* log = user_data;
+  switch (event->type) {
+    case MEM_EVENT_ALLOC:
+      ++log->allocs;
+      mem_spec_add(log, (uintptr_t)event->ptr, event->size);
+      break;
+    case MEM_EVENT_REALLOC: {
+      ++log->reallocs;
+      index_s old_size = mem_spec_remove(log, event->old_addr);
+      if (old_size != event->old_size) log->lost = true;
+      if ((uintptr_t)event->ptr != event->old_addr) {
+        log->copy_bytes += MIN(event->old_size, event->size);
+      }
+      mem_spec_add(log, (uintptr_t)event->ptr, event->size);
+    } break;
+    case MEM_EVENT_FREE:
+      ++log->frees;
+      if (mem_spec_remove(log, event->old_addr) != event->old_size) {
+        log->lost = true;
+      }
+      break;
+  }
+}
+
+#ifdef MCLIB_MEMSTATS
+
+describe(memstats_counts) {
+  MemSpecLog* log = calloc(1, sizeof(MemSpecLog));
+
+  it("agree with the events reported to the hook") {
+    memstats_reset_peak();
+    MemStats before = memstats_get();
+    memstats_set_hook(mem_spec_hook, log);
+
+    Array arrays[4];
+    for (int a = 0; a < 4; ++a) arrays[a] = array_new(int);
+    for (int n = 0; n < 3000; ++n) {
+      // interleaved so some of the reallocs have to move
+      for (int a = 0; a < 4; ++a) array_write_back(arrays[a], &n);
+    }
+    array_reserve(arrays[1], 50000);
+    array_truncate(arrays[2], 10);
+    array_delete(&arrays[0]);
+
+    MemStats during = memstats_get();
+    index_s during_bytes = log->live_bytes;
+    for (int a = 1; a < 4; ++a) array_delete(&arrays[a]);
+    MemStats done = memstats_get();
+    memstats_set_hook(NULL, NULL);
+
+    expect(not log->lost);
+    expect(log->allocs > 0 && log->reallocs > 0 && log->copy_bytes > 0);
+    expect(during.live_bytes - before.live_bytes, == , during_bytes);
+    expect(done.live_bytes, == , before.live_bytes);
+    expect(done.live_count, == , before.live_count);
+    expect(done.peak_bytes - before.live_bytes, == , log->peak_bytes);
+    expect(done.alloc_count - before.alloc_count, == , log->allocs);
+    expect(done.realloc_count - before.realloc_count, == , log->reallocs);
+    expect(mem_spec_frees(done) - mem_spec_frees(before), == , log->frees);
+    expect(done.realloc_copy_bytes - before.realloc_copy_bytes, == ,
+      log->copy_bytes
+    );
+  }
+
+  it("resets the peak to what's live") {
+    Array big = array_new_reserve(int, 100000);
+    array_delete(&big);
+    MemStats stats = memstats_get();
+    expect(stats.peak_bytes >= stats.live_bytes + 400000);
+
+    memstats_reset_peak();
+    stats = memstats_get();
+    expect(stats.peak_bytes, == , stats.live_bytes);
+  }
+
+  it("stops tracking buffers handed to the caller") {
+    Array array = array_new_reserve(int, 100);
+    MemStats before = memstats_get();
+    int* data = array_release(&array);
+    MemStats after_release = memstats_get();
+
+    expect(before.live_count - after_release.live_count, == , 2);
+    expect(before.live_bytes - after_release.live_bytes >= 400);
+    expect(mem_spec_frees(after_release) - mem_spec_frees(before), == , 1);
+
+    free(data);
+    MemStats done = memstats_get();
+    expect(mem_spec_frees(done), == , mem_spec_frees(after_release));
+    expect(done.live_bytes, == , after_release.live_bytes);
+  }
+
+  free(log);
+
+}
+
+#define MEM_SPEC_JOBS 8
+
+// Lists the sites over and over, counting results that aren't in order or
+//    that list a site twice
+static void mem_spec_list_sites(void* data) {
+  int* bad = data;
+  MemSite sites[64];
+  for (int n = 0; n < 200; ++n) {
+    index_s count = memstats_sites(sites, 64);
+    for (index_s i = 1; i < count; ++i) {
+      if (sites[i - 1].live_bytes < sites[i].live_bytes) ++*bad;
+      for (index_s j = 0; j < i; ++j) {
+        if (sites[j].file == sites[i].file && sites[j].line == sites[i].line) {
+          ++*bad;
+        }
+      }
+    }
+  }
+}
+
+describe(memstats_sites) {
+
+  it("lists strings against the line that made them") {
+    String str = str_new("attributed to this line"); int line = __LINE__;
+
+    MemSite sites[64];
+    index_s count = memstats_sites(sites, 64);
+    const MemSite* found = NULL;
+    for (index_s i = 0; i < count; ++i) {
+      if (i > 0) expect(sites[i - 1].live_bytes >= sites[i].live_bytes);
+      if (sites[i].file && sites[i].line == line
+        && strcmp(sites[i].file, __FILE__) == 0
+      ) {
+        found = &sites[i];
+      }
+    }
+    expect(found != NULL);
+    if (found) {
+      expect(found->live_count > 0 && found->live_bytes > 0);
+      expect(found->alloc_count, == , found->live_count);
+    }
+
+    str_delete(&str);
+    count = memstats_sites(sites, 64);
+    for (index_s i = 0; i < count; ++i) {
+      if (sites[i].line != line || !sites[i].file) continue;
+      if (strcmp(sites[i].file, __FILE__) != 0) continue;
+      expect(sites[i].live_count, == , 0);
+      expect(sites[i].alloc_count > 0);
+    }
+  }
+
+  it("gives each of several threads listing at once its own results") {
+    String strs[16];
+    for (int i = 0; i < 16; ++i) strs[i] = str_new("spread over some sites");
+    Array array = array_new(int);
+    for (int n = 0; n < 1000; ++n) array_write_back(array, &n);
+
+    JobPool pool = job_pool_new(4);
+    Job jobs[MEM_SPEC_JOBS];
+    int bad[MEM_SPEC_JOBS] = { 0 };
+    for (int i = 0; i < MEM_SPEC_JOBS; ++i) {
+      jobs[i] = job_run(pool, mem_spec_list_sites, &bad[i]);
+    }
+    for (int i = 0; i < MEM_SPEC_JOBS; ++i) job_wait(pool, &jobs[i]);
+    job_pool_delete(&pool);
+
+    for (int i = 0; i < MEM_SPEC_JOBS; ++i) expect(bad[i], == , 0);
+
+    array_delete(&array);
+    for (int i = 0; i < 16; ++i) str_delete(&strs[i]);
+  }
+
+}
+
+#else
+
+describe(memstats_disabled) {
+  MemSpecLog* log = calloc(1, sizeof(MemSpecLog));
+
+  it("reports nothing and never calls the hook") {
+    memstats_set_hook(mem_spec_hook, log);
+    Array array = array_new(int);
+    for (int n = 0; n < 100; ++n) array_write_back(array, &n);
+    array_delete(&array);
+    String str = str_new("not tracked");
+    str_delete(&str);
+    memstats_set_hook(NULL, NULL);
+
+    expect(log->allocs + log->reallocs + log->frees, == , 0);
+
+    MemStats stats = memstats_get();
+    expect(stats.alloc_count, == , 0);
+    expect(stats.live_bytes, == , 0);
+    expect(memstats_sites((MemSite[1]) { 0 }, 1), == , 0);
+    expect(not memstats_dump_every(0));
+  }
+
+  free(log);
+
+}
+
+#endif
+
+test_suite(tests_memstats) {
+#ifdef MCLIB_MEMSTATS
+  test_group(memstats_counts),
+  test_group(memstats_sites),
+#else
+  test_group(memstats_disabled),
+#endif
+  test_suite_end
+};
@@ -0,0 +1,320 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "noise.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define NOISE_SPEC_G2 ((3 - sqrt(3.0)) / 6)
+#define NOISE_SPEC_G3 (1.0 / 6)
+
+static unsigned noise_spec_state = 41;
+
+static float noise_spec_random(float lo, float hi) {
+  return spec_random_range(&noise_spec_state, lo, hi);
+}
+
+// The gradients are all made of -1, 0 and 1, and close to a lattice point the
+//    noise is just that point's gradient dotted with the offset (scaled by the
+//    falloff for simplex noise), so a small step along each axis recovers it.
+#define NOISE_SPEC_STEP 0.01f
+
+static double noise_spec_round(double x) {
+  return floor(x + 0.5);
+}
+
+static void noise_spec_perlin2_grad(int x, int y, double g[2]) {
+  float h = NOISE_SPEC_STEP;
+  g[0] = noise_spec_round(perlin2(v2f((float)x + h, (float)y)) / h);
+  g[1] = noise_spec_round(perlin2(v2f((float)x, (float)y + h)) / h);
+}
+
+static void noise_spec_perlin3_grad(int x, int y, int z, double g[3]) {
+  float h = NOISE_SPEC_STEP;
+  vec3 P = v3f((float)x, (float)y, (float)z);
+  for (int c = 0; c < 3; ++c) {
+    vec3 Q = P;
+    Q.f[c] += h;
+    g[c] = noise_spec_round(perlin3(Q) / h);
+  }
+}
+
+static void noise_spec_simplex2_grad(int i, int j, double g[2]) {
+  double t = (i + j) * NOISE_SPEC_G2;
+  vec2 V = v2f((float)(i - t), (float)(j - t));
+  float h = NOISE_SPEC_STEP;
+  double scale = 70 * pow(0.5 - (double)h * h, 4) * h;
+  g[0] = noise_spec_round(simplex2(v2f(V.x + h, V.y)) / scale);
+  g[1] = noise_spec_round(simplex2(v2f(V.x, V.y + h)) / scale);
+}
+
+static void noise_spec_simplex3_grad(int i, int j, int k, double g[3]) {
+  double t = (i + j + k) * NOISE_SPEC_G3;
+  vec3 V = v3f((float)(i - t), (float)(j - t), (float)(k - t));
+  float h = NOISE_SPEC_STEP;
+  double scale = 32 * pow(0.6 - (double)h * h, 4) * h;
+  for (int c = 0; c < 3; ++c) {
+    vec3 Q = V;
+    Q.f[c] += h;
+    g[c] = noise_spec_round(simplex3(Q) / scale);
+  }
+}
+
+static double noise_spec_fade(double t) {
+  return t * t * t * (t * (t * 6 - 15) + 10);
+}
+
+// Interpolates the corner contributions of the cell in double precision
+static double noise_spec_perlin2(vec2 P) {
+  int x = (int)floor(P.x), y = (int)floor(P.y);
+  double fx = P.x - x, fy = P.y - y;
+  double sum = 0;
+  for (int c = 0; c < 4; ++c) {
+    int cx = c & 1, cy = c >> 1;
+    double g[2];
+    noise_spec_perlin2_grad(x + cx, y + cy, g);
+    double dot = g[0] * (fx - cx) + g[1] * (fy - cy);
+    double wx = cx ? noise_spec_fade(fx) : 1 - noise_spec_fade(fx);
+    double wy = cy ? noise_spec_fade(fy) : 1 - noise_spec_fade(fy);
+    sum += wx * wy * dot;
+  }
+  return sum;
+}
+
+static double noise_spec_perlin3(vec3 P) {
+  int base[3];
+  double f[3];
+  for (int a = 0; a < 3; ++a) {
+    base[a] = (int)floor(P.f[a]);
+    f[a] = P.f[a] - base[a];
+  }
+
+  double sum = 0;
+  for (int c = 0; c < 8; ++c) {
+    int o[3] = { c & 1, (c >> 1) & 1, c >> 2 };
+    double g[3], weight = 1, dot = 0;
+    noise_spec_perlin3_grad(base[0] + o[0], base[1] + o[1], base[2] + o[2], g);
+    for (int a = 0; a < 3; ++a) {
+      double fade = noise_spec_fade(f[a]);
+      weight *= o[a] ? fade : 1 - fade;
+      dot += g[a] * (f[a] - o[a]);
+    }
+    sum += weight * dot;
+  }
+  return sum;
+}
+
+// Sums the falloff of every nearby lattice vertex rather than picking the
+//    corners of the enclosing simplex
+static double noise_spec_simplex2(vec2 P) {
+  double s = (P.x + P.y) * (sqrt(3.0) - 1) / 2;
+  int ci = (int)floor(P.x + s), cj = (int)floor(P.y + s);
+  double sum = 0;
+  for (int i = ci - 2; i <= ci + 2; ++i) {
+    for (int j = cj - 2; j <= cj + 2; ++j) {
+      double t = (i + j) * NOISE_SPEC_G2;
+      double dx = P.x - (i - t), dy = P.y - (j - t);
+      double falloff = 0.5 - dx * dx - dy * dy;
+      if (falloff <= 0) continue;
+      double g[2];
+      noise_spec_simplex2_grad(i, j, g);
+      sum += pow(falloff, 4) * (g[0] * dx + g[1] * dy);
+    }
+  }
+  return 70 * sum;
+}
+
+// The 0.6 falloff reaches a little past the enclosing simplex, and like the
+//    reference only its four corners count, so this finds the simplex by
+//    trying each ordering of the skewed cell offsets instead
+static double noise_spec_simplex3(vec3 P) {
+  static const int orders[6][3] = {
+    { 0, 1, 2 }, { 0, 2, 1 }, { 1, 0, 2 },
+    { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 },
+  };
+
+  double s = ((double)P.x + P.y + P.z) / 3;
+  int cell[3];
+  double f[3];
+  for (int a = 0; a < 3; ++a) {
+    cell[a] = (int)floor(P.f[a] + s);
+    f[a] = P.f[a] + s - cell[a];
+  }
+
+  const int* order = orders[0];
+  for (int o = 0; o < 6; ++o) {
+    const int* next = orders[o];
+    if (f[next[0]] >= f[next[1]] && f[next[1]] >= f[next[2]]) order = next;
+  }
+
+  double sum = 0;
+  int corner[3] = { cell[0], cell[1], cell[2] };
+  for (int step = 0; step < 4; ++step) {
+    if (step) ++corner[order[step - 1]];
+    double t = (corner[0] + corner[1] + corner[2]) * NOISE_SPEC_G3;
+    double d[3], falloff = 0.6;
+    for (int a = 0; a < 3; ++a) {
+      d[a] = P.f[a] - (corner[a] - t);
+      falloff -= d[a] * d[a];
+    }
+    if (falloff <= 0) continue;
+    double g[3];
+    noise_spec_simplex3_grad(corner[0], corner[1], corner[2], g);
+    sum += pow(falloff, 4) * (g[0] * d[0] + g[1] * d[1] + g[2] * d[2]);
+  }
+  return 32 * sum;
+}
+
+describe(noise_perlin) {
+
+  it("matches the reference implementation") {
+    expect(fabsf(perlin3(v3f(3.14f, 42, 7)) - 0.136920f) < 1e-5f);
+  }
+
+  it("is zero at the lattice points") {
+    for (int x = -20; x <= 20; x += 3) {
+      for (int y = -20; y <= 20; y += 3) {
+        expect(perlin2(v2f((float)x, (float)y)) == 0.f);
+        expect(perlin3(v3f((float)x, (float)y, (float)(x - y))) == 0.f);
+      }
+    }
+  }
+
+  it("interpolates the lattice gradients") {
+    for (int n = 0; n < 300; ++n) {
+      vec2 P = v2f(noise_spec_random(-50, 50), noise_spec_random(-50, 50));
+      expect(fabs(perlin2(P) - noise_spec_perlin2(P)) < 1e-4);
+
+      vec3 Q = v3f(noise_spec_random(-50, 50), noise_spec_random(-50, 50),
+        noise_spec_random(-50, 50)
+      );
+      expect(fabs(perlin3(Q) - noise_spec_perlin3(Q)) < 1e-4);
+    }
+  }
+
+  it("repeats every 256 units") {
+    for (int n = 0; n < 200; ++n) {
+      // multiples of 1/64 so the shifted points are exact
+      vec3 P = v3f(floorf(noise_spec_random(-64, 64) * 64) / 64,
+        floorf(noise_spec_random(-64, 64) * 64) / 64,
+        floorf(noise_spec_random(-64, 64) * 64) / 64
+      );
+      expect(perlin2(P.xy) == perlin2(v2f(P.x + 256, P.y - 256)));
+      expect(perlin3(P) == perlin3(v3f(P.x - 256, P.y, P.z + 512)));
+    }
+  }
+
+}
+
+describe(noise_simplex) {
+
+  it("sums the falloff of the lattice vertices around each point") {
+    for (int n = 0; n < 300; ++n) {
+      vec2 P = v2f(noise_spec_random(-50, 50), noise_spec_random(-50, 50));
+      expect(fabs(simplex2(P) - noise_spec_simplex2(P)) < 1e-4);
+
+      vec3 Q = v3f(noise_spec_random(-50, 50), noise_spec_random(-50, 50),
+        noise_spec_random(-50, 50)
+      );
+      expect(fabs(simplex3(Q) - noise_spec_simplex3(Q)) < 1e-4);
+    }
+  }
+
+  it("stays within [-1, 1] and uses most of it") {
+    float lo = 0, hi = 0;
+    for (int n = 0; n < 20000; ++n) {
+      vec3 P = v3f(noise_spec_random(-30, 30), noise_spec_random(-30, 30),
+        noise_spec_random(-30, 30)
+      );
+      float a = simplex2(P.xy), b = simplex3(P);
+      lo = fminf(lo, fminf(a, b));
+      hi = fmaxf(hi, fmaxf(a, b));
+    }
+    expect(lo >= -1.f && lo < -0.6f);
+    expect(hi <= 1.f && hi > 0.6f);
+  }
+
+}
+
+describe(noise_batch) {
+  Array_vec2 points2 = arr_v2_new();
+  Array_vec3 points3 = arr_v3_new();
+  for (int i = 0; i < 1003; ++i) {
+    vec3 P = v3f(noise_spec_random(-300, 300), noise_spec_random(-300, 300),
+      noise_spec_random(-300, 300)
+    );
+    // and some on the lattice lines, where the floor is easy to get wrong
+    if (i % 7 == 0) P.x = floorf(P.x);
+    if (i % 11 == 0) P.y = -floorf(P.y);
+    arr_v2_push_back(points2, P.xy);
+    arr_v3_push_back(points3, P);
+  }
+  float* out = malloc(1003 * sizeof(float));
+
+  it("gives the same results as the scalar functions") {
+    perlin2_batch(points2, out);
+    for (int i = 0; i < 1003; ++i) {
+      expect(out[i] == perlin2(points2->arr[i]));
+    }
+
+    perlin3_batch(points3, out);
+    for (int i = 0; i < 1003; ++i) {
+      expect(out[i] == perlin3(points3->arr[i]));
+    }
+
+    simplex2_batch(points2, out);
+    for (int i = 0; i < 1003; ++i) {
+      expect(out[i] == simplex2(points2->arr[i]));
+    }
+
+    simplex3_batch(points3, out);
+    for (int i = 0; i < 1003; ++i) {
+      expect(out[i] == simplex3(points3->arr[i]));
+    }
+  }
+
+  it("only writes the given count") {
+    out[5] = 1234.f;
+    perlin3_batch_s(points3->arr, 5, out);
+    simplex2_batch_s(points2->arr, 5, out);
+    expect(out[5] == 1234.f);
+  }
+
+  free(out);
+  arr_v3_delete(&points3);
+  arr_v2_delete(&points2);
+
+}
+
+test_suite(tests_noise) {
+  test_group(noise_perlin),
+  test_group(noise_simplex),
+  test_group(noise_batch),
+  test_suite_end
+};
@@ -0,0 +1,320 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "pack.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+// Odd so the batch functions also run their scalar tails
+#define PACK_SPEC_COUNT 1031
+
+static uint pack_spec_bits(float f) {
+  uint u;
+  memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+static float pack_spec_float(uint u) {
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+// Spread over every exponent, both signs and the odd special value
+static void pack_spec_floats(float* out, index_s count, float scale) {
+  unsigned state = 9;
+  for (index_s i = 0; i < count; ++i) {
+    out[i] = ((float)spec_random(&state) / 16777216.f * 2.f - 1.f) * scale;
+  }
+  out[0] = 0.f;
+  out[1] = -0.f;
+  out[2] = scale;
+  out[3] = -scale;
+}
+
+describe(ftoh) {
+
+  it("converts exactly representable values") {
+    expect(ftoh(0.f), == , 0x0000);
+    expect(ftoh(-0.f), == , 0x8000);
+    expect(ftoh(1.f), == , 0x3C00);
+    expect(ftoh(-2.f), == , 0xC000);
+    expect(ftoh(65504.f), == , 0x7BFF);
+    expect(ftoh(ldexpf(1, -14)), == , 0x0400);
+    expect(ftoh(ldexpf(1, -24)), == , 0x0001);
+  }
+
+  it("handles infinity, overflow and NaN") {
+    expect(ftoh(INFINITY), == , 0x7C00);
+    expect(ftoh(-INFINITY), == , 0xFC00);
+    expect(ftoh(65520.f), == , 0x7C00);
+    expect(ftoh(1e10f), == , 0x7C00);
+
+    u16 nan = ftoh(NAN);
+    expect((nan & 0x7C00) == 0x7C00 && (nan & 0x3FF) != 0);
+  }
+
+  it("rounds halfway cases to even") {
+    // 1 + 2^-11 is halfway between 1 and the next half
+    expect(ftoh(1.f + ldexpf(1, -11)), == , 0x3C00);
+    expect(ftoh(1.f + 3 * ldexpf(1, -11)), == , 0x3C02);
+    expect(ftoh(ldexpf(1, -25)), == , 0x0000);
+    expect(ftoh(3 * ldexpf(1, -25)), == , 0x0002);
+  }
+
+  it("picks the nearest half of its neighbours") {
+    float values[PACK_SPEC_COUNT];
+    pack_spec_floats(values, PACK_SPEC_COUNT, 60000.f);
+
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      float f = values[i] * ldexpf(1, -(int)(i % 40));
+      u16 h = ftoh(f);
+      float err = fabsf(htof(h) - f);
+
+      // the halves either side of h, within the same sign
+      if ((h & 0x7FFF) != 0) expect(err <= fabsf(htof(h - 1) - f));
+      if ((h & 0x7FFF) < 0x7BFF) expect(err <= fabsf(htof(h + 1) - f));
+    }
+  }
+
+}
+
+describe(htof) {
+
+  it("round-trips every half through ftoh") {
+    for (uint h = 0; h < 0x10000; ++h) {
+      float f = htof((u16)h);
+      if (isnan(f)) {
+        expect((h & 0x7C00) == 0x7C00 && (h & 0x3FF) != 0);
+        expect(isnan(htof(ftoh(f))));
+      } else {
+        expect(ftoh(f), == , (u16)h);
+      }
+    }
+  }
+
+  it("decodes subnormals and specials") {
+    expect(htof(0x0001) == ldexpf(1, -24));
+    expect(htof(0x03FF) == ldexpf(1023, -24));
+    expect(htof(0x7C00) == INFINITY);
+    expect(htof(0xFC00) == -INFINITY);
+    expect(pack_spec_bits(htof(0x8000)), == , 0x80000000u);
+  }
+
+}
+
+describe(unorm_snorm) {
+
+  it("round-trips every 8-bit value") {
+    for (int b = 0; b < 256; ++b) {
+      expect(ftoun8(un8tof((byte)b)), == , b);
+    }
+    for (int b = -127; b < 128; ++b) {
+      expect(ftosn8(sn8tof((signed char)b)), == , b);
+    }
+    expect(sn8tof(-128) == -1.f);
+  }
+
+  it("round-trips every 16-bit value") {
+    for (int s = 0; s < 0x10000; ++s) {
+      expect(ftoun16(un16tof((u16)s)), == , s);
+    }
+    for (int s = -32767; s < 32768; ++s) {
+      expect(ftosn16(sn16tof((short)s)), == , s);
+    }
+    expect(sn16tof(-32768) == -1.f);
+  }
+
+  it("clamps out of range values") {
+    expect(ftoun8(-0.5f), == , 0);
+    expect(ftoun8(2.f), == , 255);
+    expect(ftosn8(-3.f), == , -127);
+    expect(ftosn8(3.f), == , 127);
+    expect(ftoun16(-1.f), == , 0);
+    expect(ftoun16(1.5f), == , 65535);
+    expect(ftosn16(-1.5f), == , -32767);
+    expect(ftosn16(1.5f), == , 32767);
+  }
+
+  it("rounds to the nearest step") {
+    expect(ftoun8(0.5f / 255.f + 1e-4f), == , 1);
+    expect(ftoun8(0.5f / 255.f - 1e-4f), == , 0);
+    expect(ftosn8(-1.4f / 127.f), == , -1);
+  }
+
+}
+
+describe(oct_encode) {
+  vec3 normals[PACK_SPEC_COUNT];
+  float coords[PACK_SPEC_COUNT * 3];
+  pack_spec_floats(coords, PACK_SPEC_COUNT * 3, 1.f);
+  for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+    vec3 n = v3f(coords[i * 3], coords[i * 3 + 1], coords[i * 3 + 2]);
+    normals[i] = i < 6 ? v3f(0, 0, 0) : v3norm(n);
+  }
+  normals[0] = v3f(1, 0, 0);
+  normals[1] = v3f(0, -1, 0);
+  normals[2] = v3f(0, 0, 1);
+  normals[3] = v3f(0, 0, -1);
+  normals[4] = v3norm(v3f(1, 1, -1));
+  normals[5] = v3norm(v3f(-1, 1, -1));
+
+  it("maps unit vectors into the square and back") {
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      vec2 e = oct_encode(normals[i]);
+      expect(fabsf(e.x) <= 1.f && fabsf(e.y) <= 1.f);
+      expect(v3dot(oct_decode(e), normals[i]) > 0.99999f);
+    }
+  }
+
+  it("keeps packed normals within snorm16 precision") {
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      vec3 n = oct_unpack16(oct_pack16(normals[i]));
+      expect(fabsf(v3mag(n) - 1.f) < 1e-5f);
+      expect(v3mag(v3sub(n, normals[i])) < 1e-4f);
+    }
+  }
+
+  it("packs batches like the scalar functions") {
+    uint packed[PACK_SPEC_COUNT];
+    vec3 unpacked[PACK_SPEC_COUNT];
+    pack_oct16(packed, normals, PACK_SPEC_COUNT);
+    unpack_oct16(unpacked, packed, PACK_SPEC_COUNT);
+
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(packed[i], == , oct_pack16(normals[i]));
+      vec3 n = oct_unpack16(packed[i]);
+      expect(memcmp(&unpacked[i], &n, sizeof(n)) == 0);
+    }
+  }
+
+}
+
+describe(pack_f16) {
+  float values[PACK_SPEC_COUNT];
+  pack_spec_floats(values, PACK_SPEC_COUNT, 70000.f);
+  for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+    values[i] *= ldexpf(1, -(int)(i % 48));
+  }
+  values[4] = INFINITY;
+  values[5] = -INFINITY;
+  values[6] = NAN;
+  values[7] = pack_spec_float(0x7F800001u); // signalling NaN
+
+  it("matches ftoh and htof") {
+    u16 halves[PACK_SPEC_COUNT];
+    float floats[PACK_SPEC_COUNT];
+    pack_f16(halves, values, PACK_SPEC_COUNT);
+    unpack_f16(floats, halves, PACK_SPEC_COUNT);
+
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(halves[i], == , ftoh(values[i]));
+      expect(pack_spec_bits(floats[i]), == , pack_spec_bits(htof(halves[i])));
+    }
+  }
+
+}
+
+describe(pack_unorm8) {
+  float values[PACK_SPEC_COUNT];
+  pack_spec_floats(values, PACK_SPEC_COUNT, 1.25f);
+
+  it("matches the scalar 8-bit conversions") {
+    byte un[PACK_SPEC_COUNT];
+    signed char sn[PACK_SPEC_COUNT];
+    float out[PACK_SPEC_COUNT];
+
+    pack_unorm8(un, values, PACK_SPEC_COUNT);
+    pack_snorm8(sn, values, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(un[i], == , ftoun8(values[i]));
+      expect(sn[i], == , ftosn8(values[i]));
+    }
+
+    unpack_unorm8(out, un, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(out[i] == un8tof(un[i]));
+    }
+
+    unpack_snorm8(out, sn, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(out[i] == sn8tof(sn[i]));
+    }
+  }
+
+  it("matches the scalar 16-bit conversions") {
+    u16 un[PACK_SPEC_COUNT];
+    short sn[PACK_SPEC_COUNT];
+    float out[PACK_SPEC_COUNT];
+
+    pack_unorm16(un, values, PACK_SPEC_COUNT);
+    pack_snorm16(sn, values, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(un[i], == , ftoun16(values[i]));
+      expect(sn[i], == , ftosn16(values[i]));
+    }
+
+    unpack_unorm16(out, un, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(out[i] == un16tof(un[i]));
+    }
+
+    unpack_snorm16(out, sn, PACK_SPEC_COUNT);
+    for (index_s i = 0; i < PACK_SPEC_COUNT; ++i) {
+      expect(out[i] == sn16tof(sn[i]));
+    }
+  }
+
+  it("converts colors per channel") {
+    vec4 color = v4f(0.f, 0.5f, 1.f, 2.f);
+    vec4b bytes = b4from_v4(color);
+    expect(bytes.r, == , 0);
+    expect(bytes.g, == , 128);
+    expect(bytes.b, == , 255);
+    expect(bytes.a, == , 255);
+
+    vec3b rgb = b3from_v3(v3f(0.25f, -1.f, 1.f));
+    expect(rgb.r, == , 64);
+    expect(rgb.g, == , 0);
+    vec3 back = v3from_b3(rgb);
+    expect(back.r == un8tof(64) && back.b == 1.f);
+    expect(v4from_b4(bytes).a == 1.f);
+  }
+
+}
+
+test_suite(tests_pack) {
+  test_group(ftoh),
+  test_group(htof),
+  test_group(unorm_snorm),
+  test_group(oct_encode),
+  test_group(pack_f16),
+  test_group(pack_unorm8),
+  test_suite_end
+};
@@ -0,0 +1,524 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "parallel.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "spec_random.h"
+
+#define con_type int
+#define con_prefix int
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#define con_type double
+#define con_prefix dbl
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+typedef struct {
+  int key;
+  int index;
+} ParSpecPair;
+
+#define con_type ParSpecPair
+#define con_prefix pair
+#include "array.h"
+#undef con_type
+#undef con_prefix
+
+#include "cspec.h"
+
+// Large enough to be split into chunks on any pool
+#define PAR_SPEC_COUNT (PAR_MIN_CHUNK * 24 + 17)
+
+static int par_spec_random(unsigned* state) {
+  return (int)(spec_random(state) >> 8 & 0x7FFF);
+}
+
+static Array_int par_spec_ints(index_s count, int modulo) {
+  Array_int ret = arr_int_new_reserve(count);
+  unsigned state = 42;
+  for (index_s i = 0; i < count; ++i) {
+    arr_int_push_back(ret, par_spec_random(&state) % modulo);
+  }
+  return ret;
+}
+
+static void par_spec_square(
+  void* data, void* first, index_s begin, index_s end
+) {
+  PARAM_UNUSED(data);
+  int* el = first;
+  for (index_s i = begin; i < end; ++i, ++el) *el = *el * *el;
+}
+
+// Remembers the first and last element seen, which only comes out right if
+// the chunks are folded together in order
+typedef struct {
+  long long sum;
+  index_s count;
+  int first, last;
+} ParSpecAcc;
+
+static void par_spec_reduce(
+  void* data, void* acc_in, const void* first, index_s count
+) {
+  PARAM_UNUSED(data);
+  ParSpecAcc* acc = acc_in;
+  const int* el = first;
+  if (count == 0) return;
+  if (acc->count == 0) acc->first = el[0];
+  for (index_s i = 0; i < count; ++i) acc->sum += el[i];
+  acc->last = el[count - 1];
+  acc->count += count;
+}
+
+static void par_spec_combine(void* data, void* acc_in, const void* other_in) {
+  PARAM_UNUSED(data);
+  ParSpecAcc* acc = acc_in;
+  const ParSpecAcc* other = other_in;
+  if (other->count == 0) return;
+  if (acc->count == 0) acc->first = other->first;
+  acc->sum += other->sum;
+  acc->last = other->last;
+  acc->count += other->count;
+}
+
+static void par_spec_add(void* acc, const void* rhs) {
+  *(int*)acc += *(const int*)rhs;
+}
+
+// Associative but not commutative: the latest non-zero value wins
+static void par_spec_latest(void* acc, const void* rhs) {
+  if (*(const int*)rhs) *(int*)acc = *(const int*)rhs;
+}
+
+static bool par_spec_even(void* data, const void* element) {
+  PARAM_UNUSED(data);
+  return *(const int*)element % 2 == 0;
+}
+
+static bool par_spec_above(void* data, const void* element) {
+  return *(const int*)element > *(int*)data;
+}
+
+static bool par_spec_int_less(const void* lhs, const void* rhs) {
+  return *(const int*)lhs < *(const int*)rhs;
+}
+
+static bool par_spec_pair_less(const void* lhs, const void* rhs) {
+  return ((const ParSpecPair*)lhs)->key < ((const ParSpecPair*)rhs)->key;
+}
+
+static int par_spec_int_cmp(const void* lhs, const void* rhs) {
+  return *(const int*)lhs - *(const int*)rhs;
+}
+
+// Comma separated numbers with the odd empty, padded or invalid field, several
+// times
+// PAR_MIN_TEXT_CHUNK long so it's split across the pool
+static char* par_spec_text(index_s* out_size) {
+  index_s capacity = PAR_MIN_TEXT_CHUNK * 8;
+  char* text = malloc(capacity);
+  index_s size = 0;
+  unsigned state = 3;
+
+  while (size < capacity - 64) {
+    int value = par_spec_random(&state) - 16000;
+    switch (value & 15) {
+      case 0: size += sprintf(text + size, ","); break;
+      case 1: size += sprintf(text + size, "  %d.25 ,", value); break;
+      case 2: size += sprintf(text + size, "n/a,"); break;
+      default: size += sprintf(text + size, "%d,", value); break;
+    }
+  }
+  size += sprintf(text + size, "7\n");
+
+  *out_size = size;
+  return text;
+}
+
+describe(par_foreach) {
+  JobPool pool = job_pool_new(4);
+  Array_int values = par_spec_ints(PAR_SPEC_COUNT, 100);
+  Array_int expected = par_spec_ints(PAR_SPEC_COUNT, 100);
+
+  it("calls fn on every element once") {
+    par_foreach(pool, values, 1000, par_spec_square, NULL);
+
+    for (index_s i = 0; i < expected->size; ++i) {
+      expect(values->arr[i], == , expected->arr[i] * expected->arr[i]);
+    }
+  }
+
+  it("picks a grain when given zero") {
+    par_foreach(pool, values, 0, par_spec_square, NULL);
+
+    for (index_s i = 0; i < expected->size; ++i) {
+      expect(values->arr[i], == , expected->arr[i] * expected->arr[i]);
+    }
+  }
+
+  arr_int_delete(&expected);
+  arr_int_delete(&values);
+  job_pool_delete(&pool);
+
+}
+
+describe(par_reduce) {
+  JobPool pool = job_pool_new(4);
+  Array_int values = par_spec_ints(PAR_SPEC_COUNT, 1000);
+
+  ParSpecAcc expected = { 0 };
+  par_spec_reduce(NULL, &expected, values->arr, values->size);
+
+  it("matches the serial fold and keeps chunks in order") {
+    ParSpecAcc acc = { 0 };
+    par_reduce(pool, values, &acc, sizeof(acc),
+      par_spec_reduce, par_spec_combine, NULL
+    );
+
+    expect(acc.sum, == , expected.sum);
+    expect(acc.count, == , values->size);
+    expect(acc.first, == , values->arr[0]);
+    expect(acc.last, == , values->arr[values->size - 1]);
+  }
+
+  it("folds small inputs on the calling thread") {
+    ParSpecAcc acc = { 0 };
+    par_reduce_s(pool, values->arr, 10, sizeof(int), &acc, sizeof(acc),
+      par_spec_reduce, par_spec_combine, NULL
+    );
+
+    expect(acc.count, == , 10);
+    expect(acc.first, == , values->arr[0]);
+    expect(acc.last, == , values->arr[9]);
+  }
+
+  it("leaves the identity for an empty input") {
+    ParSpecAcc acc = { .first = -1 };
+    par_reduce_s(pool, values->arr, 0, sizeof(int), &acc, sizeof(acc),
+      par_spec_reduce, par_spec_combine, NULL
+    );
+
+    expect(acc.count, == , 0);
+    expect(acc.first, == , -1);
+  }
+
+  arr_int_delete(&values);
+  job_pool_delete(&pool);
+
+}
+
+describe(par_scan) {
+  JobPool pool = job_pool_new(4);
+  Array_int values = par_spec_ints(PAR_SPEC_COUNT, 10);
+  Array_int out = arr_int_new();
+  const int zero = 0;
+
+  it("matches a serial inclusive scan") {
+    par_scan_inclusive(pool, values, out, &zero, par_spec_add);
+
+    expect(out->size, == , values->size);
+    int sum = 0;
+    for (index_s i = 0; i < values->size; ++i) {
+      sum += values->arr[i];
+      expect(out->arr[i], == , sum);
+    }
+  }
+
+  it("matches a serial exclusive scan") {
+    par_scan_exclusive(pool, values, out, &zero, par_spec_add);
+
+    expect(out->size, == , values->size);
+    int sum = 0;
+    for (index_s i = 0; i < values->size; ++i) {
+      expect(out->arr[i], == , sum);
+      sum += values->arr[i];
+    }
+  }
+
+  it("scans in place") {
+    Array_int expected = par_spec_ints(PAR_SPEC_COUNT, 10);
+    par_scan_exclusive(pool, values, values, &zero, par_spec_add);
+
+    int sum = 0;
+    for (index_s i = 0; i < expected->size; ++i) {
+      expect(values->arr[i], == , sum);
+      sum += expected->arr[i];
+    }
+
+    arr_int_delete(&expected);
+  }
+
+  it("applies a non-commutative op in order") {
+    for (index_s i = 0; i < values->size; ++i) {
+      if (i % 1000 != 0) values->arr[i] = 0;
+    }
+    par_scan_inclusive(pool, values, out, &zero, par_spec_latest);
+
+    int latest = 0;
+    for (index_s i = 0; i < values->size; ++i) {
+      if (values->arr[i]) latest = values->arr[i];
+      expect(out->arr[i], == , latest);
+    }
+  }
+
+  it("empties out for an empty input") {
+    Array_int empty = arr_int_new();
+    arr_int_push_back(out, 1);
+    par_scan_inclusive(pool, empty, out, &zero, par_spec_add);
+
+    expect(out->size, == , 0);
+    arr_int_delete(&empty);
+  }
+
+  arr_int_delete(&out);
+  arr_int_delete(&values);
+  job_pool_delete(&pool);
+
+}
+
+describe(par_filter) {
+  JobPool pool = job_pool_new(4);
+  Array_int values = par_spec_ints(PAR_SPEC_COUNT, 1000);
+  Array_int out = arr_int_new();
+
+  it("keeps passing elements in their original order") {
+    index_s kept = par_filter(pool, values, out, par_spec_even, NULL);
+
+    index_s j = 0;
+    for (index_s i = 0; i < values->size; ++i) {
+      if (values->arr[i] % 2) continue;
+      expect(j < out->size);
+      if (j < out->size) expect(out->arr[j], == , values->arr[i]);
+      ++j;
+    }
+    expect(kept, == , j);
+    expect(out->size, == , j);
+  }
+
+  it("replaces the contents of out") {
+    int limit = 2000;
+    arr_int_push_back(out, 7);
+    index_s kept = par_filter(pool, values, out, par_spec_above, &limit);
+
+    expect(kept, == , 0);
+    expect(out->size, == , 0);
+  }
+
+  arr_int_delete(&out);
+  arr_int_delete(&values);
+  job_pool_delete(&pool);
+
+}
+
+describe(par_sort) {
+  JobPool pool = job_pool_new(4);
+
+  it("matches qsort") {
+    Array_int values = par_spec_ints(PAR_SPEC_COUNT, 30000);
+    Array_int expected = par_spec_ints(PAR_SPEC_COUNT, 30000);
+
+    par_sort(pool, values, par_spec_int_less);
+    qsort(expected->arr, expected->size, sizeof(int), par_spec_int_cmp);
+
+    for (index_s i = 0; i < expected->size; ++i) {
+      expect(values->arr[i], == , expected->arr[i]);
+    }
+
+    arr_int_delete(&expected);
+    arr_int_delete(&values);
+  }
+
+  it("keeps equal elements in their original order") {
+    Array_ParSpecPair pairs = arr_pair_new_reserve(PAR_SPEC_COUNT);
+    unsigned state = 7;
+    for (int i = 0; i < PAR_SPEC_COUNT; ++i) {
+      ParSpecPair pair = { .key = par_spec_random(&state) % 50, .index = i };
+      arr_pair_push_back(pairs, pair);
+    }
+
+    par_sort(pool, pairs, par_spec_pair_less);
+
+    for (index_s i = 1; i < pairs->size; ++i) {
+      ParSpecPair prev = pairs->arr[i - 1], cur = pairs->arr[i];
+      expect(prev.key <= cur.key);
+      if (prev.key == cur.key) expect(prev.index < cur.index);
+    }
+
+    arr_pair_delete(&pairs);
+  }
+
+  it("sorts small inputs on the calling thread") {
+    int values[] = { 5, -1, 3, 3, 0, 9, -7 };
+    int expected[] = { -7, -1, 0, 3, 3, 5, 9 };
+    par_sort_s(pool, values, 7, sizeof(int), par_spec_int_less);
+
+    for (int i = 0; i < 7; ++i) expect(values[i], == , expected[i]);
+  }
+
+  job_pool_delete(&pool);
+
+}
+
+describe(par_str_split) {
+  JobPool pool = job_pool_new(4);
+  index_s size;
+  char* text = par_spec_text(&size);
+  StringRange range = str_range_s(text, size);
+
+  it("matches str_split") {
+    Array_StrR expected = str_split(range, ",");
+    Array_StrR result = par_str_split(pool, range, ",");
+
+    expect(result->size, == , expected->size);
+    expect(result to all(str_eq, expected->arr[n], StringRange, array));
+
+    arr_str_delete(&result);
+    arr_str_delete(&expected);
+  }
+
+  it("matches str_split with a multi-char delimiter") {
+    Array_StrR expected = str_split(range, "5,");
+    Array_StrR result = par_str_split(pool, range, "5,");
+
+    expect(result->size, == , expected->size);
+    expect(result to all(str_eq, expected->arr[n], StringRange, array));
+
+    arr_str_delete(&result);
+    arr_str_delete(&expected);
+  }
+
+  it("matches str_split with a self-overlapping delimiter") {
+    for (index_s i = 0; i < size; i += 7) text[i] = ',';
+    Array_StrR expected = str_split(range, ",,");
+    Array_StrR result = par_str_split(pool, range, ",,");
+
+    expect(result->size, == , expected->size);
+    expect(result to all(str_eq, expected->arr[n], StringRange, array));
+
+    arr_str_delete(&result);
+    arr_str_delete(&expected);
+  }
+
+  it("keeps the trailing empty field after a final delimiter") {
+    text[size - 1] = ',';
+    Array_StrR expected = str_split(range, ",");
+    Array_StrR result = par_str_split(pool, range, ",");
+
+    expect(result->size, == , expected->size);
+    expect(str_size(result->arr[result->size - 1]), == , 0);
+
+    arr_str_delete(&result);
+    arr_str_delete(&expected);
+  }
+
+  free(text);
+  job_pool_delete(&pool);
+
+}
+
+describe(par_str_to_int) {
+  JobPool pool = job_pool_new(4);
+  index_s size;
+  char* text = par_spec_text(&size);
+  StringRange range = str_range_s(text, size);
+
+  // serial reference: split, trim, skip empty fields and bad numbers
+  Array_StrR fields = str_split(range, ",");
+  Array_int ints = arr_int_new();
+  Array_double doubles = arr_dbl_new();
+  bool valid = true;
+  for (index_s i = 0; i < fields->size; ++i) {
+    StringRange field = str_trim(fields->arr[i]);
+    if (field.size == 0) continue;
+
+    int value;
+    if (str_to_int(field, &value)) arr_int_push_back(ints, value);
+    else valid = false;
+
+    double real;
+    if (str_to_double(field, &real)) arr_dbl_push_back(doubles, real);
+  }
+
+  it("parses ints like a serial loop, leaving out invalid fields") {
+    Array_int out = arr_int_new();
+    arr_int_push_back(out, 12345);
+
+    expect(valid, == , false);
+    expect(par_str_to_int(pool, range, ",", out), == , false);
+    expect(out->size, == , ints->size);
+    for (index_s i = 0; i < ints->size; ++i) {
+      expect(out->arr[i], == , ints->arr[i]);
+    }
+
+    arr_int_delete(&out);
+  }
+
+  it("parses doubles like a serial loop") {
+    Array_double out = arr_dbl_new();
+
+    expect(par_str_to_double(pool, range, ",", out), == , false);
+    expect(out->size, == , doubles->size);
+    for (index_s i = 0; i < doubles->size; ++i) {
+      expect(out->arr[i] == doubles->arr[i]);
+    }
+
+    arr_dbl_delete(&out);
+  }
+
+  it("clears out for empty text") {
+    Array_int out = arr_int_new();
+    arr_int_push_back(out, 1);
+
+    expect(par_str_to_int(pool, "", ",", out), == , true);
+    expect(out->size, == , 0);
+
+    arr_int_delete(&out);
+  }
+
+  arr_dbl_delete(&doubles);
+  arr_int_delete(&ints);
+  arr_str_delete(&fields);
+  free(text);
+  job_pool_delete(&pool);
+
+}
+
+test_suite(tests_parallel) {
+  test_group(par_foreach),
+  test_group(par_reduce),
+  test_group(par_scan),
+  test_group(par_filter),
+  test_group(par_sort),
+  test_group(par_str_split),
+  test_group(par_str_to_int),
+  test_suite_end
+};
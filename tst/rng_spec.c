@@ -0,0 +1,214 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "rng.h"
+
+#include <string.h>
+
+#include "cspec.h"
+
+// The published xoshiro128** step, one generator at a time
+static uint rng_spec_next(uint s[4]) {
+  uint x = s[1] * 5;
+  uint result = ((x << 7) | (x >> 25)) * 9;
+  uint t = s[1] << 9;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = (s[3] << 11) | (s[3] >> 21);
+  return result;
+}
+
+// Lane l starts from {1, 2, 3, 4} + l * 4, so lane 0 has the usual test state
+static Rng rng_spec_known(uint ref[RNG_LANES][4]) {
+  Rng rng = rng_new(0);
+  for (int lane = 0; lane < RNG_LANES; ++lane) {
+    for (int w = 0; w < 4; ++w) {
+      ref[lane][w] = rng.state[w][lane] = (uint)(1 + w + lane * 4);
+    }
+  }
+  return rng;
+}
+
+describe(rng_uint) {
+  uint ref[RNG_LANES][4];
+  Rng rng = rng_spec_known(ref);
+
+  it("interleaves the outputs of independent xoshiro128** lanes") {
+    for (int n = 0; n < 4000; ++n) {
+      expect(rng_uint(&rng), == , rng_spec_next(ref[n % RNG_LANES]));
+    }
+  }
+
+  it("gives the reference sequence for the usual test state") {
+    uint first[4];
+    for (int n = 0; n < 4; ++n) {
+      first[n] = rng_uint(&rng);
+      for (int lane = 1; lane < RNG_LANES; ++lane) rng_uint(&rng);
+    }
+    expect(first[0], == , 11520);
+    expect(first[1], == , 0);
+    expect(first[2], == , 5927040);
+    expect(first[3], == , 70819200);
+  }
+
+  it("is deterministic per seed and differs between seeds and lanes") {
+    Rng a = rng_new(1234), b = rng_new(1234), c = rng_new(1235);
+    bool differs = false;
+    for (int n = 0; n < 64; ++n) {
+      uint x = rng_uint(&a);
+      expect(x, == , rng_uint(&b));
+      differs |= x != rng_uint(&c);
+    }
+    expect(differs);
+
+    for (int lane = 1; lane < RNG_LANES; ++lane) {
+      expect(memcmp(a.state[0], a.state[lane], sizeof(uint)) != 0
+        || a.state[1][0] != a.state[1][lane]
+      );
+    }
+  }
+
+}
+
+describe(rng_fill) {
+  Rng seeded = rng_new(99);
+
+  it("gives the same values as single draws from any position") {
+    uint filled[16], single[16];
+    for (int prefix = 0; prefix <= RNG_LANES; ++prefix) {
+      for (index_s count = 0; count <= 13; ++count) {
+        Rng a = seeded, b = seeded;
+        for (int p = 0; p < prefix; ++p) {
+          rng_uint(&a);
+          rng_uint(&b);
+        }
+
+        rng_fill_uint(&a, filled, count);
+        for (index_s i = 0; i < count; ++i) single[i] = rng_uint(&b);
+        for (index_s i = 0; i < count; ++i) expect(filled[i], == , single[i]);
+
+        // and both carry on from the same place
+        expect(rng_uint(&a), == , rng_uint(&b));
+      }
+    }
+  }
+
+  it("fills floats and vectors like rng_range per component") {
+    float f[11];
+    vec2 v2[7];
+    vec3 v3[5];
+    for (int prefix = 0; prefix <= RNG_LANES; ++prefix) {
+      Rng a = seeded, b = seeded;
+      for (int p = 0; p < prefix; ++p) {
+        rng_float(&a);
+        rng_float(&b);
+      }
+
+      rng_fill_f(&a, f, 11, -3, 5);
+      for (int i = 0; i < 11; ++i) expect(f[i] == rng_range(&b, -3, 5));
+
+      rng_fill_v2(&a, v2, 7, v2f(0, -1), v2f(10, 1));
+      for (int i = 0; i < 7; ++i) {
+        expect(v2[i].x == rng_range(&b, 0, 10));
+        expect(v2[i].y == rng_range(&b, -1, 1));
+      }
+
+      rng_fill_v3(&a, v3, 5, v3f(1, 2, 3), v3f(2, 4, 8));
+      for (int i = 0; i < 5; ++i) {
+        expect(v3[i].x == rng_range(&b, 1, 2));
+        expect(v3[i].y == rng_range(&b, 2, 4));
+        expect(v3[i].z == rng_range(&b, 3, 8));
+      }
+
+      expect(rng_float(&a) == rng_float(&b));
+    }
+  }
+
+  it("keeps floats in range and evenly spread") {
+    enum { count = 1 << 16, buckets = 16 };
+    float* f = malloc(count * sizeof(float));
+    rng_fill_f(&seeded, f, count, 0, 1);
+
+    int hist[buckets] = { 0 };
+    double sum = 0;
+    for (int i = 0; i < count; ++i) {
+      expect(f[i] >= 0 && f[i] < 1);
+      if (f[i] >= 0 && f[i] < 1) ++hist[(int)(f[i] * buckets)];
+      sum += f[i];
+    }
+
+    expect(sum / count > 0.49 && sum / count < 0.51);
+    for (int b = 0; b < buckets; ++b) {
+      expect(hist[b] > count / buckets * 9 / 10);
+      expect(hist[b] < count / buckets * 11 / 10);
+    }
+    free(f);
+  }
+
+}
+
+describe(rng_jump) {
+  Rng seeded = rng_new(7);
+
+  it("commutes with stepping the generator") {
+    uint skipped[12];
+    Rng a = seeded, b = seeded;
+    rng_jump(&a);
+    rng_fill_uint(&a, skipped, 12);
+
+    rng_fill_uint(&b, skipped, 12);
+    rng_jump(&b);
+    expect(memcmp(a.state, b.state, sizeof(a.state)) == 0);
+  }
+
+  it("gives a stream that doesn't start within the original") {
+    Rng a = seeded, b = seeded;
+    rng_jump(&b);
+    for (int n = 0; n < 1000; ++n) {
+      expect(memcmp(a.state, b.state, sizeof(a.state)) != 0);
+      rng_fill_uint(&a, (uint[RNG_LANES]) { 0 }, RNG_LANES);
+    }
+  }
+
+  it("discards buffered outputs") {
+    uint skipped[RNG_LANES];
+    Rng a = seeded, b = seeded;
+    rng_uint(&a);
+    rng_jump(&a);
+    rng_fill_uint(&b, skipped, RNG_LANES);
+    rng_jump(&b);
+    expect(rng_uint(&a), == , rng_uint(&b));
+  }
+
+}
+
+test_suite(tests_rng) {
+  test_group(rng_uint),
+  test_group(rng_fill),
+  test_group(rng_jump),
+  test_suite_end
+};
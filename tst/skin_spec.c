@@ -0,0 +1,467 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "skin.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+#define SKIN_SPEC_COUNT 37
+#define SKIN_SPEC_BONES 6
+
+static unsigned skin_spec_state = 29;
+
+static float skin_spec_random(float lo, float hi) {
+  return spec_random_range(&skin_spec_state, lo, hi);
+}
+
+static vec3 skin_spec_point(float extent) {
+  return v3f(skin_spec_random(-extent, extent),
+    skin_spec_random(-extent, extent), skin_spec_random(-extent, extent)
+  );
+}
+
+static vec3 skin_spec_axis(void) {
+  vec3 axis = skin_spec_point(1);
+  float len = v3mag(axis);
+  if (len < 1e-3f) return v3f(0, 0, 1);
+  return v3scale(axis, 1 / len);
+}
+
+static quat skin_spec_rotation(void) {
+  vec3 axis = skin_spec_axis();
+  float angle = skin_spec_random(0, 6.2831853f);
+  vec3 v = v3scale(axis, sinf(angle / 2));
+  return v4f(v.x, v.y, v.z, cosf(angle / 2));
+}
+
+static float skin_spec_qdot(quat a, quat b) {
+  return a.i * b.i + a.j * b.j + a.k * b.k + a.w * b.w;
+}
+
+static quat skin_spec_qneg(quat q) {
+  return v4f(-q.i, -q.j, -q.k, -q.w);
+}
+
+static bool skin_spec_near(vec3 a, vec3 b, float tolerance) {
+  return fabsf(a.x - b.x) <= tolerance
+    && fabsf(a.y - b.y) <= tolerance
+    && fabsf(a.z - b.z) <= tolerance;
+}
+
+// Hamilton product in double precision, as {i, j, k, w}
+static void skin_spec_qmul(const double* a, const double* b, double* out) {
+  double r[4] = {
+    a[3] * b[0] + a[0] * b[3] + a[1] * b[2] - a[2] * b[1],
+    a[3] * b[1] - a[0] * b[2] + a[1] * b[3] + a[2] * b[0],
+    a[3] * b[2] + a[0] * b[1] - a[1] * b[0] + a[2] * b[3],
+    a[3] * b[3] - a[0] * b[0] - a[1] * b[1] - a[2] * b[2],
+  };
+  for (int c = 0; c < 4; ++c) out[c] = r[c];
+}
+
+// Applies a dual quaternion as q p q* + 2 d q*, without renormalizing
+static void skin_spec_apply(
+  const double* real, const double* dual, const double* p, bool translate,
+  double* out
+) {
+  double conj[4] = { -real[0], -real[1], -real[2], real[3] };
+  double v[4] = { p[0], p[1], p[2], 0 };
+  skin_spec_qmul(real, v, v);
+  skin_spec_qmul(v, conj, v);
+
+  double t[4];
+  skin_spec_qmul(dual, conj, t);
+  for (int c = 0; c < 3; ++c) out[c] = v[c] + (translate ? 2 * t[c] : 0);
+}
+
+static vec3 skin_spec_rigid(quat r, vec3 t, vec3 p) {
+  double real[4] = { r.i, r.j, r.k, r.w };
+  double dual[4] = { 0, 0, 0, 0 };
+  double in[3] = { p.x, p.y, p.z }, out[3];
+  skin_spec_apply(real, dual, in, false, out);
+  return v3f((float)out[0] + t.x, (float)out[1] + t.y, (float)out[2] + t.z);
+}
+
+typedef struct {
+  float pos[3][SKIN_SPEC_COUNT];
+  float nrm[3][SKIN_SPEC_COUNT];
+  float out_pos[3][SKIN_SPEC_COUNT];
+  float out_nrm[3][SKIN_SPEC_COUNT];
+  u16   bones[SKIN_INFLUENCES][SKIN_SPEC_COUNT];
+  float weights[SKIN_INFLUENCES][SKIN_SPEC_COUNT];
+  SkinMesh mesh;
+} SkinSpecMesh;
+
+static void skin_spec_stream(
+  SkinStream* stream, float (*data)[SKIN_SPEC_COUNT]
+) {
+  stream->x = data[0];
+  stream->y = data[1];
+  stream->z = data[2];
+}
+
+// Random vertices with one to four influences each, including unused slots
+//    in the middle and repeated bones
+static void skin_spec_mesh(SkinSpecMesh* m) {
+  for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+    vec3 p = skin_spec_point(10), n = skin_spec_axis();
+    for (int c = 0; c < 3; ++c) {
+      m->pos[c][i] = p.f[c];
+      m->nrm[c][i] = n.f[c];
+      m->out_pos[c][i] = m->out_nrm[c][i] = -1234.f;
+    }
+
+    float sum = 0;
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      float w = skin_spec_random(0, 1);
+      if (k > 0 && (i + k) % 3 == 0) w = 0;
+      m->bones[k][i] = (u16)(skin_spec_random(0, SKIN_SPEC_BONES - 0.01f));
+      m->weights[k][i] = w;
+      sum += w;
+    }
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) m->weights[k][i] /= sum;
+  }
+
+  skin_spec_stream(&m->mesh.positions, m->pos);
+  skin_spec_stream(&m->mesh.normals, m->nrm);
+  skin_spec_stream(&m->mesh.out_positions, m->out_pos);
+  skin_spec_stream(&m->mesh.out_normals, m->out_nrm);
+  for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+    m->mesh.bones[k] = m->bones[k];
+    m->mesh.weights[k] = m->weights[k];
+  }
+}
+
+// Points the unused slots past the end of any palette
+static void skin_spec_unused_bones(SkinSpecMesh* m) {
+  for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      if (m->weights[k][i] == 0) m->bones[k][i] = 0xFFFF;
+    }
+  }
+}
+
+static vec3 skin_spec_get(float (*data)[SKIN_SPEC_COUNT], int i) {
+  return v3f(data[0][i], data[1][i], data[2][i]);
+}
+
+// Blends the transformed points rather than the matrices
+static void skin_spec_lbs(
+  const SkinSpecMesh* m, const mat34* palette, int i, vec3* pos, vec3* nrm
+) {
+  double p[3] = { 0 }, n[3] = { 0 };
+  for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+    double w = m->weights[k][i];
+    if (w == 0) continue;
+    const mat34* bone = &palette[m->bones[k][i]];
+    for (int r = 0; r < 3; ++r) {
+      p[r] += w * bone->m[r][3];
+      for (int c = 0; c < 3; ++c) {
+        p[r] += w * bone->m[r][c] * m->pos[c][i];
+        n[r] += w * bone->m[r][c] * m->nrm[c][i];
+      }
+    }
+  }
+  double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+  *pos = v3f((float)p[0], (float)p[1], (float)p[2]);
+  *nrm = v3f((float)(n[0] / len), (float)(n[1] / len), (float)(n[2] / len));
+}
+
+// Normalized blend along the shortest arc from the first used influence
+static void skin_spec_dqs(
+  const SkinSpecMesh* m, const dquat* palette, int i, vec3* pos, vec3* nrm
+) {
+  const dquat* pivot = NULL;
+  double real[4] = { 0 }, dual[4] = { 0 };
+  for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+    double w = m->weights[k][i];
+    if (w == 0) continue;
+    const dquat* dq = &palette[m->bones[k][i]];
+    if (!pivot) pivot = dq;
+    if (skin_spec_qdot(dq->real, pivot->real) < 0) w = -w;
+    for (int c = 0; c < 4; ++c) {
+      real[c] += w * dq->real.f[c];
+      dual[c] += w * dq->dual.f[c];
+    }
+  }
+  double len = sqrt(real[0] * real[0] + real[1] * real[1]
+    + real[2] * real[2] + real[3] * real[3]
+  );
+  for (int c = 0; c < 4; ++c) {
+    real[c] /= len;
+    dual[c] /= len;
+  }
+
+  double in[3], out[3];
+  for (int c = 0; c < 3; ++c) in[c] = m->pos[c][i];
+  skin_spec_apply(real, dual, in, true, out);
+  *pos = v3f((float)out[0], (float)out[1], (float)out[2]);
+  for (int c = 0; c < 3; ++c) in[c] = m->nrm[c][i];
+  skin_spec_apply(real, dual, in, false, out);
+  *nrm = v3f((float)out[0], (float)out[1], (float)out[2]);
+}
+
+static mat34 skin_spec_rigid_m34(void) {
+  mat4 rotation = m4rotation(skin_spec_axis(), skin_spec_random(0, 6.28f));
+  mat4 translation = m4translation(skin_spec_point(5));
+  return m34from_m4(m4mul(translation, rotation));
+}
+
+describe(skin_transforms) {
+
+  it("converts to and from mat4 like mv4mul") {
+    for (int n = 0; n < 50; ++n) {
+      mat4 m = m4identity;
+      for (int c = 0; c < 4; ++c) {
+        m.col[c].xyz = skin_spec_point(3);
+      }
+      mat34 m34 = m34from_m4(m);
+      mat4 back = m4from_m34(m34);
+      for (int c = 0; c < 16; ++c) expect(back.f[c] == m.f[c]);
+
+      vec3 p = skin_spec_point(10);
+      vec4 expected = mv4mul(m, v4f(p.x, p.y, p.z, 1));
+      expect(skin_spec_near(m34transform(m34, p), expected.xyz, 1e-4f));
+    }
+  }
+
+  it("builds dual quaternions that apply the rotation and translation") {
+    for (int n = 0; n < 200; ++n) {
+      quat r = skin_spec_rotation();
+      vec3 t = skin_spec_point(5);
+      vec3 p = skin_spec_point(10);
+      dquat dq = dq_from_rt(r, t);
+      expect(skin_spec_near(dq_transform(dq, p), skin_spec_rigid(r, t, p),
+        1e-4f
+      ));
+    }
+  }
+
+  it("recovers rigid transforms from matrices") {
+    for (int n = 0; n < 200; ++n) {
+      mat34 m = skin_spec_rigid_m34();
+      dquat dq = dq_from_m34(m);
+      expect(fabsf(skin_spec_qdot(dq.real, dq.real) - 1) < 1e-5f);
+      for (int i = 0; i < 5; ++i) {
+        vec3 p = skin_spec_point(10);
+        expect(skin_spec_near(dq_transform(dq, p), m34transform(m, p), 1e-4f));
+      }
+    }
+
+    // half turns about each axis take the branches with a negative trace
+    vec3 axes[3] = { v3f(1, 0, 0), v3f(0, 1, 0), v3f(0, 0, 1) };
+    for (int a = 0; a < 3; ++a) {
+      mat34 m = m34from_m4(m4rotation(axes[a], 3.14159265f));
+      dquat dq = dq_from_m34(m);
+      vec3 p = v3f(1, 2, 3);
+      expect(skin_spec_near(dq_transform(dq, p), m34transform(m, p), 1e-5f));
+    }
+  }
+
+}
+
+describe(skin_lbs) {
+  SkinSpecMesh* m = malloc(sizeof(SkinSpecMesh));
+  skin_spec_mesh(m);
+
+  mat34 palette[SKIN_SPEC_BONES];
+  for (int b = 0; b < SKIN_SPEC_BONES; ++b) {
+    for (int c = 0; c < 12; ++c) palette[b].f[c] = skin_spec_random(-2, 2);
+  }
+
+  it("matches blending the transformed vertices") {
+    skin_lbs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      vec3 pos, nrm;
+      skin_spec_lbs(m, palette, i, &pos, &nrm);
+      expect(skin_spec_near(skin_spec_get(m->out_pos, i), pos, 1e-3f));
+      expect(skin_spec_near(skin_spec_get(m->out_nrm, i), nrm, 1e-4f));
+    }
+  }
+
+  it("only writes the given range") {
+    skin_lbs(&m->mesh, palette, 5, 30);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      bool written = i >= 5 && i < 30;
+      expect((m->out_pos[0][i] != -1234.f) == written);
+      expect((m->out_nrm[2][i] != -1234.f) == written);
+    }
+  }
+
+  it("skips normals when there are none") {
+    m->mesh.normals.x = NULL;
+    skin_lbs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      expect(m->out_pos[1][i] != -1234.f);
+      expect(m->out_nrm[1][i] == -1234.f);
+    }
+  }
+
+  it("never reads the palette through unused slots") {
+    m->mesh.normals.x = m->nrm[0];
+    skin_lbs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    float expected[3][SKIN_SPEC_COUNT];
+    memcpy(expected, m->out_pos, sizeof(expected));
+
+    skin_spec_unused_bones(m);
+    skin_lbs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    expect(memcmp(expected, m->out_pos, sizeof(expected)) == 0);
+  }
+
+  it("can write over its inputs") {
+    SkinSpecMesh* copy = malloc(sizeof(SkinSpecMesh));
+    *copy = *m;
+    skin_lbs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+
+    skin_spec_stream(&copy->mesh.positions, copy->pos);
+    skin_spec_stream(&copy->mesh.normals, copy->nrm);
+    skin_spec_stream(&copy->mesh.out_positions, copy->pos);
+    skin_spec_stream(&copy->mesh.out_normals, copy->nrm);
+    for (int k = 0; k < SKIN_INFLUENCES; ++k) {
+      copy->mesh.bones[k] = copy->bones[k];
+      copy->mesh.weights[k] = copy->weights[k];
+    }
+    skin_lbs(&copy->mesh, palette, 0, SKIN_SPEC_COUNT);
+
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      for (int c = 0; c < 3; ++c) {
+        expect(copy->pos[c][i] == m->out_pos[c][i]);
+        expect(copy->nrm[c][i] == m->out_nrm[c][i]);
+      }
+    }
+    free(copy);
+  }
+
+  free(m);
+
+}
+
+describe(skin_dqs) {
+  SkinSpecMesh* m = malloc(sizeof(SkinSpecMesh));
+  skin_spec_mesh(m);
+
+  dquat palette[SKIN_SPEC_BONES];
+  for (int b = 0; b < SKIN_SPEC_BONES; ++b) {
+    palette[b] = dq_from_rt(skin_spec_rotation(), skin_spec_point(5));
+  }
+
+  it("matches a normalized blend along the shortest arc") {
+    skin_dqs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      vec3 pos, nrm;
+      skin_spec_dqs(m, palette, i, &pos, &nrm);
+      expect(skin_spec_near(skin_spec_get(m->out_pos, i), pos, 1e-3f));
+      expect(skin_spec_near(skin_spec_get(m->out_nrm, i), nrm, 1e-4f));
+    }
+  }
+
+  it("pivots on the first used slot and never reads through unused ones") {
+    SkinSpecMesh* sparse = malloc(sizeof(SkinSpecMesh));
+    skin_spec_mesh(sparse);
+    for (int i = 0; i < SKIN_SPEC_COUNT; i += 3) {
+      float w = sparse->weights[0][i];
+      sparse->weights[0][i] = 0;
+      sparse->weights[SKIN_INFLUENCES - 1][i] += w;
+    }
+    skin_spec_unused_bones(sparse);
+
+    skin_dqs(&sparse->mesh, palette, 0, SKIN_SPEC_COUNT);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      vec3 pos, nrm;
+      skin_spec_dqs(sparse, palette, i, &pos, &nrm);
+      expect(skin_spec_near(skin_spec_get(sparse->out_pos, i), pos, 1e-3f));
+      expect(skin_spec_near(skin_spec_get(sparse->out_nrm, i), nrm, 1e-4f));
+    }
+    free(sparse);
+  }
+
+  it("applies a single bone exactly like the rigid transform") {
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      m->weights[0][i] = 1;
+      for (int k = 1; k < SKIN_INFLUENCES; ++k) m->weights[k][i] = 0;
+    }
+    skin_dqs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      dquat dq = palette[m->bones[0][i]];
+      vec3 pos = dq_transform(dq, skin_spec_get(m->pos, i));
+      vec3 nrm = skin_spec_rigid(dq.real, v3f(0, 0, 0),
+        skin_spec_get(m->nrm, i)
+      );
+      expect(skin_spec_near(skin_spec_get(m->out_pos, i), pos, 1e-4f));
+      expect(skin_spec_near(skin_spec_get(m->out_nrm, i), nrm, 1e-5f));
+    }
+  }
+
+  it("treats a negated quaternion as the same rotation") {
+    dquat flipped[SKIN_SPEC_BONES];
+    for (int b = 0; b < SKIN_SPEC_BONES; ++b) {
+      flipped[b] = palette[b];
+      if (b % 2) {
+        flipped[b].real = skin_spec_qneg(palette[b].real);
+        flipped[b].dual = skin_spec_qneg(palette[b].dual);
+      }
+    }
+
+    skin_dqs(&m->mesh, palette, 0, SKIN_SPEC_COUNT);
+    float expected[3][SKIN_SPEC_COUNT];
+    for (int c = 0; c < 3; ++c) {
+      for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+        expected[c][i] = m->out_pos[c][i];
+      }
+    }
+
+    skin_dqs(&m->mesh, flipped, 0, SKIN_SPEC_COUNT);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      expect(skin_spec_near(skin_spec_get(m->out_pos, i),
+        skin_spec_get(expected, i), 1e-4f
+      ));
+    }
+  }
+
+  it("only writes the given range") {
+    skin_dqs(&m->mesh, palette, 3, 28);
+    for (int i = 0; i < SKIN_SPEC_COUNT; ++i) {
+      bool written = i >= 3 && i < 28;
+      expect((m->out_pos[0][i] != -1234.f) == written);
+      expect((m->out_nrm[2][i] != -1234.f) == written);
+    }
+  }
+
+  free(m);
+
+}
+
+test_suite(tests_skin) {
+  test_group(skin_transforms),
+  test_group(skin_lbs),
+  test_group(skin_dqs),
+  test_suite_end
+};
@@ -27,6 +27,25 @@
 // Test suites
 
 extern TestSuite tests_cspec;
+extern TestSuite tests_array;
+extern TestSuite tests_async;
+extern TestSuite tests_blob;
+extern TestSuite tests_camera;
+extern TestSuite tests_color;
+extern TestSuite tests_file;
+extern TestSuite tests_geom;
+extern TestSuite tests_job;
+extern TestSuite tests_kdtree;
+extern TestSuite tests_memstats;
+extern TestSuite tests_noise;
+extern TestSuite tests_pack;
+extern TestSuite tests_parallel;
+extern TestSuite tests_rng;
+extern TestSuite tests_skin;
+extern TestSuite tests_trace;
+extern TestSuite tests_utility;
+extern TestSuite tests_vec_inline;
+extern TestSuite tests_vec_t;
 extern TestSuite tests_string;
 
 // Main
@@ -34,6 +53,25 @@ extern TestSuite tests_string;
 int main(int argc, char* argv[]) {
   TestSuite* test_suites[] = {
     &tests_cspec,
+    &tests_array,
+    &tests_async,
+    &tests_blob,
+    &tests_camera,
+    &tests_color,
+    &tests_file,
+    &tests_geom,
+    &tests_job,
+    &tests_kdtree,
+    &tests_memstats,
+    &tests_noise,
+    &tests_pack,
+    &tests_parallel,
+    &tests_rng,
+    &tests_skin,
+    &tests_trace,
+    &tests_utility,
+    &tests_vec_inline,
+    &tests_vec_t,
     &tests_string
   };
 
@@ -0,0 +1,47 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#ifndef _MCLIB_SPEC_RANDOM_H_
+#define _MCLIB_SPEC_RANDOM_H_
+
+// Repeatable pseudo-random data for the specs. Each spec seeds and keeps its
+//    own state, so what it sees doesn't depend on which specs ran first.
+
+// \brief Steps the generator and returns 24 uniform bits.
+static inline unsigned spec_random(unsigned* state) {
+  *state = *state * 1103515245u + 12345u;
+  return *state >> 8;
+}
+
+// \brief Uniform integer in [0, range).
+static inline unsigned spec_random_below(unsigned* state, unsigned range) {
+  return spec_random(state) % range;
+}
+
+// \brief Uniform float in [lo, hi].
+static inline float spec_random_range(unsigned* state, float lo, float hi) {
+  return lo + (float)spec_random(state) / 16777215.f * (hi - lo);
+}
+
+#endif
@@ -214,6 +214,11 @@ describe(str_from_float) {
     expect(str_eq(subject->range, R("0")));
   }
 
+  it("drops the sign of negative zero") {
+    subject = str_from_float(-0.0f);
+    expect(str_eq(subject->range, R("0")));
+  }
+
   it("gets pretty exact values from whole numbers") {
     subject = str_from_float(4.0f);
     expect(str_eq(subject->range, R("4")));
@@ -229,6 +234,26 @@ describe(str_from_float) {
     expect(str_eq(subject->range, R("2.73")));
   }
 
+  it("keeps leading zeroes in the decimals") {
+    subject = str_from_float(1.05f);
+    expect(str_eq(subject->range, R("1.05")));
+  }
+
+  it("keeps the sign of values between -1 and 0") {
+    subject = str_from_float(-0.5f);
+    expect(str_eq(subject->range, R("-0.5")));
+  }
+
+  it("uses the shortest digits that read back as the same value") {
+    subject = str_from_float(0.1f);
+    expect(str_eq(subject->range, R("0.1")));
+  }
+
+  it("uses exponent notation for very large values") {
+    subject = str_from_float(3e30f);
+    expect(str_eq(subject->range, R("3e+30")));
+  }
+
   if (subject) {
     str_delete(&subject);
   }
@@ -593,6 +618,211 @@ describe(str_find) {
 
 }
 
+describe(str_eq_nocase) {
+
+  it("matches strings that differ only in case") {
+    expect(str_eq_nocase("Content-Type", "content-type"));
+    expect(str_eq_nocase("A LONGER STRING THAN ONE BLOCK", "a longer string than one block"));
+  }
+
+  it("does not match different strings") {
+    expect(not str_eq_nocase("Content-Type", "Content-Typo"));
+    expect(not str_eq_nocase("Content", "Content-Type"));
+  }
+
+  it("only folds letters") {
+    expect(not str_eq_nocase("@", "`"));
+    expect(not str_eq_nocase("[", "{"));
+  }
+
+  it("has case-insensitive starts_with and ends_with") {
+    expect(str_starts_with_nocase("Content-Type: text", "CONTENT-TYPE"));
+    expect(str_ends_with_nocase("image.PNG", ".png"));
+    expect(not str_ends_with_nocase("png", ".png"));
+  }
+
+  expect(malloc_count == 0);
+
+}
+
+describe(str_index_of_nocase) {
+  StringRange range = R("This Is A String");
+
+  it("finds an index regardless of case") {
+    expect(str_index_of_nocase(range, "is", 3), == , 5u);
+    expect(str_index_of_nocase(range, "STRING", 0), == , 10u);
+  }
+
+  it("fails to find a substring that isn't present") {
+    expect(str_index_of_nocase(range, "strong", 0), == , range.size);
+  }
+
+  it("finds matches past the first block of a long string") {
+    StringRange long_range = R("a long run of text that goes on for a while, Needle");
+    expect(str_index_of_nocase(long_range, "NEEDLE", 0), == , 45u);
+  }
+
+  expect(malloc_count == 0);
+
+}
+
+describe(str_to_lower) {
+  String result = NULL;
+
+  it("converts a string to lower case") {
+    result = str_to_lower("Hello, World!");
+    expect(result to match("hello, world!", str_eq));
+  }
+
+  it("converts a string to upper case") {
+    result = str_to_upper("Hello, World!");
+    expect(result to match("HELLO, WORLD!", str_eq));
+  }
+
+  it("leaves non-ascii bytes alone") {
+    result = str_to_upper("caf\xc3\xa9");
+    expect(result to match("CAF\xc3\xa9", str_eq));
+  }
+
+  it("converts in place") {
+    char buffer[] = "MiXeD CaSe";
+    StringRange range = R(buffer);
+    expect(str_to_lower_to(buffer, range), == , range.size);
+    expect(range to match("mixed case", str_eq));
+  }
+
+  if (result) str_delete(&result);
+
+}
+
+describe(str_utf8_valid) {
+
+  it("accepts ascii and multi-byte sequences") {
+    expect(str_utf8_valid(""));
+    expect(str_utf8_valid("plain ascii"));
+    expect(str_utf8_valid("caf\xc3\xa9 \xe2\x82\xac \xf0\x9f\x98\x80"));
+  }
+
+  it("rejects overlong encodings, surrogates and truncation") {
+    expect(not str_utf8_valid("\xc0\x80"));
+    expect(not str_utf8_valid("\xe0\x9f\xbf"));
+    expect(not str_utf8_valid("\xed\xa0\x80"));
+    expect(not str_utf8_valid("\xf4\x90\x80\x80"));
+    expect(not str_utf8_valid("abc\xe2\x82"));
+  }
+
+  it("finds the first invalid sequence past a full block") {
+    StringRange text = R(
+      "0123456789012345678901234567890123456789012345678901234567890123"
+      "ok \xc3\xa9 \x80 tail"
+    );
+    expect(str_utf8_validate(text), == , 70);
+  }
+
+  it("counts code points") {
+    expect(str_utf8_length("h\xc3\xa9llo \xf0\x9f\x98\x80"), == , 7);
+    expect(str_utf16_length("h\xc3\xa9llo \xf0\x9f\x98\x80"), == , 8);
+  }
+
+  it("iterates code points, replacing invalid bytes") {
+    StringRange text = R("a\xc3\xa9\xff");
+    uint expected[] = { 'a', 0xE9, 0xFFFD };
+    index_s pos = 0;
+    uint cp;
+    int i = 0;
+    while (str_utf8_next(text, &pos, &cp)) {
+      expect(cp, == , expected[i++]);
+    }
+    expect(i, == , 3);
+  }
+
+}
+
+describe(str_to_utf16) {
+  String result = NULL;
+
+  it("round trips through utf-16 with surrogate pairs") {
+    u16 buffer[16];
+    index_s count = str_to_utf16(buffer, "x\xf0\x9f\x98\x80");
+    expect(count, == , 3);
+    expect(buffer[1], == , 0xD83D);
+    expect(buffer[2], == , 0xDE00);
+    result = str_from_utf16(buffer, count);
+    expect(result to match("x\xf0\x9f\x98\x80", str_eq));
+  }
+
+  it("round trips through utf-32") {
+    uint buffer[16];
+    index_s count = str_to_utf32(buffer, "\xe2\x82\xac" "1");
+    expect(count, == , 2);
+    expect(buffer[0], == , 0x20AC);
+    result = str_from_utf32(buffer, count);
+    expect(result to match("\xe2\x82\xac" "1", str_eq));
+  }
+
+  it("rejects invalid input") {
+    u16 lone[] = { 'a', 0xDC00 };
+    u16 buffer[4];
+    expect(str_to_utf16(buffer, "\xc3"), == , -1);
+    expect(str_from_utf16(lone, 2) == NULL);
+  }
+
+  it("appends to an array") {
+    Array out = array_new(u16);
+    expect(str_to_utf16_array(out, "h\xc3\xa9"), == , 2);
+    expect(str_to_utf16_array(out, "\xff"), == , -1);
+    expect(out->size, == , 2);
+    expect(((u16*)out->arr)[1], == , 0xE9);
+    array_delete(&out);
+  }
+
+  if (result) str_delete(&result);
+
+}
+
+describe(str_replace) {
+  String result = NULL;
+
+  it("replaces the first instance") {
+    result = str_replace("one two one", "one", "1");
+    expect(result to match("1 two one", str_eq));
+  }
+
+  it("replaces every instance") {
+    result = str_replace_all("one two one", "one", "three");
+    expect(result to match("three two three", str_eq));
+  }
+
+  it("doesn't rescan replaced text") {
+    result = str_replace_all("aaa", "a", "aa");
+    expect(result to match("aaaaaa", str_eq));
+  }
+
+  it("copies the string when nothing matches") {
+    result = str_replace_all("unchanged", "xyz", "abc");
+    expect(result to match("unchanged", str_eq));
+  }
+
+  it("replaces several tokens in one pass") {
+    StrReplacement escapes[] = {
+      { R("&"), R("&amp;") }, { R("<"), R("&lt;") }, { R(">"), R("&gt;") },
+    };
+    result = str_replace_multi("<a & b>", escapes, 3);
+    expect(result to match("&lt;a &amp; b&gt;", str_eq));
+  }
+
+  it("prefers the longest token") {
+    StrReplacement vars[] = {
+      { R("{{n}}"), R("short") }, { R("{{name}}"), R("long") },
+    };
+    result = str_replace_multi("{{name}}/{{n}}", vars, 2);
+    expect(result to match("long/short", str_eq));
+  }
+
+  if (result) str_delete(&result);
+
+}
+
 describe(str_substring) {
 
   StringRange range = R("This is a string");
@@ -905,6 +1135,15 @@ describe(str_format) {
       expect(result to match("|test||", str_eq));
     }
 
+    it("returns a valid string after shrinking the output buffer") {
+      StringRange word = R("0123456789abcdef0123456789abcdef");
+      result = str_format("{}{}{}{}", word, word, word, word);
+      expect(result->size, == , 128);
+      expect(result->begin[128] == '\0');
+      expect(str_starts_with(result, word));
+      expect(str_ends_with(result, word));
+    }
+
     it("completely pads an argument out of range") {
       result = str_format("|{1:5}|", "unused");
       expect(result to match("|     |", str_eq));
@@ -1269,6 +1508,12 @@ test_suite(tests_string) {
   test_group(str_to_int),
   test_group(str_index_of),
   test_group(str_find),
+  test_group(str_eq_nocase),
+  test_group(str_index_of_nocase),
+  test_group(str_to_lower),
+  test_group(str_utf8_valid),
+  test_group(str_to_utf16),
+  test_group(str_replace),
   test_group(str_substring),
   test_group(str_trim),
   test_group(str_split),
@@ -0,0 +1,240 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "job.h"
+
+#include "cspec.h"
+
+#define TRACE_SPEC_PATH "trace_spec.json"
+#define TRACE_SPEC_JOBS 16
+
+typedef struct {
+  char name[32];
+  int tid;
+  double ts, dur;
+} TraceSpecEvent;
+
+#ifdef MCLIB_TRACE
+
+// Reads back the complete events with the given name prefix, line by line
+//    since the export writes one event per line
+static index_s trace_spec_load(
+  const char* prefix, TraceSpecEvent* out, index_s capacity
+) {
+  FILE* file = fopen(TRACE_SPEC_PATH, "r");
+  if (!file) return -1;
+
+  char line[256];
+  index_s count = 0;
+  while (fgets(line, sizeof(line), file)) {
+    TraceSpecEvent e;
+    int read = sscanf(line, "{\"ph\": \"X\", \"name\": \"%31[^\"]\", "
+      "\"pid\": 1, \"tid\": %d, \"ts\": %lf, \"dur\": %lf}",
+      e.name, &e.tid, &e.ts, &e.dur
+    );
+    if (read != 4 || strncmp(e.name, prefix, strlen(prefix)) != 0) continue;
+    if (count < capacity) out[count] = e;
+    ++count;
+  }
+
+  fclose(file);
+  return count;
+}
+
+static bool trace_spec_file_has(const char* text) {
+  FILE* file = fopen(TRACE_SPEC_PATH, "r");
+  if (!file) return false;
+
+  char line[256];
+  bool found = false;
+  while (!found && fgets(line, sizeof(line), file)) {
+    found = strstr(line, text) != NULL;
+  }
+  fclose(file);
+  return found;
+}
+
+static bool trace_spec_within(TraceSpecEvent inner, TraceSpecEvent outer) {
+  // timestamps are printed to the nanosecond
+  return inner.ts >= outer.ts - 0.001
+    && inner.ts + inner.dur <= outer.ts + outer.dur + 0.002;
+}
+
+// Long enough that the workers get to take some of the jobs
+static void trace_spec_job(void* data) {
+  PARAM_UNUSED(data);
+  TRACE_BEGIN("spec_job");
+  for (volatile int spin = 0; spin < 100000; ++spin);
+  TRACE_END();
+}
+
+static void trace_spec_run_jobs(int workers) {
+  JobPool pool = job_pool_new(workers);
+  Job jobs[TRACE_SPEC_JOBS];
+  for (int i = 0; i < TRACE_SPEC_JOBS; ++i) {
+    jobs[i] = job_run(pool, trace_spec_job, NULL);
+  }
+  for (int i = 0; i < TRACE_SPEC_JOBS; ++i) job_wait(pool, &jobs[i]);
+  job_pool_delete(&pool);
+}
+
+describe(trace_export) {
+  TraceSpecEvent* events = malloc(sizeof(TraceSpecEvent) * 64);
+  trace_clear();
+
+  it("writes nested zones inside their parents") {
+    TRACE_BEGIN("spec_outer");
+    for (int i = 0; i < 3; ++i) {
+      TRACE_BEGIN("spec_inner");
+      TRACE_END();
+    }
+    TRACE_SCOPE("spec_scope") {
+      TRACE_BEGIN("spec_scoped");
+      TRACE_END();
+    }
+    TRACE_END();
+
+    expect(trace_export(TRACE_SPEC_PATH));
+    index_s count = trace_spec_load("spec_", events, 64);
+    expect(count, == , 6);
+    if (count != 6) return;
+
+    // each zone is written as it ends, so children come first
+    const char* order[6] = {
+      "spec_inner", "spec_inner", "spec_inner",
+      "spec_scoped", "spec_scope", "spec_outer"
+    };
+    for (int i = 0; i < 6; ++i) {
+      expect(strcmp(events[i].name, order[i]) == 0);
+      expect(events[i].tid, == , events[5].tid);
+      expect(events[i].dur >= 0);
+      expect(trace_spec_within(events[i], events[5]));
+    }
+    expect(trace_spec_within(events[3], events[4]));
+    for (int i = 1; i < 3; ++i) {
+      expect(events[i].ts >= events[i - 1].ts + events[i - 1].dur - 0.002);
+    }
+  }
+
+  it("drops events on clear and keeps the newest when the ring fills") {
+    TRACE_BEGIN("spec_cleared");
+    TRACE_END();
+    trace_clear();
+
+    for (int i = 0; i < TRACE_BUFFER_EVENTS + 10; ++i) {
+      TRACE_BEGIN(i < 10 ? "spec_oldest" : "spec_ring");
+      TRACE_END();
+    }
+
+    expect(trace_export(TRACE_SPEC_PATH));
+    expect(trace_spec_load("spec_cleared", events, 64), == , 0);
+    expect(trace_spec_load("spec_oldest", events, 64), == , 0);
+    expect(trace_spec_load("spec_ring", events, 64), == ,
+      TRACE_BUFFER_EVENTS
+    );
+  }
+
+  it("keeps begins and ends matched past the depth limit") {
+    for (int i = 0; i < 100; ++i) TRACE_BEGIN("spec_deep");
+    for (int i = 0; i < 100; ++i) TRACE_END();
+    TRACE_END(); // unmatched ends are ignored
+
+    expect(trace_export(TRACE_SPEC_PATH));
+    index_s count = trace_spec_load("spec_deep", events, 64);
+    expect(count > 0 && count < 100);
+  }
+
+  it("includes other threads and their names") {
+    trace_set_thread_name("spec \"main\"\n");
+    trace_spec_run_jobs(2);
+
+    expect(trace_export(TRACE_SPEC_PATH));
+    expect(trace_spec_load("spec_job", events, 64), == , TRACE_SPEC_JOBS);
+    expect(trace_spec_file_has("\"args\": {\"name\": \"spec \\\"main\\\"\"}"));
+  }
+
+  it("reuses the buffers of exited threads after a clear") {
+    // the main thread and two workers at a time, but eight workers in total
+    int tids[3 * TRACE_SPEC_JOBS];
+    int distinct = 0;
+    for (int round = 0; round < 4; ++round) {
+      trace_clear();
+      trace_spec_run_jobs(2);
+      expect(trace_export(TRACE_SPEC_PATH));
+      index_s count = trace_spec_load("spec_job", events, 64);
+      expect(count, == , TRACE_SPEC_JOBS);
+
+      for (index_s i = 0; i < count && i < 64; ++i) {
+        int seen = 0;
+        while (seen < distinct && tids[seen] != events[i].tid) ++seen;
+        if (seen == distinct && distinct < 3 * TRACE_SPEC_JOBS) {
+          tids[distinct++] = events[i].tid;
+        }
+      }
+    }
+    expect(distinct <= 3);
+  }
+
+  it("fails for paths it can't write") {
+    expect(not trace_export("no/such/directory/trace.json"));
+  }
+
+  remove(TRACE_SPEC_PATH);
+  free(events);
+
+}
+
+#else
+
+describe(trace_export) {
+
+  it("records nothing without MCLIB_TRACE") {
+    int runs = 0;
+    TRACE_BEGIN("spec_outer");
+    TRACE_SCOPE("spec_scope") {
+      ++runs;
+    }
+    TRACE_END();
+    expect(runs, == , 1);
+
+    trace_begin("spec_direct");
+    trace_end();
+    expect(not trace_export(TRACE_SPEC_PATH));
+    expect(fopen(TRACE_SPEC_PATH, "r") == NULL);
+  }
+
+}
+
+#endif
+
+test_suite(tests_trace) {
+  test_group(trace_export),
+  test_suite_end
+};
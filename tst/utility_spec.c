@@ -0,0 +1,266 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "utility.h"
+
+#include <string.h>
+
+#include "array.h"
+#include "spec_random.h"
+
+#include "cspec.h"
+
+// Room for the largest buffer plus guard bytes on both sides
+#define UTIL_SPEC_GUARD 40
+#define UTIL_SPEC_BYTES 2048
+
+// Elements in each bswap array: up to 100 swapped, with guard elements
+#define UTIL_SPEC_SWAP_GUARD 8
+#define UTIL_SPEC_SWAPS (100 + 3 + 2 * UTIL_SPEC_SWAP_GUARD)
+
+static unsigned util_spec_state = 29;
+
+static byte util_spec_random(void) {
+  return (byte)spec_random(&util_spec_state);
+}
+
+static void util_spec_fill(byte* p, index_s size) {
+  for (index_s i = 0; i < size; ++i) p[i] = util_spec_random();
+}
+
+// The plain element by element reversal everything is checked against
+static void util_spec_reverse(
+  byte* out, const byte* in, index_s element_size, index_s count
+) {
+  for (index_s i = 0; i < count; ++i) {
+    memcpy(out + (count - 1 - i) * element_size, in + i * element_size,
+      element_size
+    );
+  }
+}
+
+// Checks one reversal, offset from an aligned buffer and with guard bytes
+//    either side of it that must be left alone
+static bool util_spec_check_reverse(
+  index_s offset, index_s element_size, index_s count
+) {
+  static byte buffer[UTIL_SPEC_BYTES + 2 * UTIL_SPEC_GUARD];
+  static byte expected[UTIL_SPEC_BYTES + 2 * UTIL_SPEC_GUARD];
+  index_s total = UTIL_SPEC_BYTES + 2 * UTIL_SPEC_GUARD;
+  index_s size = element_size * count;
+
+  util_spec_fill(buffer, total);
+  memcpy(expected, buffer, total);
+  byte* data = buffer + UTIL_SPEC_GUARD + offset;
+  util_spec_reverse(expected + UTIL_SPEC_GUARD + offset, data,
+    element_size, count
+  );
+
+  if (element_size == 1) memrev(data, (unsigned)size);
+  else memrev_elements(data, element_size, count);
+  return memcmp(buffer, expected, total) == 0;
+}
+
+static u16 util_spec_swap16(u16 x) {
+  return (u16)((x >> 8) | (x << 8));
+}
+
+static unsigned long long util_spec_swap(unsigned long long x, int bytes) {
+  unsigned long long ret = 0;
+  for (int i = 0; i < bytes; ++i) {
+    ret = (ret << 8) | ((x >> (8 * i)) & 0xFF);
+  }
+  return ret;
+}
+
+// Fills a whole array of UTIL_SPEC_SWAPS elements with random bytes, and
+//    expected with the same bytes after swapping count elements from start
+static void util_spec_swapped(
+  void* data, byte* expected, index_s width, index_s start, index_s count
+) {
+  util_spec_fill(data, UTIL_SPEC_SWAPS * width);
+  memcpy(expected, data, UTIL_SPEC_SWAPS * width);
+  for (index_s i = start; i < start + count; ++i) {
+    memrev(expected + i * width, (unsigned)width);
+  }
+}
+
+describe(memrev) {
+
+  it("reverses every size from 0 to 300 bytes at any offset") {
+    bool ok = true;
+    for (index_s offset = 0; offset < 4; ++offset) {
+      for (index_s size = 0; size <= 300; ++size) {
+        ok = ok && util_spec_check_reverse(offset, 1, size);
+      }
+    }
+    expect(ok);
+  }
+
+  it("reverses large buffers") {
+    expect(util_spec_check_reverse(0, 1, UTIL_SPEC_BYTES));
+    expect(util_spec_check_reverse(3, 1, UTIL_SPEC_BYTES - 5));
+    expect(util_spec_check_reverse(1, 1, 1023));
+  }
+
+  it("reverses a known string") {
+    char text[] = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJ";
+    memrev(text, (unsigned)strlen(text));
+    expect(strcmp(text, "JIHGFEDCBAzyxwvutsrqponmlkjihgfedcba9876543210"),
+      == , 0
+    );
+  }
+
+}
+
+describe(memrev_elements) {
+
+  it("reverses elements of every size from 1 to 40 bytes") {
+    bool ok = true;
+    for (index_s element_size = 1; element_size <= 40; ++element_size) {
+      for (index_s count = 0; count <= 50; ++count) {
+        index_s offset = count % 3;
+        ok = ok && util_spec_check_reverse(offset, element_size, count);
+      }
+    }
+    expect(ok);
+  }
+
+  it("reverses elements bigger than the swap buffer") {
+    expect(util_spec_check_reverse(0, 64, 31));
+    expect(util_spec_check_reverse(1, 100, 20));
+    expect(util_spec_check_reverse(2, 1000, 2));
+  }
+
+  it("reverses many power of two sized elements") {
+    index_s sizes[5] = { 1, 2, 4, 8, 16 };
+    for (int i = 0; i < 5; ++i) {
+      index_s count = UTIL_SPEC_BYTES / sizes[i];
+      expect(util_spec_check_reverse(0, sizes[i], count));
+      expect(util_spec_check_reverse(sizes[i] / 2 + 1, sizes[i], count - 3));
+    }
+  }
+
+}
+
+describe(bswap) {
+  static u16 data16[UTIL_SPEC_SWAPS];
+  static uint data32[UTIL_SPEC_SWAPS];
+  static unsigned long long data64[UTIL_SPEC_SWAPS];
+  static float dataf[UTIL_SPEC_SWAPS];
+  static byte expected[UTIL_SPEC_SWAPS * 8];
+
+  it("swaps single values") {
+    expect(bswap16(0x1234), == , 0x3412);
+    expect(bswap32(0x12345678u), == , 0x78563412u);
+    expect(bswap64(0x0102030405060708ull), == , 0x0807060504030201ull);
+    for (int i = 0; i < 1000; ++i) {
+      unsigned long long x = 0;
+      for (int b = 0; b < 8; ++b) x = (x << 8) | util_spec_random();
+      expect(bswap16((u16)x), == , util_spec_swap16((u16)x));
+      expect(bswap32((uint)x), == , (uint)util_spec_swap(x, 4));
+      expect(bswap64(x), == , util_spec_swap(x, 8));
+    }
+  }
+
+  it("swaps every element of an array, and nothing past it") {
+    bool ok = true;
+    for (index_s count = 0; count <= 100; ++count) {
+      index_s start = UTIL_SPEC_SWAP_GUARD + count % 4;
+
+      util_spec_swapped(data16, expected, 2, start, count);
+      bswap16_s(data16 + start, count);
+      ok = ok && memcmp(data16, expected, sizeof(data16)) == 0;
+
+      util_spec_swapped(data32, expected, 4, start, count);
+      bswap32_s(data32 + start, count);
+      ok = ok && memcmp(data32, expected, sizeof(data32)) == 0;
+
+      util_spec_swapped(data64, expected, 8, start, count);
+      bswap64_s(data64 + start, count);
+      ok = ok && memcmp(data64, expected, sizeof(data64)) == 0;
+
+      util_spec_swapped(dataf, expected, 4, start, count);
+      bswapf_s(dataf + start, count);
+      ok = ok && memcmp(dataf, expected, sizeof(dataf)) == 0;
+    }
+    expect(ok);
+  }
+
+  it("round trips floats through a double swap") {
+    float values[37];
+    for (int i = 0; i < 37; ++i) values[i] = (float)i * 0.37f - 5.f;
+    bswapf_s(values, 37);
+    bswapf_s(values, 37);
+    for (int i = 0; i < 37; ++i) {
+      expect(values[i] == (float)i * 0.37f - 5.f);
+    }
+  }
+
+}
+
+describe(array_reverse) {
+  Array ints = array_new(int);
+  Array triples = array_new_reserve(byte[3], 200);
+
+  it("reverses arrays of every length up to 200") {
+    bool ok = true;
+    for (int size = 0; size <= 200; ++size) {
+      array_clear(ints);
+      for (int i = 0; i < size; ++i) array_write_back(ints, &i);
+      array_reverse(ints);
+      const int* data = ints->arr;
+      for (int i = 0; i < size; ++i) ok = ok && data[i] == size - 1 - i;
+    }
+    expect(ok);
+  }
+
+  it("reverses odd sized elements") {
+    for (int i = 0; i < 200; ++i) {
+      byte triple[3] = { (byte)i, (byte)(i + 1), (byte)(i + 2) };
+      array_write_back(triples, triple);
+    }
+    array_reverse(triples);
+    const byte* data = triples->arr;
+    bool ok = true;
+    for (int i = 0; i < 200; ++i) {
+      int from = 199 - i;
+      ok = ok && data[3 * i] == (byte)from;
+      ok = ok && data[3 * i + 2] == (byte)(from + 2);
+    }
+    expect(ok);
+  }
+
+  array_delete(&triples);
+  array_delete(&ints);
+
+}
+
+test_suite(tests_utility) {
+  test_group(memrev),
+  test_group(memrev_elements),
+  test_group(bswap),
+  test_group(array_reverse),
+  test_suite_end
+};
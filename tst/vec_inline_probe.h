@@ -0,0 +1,111 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// No include guard - vec_inline_spec.c includes this with MCLIB_INLINE_MATH
+// and vec_inline_probe.c without it, naming the function through
+// VEC_INLINE_PROBE, so the same calls go through both builds of the math.
+
+#include "mat.h"
+#include "vec.h"
+
+#include <string.h>
+
+#define VEC_INLINE_PROBE_IN 47
+#define VEC_INLINE_PROBE_OUT 256
+
+#define _probe(v) (memcpy(o, (v).f, sizeof((v).f)), o += sizeof((v).f) / 4)
+
+// \brief Runs every function in vec_inline.h and mat_inline.h on floats from
+//    in, writes each result's components to out and returns how many there
+//    were. Integer results are written as floats.
+index_s VEC_INLINE_PROBE(const float* in, float* out);
+index_s VEC_INLINE_PROBE(const float* in, float* out) {
+  float* o = out;
+  float s = in[0];
+  vec2 a2 = v2f(in[1], in[2]), b2 = v2f(in[3], in[4]);
+  vec3 a3 = v3f(in[5], in[6], in[7]), b3 = v3f(in[8], in[9], in[10]);
+  vec4 a4 = v4f(in[11], in[12], in[13], in[14]);
+  mat4 ma, mb;
+  memcpy(ma.f, in + 15, sizeof(ma.f));
+  memcpy(mb.f, in + 31, sizeof(mb.f));
+  _probe(a2); _probe(b2); _probe(a3); _probe(b3); _probe(a4);
+
+  int n = (int)(s * 10);
+  vec3b c3 = v3b((byte)n, (byte)(n * 3), (byte)(n * 7));
+  vec4b c4 = v4b((byte)n, (byte)(n * 5), (byte)(n * 9), (byte)(n * 11));
+  vec2i i2 = v2i(n, 7);
+  vec3i i3 = v3i(n, -n, n * 2);
+  for (int i = 0; i < 3; ++i) *o++ = c3.i[i];
+  for (int i = 0; i < 4; ++i) *o++ = c4.i[i];
+  for (int i = 0; i < 2; ++i) *o++ = (float)i2.i[i];
+  for (int i = 0; i < 3; ++i) *o++ = (float)i3.i[i];
+  *o++ = i2aspect(i2);
+
+  *o++ = v2magsq(a2);
+  *o++ = v2mag(a2);
+  *o++ = v2dot(a2, b2);
+  *o++ = v2cross(a2, b2);
+  *o++ = v2distsq(a2, b2);
+  *o++ = v2dist(a2, b2);
+  _probe(v2neg(a2));
+  _probe(v2add(a2, b2));
+  _probe(v2sub(a2, b2));
+  _probe(v2scale(a2, s));
+  _probe(v2had(a2, b2));
+  _probe(v2perp(a2));
+  _probe(v2norm(a2));
+  _probe(v2lerp(a2, b2, s));
+  _probe(v23(a2));
+  _probe(v24(a2));
+  _probe(p24(a2));
+  _probe(v23f(a2, s));
+  _probe(v24f(a2, s, in[3]));
+  _probe(p24f(a2, s));
+
+  *o++ = v3magsq(a3);
+  *o++ = v3mag(a3);
+  *o++ = v3dot(a3, b3);
+  _probe(v3norm(a3));
+  _probe(v3neg(a3));
+  _probe(v3add(a3, b3));
+  _probe(v3sub(a3, b3));
+  _probe(v3scale(a3, s));
+  _probe(v3had(a3, b3));
+  _probe(v3cross(a3, b3));
+  _probe(v34(a3));
+  _probe(p34(a3));
+  _probe(v34f(a3, s));
+  _probe(qtransform(a4, b3));
+
+  _probe(m4basis(a3, b3, v3cross(a3, b3), a2.x > 0 ? a3 : b3));
+  _probe(m4translation(a3));
+  _probe(m4scalar(b3));
+  _probe(m4uniform(s));
+  _probe(m4mul(ma, mb));
+  _probe(mv4mul(ma, a4));
+
+  return (index_s)(o - out);
+}
+
+#undef _probe
@@ -0,0 +1,77 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+// Everything in this file sees the static inline definitions of the trivial
+// vec and mat functions, to check them against the out-of-line build.
+#ifndef MCLIB_INLINE_MATH
+#define MCLIB_INLINE_MATH
+#endif
+
+#include "vec.h"
+#include "mat.h"
+
+#include <math.h>
+
+#include "spec_random.h"
+
+#define VEC_INLINE_PROBE vec_inline_spec_probe_inline
+#include "vec_inline_probe.h"
+#undef VEC_INLINE_PROBE
+
+#include "cspec.h"
+
+index_s vec_inline_spec_probe(const float* in, float* out);
+
+describe(inline_math) {
+
+  it("matches the out-of-line vec and mat functions") {
+    unsigned state = 13;
+    float in[VEC_INLINE_PROBE_IN];
+    float inline_out[VEC_INLINE_PROBE_OUT];
+    float extern_out[VEC_INLINE_PROBE_OUT];
+
+    for (int n = 0; n < 200; ++n) {
+      for (int i = 0; i < VEC_INLINE_PROBE_IN; ++i) {
+        in[i] = spec_random_range(&state, -10, 10);
+      }
+      index_s count = vec_inline_spec_probe_inline(in, inline_out);
+      expect(count <= VEC_INLINE_PROBE_OUT);
+      expect(vec_inline_spec_probe(in, extern_out), == , count);
+
+      // the caller's contraction into fused multiply-adds may differ
+      int mismatches = 0;
+      for (index_s i = 0; i < count; ++i) {
+        float a = inline_out[i], b = extern_out[i];
+        mismatches += !(fabsf(a - b) <= 1e-5f * fmaxf(1, fabsf(a)));
+      }
+      expect(mismatches, == , 0);
+    }
+  }
+
+}
+
+test_suite(tests_vec_inline) {
+  test_group(inline_math),
+  test_suite_end
+};
@@ -0,0 +1,301 @@
+/*******************************************************************************
+* MIT License
+*
+* Copyright (c) 2024 Curtis McCoy
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include "fixed.h"
+#include "vecd.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spec_random.h"
+
+#include "cspec.h"
+
+static unsigned vec_t_spec_state = 11;
+
+static double vec_t_spec_random(double scale) {
+  return ((double)spec_random(&vec_t_spec_state) / 16777215. * 2. - 1.) * scale;
+}
+
+static mat4 vec_t_spec_mat4(void) {
+  mat4 ret;
+  for (int x = 0; x < 4; ++x) {
+    for (int y = 0; y < 4; ++y) ret.m[x][y] = (float)vec_t_spec_random(4);
+  }
+  return ret;
+}
+
+describe(dm4mul) {
+
+  it("matches a naive product in the same summation order") {
+    for (int n = 0; n < 100; ++n) {
+      dmat4 a = dm4from(vec_t_spec_mat4());
+      dmat4 b = dm4from(vec_t_spec_mat4());
+      dmat4 c = dm4mul(a, b);
+
+      for (int x = 0; x < 4; ++x) {
+        for (int y = 0; y < 4; ++y) {
+          double sum = a.m[0][y] * b.m[x][0];
+          for (int i = 1; i < 4; ++i) sum += a.m[i][y] * b.m[x][i];
+          expect(c.m[x][y] == sum);
+        }
+      }
+    }
+  }
+
+  it("follows the layout of the float m4mul") {
+    mat4 a = vec_t_spec_mat4();
+    mat4 b = vec_t_spec_mat4();
+    mat4 expected = m4mul(a, b);
+    mat4 result = dm4tof(dm4mul(dm4from(a), dm4from(b)));
+
+    for (int i = 0; i < 16; ++i) {
+      expect(fabsf(result.f[i] - expected.f[i]) < 1e-4f);
+    }
+  }
+
+  it("transforms vectors like the float mv4mul") {
+    for (int n = 0; n < 100; ++n) {
+      mat4 m = vec_t_spec_mat4();
+      vec4 v = v4f((float)vec_t_spec_random(8), (float)vec_t_spec_random(8),
+        (float)vec_t_spec_random(8), 1
+      );
+      dvec4 result = dmv4mul(dm4from(m), dv4from(v));
+
+      for (int y = 0; y < 4; ++y) {
+        double sum = (double)m.m[0][y] * v.f[0];
+        for (int x = 1; x < 4; ++x) sum += (double)m.m[x][y] * v.f[x];
+        expect(result.e[y] == sum);
+      }
+
+      vec4 expected = mv4mul(m, v);
+      vec4 rounded = dv4tof(result);
+      for (int y = 0; y < 4; ++y) {
+        expect(fabsf(rounded.f[y] - expected.f[y]) < 1e-4f);
+      }
+    }
+  }
+
+  it("builds transforms from vectors") {
+    dvec3 offset = dv3(1e9, -2.5, 0.125);
+    dvec4 P = dmv4mul(dm4translation(offset), dv4(3, 4, 5, 1));
+    expect(P.x == 1e9 + 3 && P.y == 1.5 && P.z == 5.125 && P.w == 1);
+
+    dmat4 t = dm4transpose(dm4translation(offset));
+    expect(t.m[0][3] == 1e9 && t.m[3][0] == 0);
+
+    dvec4 S = dmv4mul(dm4uniform(2), dv4(3, 4, 5, 1));
+    expect(S.x == 6 && S.y == 8 && S.z == 10 && S.w == 1);
+
+    dmat4 I = dm4mul(dm4identity(), dm4scalar(dv3(2, 3, 4)));
+    expect(I.m[0][0] == 2 && I.m[1][1] == 3 && I.m[2][2] == 4);
+    expect(I.m[3][3] == 1 && I.m[1][0] == 0);
+  }
+
+}
+
+describe(dvec) {
+
+  it("keeps precision far from the origin") {
+    dvec3 far = dv3(1e9, 1e9, 0);
+    dvec3 near = dv3add(far, dv3(0.001, -0.002, 0.5));
+    dvec3 delta = dv3sub(near, far);
+
+    expect(fabs(delta.x - 0.001) < 1e-6);
+    expect(fabs(delta.y + 0.002) < 1e-6);
+    expect(delta.z == 0.5);
+    expect(fabs(dv3dist(far, near) - dv3mag(delta)) < 1e-9);
+  }
+
+  it("computes products like the float versions") {
+    dvec3 a = dv3(1, 2, 3), b = dv3(-4, 5, 0.5);
+    expect(dv3dot(a, b) == 7.5);
+
+    dvec3 c = dv3cross(a, b);
+    expect(c.x == -14 && c.y == -12.5 && c.z == 13);
+    expect(dv3dot(c, a) == 0 && dv3dot(c, b) == 0);
+
+    expect(dv2cross(dv2(1, 0), dv2(0, 1)) == 1);
+    dvec2 p = dv2perp(dv2(3, 4));
+    expect(dv2dot(p, dv2(3, 4)) == 0);
+  }
+
+  it("normalizes and interpolates") {
+    dvec4 n = dv4norm(dv4(1, 2, 2, 4));
+    expect(fabs(dv4mag(n) - 1) < 1e-15);
+    expect(n.x == 0.2 && n.w == 0.8);
+
+    dvec3 m = dv3lerp(dv3(0, 10, -2), dv3(4, 20, 2), 0.25);
+    expect(m.x == 1 && m.y == 12.5 && m.z == -1);
+  }
+
+  it("converts to and from floats") {
+    vec3 v = v3f(1.5f, -2.25f, 1e-3f);
+    vec3 back = dv3tof(dv3from(v));
+    expect(memcmp(&v, &back, sizeof(v)) == 0);
+  }
+
+}
+
+describe(fx_mul) {
+
+  it("converts integers and floats") {
+    expect(fx(3), == , 3 * 65536);
+    expect(fx(-2), == , -2 * 65536);
+    expect(fx_from_float(0.5f), == , FX_HALF);
+    expect(fx_from_float(-0.25f), == , -FX_ONE / 4);
+    expect(fx_from_double(1.0 / 3), == , 21845);
+    expect(fx_to_float(FX_ONE + FX_HALF) == 1.5f);
+    expect(fx_to_double(-FX_HALF) == -0.5);
+  }
+
+  it("matches a wide product truncated toward negative infinity") {
+    unsigned state = 99;
+    for (int n = 0; n < 10000; ++n) {
+      fixed a = (fixed)(spec_random(&state) >> 1);
+      fixed b = -(fixed)(spec_random(&state) >> 3);
+
+      long long wide = (long long)a * b;
+      long long floor_div = wide / 65536 - (wide % 65536 < 0);
+      expect(fx_mul(a, b), == , (fixed)floor_div);
+    }
+    expect(fx_mul(fx(3), FX_HALF), == , fx(1) + FX_HALF);
+    expect(fx_mul(-1, 1), == , -1);
+  }
+
+  it("divides and saturates on zero") {
+    expect(fx_div(fx(1), fx(3)), == , 21845);
+    expect(fx_div(fx(-6), fx(4)), == , -FX_ONE - FX_HALF);
+    expect(fx_div(fx(5), 0), == , FX_MAX);
+    expect(fx_div(fx(-5), 0), == , FX_MIN);
+  }
+
+  it("takes the integer square root") {
+    fixed values[] = { 1, 2, 3, FX_HALF, FX_ONE, fx(2), fx(100), fx(12345),
+      FX_MAX, FX_MAX - 1, 0x12345678
+    };
+    for (int i = 0; i < (int)(sizeof(values) / sizeof(*values)); ++i) {
+      unsigned long long n = (unsigned long long)values[i] << 16;
+      unsigned long long r = (unsigned long long)fx_sqrt(values[i]);
+      expect(r * r <= n && (r + 1) * (r + 1) > n);
+    }
+    expect(fx_sqrt(fx(4)), == , fx(2));
+    expect(fx_sqrt(0), == , 0);
+    expect(fx_sqrt(-FX_ONE), == , 0);
+  }
+
+}
+
+describe(fxvec) {
+
+  it("does integer vector math") {
+    fxvec3 a = fxv3(fx(1), fx(2), fx(3)), b = fxv3(fx(-4), fx(5), FX_HALF);
+    expect(fxv3dot(a, b), == , fx(7) + FX_HALF);
+
+    fxvec3 c = fxv3cross(a, b);
+    expect(c.x, == , fx(-14));
+    expect(c.y, == , fx(-12) - FX_HALF);
+    expect(c.z, == , fx(13));
+
+    expect(fxv3mag(fxv3(fx(2), fx(3), fx(6))), == , fx(7));
+    expect(fxv2distsq(fxv2(0, 0), fxv2(fx(3), fx(4))), == , fx(25));
+
+    fxvec3 m = fxv3lerp(fxv3(0, fx(10), fx(-2)), fxv3(fx(4), fx(20), fx(2)),
+      FX_ONE / 4
+    );
+    expect(m.x, == , fx(1));
+    expect(m.y, == , fx(12) + FX_HALF);
+    expect(m.z, == , fx(-1));
+  }
+
+  it("wraps around on overflow") {
+    expect(fx_add(FX_MAX, 1), == , FX_MIN);
+    expect(fx_sub(FX_MIN, 1), == , FX_MAX);
+    expect(fx_neg(FX_MIN), == , FX_MIN);
+    expect(fx(32768), == , FX_MIN);
+
+    fxvec2 big = fxv2(FX_MAX, FX_MIN);
+    fxvec2 sum = fxv2add(big, fxv2(FX_ONE, -FX_ONE));
+    expect(sum.x, == , FX_MIN + FX_ONE - 1);
+    expect(sum.y, == , FX_MAX - FX_ONE + 1);
+    expect(fxv2neg(big).y, == , FX_MIN);
+
+    // 22500 + 22500 is past the largest whole number, 32767
+    fxvec2 v = fxv2(fx(150), fx(150));
+    expect(fxv2dot(v, v), == , fx(45000 - 65536));
+  }
+
+  it("normalizes to within a few steps of one") {
+    fxvec3 n = fxv3norm(fxv3(fx(3), fx(-7), fx(11)));
+    expect(abs(fxv3mag(n) - FX_ONE) <= 4);
+  }
+
+  it("multiplies matrices exactly for whole numbers") {
+    fxmat4 a, b;
+    int ia[16], ib[16];
+    for (int i = 0; i < 16; ++i) {
+      ia[i] = (i * 7) % 11 - 5;
+      ib[i] = (i * 5) % 9 - 4;
+      a.e[i] = fx(ia[i]);
+      b.e[i] = fx(ib[i]);
+    }
+
+    fxmat4 c = fxm4mul(a, b);
+    for (int x = 0; x < 4; ++x) {
+      for (int y = 0; y < 4; ++y) {
+        int sum = 0;
+        for (int i = 0; i < 4; ++i) sum += ia[i * 4 + y] * ib[x * 4 + i];
+        expect(c.m[x][y], == , fx(sum));
+      }
+    }
+
+    fxvec4 v = fxmv4mul(fxm4translation(fxv3(fx(1), fx(2), fx(3))),
+      fxv4(FX_HALF, 0, fx(-3), FX_ONE)
+    );
+    expect(v.x, == , fx(1) + FX_HALF);
+    expect(v.y, == , fx(2));
+    expect(v.z, == , 0);
+    expect(v.w, == , FX_ONE);
+  }
+
+  it("converts to and from floats") {
+    fxvec3 v = fxv3from(v3f(1.5f, -0.25f, 100.f));
+    expect(v.x, == , fx(1) + FX_HALF);
+    expect(v.y, == , -FX_ONE / 4);
+    expect(v.z, == , fx(100));
+
+    vec4 f = fxv4tof(fxv4(FX_HALF, fx(-2), 1, 0));
+    expect(f.x == 0.5f && f.y == -2.f && f.z == 1.f / 65536.f && f.w == 0.f);
+  }
+
+}
+
+test_suite(tests_vec_t) {
+  test_group(dm4mul),
+  test_group(dvec),
+  test_group(fx_mul),
+  test_group(fxvec),
+  test_suite_end
+};